@@ -0,0 +1,101 @@
+// 等值查找测试：比较全表扫描、B+ 树索引与哈希索引在同一 INT 列上的单条查找耗时
+// 用法：index_bench [--bench-rows=200000] [--bench-lookups=20000]
+// 查询经过执行器（索引扫描后由选择算子检查条件），探测只调用索引的 Scan，不读取记录
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include "exception/exceptions.h"
+#include "exec/exec.h"
+#include "oper/conditions/conditions.h"
+#include "oper/nodes.h"
+#include "oper/scan_node.h"
+#include "record/fields.h"
+#include "system/config_manager.h"
+#include "system/system_manager.h"
+
+using namespace dbtrain;
+
+static const char *BENCH_DB = "index_bench";
+// 全表扫描较慢，只执行少量查询
+static const int SCAN_LOOKUPS = 20;
+// 每次插入的记录数
+static const int INSERT_BATCH = 1000;
+
+static size_t RunQuery(OperNode *plan) {
+  Executor executor(new SelectNode(plan));
+  executor.Begin();
+  RecordList records = executor.RunNext();
+  executor.Commit();
+  for (Record *record : records) delete record;
+  return records.size();
+}
+
+// 查询的键按固定步长分散在 [0, rows) 中，返回平均每次查询的微秒数
+static double Measure(int rows, int lookups, const std::function<size_t(int)> &query, size_t &found) {
+  found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < lookups; i++) found += query((int)((long long)i * 7919 % rows));
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / lookups;
+}
+
+int main(int argc, char *argv[]) {
+  ConfigManager &config = ConfigManager::GetInstance();
+  config.Init(argc, argv);
+  int rows = (int)config.GetInt("bench-rows", 200000);
+  int lookups = (int)config.GetInt("bench-lookups", 20000);
+
+  SystemManager &system_manager = SystemManager::GetInstance();
+  try {
+    system_manager.DropDatabase(BENCH_DB, true);
+    system_manager.CreateDatabase(BENCH_DB);
+    system_manager.UseDatabase(BENCH_DB);
+    system_manager.CreateTable("t", {{FieldType::INT, 4, "a"}, {FieldType::STRING, 40, "s"}});
+    Table *table = system_manager.GetTable("t");
+    for (int begin = 0; begin < rows; begin += INSERT_BATCH) {
+      RecordList records;
+      for (int i = begin; i < begin + INSERT_BATCH && i < rows; i++) {
+        Record *record = new Record();
+        std::string value = "row" + std::to_string(i);
+        record->PushBack(new IntField(i));
+        record->PushBack(new StrField(value.c_str(), value.size()));
+        records.push_back(record);
+      }
+      Executor executor(new InsertNode(table, records));
+      executor.Begin();
+      executor.RunNext();
+      executor.Commit();
+    }
+    system_manager.CreateIndex("t_btree", "t", "a", "btree");
+    system_manager.CreateIndex("t_hash", "t", "a", "hash");
+    Index *btree = table->GetIndex(0, true);
+    Index *hash = table->GetIndex(0, false);
+
+    size_t found = 0;
+    double us = Measure(rows, SCAN_LOOKUPS, [&](int key) {
+      return RunQuery(new FilterNode(new TableScanNode(table), new EqualCondition(0, new IntField(key))));
+    }, found);
+    std::cout << "scan  query " << us << " us rows " << found << "\n";
+    for (Index *index : {btree, hash}) {
+      const char *name = index == btree ? "btree" : "hash ";
+      us = Measure(rows, lookups, [&](int key) {
+        OperNode *scan = new IndexScanNode(table, index, new IntField(key), new IntField(key));
+        return RunQuery(new FilterNode(scan, new EqualCondition(0, new IntField(key))));
+      }, found);
+      std::cout << name << " query " << us << " us rows " << found << "\n";
+      us = Measure(rows, lookups * 10, [&](int key) {
+        IntField field(key);
+        return index->Scan(&field, &field).size();
+      }, found);
+      std::cout << name << " probe " << us << " us rids " << found << "\n";
+    }
+    system_manager.CloseDatabase();
+  } catch (DbError &e) {
+    std::cerr << e.what() << std::endl;
+    system_manager.CloseDatabase();
+    return 1;
+  }
+  return 0;
+}
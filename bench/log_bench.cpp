@@ -0,0 +1,79 @@
+// 日志追加的多线程吞吐测试：每个线程执行若干事务，每个事务写入 BEGIN、若干条插入日志与 COMMIT
+// 用法：log_bench [--bench-threads=1,2,4,8] [--bench-txns=50] [--bench-records=2000]
+// 其余运行参数与 cli 相同，例如 --wal-buffer-size=4M；结果只在多核机器上才能反映 LSN 预留的扩展性
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "exception/exceptions.h"
+#include "log/log_manager.h"
+#include "system/config_manager.h"
+#include "system/system_manager.h"
+#include "table/table.h"
+#include "tx/tx_manager.h"
+
+using namespace dbtrain;
+
+static const char *BENCH_DB = "log_bench";
+
+int main(int argc, char *argv[]) {
+  ConfigManager &config = ConfigManager::GetInstance();
+  config.Init(argc, argv);
+  std::vector<int> thread_counts;
+  std::stringstream threads(config.GetString("bench-threads", "1,2,4,8"));
+  for (std::string item; std::getline(threads, item, ',');) thread_counts.push_back(std::stoi(item));
+  int txns = (int)config.GetInt("bench-txns", 50);
+  int records = (int)config.GetInt("bench-records", 2000);
+
+  SystemManager &system_manager = SystemManager::GetInstance();
+  LogManager &log_manager = LogManager::GetInstance();
+  try {
+    system_manager.DropDatabase(BENCH_DB, true);
+    system_manager.CreateDatabase(BENCH_DB);
+    system_manager.UseDatabase(BENCH_DB);
+    system_manager.CreateTable("t", {{FieldType::INT, 4, "a"}});
+    TableID table_id = system_manager.GetTable("t")->GetID();
+    std::cout << "cpus " << std::thread::hardware_concurrency() << "\n";
+    std::atomic<XID> next_xid(TxManager::GetInstance().GetXID());
+    for (int thread_count : thread_counts) {
+      LogStatus before = log_manager.GetStatus();
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> workers;
+      for (int k = 0; k < thread_count; k++) {
+        workers.emplace_back([&, k] {
+          Byte value[64] = {0};
+          for (int i = 0; i < txns; i++) {
+            XID xid = next_xid++;
+            log_manager.Begin(xid);
+            for (int r = 0; r < records; r++) {
+              // 各线程修改不同的页面，只测试日志追加本身
+              value[0] = (Byte)r;
+              Rid rid = {(PageID)(k * 1000 + r % 50), (SlotID)r};
+              log_manager.InsertRecordLog(xid, table_id, rid, sizeof(value), value);
+            }
+            log_manager.Commit(xid);
+          }
+        });
+      }
+      for (auto &worker : workers) worker.join();
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      LogStatus after = log_manager.GetStatus();
+      double logs = (double)thread_count * txns * (records + 2);
+      std::cout << "threads " << thread_count << " logs/s " << (long long)(logs / seconds) << " reserve_retries "
+                << after.reserve_retries - before.reserve_retries << " buffer_full_waits "
+                << after.buffer_full_waits - before.buffer_full_waits << " flushes " << after.flushes - before.flushes
+                << "\n";
+    }
+    system_manager.CloseDatabase();
+  } catch (DbError &e) {
+    std::cerr << e.what() << std::endl;
+    system_manager.CloseDatabase();
+    return 1;
+  }
+  return 0;
+}
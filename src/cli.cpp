@@ -7,6 +7,7 @@
 #include "exception/exceptions.h"
 #include "parser/visitor.h"
 #include "result/printers.h"
+#include "system/config_manager.h"
 #include "system/system_manager.h"
 
 using namespace dbtrain;
@@ -50,14 +51,33 @@ void cli(std::unique_ptr<Printer> printer) {
   }
 }
 
+int verify(const std::string &db_name, std::unique_ptr<Printer> printer) {
+  try {
+    size_t corrupted_pages = 0;
+    Result result = SystemManager::GetInstance().VerifyDatabase(db_name, corrupted_pages);
+    printer->Print(&result);
+    return corrupted_pages > 0 ? 1 : 0;
+  } catch (DbError &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+}
+
 int main(int argc, char *argv[]) {
   signal(SIGINT, sigint_handler);
+  // 运行参数，例如 --buffer-size=1G
+  ConfigManager::GetInstance().Init(argc, argv);
   std::unique_ptr<Printer> printer;
   if (argc >= 2 && strcmp(argv[1], "-s") == 0) {
     printer = std::make_unique<RawPrinter>();
   } else {
     printer = std::make_unique<TablePrinter>();
   }
+  // --verify 校验所有数据库，--verify=<数据库名> 只校验该数据库，之后直接退出，存在损坏的页面时返回 1
+  if (ConfigManager::GetInstance().Has("verify")) {
+    std::string db_name = ConfigManager::GetInstance().GetString("verify", "on");
+    return verify(db_name == "on" ? "" : db_name, std::move(printer));
+  }
   cli(std::move(printer));
   return 0;
 }
@@ -34,14 +34,26 @@ static const int META_PAGE_NO = 0;
 static const std::string BASE_PATH = "dbtrain";
 static const std::string DB_META_SUFFIX = ".meta";
 static const std::string DB_DATA_SUFFIX = ".data";
+// 索引文件名为索引名加上该后缀，索引名在数据库内唯一
+static const std::string DB_INDEX_SUFFIX = ".index";
+// 压缩存放的数据文件的页面映射文件名为表名加上该后缀
+static const std::string DB_PAGE_MAP_SUFFIX = ".pmap";
 static const std::string MASTER_RECORD = "MASTER";
-static const std::string LOG_INDEX = "LOGIDX";
-static const std::string LOG_DATA = "LOGDATA";
+// double-write 打开时页面写回前先写入该文件
+static const std::string DOUBLE_WRITE_FILE = "DOUBLE_WRITE";
+// 日志段文件名为前缀加上段内第一条日志的 LSN
+static const std::string LOG_SEGMENT_PREFIX = "WAL_";
+// 截断后留待复用的段文件名为该前缀加上原文件名
+static const std::string LOG_RECYCLE_PREFIX = "FREE_";
+// wal-archive 打开时截断的日志段移动到数据库目录下的该目录中
+static const std::string LOG_ARCHIVE_DIR = "wal_archive";
 
 static const PageID NULL_PAGE = 0xFFFFFFFF;
 static const XID INIT_XID = 0x0001;
 static const LSN INIT_LSN = 0x0001;
 static const XID INVALID_XID = 0x0;
+// 表编号从 1 开始分配
+static const TableID INVALID_TABLE_ID = 0;
 
 static const int BITMAP_WIDTH = 8;
 
@@ -37,6 +37,24 @@ class UnknownError : public DbError {
   UnknownError() : DbError("Unknown Error") { perror("Error"); }
 };
 
+class PageCorruptedError : public DbError {
+ public:
+  PageCorruptedError(const std::string &filename, unsigned int page_no)
+      : DbError("Page " + std::to_string(page_no) + " of " + filename + " failed checksum verification") {}
+};
+
+class LogCorruptedError : public DbError {
+ public:
+  LogCorruptedError(const std::string &filename, unsigned int lsn)
+      : DbError("Log " + std::to_string(lsn) + " in " + filename + " is missing or failed checksum verification") {}
+};
+
+class InvalidConfigError : public DbError {
+ public:
+  InvalidConfigError(const std::string &key, const std::string &value)
+      : DbError("Invalid config value '" + value + "' for " + key) {}
+};
+
 class DropUsingDatabaseError : public DbError {
  public:
   DropUsingDatabaseError() : DbError("Cannot drop the currently open database") {}
@@ -52,6 +70,16 @@ class DatabaseExistsError : public DbError {
   DatabaseExistsError(std::string db_name) : DbError("Database '" + db_name + "' already exists") {}
 };
 
+class ReadOnlyError : public DbError {
+ public:
+  ReadOnlyError() : DbError("Database is opened read-only") {}
+};
+
+class VacuumInTransactionError : public DbError {
+ public:
+  VacuumInTransactionError() : DbError("VACUUM cannot run inside a transaction") {}
+};
+
 class NoUsingDatabaseError : public DbError {
  public:
   NoUsingDatabaseError() : DbError("No database selected") {}
@@ -72,6 +100,27 @@ class TableNotExistsError : public DbError {
   TableNotExistsError(std::string table_name) : DbError("Table '" + table_name + "' doesn't exist") {}
 };
 
+class IndexExistsError : public DbError {
+ public:
+  IndexExistsError(std::string index_name) : DbError("Index '" + index_name + "' already exists") {}
+};
+
+class IndexNotExistsError : public DbError {
+ public:
+  IndexNotExistsError(std::string index_name) : DbError("Index '" + index_name + "' doesn't exist") {}
+};
+
+class InvalidIndexColumnError : public DbError {
+ public:
+  InvalidIndexColumnError(std::string col_name, std::string col_type)
+      : DbError("Cannot index column " + col_name + " of type " + col_type) {}
+};
+
+class InvalidIndexTypeError : public DbError {
+ public:
+  InvalidIndexTypeError(std::string index_type) : DbError("Invalid index type '" + index_type + "'") {}
+};
+
 class InvalidInsertCountError : public DbError {
  public:
   InvalidInsertCountError(size_t insert_size, size_t col_size)
@@ -98,6 +147,19 @@ class InvalidInsertStringLenError : public DbError {
                 ", column length: " + std::to_string(col_len)) {}
 };
 
+class RecordTooLongError : public DbError {
+ public:
+  RecordTooLongError(size_t record_len, size_t max_len)
+      : DbError("Record too long: " + std::to_string(record_len) + " bytes, page capacity: " +
+                std::to_string(max_len) + " bytes") {}
+};
+
+class InvalidTableOptionError : public DbError {
+ public:
+  InvalidTableOptionError(const std::string &key, const std::string &value)
+      : DbError("Invalid table option " + key + " = '" + value + "'") {}
+};
+
 class DuplicateColumnError : public DbError {
  public:
   DuplicateColumnError(std::string col_name) : DbError("Duplicate column " + col_name) {}
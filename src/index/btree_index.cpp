@@ -0,0 +1,266 @@
+#include "btree_index.h"
+
+#include <mutex>
+
+#include "../log/log_manager.h"
+
+namespace dbtrain {
+
+BTreeIndex::BTreeIndex(const std::string &index_name, int fd) : Index(index_name, fd) {
+  inner_entry_size_ = entry_size_ + sizeof(PageID);
+}
+
+BTreeIndex::BTreeIndex(const std::string &index_name, int fd, TableID index_id, TableID table_id, int column,
+                       FieldType type, int col_len)
+    : Index(index_name, fd, index_id, table_id, column, IndexType::BTREE, type, col_len) {
+  inner_entry_size_ = entry_size_ + sizeof(PageID);
+  // 第 1 页为空的根节点
+  ExtendTo(2);
+  {
+    PageGuard meta_page = buffer_manager_.GetPage(fd_, META_PAGE_NO);
+    IndexMeta *meta = GetIndexMeta(meta_page->GetData());
+    meta->root = 1;
+    meta->page_end = 2;
+    meta_page->SetDirty();
+    PageGuard root_page = buffer_manager_.GetPage(fd_, 1);
+    IndexNodeHeader *root = GetNodeHeader(root_page->GetData());
+    root->leaf = 1;
+    root->count = 0;
+    root->link = NULL_PAGE;
+    root_page->SetDirty();
+  }
+  FlushNew();
+}
+
+bool BTreeIndex::SupportsRange() const { return true; }
+
+size_t BTreeIndex::EntrySize(const Byte *node) const {
+  return ((const IndexNodeHeader *)(node + sizeof(PageHeader)))->leaf ? entry_size_ : inner_entry_size_;
+}
+
+size_t BTreeIndex::Capacity(size_t entry_size) const { return (PAGE_SIZE - INDEX_NODE_DATA) / entry_size; }
+
+size_t BTreeIndex::LowerBound(const Byte *node, const Byte *entry) const {
+  size_t entry_size = EntrySize(node);
+  size_t low = 0, high = ((const IndexNodeHeader *)(node + sizeof(PageHeader)))->count;
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    if (CompareEntry(node + INDEX_NODE_DATA + mid * entry_size, entry) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+PageID BTreeIndex::FindChild(const Byte *node, const Byte *entry) const {
+  const IndexNodeHeader *header = (const IndexNodeHeader *)(node + sizeof(PageHeader));
+  if (entry == nullptr) return header->link;
+  // 最后一个不大于 entry 的项的子节点，没有时为最左侧的子节点
+  size_t low = 0, high = header->count;
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    if (CompareEntry(node + INDEX_NODE_DATA + mid * inner_entry_size_, entry) <= 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low == 0) return header->link;
+  PageID child;
+  memcpy(&child, node + INDEX_NODE_DATA + (low - 1) * inner_entry_size_ + entry_size_, sizeof(PageID));
+  return child;
+}
+
+PageID BTreeIndex::FindLeaf(const Byte *entry, std::vector<PageID> *path) {
+  PageGuard meta_page = GetNode(META_PAGE_NO);
+  meta_page->RLatch();
+  PageID page_no = GetIndexMeta(meta_page->GetData())->root;
+  meta_page->RUnlatch();
+  while (true) {
+    PageGuard page = GetNode(page_no);
+    page->RLatch();
+    const Byte *data = page->GetData();
+    if (GetNodeHeader(page->GetData())->leaf) {
+      page->RUnlatch();
+      return page_no;
+    }
+    if (path != nullptr) path->push_back(page_no);
+    PageID child = FindChild(data, entry);
+    page->RUnlatch();
+    page_no = child;
+  }
+}
+
+void BTreeIndex::Insert(XID xid, const Field *field, const Rid &rid) {
+  std::vector<Byte> entry(entry_size_);
+  MakeKey(field, entry.data());
+  memcpy(entry.data() + key_size_, &rid, sizeof(Rid));
+  std::unique_lock<std::shared_mutex> index_lock(index_mutex_);
+  std::vector<PageID> path;
+  PageID leaf = FindLeaf(entry.data(), &path);
+  size_t pos, count;
+  bool exists;
+  {
+    PageGuard page = GetNode(leaf);
+    page->RLatch();
+    const Byte *data = page->GetData();
+    count = GetNodeHeader(page->GetData())->count;
+    pos = LowerBound(data, entry.data());
+    exists = pos < count && CompareEntry(data + INDEX_NODE_DATA + pos * entry_size_, entry.data()) == 0;
+    page->RUnlatch();
+  }
+  if (exists) return;
+  if (count < Capacity(entry_size_)) {
+    IndexPageOp op = {IndexPageOp::Type::INSERT, leaf, pos, entry_size_, {}, entry};
+    LogManager::GetInstance().IndexPageLog(xid, index_id_, {op});
+    return;
+  }
+  SplitInsert(xid, leaf, path, entry.data());
+}
+
+void BTreeIndex::SplitInsert(XID xid, PageID leaf, const std::vector<PageID> &path, const Byte *entry) {
+  PageImages images(this, xid);
+
+  std::vector<Byte> carry(entry, entry + entry_size_);
+  PageID node = leaf;
+  size_t level = path.size();
+  while (true) {
+    Byte *data = images.Get(node);
+    IndexNodeHeader *header = GetNodeHeader(data);
+    size_t entry_size = EntrySize(data);
+    size_t pos = LowerBound(data, carry.data());
+    if (header->count < Capacity(entry_size)) {
+      InsertNodeEntry(data, pos, carry.data(), entry_size);
+      break;
+    }
+    // 插入后的所有项平分到原节点与其右侧的新节点
+    size_t total = header->count + 1;
+    std::vector<Byte> entries(total * entry_size);
+    memcpy(entries.data(), GetNodeEntry(data, 0, entry_size), pos * entry_size);
+    memcpy(entries.data() + pos * entry_size, carry.data(), entry_size);
+    memcpy(entries.data() + (pos + 1) * entry_size, GetNodeEntry(data, pos, entry_size),
+           (header->count - pos) * entry_size);
+    PageID right = images.Alloc();
+    Byte *right_data = images.Get(right);
+    IndexNodeHeader *right_header = GetNodeHeader(right_data);
+    size_t mid = total / 2;
+    std::vector<Byte> separator(inner_entry_size_);
+    if (header->leaf) {
+      right_header->leaf = 1;
+      right_header->count = total - mid;
+      right_header->link = header->link;
+      memcpy(GetNodeEntry(right_data, 0, entry_size), entries.data() + mid * entry_size, (total - mid) * entry_size);
+      header->link = right;
+      memcpy(separator.data(), entries.data() + mid * entry_size, entry_size_);
+    } else {
+      // 中间项上移到父节点，其子节点成为右侧新节点最左侧的子节点
+      const Byte *pushed = entries.data() + mid * entry_size;
+      right_header->leaf = 0;
+      right_header->count = total - mid - 1;
+      memcpy(&right_header->link, pushed + entry_size_, sizeof(PageID));
+      memcpy(GetNodeEntry(right_data, 0, entry_size), pushed + entry_size, (total - mid - 1) * entry_size);
+      memcpy(separator.data(), pushed, entry_size_);
+    }
+    header->count = mid;
+    memcpy(GetNodeEntry(data, 0, entry_size), entries.data(), mid * entry_size);
+    memcpy(separator.data() + entry_size_, &right, sizeof(PageID));
+    carry = separator;
+    if (level == 0) {
+      // 根节点分裂，新的根节点只有一项
+      PageID root = images.Alloc();
+      Byte *root_data = images.Get(root);
+      IndexNodeHeader *root_header = GetNodeHeader(root_data);
+      root_header->leaf = 0;
+      root_header->count = 0;
+      root_header->link = node;
+      InsertNodeEntry(root_data, 0, carry.data(), inner_entry_size_);
+      GetIndexMeta(images.Get(META_PAGE_NO))->root = root;
+      break;
+    }
+    node = path[--level];
+  }
+
+  images.Log();
+}
+
+std::vector<Rid> BTreeIndex::Scan(const Field *low, const Field *high) {
+  std::vector<Byte> low_entry(entry_size_, 0), high_key(key_size_);
+  if (low != nullptr) MakeKey(low, low_entry.data());
+  if (high != nullptr) MakeKey(high, high_key.data());
+  std::vector<Rid> rids;
+  std::shared_lock<std::shared_mutex> index_lock(index_mutex_);
+  // 从可能包含 (low, 最小的记录位置) 的叶节点开始向右扫描
+  PageID leaf = FindLeaf(low != nullptr ? low_entry.data() : nullptr, nullptr);
+  while (leaf != NULL_PAGE) {
+    PageGuard page = GetNode(leaf);
+    page->RLatch();
+    const Byte *data = page->GetData();
+    size_t count = GetNodeHeader(page->GetData())->count;
+    bool done = false;
+    for (size_t pos = 0; pos < count; pos++) {
+      const Byte *entry = data + INDEX_NODE_DATA + pos * entry_size_;
+      if (low != nullptr && CompareKey(entry, low_entry.data()) < 0) continue;
+      if (high != nullptr && CompareKey(entry, high_key.data()) > 0) {
+        done = true;
+        break;
+      }
+      Rid rid;
+      memcpy(&rid, entry + key_size_, sizeof(Rid));
+      rids.push_back(rid);
+    }
+    leaf = done ? NULL_PAGE : GetNodeHeader(page->GetData())->link;
+    page->RUnlatch();
+  }
+  return rids;
+}
+
+size_t BTreeIndex::BulkDelete(XID xid, const std::function<bool(const Byte *key, const Rid &rid)> &dead) {
+  PageID leaf;
+  {
+    std::shared_lock<std::shared_mutex> index_lock(index_mutex_);
+    leaf = FindLeaf(nullptr, nullptr);
+  }
+  // 节点只向右分裂，逐个叶节点加锁时不会漏掉移动到新节点中的项
+  size_t deleted = 0;
+  while (leaf != NULL_PAGE) {
+    std::unique_lock<std::shared_mutex> index_lock(index_mutex_);
+    std::vector<Byte> data = CopyNode(leaf);
+    const IndexNodeHeader *header = GetNodeHeader(data.data());
+    std::vector<IndexPageOp> ops;
+    for (size_t pos = header->count; pos-- > 0;) {
+      const Byte *entry = GetNodeEntry(data.data(), pos, entry_size_);
+      Rid rid;
+      memcpy(&rid, entry + key_size_, sizeof(Rid));
+      if (dead(entry, rid)) ops.push_back({IndexPageOp::Type::DELETE, leaf, pos, entry_size_, {}, {}});
+    }
+    deleted += ops.size();
+    if (!ops.empty()) LogManager::GetInstance().IndexPageLog(xid, index_id_, std::move(ops));
+    leaf = header->link;
+  }
+  return deleted;
+}
+
+IndexStats BTreeIndex::GetStats() {
+  IndexStats stats = {0, 0, 0, false};
+  std::shared_lock<std::shared_mutex> index_lock(index_mutex_);
+  std::vector<Byte> meta = CopyNode(META_PAGE_NO);
+  stats.pages = GetIndexMeta(meta.data())->page_end;
+  stats.valid = GetIndexMeta(meta.data())->valid != 0;
+  PageID page_no = GetIndexMeta(meta.data())->root;
+  while (true) {
+    std::vector<Byte> data = CopyNode(page_no);
+    stats.height++;
+    if (GetNodeHeader(data.data())->leaf) break;
+    page_no = GetNodeHeader(data.data())->link;
+  }
+  while (page_no != NULL_PAGE) {
+    std::vector<Byte> data = CopyNode(page_no);
+    stats.entries += GetNodeHeader(data.data())->count;
+    page_no = GetNodeHeader(data.data())->link;
+  }
+  return stats;
+}
+
+}  // namespace dbtrain
@@ -0,0 +1,42 @@
+#ifndef DBTRAIN_BTREE_INDEX_H
+#define DBTRAIN_BTREE_INDEX_H
+
+#include "index.h"
+
+namespace dbtrain {
+
+// B+ 树索引，项按键与记录位置排序，支持等值与范围扫描
+class BTreeIndex : public Index {
+ public:
+  // 打开已有的索引文件
+  BTreeIndex(const std::string &index_name, int fd);
+  // 新建索引文件，写入元信息与空的根节点后落盘，建立完成并调用 SetValid 前索引无效
+  BTreeIndex(const std::string &index_name, int fd, TableID index_id, TableID table_id, int column, FieldType type,
+             int col_len);
+  ~BTreeIndex() = default;
+
+  bool SupportsRange() const override;
+  void Insert(XID xid, const Field *field, const Rid &rid) override;
+  std::vector<Rid> Scan(const Field *low, const Field *high) override;
+  size_t BulkDelete(XID xid, const std::function<bool(const Byte *key, const Rid &rid)> &dead) override;
+  IndexStats GetStats() override;
+
+ private:
+  // 内部节点的项另有子节点页号
+  size_t inner_entry_size_;
+
+  size_t EntrySize(const Byte *node) const;
+  size_t Capacity(size_t entry_size) const;
+  // 节点中第一个不小于 entry 的项的位置
+  size_t LowerBound(const Byte *node, const Byte *entry) const;
+  // 内部节点中应包含 entry 的子节点
+  PageID FindChild(const Byte *node, const Byte *entry) const;
+  // 从根节点下降到应包含 entry 的叶节点，path 不为空时记录经过的内部节点
+  PageID FindLeaf(const Byte *entry, std::vector<PageID> *path);
+  // 插入需要分裂节点时在页面副本上完成修改，再把所有页面的差异记为一条日志
+  void SplitInsert(XID xid, PageID leaf, const std::vector<PageID> &path, const Byte *entry);
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_BTREE_INDEX_H
@@ -0,0 +1,293 @@
+#include "hash_index.h"
+
+#include <iostream>
+#include <mutex>
+#include <set>
+
+#include "../exception/exceptions.h"
+#include "../log/log_manager.h"
+#include "../utils/crc32c.h"
+
+namespace dbtrain {
+
+HashIndex::HashIndex(const std::string &index_name, int fd) : Index(index_name, fd) {
+  capacity_ = (PAGE_SIZE - INDEX_NODE_DATA) / entry_size_;
+}
+
+HashIndex::HashIndex(const std::string &index_name, int fd, TableID index_id, TableID table_id, int column,
+                     FieldType type, int col_len)
+    : Index(index_name, fd, index_id, table_id, column, IndexType::HASH, type, col_len) {
+  capacity_ = (PAGE_SIZE - INDEX_NODE_DATA) / entry_size_;
+  // 第 1 页为目录页，全局深度为 0 时只有一项，指向第 2 页的空桶
+  ExtendTo(3);
+  {
+    PageGuard meta_page = buffer_manager_.GetPage(fd_, META_PAGE_NO);
+    IndexMeta *meta = GetIndexMeta(meta_page->GetData());
+    meta->page_end = 3;
+    meta->global_depth = 0;
+    meta->dir_pages = 1;
+    GetDirPages(meta_page->GetData())[0] = 1;
+    meta_page->SetDirty();
+    PageGuard dir_page = buffer_manager_.GetPage(fd_, 1);
+    GetDirEntries(dir_page->GetData())[0] = 2;
+    dir_page->SetDirty();
+    PageGuard bucket_page = buffer_manager_.GetPage(fd_, 2);
+    HashBucketHeader *bucket = GetBucketHeader(bucket_page->GetData());
+    bucket->local_depth = 0;
+    bucket->count = 0;
+    bucket->next = NULL_PAGE;
+    bucket_page->SetDirty();
+  }
+  FlushNew();
+}
+
+bool HashIndex::SupportsRange() const { return false; }
+
+uint32_t HashIndex::Hash(const Byte *key) const { return Crc32c(key, key_size_); }
+
+PageID HashIndex::FindBucket(uint32_t hash) {
+  PageGuard meta_page = GetNode(META_PAGE_NO);
+  meta_page->RLatch();
+  IndexMeta *meta = GetIndexMeta(meta_page->GetData());
+  size_t slot = hash & ((1u << meta->global_depth) - 1);
+  PageID dir_page_no = GetDirPages(meta_page->GetData())[slot / HASH_DIR_ENTRIES];
+  meta_page->RUnlatch();
+  PageGuard dir_page = GetNode(dir_page_no);
+  dir_page->RLatch();
+  PageID bucket = GetDirEntries(dir_page->GetData())[slot % HASH_DIR_ENTRIES];
+  dir_page->RUnlatch();
+  return bucket;
+}
+
+std::vector<PageID> HashIndex::ListBuckets() {
+  std::vector<Byte> meta = CopyNode(META_PAGE_NO);
+  size_t dir_size = (size_t)1 << GetIndexMeta(meta.data())->global_depth;
+  std::set<PageID> buckets;
+  for (size_t i = 0; i * HASH_DIR_ENTRIES < dir_size; i++) {
+    std::vector<Byte> dir = CopyNode(GetDirPages(meta.data())[i]);
+    size_t count = std::min(dir_size - i * HASH_DIR_ENTRIES, HASH_DIR_ENTRIES);
+    buckets.insert(GetDirEntries(dir.data()), GetDirEntries(dir.data()) + count);
+  }
+  return std::vector<PageID>(buckets.begin(), buckets.end());
+}
+
+void HashIndex::Insert(XID xid, const Field *field, const Rid &rid) {
+  std::vector<Byte> entry(entry_size_);
+  MakeKey(field, entry.data());
+  memcpy(entry.data() + key_size_, &rid, sizeof(Rid));
+  uint32_t hash = Hash(entry.data());
+  std::unique_lock<std::shared_mutex> index_lock(index_mutex_);
+  while (true) {
+    PageID bucket = FindBucket(hash);
+    // 在桶与其溢出页中查找相同的项与空位
+    PageID page_no = bucket, last = bucket, free_page = NULL_PAGE;
+    size_t free_pos = 0;
+    bool same_hash = true;
+    uint8_t local_depth = 0;
+    while (page_no != NULL_PAGE) {
+      std::vector<Byte> data = CopyNode(page_no);
+      HashBucketHeader *header = GetBucketHeader(data.data());
+      if (page_no == bucket) local_depth = header->local_depth;
+      for (size_t pos = 0; pos < header->count; pos++) {
+        const Byte *other = GetNodeEntry(data.data(), pos, entry_size_);
+        if (CompareEntry(other, entry.data()) == 0) return;
+        if (Hash(other) != hash) same_hash = false;
+      }
+      if (free_page == NULL_PAGE && header->count < capacity_) {
+        free_page = page_no;
+        free_pos = header->count;
+      }
+      last = page_no;
+      page_no = header->next;
+    }
+    if (free_page != NULL_PAGE) {
+      IndexPageOp op = {IndexPageOp::Type::INSERT, free_page, free_pos, entry_size_, {}, entry};
+      LogManager::GetInstance().IndexPageLog(xid, index_id_, {op});
+      return;
+    }
+    std::vector<Byte> meta = CopyNode(META_PAGE_NO);
+    bool split = !same_hash;
+    if (split && local_depth == GetIndexMeta(meta.data())->global_depth) split = DoubleDirectory(xid);
+    if (split) {
+      SplitBucket(xid, bucket, hash);
+      continue;
+    }
+    // 分裂不能分开桶中的项时链接溢出页
+    PageImages images(this, xid);
+    PageID overflow = images.Alloc();
+    HashBucketHeader *overflow_header = GetBucketHeader(images.Get(overflow));
+    overflow_header->local_depth = local_depth;
+    overflow_header->count = 1;
+    overflow_header->next = NULL_PAGE;
+    memcpy(GetNodeEntry(images.Get(overflow), 0, entry_size_), entry.data(), entry_size_);
+    GetBucketHeader(images.Get(last))->next = overflow;
+    images.Log();
+    return;
+  }
+}
+
+bool HashIndex::DoubleDirectory(XID xid) {
+  std::vector<Byte> meta = CopyNode(META_PAGE_NO);
+  uint8_t global_depth = GetIndexMeta(meta.data())->global_depth;
+  size_t dir_size = (size_t)1 << global_depth;
+  size_t dir_pages = GetIndexMeta(meta.data())->dir_pages;
+  if (dir_size < HASH_DIR_ENTRIES) {
+    // 目录在第一个目录页中，后一半复制前一半
+    PageImages images(this, xid);
+    PageID *entries = GetDirEntries(images.Get(GetDirPages(meta.data())[0]));
+    memcpy(entries + dir_size, entries, dir_size * sizeof(PageID));
+    GetIndexMeta(images.Get(META_PAGE_NO))->global_depth++;
+    images.Log();
+    return true;
+  }
+  if (dir_pages * 2 > HASH_MAX_DIR_PAGES) return false;
+  // 逐页复制目录，新目录页在更新元信息之前不会被访问，每页一条日志
+  std::vector<PageID> new_pages;
+  for (size_t i = 0; i < dir_pages; i++) {
+    std::vector<Byte> dir = CopyNode(GetDirPages(meta.data())[i]);
+    PageImages images(this, xid);
+    PageID page_no = images.Alloc();
+    memcpy(GetDirEntries(images.Get(page_no)), GetDirEntries(dir.data()), HASH_DIR_ENTRIES * sizeof(PageID));
+    images.Log();
+    new_pages.push_back(page_no);
+  }
+  PageImages images(this, xid);
+  Byte *meta_data = images.Get(META_PAGE_NO);
+  memcpy(GetDirPages(meta_data) + dir_pages, new_pages.data(), dir_pages * sizeof(PageID));
+  GetIndexMeta(meta_data)->dir_pages = dir_pages * 2;
+  GetIndexMeta(meta_data)->global_depth++;
+  images.Log();
+  return true;
+}
+
+void HashIndex::SplitBucket(XID xid, PageID bucket, uint32_t hash) {
+  PageImages images(this, xid);
+  Byte *meta = images.Get(META_PAGE_NO);
+  uint8_t global_depth = GetIndexMeta(meta)->global_depth;
+  uint8_t local_depth = GetBucketHeader(images.Get(bucket))->local_depth;
+  uint32_t bit = 1u << local_depth;
+  // 收集桶与溢出页中的所有项，按第 local_depth 位分开
+  std::vector<PageID> pages;
+  std::vector<Byte> low_entries, high_entries;
+  for (PageID page_no = bucket; page_no != NULL_PAGE; page_no = GetBucketHeader(images.Get(page_no))->next) {
+    Byte *data = images.Get(page_no);
+    pages.push_back(page_no);
+    for (size_t pos = 0; pos < GetBucketHeader(data)->count; pos++) {
+      const Byte *entry = GetNodeEntry(data, pos, entry_size_);
+      std::vector<Byte> &side = (Hash(entry) & bit) ? high_entries : low_entries;
+      side.insert(side.end(), entry, entry + entry_size_);
+    }
+  }
+  // 原桶与溢出页依次用于两个新桶，不够时分配新页面
+  size_t next_page = 0;
+  auto write_chain = [&](const std::vector<Byte> &entries) -> PageID {
+    size_t count = entries.size() / entry_size_;
+    PageID first = NULL_PAGE, prev = NULL_PAGE;
+    size_t written = 0;
+    do {
+      PageID page_no = next_page < pages.size() ? pages[next_page++] : images.Alloc();
+      HashBucketHeader *header = GetBucketHeader(images.Get(page_no));
+      size_t n = std::min(count - written, capacity_);
+      header->local_depth = local_depth + 1;
+      header->count = n;
+      header->next = NULL_PAGE;
+      memcpy(GetNodeEntry(images.Get(page_no), 0, entry_size_), entries.data() + written * entry_size_,
+             n * entry_size_);
+      written += n;
+      if (prev == NULL_PAGE) {
+        first = page_no;
+      } else {
+        GetBucketHeader(images.Get(prev))->next = page_no;
+      }
+      prev = page_no;
+    } while (written < count);
+    return first;
+  };
+  write_chain(low_entries);
+  PageID high_bucket = write_chain(high_entries);
+  // 低 local_depth 位与原桶相同且第 local_depth 位为 1 的目录项指向新桶
+  size_t dir_size = (size_t)1 << global_depth;
+  for (size_t slot = (hash & (bit - 1)) | bit; slot < dir_size; slot += bit << 1) {
+    Byte *dir = images.Get(GetDirPages(meta)[slot / HASH_DIR_ENTRIES]);
+    GetDirEntries(dir)[slot % HASH_DIR_ENTRIES] = high_bucket;
+  }
+  images.Log();
+}
+
+std::vector<Rid> HashIndex::Scan(const Field *low, const Field *high) {
+  std::vector<Byte> key(key_size_);
+  if (low == nullptr || high == nullptr) {
+    std::cerr << "Error in HashIndex::Scan\n";
+    throw UnknownError();
+  }
+  MakeKey(low, key.data());
+  if (!KeyEquals(key.data(), high)) {
+    std::cerr << "Error in HashIndex::Scan\n";
+    throw UnknownError();
+  }
+  uint32_t hash = Hash(key.data());
+  std::vector<Rid> rids;
+  std::shared_lock<std::shared_mutex> index_lock(index_mutex_);
+  PageID page_no = FindBucket(hash);
+  while (page_no != NULL_PAGE) {
+    PageGuard page = GetNode(page_no);
+    page->RLatch();
+    Byte *data = page->GetData();
+    for (size_t pos = 0; pos < GetBucketHeader(data)->count; pos++) {
+      const Byte *entry = GetNodeEntry(data, pos, entry_size_);
+      if (CompareKey(entry, key.data()) != 0) continue;
+      Rid rid;
+      memcpy(&rid, entry + key_size_, sizeof(Rid));
+      rids.push_back(rid);
+    }
+    page_no = GetBucketHeader(data)->next;
+    page->RUnlatch();
+  }
+  return rids;
+}
+
+size_t HashIndex::BulkDelete(XID xid, const std::function<bool(const Byte *key, const Rid &rid)> &dead) {
+  std::vector<PageID> buckets;
+  {
+    std::shared_lock<std::shared_mutex> index_lock(index_mutex_);
+    buckets = ListBuckets();
+  }
+  // 逐页加锁，期间分裂移动的项可能被跳过，留给下一次清理
+  size_t deleted = 0;
+  for (PageID page_no : buckets) {
+    while (page_no != NULL_PAGE) {
+      std::unique_lock<std::shared_mutex> index_lock(index_mutex_);
+      std::vector<Byte> data = CopyNode(page_no);
+      const HashBucketHeader *header = GetBucketHeader(data.data());
+      std::vector<IndexPageOp> ops;
+      for (size_t pos = header->count; pos-- > 0;) {
+        const Byte *entry = GetNodeEntry(data.data(), pos, entry_size_);
+        Rid rid;
+        memcpy(&rid, entry + key_size_, sizeof(Rid));
+        if (dead(entry, rid)) ops.push_back({IndexPageOp::Type::DELETE, page_no, pos, entry_size_, {}, {}});
+      }
+      deleted += ops.size();
+      if (!ops.empty()) LogManager::GetInstance().IndexPageLog(xid, index_id_, std::move(ops));
+      page_no = header->next;
+    }
+  }
+  return deleted;
+}
+
+IndexStats HashIndex::GetStats() {
+  IndexStats stats = {0, 2, 0, false};
+  std::shared_lock<std::shared_mutex> index_lock(index_mutex_);
+  std::vector<Byte> meta = CopyNode(META_PAGE_NO);
+  stats.pages = GetIndexMeta(meta.data())->page_end;
+  stats.valid = GetIndexMeta(meta.data())->valid != 0;
+  for (PageID page_no : ListBuckets()) {
+    while (page_no != NULL_PAGE) {
+      std::vector<Byte> data = CopyNode(page_no);
+      stats.entries += GetBucketHeader(data.data())->count;
+      page_no = GetBucketHeader(data.data())->next;
+    }
+  }
+  return stats;
+}
+
+}  // namespace dbtrain
@@ -0,0 +1,43 @@
+#ifndef DBTRAIN_HASH_INDEX_H
+#define DBTRAIN_HASH_INDEX_H
+
+#include "index.h"
+
+namespace dbtrain {
+
+// 可扩展哈希索引，只支持等值查找
+// 目录以键的哈希值低 global_depth 位定位桶页，桶放满时只分裂该桶，局部深度等于全局深度时先将目录加倍
+// 同一桶中的项哈希值均相同而无法分裂时链接溢出页
+class HashIndex : public Index {
+ public:
+  // 打开已有的索引文件
+  HashIndex(const std::string &index_name, int fd);
+  // 新建索引文件，写入元信息、一个目录页与一个空桶后落盘
+  HashIndex(const std::string &index_name, int fd, TableID index_id, TableID table_id, int column, FieldType type,
+            int col_len);
+  ~HashIndex() = default;
+
+  bool SupportsRange() const override;
+  void Insert(XID xid, const Field *field, const Rid &rid) override;
+  // low 与 high 需为同一个键
+  std::vector<Rid> Scan(const Field *low, const Field *high) override;
+  size_t BulkDelete(XID xid, const std::function<bool(const Byte *key, const Rid &rid)> &dead) override;
+  IndexStats GetStats() override;
+
+ private:
+  size_t capacity_;
+
+  uint32_t Hash(const Byte *key) const;
+  // 哈希值对应的桶页
+  PageID FindBucket(uint32_t hash);
+  // 目录中不同的桶页
+  std::vector<PageID> ListBuckets();
+  // 目录加倍，目录页数达到上限时返回 false
+  bool DoubleDirectory(XID xid);
+  // 把包含哈希值 hash 的桶的所有项按下一位分到两个桶中
+  void SplitBucket(XID xid, PageID bucket, uint32_t hash);
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_HASH_INDEX_H
@@ -0,0 +1,202 @@
+#include "index.h"
+
+#include <iostream>
+#include <mutex>
+
+#include "../exception/exceptions.h"
+#include "../log/log_manager.h"
+#include "../record/fields.h"
+#include "../storage/disk_manager.h"
+
+namespace dbtrain {
+
+Index::Index(const std::string &index_name, int fd)
+    : index_name_(index_name), fd_(fd), buffer_manager_(BufferManager::GetInstance()) {
+  file_end_ = DiskManager::GetInstance().FileSize(fd_) / PAGE_SIZE;
+  // 元信息中的编号、列与键在新建时写入后不再改变
+  PageGuard meta_page = buffer_manager_.GetPage(fd_, META_PAGE_NO);
+  IndexMeta *meta = GetIndexMeta(meta_page->GetData());
+  index_id_ = meta->index_id;
+  table_id_ = meta->table_id;
+  column_ = meta->column;
+  type_ = (IndexType)meta->type;
+  key_type_ = (FieldType)meta->key_type;
+  key_size_ = meta->key_size;
+  entry_size_ = key_size_ + sizeof(Rid);
+}
+
+Index::Index(const std::string &index_name, int fd, TableID index_id, TableID table_id, int column, IndexType type,
+             FieldType key_type, int col_len)
+    : index_name_(index_name),
+      fd_(fd),
+      index_id_(index_id),
+      table_id_(table_id),
+      column_(column),
+      type_(type),
+      key_type_(key_type),
+      buffer_manager_(BufferManager::GetInstance()) {
+  if (key_type == FieldType::INT) {
+    key_size_ = sizeof(int);
+  } else if (key_type == FieldType::FLOAT) {
+    key_size_ = sizeof(double);
+  } else {
+    key_size_ = std::min<size_t>(col_len, INDEX_KEY_MAX_SIZE);
+  }
+  entry_size_ = key_size_ + sizeof(Rid);
+  // 第 0 页为元信息，新建时不记日志，由子类写入初始页面后直接落盘
+  file_end_ = 0;
+  ExtendTo(1);
+  PageGuard meta_page = buffer_manager_.GetPage(fd_, META_PAGE_NO);
+  IndexMeta *meta = GetIndexMeta(meta_page->GetData());
+  meta->index_id = index_id_;
+  meta->table_id = table_id_;
+  meta->column = column_;
+  meta->key_type = (uint8_t)key_type_;
+  meta->key_size = key_size_;
+  meta->root = NULL_PAGE;
+  meta->page_end = 1;
+  meta->valid = 0;
+  meta->type = (uint8_t)type_;
+  meta->global_depth = 0;
+  meta->dir_pages = 0;
+  meta_page->SetDirty();
+}
+
+Index::~Index() { buffer_manager_.FlushFile(fd_); }
+
+void Index::FlushNew() {
+  buffer_manager_.FlushFile(fd_);
+  DiskManager::GetInstance().FlushFile(fd_);
+}
+
+std::string Index::GetName() const { return index_name_; }
+
+TableID Index::GetID() const { return index_id_; }
+
+TableID Index::GetTableID() const { return table_id_; }
+
+int Index::GetColumn() const { return column_; }
+
+IndexType Index::GetType() const { return type_; }
+
+bool Index::IsValid() {
+  PageGuard meta_page = GetNode(META_PAGE_NO);
+  meta_page->RLatch();
+  bool valid = GetIndexMeta(meta_page->GetData())->valid != 0;
+  meta_page->RUnlatch();
+  return valid;
+}
+
+void Index::SetValid(XID xid) {
+  std::unique_lock<std::shared_mutex> index_lock(index_mutex_);
+  PageImages images(this, xid);
+  GetIndexMeta(images.Get(META_PAGE_NO))->valid = 1;
+  images.Log();
+}
+
+bool Index::Accepts(const Field *field) const {
+  return field->GetType() == key_type_ || (key_type_ == FieldType::FLOAT && field->GetType() == FieldType::INT);
+}
+
+void Index::MakeKey(const Field *field, Byte *key) const {
+  if (key_type_ == FieldType::INT) {
+    int value = dynamic_cast<const IntField *>(field)->GetValue();
+    memcpy(key, &value, sizeof(int));
+  } else if (key_type_ == FieldType::FLOAT) {
+    double value = field->GetType() == FieldType::INT ? dynamic_cast<const IntField *>(field)->GetValue()
+                                                       : dynamic_cast<const FloatField *>(field)->GetValue();
+    // -0.0 与 0.0 相等，哈希索引按键的字节计算哈希值
+    if (value == 0) value = 0;
+    memcpy(key, &value, sizeof(double));
+  } else {
+    // 以 0 补齐的前缀按字节比较，与字符串的字典序一致
+    std::string value = dynamic_cast<const StrField *>(field)->GetValue();
+    memset(key, 0, key_size_);
+    memcpy(key, value.c_str(), std::min(strlen(value.c_str()), key_size_));
+  }
+}
+
+int Index::CompareKey(const Byte *a, const Byte *b) const {
+  if (key_type_ == FieldType::INT) {
+    int x, y;
+    memcpy(&x, a, sizeof(int));
+    memcpy(&y, b, sizeof(int));
+    return x < y ? -1 : (x > y ? 1 : 0);
+  } else if (key_type_ == FieldType::FLOAT) {
+    double x, y;
+    memcpy(&x, a, sizeof(double));
+    memcpy(&y, b, sizeof(double));
+    return x < y ? -1 : (x > y ? 1 : 0);
+  }
+  return memcmp(a, b, key_size_);
+}
+
+int Index::CompareEntry(const Byte *a, const Byte *b) const {
+  int result = CompareKey(a, b);
+  if (result != 0) return result;
+  Rid x, y;
+  memcpy(&x, a + key_size_, sizeof(Rid));
+  memcpy(&y, b + key_size_, sizeof(Rid));
+  if (x.page_no != y.page_no) return x.page_no < y.page_no ? -1 : 1;
+  if (x.slot_no != y.slot_no) return x.slot_no < y.slot_no ? -1 : 1;
+  return 0;
+}
+
+bool Index::KeyEquals(const Byte *key, const Field *field) const {
+  std::vector<Byte> field_key(key_size_);
+  MakeKey(field, field_key.data());
+  return CompareKey(key, field_key.data()) == 0;
+}
+
+std::vector<Byte> Index::CopyNode(PageID page_no) {
+  PageGuard page = GetNode(page_no);
+  page->RLatch();
+  std::vector<Byte> data(page->GetData(), page->GetData() + PAGE_SIZE);
+  page->RUnlatch();
+  return data;
+}
+
+Index::PageImages::PageImages(Index *index, XID xid) : index_(index), xid_(xid) {}
+
+Byte *Index::PageImages::Get(PageID page_no) {
+  auto iter = images_.find(page_no);
+  if (iter == images_.end()) {
+    std::vector<Byte> data = index_->CopyNode(page_no);
+    iter = images_.emplace(page_no, std::make_pair(data, data)).first;
+  }
+  return iter->second.second.data();
+}
+
+PageID Index::PageImages::Alloc() {
+  PageID page_no = GetIndexMeta(Get(META_PAGE_NO))->page_end++;
+  index_->ExtendTo(page_no + 1);
+  std::vector<Byte> data = index_->CopyNode(page_no);
+  images_.emplace(page_no, std::make_pair(data, std::vector<Byte>(PAGE_SIZE, 0)));
+  return page_no;
+}
+
+void Index::PageImages::Log() {
+  // 同一页面的修改在日志中相邻
+  std::vector<IndexPageOp> ops;
+  for (const auto &pair : images_) {
+    IndexPageOp op = {IndexPageOp::Type::PATCH, pair.first, 0, 0, {}, {}};
+    DiffBytes(pair.second.first.data(), pair.second.second.data(), sizeof(PageHeader), PAGE_SIZE, op.ranges, nullptr,
+              op.bytes);
+    if (!op.ranges.empty()) ops.push_back(std::move(op));
+  }
+  if (!ops.empty()) LogManager::GetInstance().IndexPageLog(xid_, index_->index_id_, std::move(ops));
+  images_.clear();
+}
+
+PageGuard Index::GetNode(PageID page_no) { return buffer_manager_.GetPage(fd_, page_no); }
+
+void Index::ExtendTo(PageID page_end) {
+  // 运行时只在持有索引的写锁时扩展，恢复时单线程扩展；文件中不存在的页面补为全零
+  if (page_end <= file_end_) return;
+  DiskManager::GetInstance().TruncateFile(fd_, (size_t)page_end * PAGE_SIZE);
+  file_end_ = page_end;
+}
+
+void Index::Prefetch(const vector<PageID> &pages) { buffer_manager_.Prefetch(fd_, pages); }
+
+}  // namespace dbtrain
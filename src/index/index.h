@@ -0,0 +1,114 @@
+#ifndef DBTRAIN_INDEX_H
+#define DBTRAIN_INDEX_H
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <shared_mutex>
+#include <string>
+
+#include "../defines.h"
+#include "../log/index_log.h"
+#include "../record/field.h"
+#include "../storage/buffer_manager.h"
+#include "index_node.h"
+
+namespace dbtrain {
+
+// 字符串键只保存前缀，更长的字符串按前缀比较
+static const size_t INDEX_KEY_MAX_SIZE = 64;
+
+// 索引的页面数、层数与项数，用于 SHOW INDEXES
+struct IndexStats {
+  PageID pages;
+  size_t height;
+  size_t entries;
+  bool valid;
+};
+
+// 单列二级索引，保存在缓冲池管理的索引文件中，页面修改记录索引日志
+// 同一条记录的每个版本各有一项；删除记录不修改索引，由清理移除指向已释放记录的项
+// 扫描结果可能包含已回滚的插入留下的项以及仅前缀相同的字符串，调用者需按条件复查记录
+// 索引级读写锁：扫描共享，插入与删除独占；页面只分裂不合并，不回收
+class Index {
+ public:
+  virtual ~Index();
+
+  std::string GetName() const;
+  TableID GetID() const;
+  TableID GetTableID() const;
+  int GetColumn() const;
+  IndexType GetType() const;
+  bool IsValid();
+  void SetValid(XID xid);
+  // 字段能否转换为该索引的键，FLOAT 列接受整数
+  bool Accepts(const Field *field) const;
+  // 能否按键的范围扫描
+  virtual bool SupportsRange() const = 0;
+  // 插入已存在的键与记录位置时不做修改
+  virtual void Insert(XID xid, const Field *field, const Rid &rid) = 0;
+  // 键在 [low, high] 中的记录位置，为空的一端不限；不支持范围的索引只接受 low 与 high 相同的等值查找
+  virtual std::vector<Rid> Scan(const Field *low, const Field *high) = 0;
+  // 删除 dead 返回 true 的项，每个页面的删除记为一条日志，返回删除的项数
+  virtual size_t BulkDelete(XID xid, const std::function<bool(const Byte *key, const Rid &rid)> &dead) = 0;
+  // 项中的键是否与字段的键相同
+  bool KeyEquals(const Byte *key, const Field *field) const;
+  virtual IndexStats GetStats() = 0;
+
+  // 页号不小于文件页面数的页面需先通过 ExtendTo 补齐
+  PageGuard GetNode(PageID page_no);
+  // 恢复时文件补齐到日志中出现的页面
+  void ExtendTo(PageID page_end);
+  void Prefetch(const vector<PageID> &pages);
+
+ protected:
+  // 打开已有的索引文件，读取元信息
+  Index(const std::string &index_name, int fd);
+  // 新建索引文件并写入元信息，子类写入初始页面后调用 FlushNew 落盘
+  Index(const std::string &index_name, int fd, TableID index_id, TableID table_id, int column, IndexType type,
+        FieldType key_type, int col_len);
+
+  std::string index_name_;
+  int fd_;
+  TableID index_id_;
+  TableID table_id_;
+  int column_;
+  IndexType type_;
+  FieldType key_type_;
+  size_t key_size_;
+  // 键与记录位置
+  size_t entry_size_;
+  std::shared_mutex index_mutex_;
+  // 文件中已有的页面数，分配新页面时补齐文件
+  std::atomic<PageID> file_end_;
+  BufferManager &buffer_manager_;
+
+  void FlushNew();
+  void MakeKey(const Field *field, Byte *key) const;
+  // 比较两个键，再比较记录位置
+  int CompareKey(const Byte *a, const Byte *b) const;
+  int CompareEntry(const Byte *a, const Byte *b) const;
+  // 持有读闩复制页面内容
+  std::vector<Byte> CopyNode(PageID page_no);
+
+  // 一次修改涉及多个页面时在页面副本上完成，再把所有页面的差异记为一条日志
+  class PageImages {
+   public:
+    PageImages(Index *index, XID xid);
+    // 页面修改后的副本，第一次访问时复制页面
+    Byte *Get(PageID page_no);
+    // 通过元信息分配一个从全零开始的新页面
+    PageID Alloc();
+    // 页头由重做维护，只比较其后的内容
+    void Log();
+
+   private:
+    Index *index_;
+    XID xid_;
+    std::map<PageID, std::pair<std::vector<Byte>, std::vector<Byte>>> images_;
+  };
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_INDEX_H
@@ -0,0 +1,32 @@
+#include "index_factory.h"
+
+#include <iostream>
+
+#include "../exception/exceptions.h"
+#include "btree_index.h"
+#include "hash_index.h"
+
+namespace dbtrain {
+
+Index *IndexFactory::LoadIndex(const std::string &index_name, int fd) {
+  IndexType type;
+  {
+    PageGuard meta_page = BufferManager::GetInstance().GetPage(fd, META_PAGE_NO);
+    type = (IndexType)GetIndexMeta(meta_page->GetData())->type;
+  }
+  if (type == IndexType::BTREE) {
+    return new BTreeIndex(index_name, fd);
+  } else if (type == IndexType::HASH) {
+    return new HashIndex(index_name, fd);
+  }
+  std::cerr << "Error in IndexFactory::LoadIndex\n";
+  throw UnknownError();
+}
+
+Index *IndexFactory::NewIndex(const std::string &index_name, int fd, IndexType type, TableID index_id,
+                              TableID table_id, int column, FieldType key_type, int col_len) {
+  if (type == IndexType::HASH) return new HashIndex(index_name, fd, index_id, table_id, column, key_type, col_len);
+  return new BTreeIndex(index_name, fd, index_id, table_id, column, key_type, col_len);
+}
+
+}  // namespace dbtrain
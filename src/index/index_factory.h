@@ -0,0 +1,19 @@
+#ifndef DBTRAIN_INDEX_FACTORY_H
+#define DBTRAIN_INDEX_FACTORY_H
+
+#include "index.h"
+
+namespace dbtrain {
+
+class IndexFactory {
+ public:
+  // 按元信息中的索引类型打开已有的索引文件
+  static Index *LoadIndex(const std::string &index_name, int fd);
+  // 新建索引文件，建立完成并调用 SetValid 前索引无效
+  static Index *NewIndex(const std::string &index_name, int fd, IndexType type, TableID index_id, TableID table_id,
+                         int column, FieldType key_type, int col_len);
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_INDEX_FACTORY_H
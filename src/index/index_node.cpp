@@ -0,0 +1,20 @@
+#include "index_node.h"
+
+namespace dbtrain {
+
+void InsertNodeEntry(Byte *data, size_t pos, const Byte *entry, size_t entry_size) {
+  IndexNodeHeader *header = GetNodeHeader(data);
+  Byte *dst = GetNodeEntry(data, pos, entry_size);
+  memmove(dst + entry_size, dst, (header->count - pos) * entry_size);
+  memcpy(dst, entry, entry_size);
+  header->count++;
+}
+
+void DeleteNodeEntry(Byte *data, size_t pos, size_t entry_size) {
+  IndexNodeHeader *header = GetNodeHeader(data);
+  Byte *dst = GetNodeEntry(data, pos, entry_size);
+  memmove(dst, dst + entry_size, (header->count - pos - 1) * entry_size);
+  header->count--;
+}
+
+}  // namespace dbtrain
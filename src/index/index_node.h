@@ -0,0 +1,78 @@
+#ifndef DBTRAIN_INDEX_NODE_H
+#define DBTRAIN_INDEX_NODE_H
+
+#include <cstddef>
+
+#include "../defines.h"
+#include "../table/page_handle.h"
+
+namespace dbtrain {
+
+enum class IndexType : uint8_t { BTREE = 0, HASH = 1 };
+
+// 索引文件第 0 页的元信息，位于 PageHeader 之后，与节点一样只通过索引日志修改
+struct IndexMeta {
+  TableID index_id;
+  TableID table_id;
+  // 被索引的列与其类型，字符串只保存前 key_size 个字节
+  uint16_t column;
+  uint8_t key_type;
+  uint16_t key_size;
+  // B+ 树的根节点
+  PageID root;
+  // 已分配的页面数，包括元信息页
+  PageID page_end;
+  // 建立完成后置为 1，未建完的索引在打开数据库时删除
+  uint8_t valid;
+  uint8_t type;
+  // 哈希索引目录的全局深度与目录页数，目录页的页号紧接在元信息之后
+  uint8_t global_depth;
+  uint16_t dir_pages;
+};
+
+// B+ 树节点的头部，位于 PageHeader 之后，之后为按键与记录位置有序排列的定长项
+// 叶节点的项为键与记录位置，内部节点的项另有子节点页号，该子节点中的项均不小于此项
+struct IndexNodeHeader {
+  uint8_t leaf;
+  uint16_t count;
+  // 叶节点为右侧的兄弟节点，内部节点为项均小于第一项的子节点
+  PageID link;
+};
+
+// 哈希桶页的头部，之后为无序排列的定长项，项与 B+ 树叶节点相同
+// 索引日志按 IndexNodeHeader 插入与删除项，count 的位置需与其一致
+struct HashBucketHeader {
+  uint8_t local_depth;
+  uint16_t count;
+  // 桶中项的哈希值低 local_depth 位均相同，放不下且无法分裂时链接溢出页
+  PageID next;
+};
+static_assert(offsetof(HashBucketHeader, count) == offsetof(IndexNodeHeader, count), "bucket header mismatch");
+static_assert(sizeof(HashBucketHeader) == sizeof(IndexNodeHeader), "bucket header mismatch");
+
+// 节点中第一项的偏移
+static const size_t INDEX_NODE_DATA = sizeof(PageHeader) + sizeof(IndexNodeHeader);
+// 每个目录页保存的桶页号数，为 2 的幂，目录加倍时按页复制
+static const size_t HASH_DIR_ENTRIES = 512;
+// 元信息页中最多记录的目录页数
+static const size_t HASH_MAX_DIR_PAGES = (PAGE_SIZE - sizeof(PageHeader) - sizeof(IndexMeta)) / sizeof(PageID);
+
+inline IndexMeta *GetIndexMeta(Byte *data) { return (IndexMeta *)(data + sizeof(PageHeader)); }
+inline IndexNodeHeader *GetNodeHeader(Byte *data) { return (IndexNodeHeader *)(data + sizeof(PageHeader)); }
+inline Byte *GetNodeEntry(Byte *data, size_t pos, size_t entry_size) {
+  return data + INDEX_NODE_DATA + pos * entry_size;
+}
+inline HashBucketHeader *GetBucketHeader(Byte *data) { return (HashBucketHeader *)(data + sizeof(PageHeader)); }
+// 元信息页中的目录页号
+inline PageID *GetDirPages(Byte *data) { return (PageID *)(data + sizeof(PageHeader) + sizeof(IndexMeta)); }
+// 目录页中的桶页号
+inline PageID *GetDirEntries(Byte *data) { return (PageID *)(data + sizeof(PageHeader)); }
+
+// 在 pos 处插入一项，之后的项后移
+void InsertNodeEntry(Byte *data, size_t pos, const Byte *entry, size_t entry_size);
+// 删除 pos 处的项，之后的项前移
+void DeleteNodeEntry(Byte *data, size_t pos, size_t entry_size);
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_INDEX_NODE_H
@@ -1,22 +1,27 @@
 #include "basic_log.h"
 
+#include "../utils/varint.h"
+
 namespace dbtrain {
 
 TxLog::TxLog(LSN lsn, LSN prev_lsn, XID xid) : Log(lsn), prev_lsn_(prev_lsn), xid_(xid) {}
 void TxLog::Load(const Byte *src) {
   Log::Load(src);
-  memcpy(&prev_lsn_, src + sizeof(LSN), sizeof(LSN));
-  memcpy(&xid_, src + 2 * sizeof(prev_lsn_), sizeof(XID));
+  size_t offset = GetVarint(src, xid_);
+  LSN prev_delta = 0;
+  GetVarint(src + offset, prev_delta);
+  prev_lsn_ = prev_delta == 0 ? NULL_LSN : lsn_ - prev_delta;
 }
 size_t TxLog::Store(Byte *dst) {
   size_t length = Log::Store(dst);
-  memcpy(dst + length, &prev_lsn_, sizeof(LSN));
-  memcpy(dst + length + sizeof(LSN), &xid_, sizeof(XID));
-  return length + sizeof(LSN) + sizeof(XID);
+  length += PutVarint(dst + length, xid_);
+  length += PutVarint(dst + length, PrevDelta());
+  return length;
 }
 LSN TxLog::GetPrevLSN() const { return prev_lsn_; }
 XID TxLog::GetXID() const { return xid_; }
-size_t TxLog::GetLength() const { return Log::GetLength() + sizeof(LSN) + sizeof(XID); }
+size_t TxLog::GetLength() const { return Log::GetLength() + VarintLength(xid_) + VarintLength(PrevDelta()); }
+LSN TxLog::PrevDelta() const { return prev_lsn_ == NULL_LSN ? 0 : lsn_ - prev_lsn_; }
 
 BeginLog::BeginLog(LSN lsn, LSN prev_lsn, XID xid) : TxLog(lsn, prev_lsn, xid) {}
 EndLog::EndLog(LSN lsn, LSN prev_lsn, XID xid) : TxLog(lsn, prev_lsn, xid) {}
@@ -5,6 +5,7 @@
 
 namespace dbtrain {
 
+// 事务编号与前一条日志的 LSN 差值均以变长整数存储，差值为 0 表示没有前一条日志
 class TxLog : public Log {
  public:
   TxLog() = default;
@@ -20,6 +21,9 @@ class TxLog : public Log {
  protected:
   LSN prev_lsn_;
   XID xid_;
+
+ private:
+  LSN PrevDelta() const;
 };
 
 class BeginLog : public TxLog {
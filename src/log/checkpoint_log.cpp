@@ -2,132 +2,106 @@
 
 #include <cassert>
 
-#include "../tx/tx_manager.h"
 #include "defines.h"
+#include "../utils/varint.h"
 
 namespace dbtrain {
 
-CheckpointLog::CheckpointLog() : Log() {}
-CheckpointLog::CheckpointLog(LSN lsn) : Log(lsn) {}
+BeginCheckpointLog::BeginCheckpointLog(LSN lsn) : Log(lsn) {}
+LogType BeginCheckpointLog::GetType() const { return LogType::BEGIN_CHECKPOINT; }
+
+CheckpointLog::CheckpointLog() : Log(), begin_lsn_(NULL_LSN), xid_(0) {}
+CheckpointLog::CheckpointLog(LSN lsn, LSN begin_lsn, XID xid, const std::map<XID, TxEntry> &att,
+                             const std::map<UniquePageID, LSN> &dpt)
+    : Log(lsn), begin_lsn_(begin_lsn), xid_(xid), att_(att), dpt_(dpt) {}
+
 void CheckpointLog::Load(const Byte *src) {
   Log::Load(src);
-  size_t fsize = sizeof(LSN);
-  LogManager &log_manager = LogManager::GetInstance();
+  // 开始记录的 LSN 以与本记录的差值存储
+  LSN begin_delta = 0;
+  size_t fsize = GetVarint(src, begin_delta);
+  begin_lsn_ = lsn_ - begin_delta;
   // TODO: 恢复当前事务编号
   // LAB 3 BEGIN
-  XID xid;
-  memcpy(&xid, src + fsize, sizeof(XID));
-  fsize += sizeof(XID);
-  TxManager::GetInstance().SetXID(xid);
+  fsize += GetVarint(src + fsize, xid_);
   // LAB 3 END
   // TODO: 加载MasterRecord对应的Checkpoint Log
   // TIPS: 利用读取的信息更新LogManager
   // LAB 2 BEGIN
-  // map size
   size_t len_of_att = 0;
-  memcpy(&len_of_att, src + fsize, sizeof(size_t));
-  fsize += sizeof(size_t);
-  log_manager.att_.clear();
-  // map content
+  fsize += GetVarint(src + fsize, len_of_att);
+  att_.clear();
   for (size_t i = 0; i < len_of_att; ++i) {
     XID xid;
     LSN lsn;
-    memcpy(&xid, src + fsize, sizeof(XID));
-    fsize += sizeof(XID);
-    memcpy(&lsn, src + fsize, sizeof(LSN));
-    fsize += sizeof(LSN);
-
-    log_manager.att_[xid] = lsn;
+    // 第一条日志以与最后一条日志的差值存储
+    LSN first_delta = 0;
+    fsize += GetVarint(src + fsize, xid);
+    fsize += GetVarint(src + fsize, lsn);
+    fsize += GetVarint(src + fsize, first_delta);
+    att_[xid] = {lsn - first_delta, lsn};
   }
-  // map size
   size_t len_of_dpt = 0;
-  memcpy(&len_of_dpt, src + fsize, sizeof(size_t));
-  fsize += sizeof(size_t);
-  log_manager.dpt_.clear();
-  // map content
+  fsize += GetVarint(src + fsize, len_of_dpt);
+  dpt_.clear();
   for (size_t i = 0; i < len_of_dpt; ++i) {
     UniquePageID upid;
     LSN lsn;
-    // variable length string
-    size_t len_of_string = 0;
-    memcpy(&len_of_string, src + fsize, sizeof(size_t));
-    fsize += sizeof(size_t);
-    char* name = new char[len_of_string];
-    memcpy(name, src + fsize, len_of_string);
-    fsize += len_of_string;
-    upid.table_name.assign(name);
-
-    memcpy(&upid.page_id, src + fsize, sizeof(PageID));
-    fsize += sizeof(PageID);
-    memcpy(&lsn, src + fsize, sizeof(LSN));
-    fsize += sizeof(LSN);
-
-    log_manager.dpt_[upid] = lsn;
+    fsize += GetVarint(src + fsize, upid.table_id);
+    fsize += GetVarint(src + fsize, upid.page_id);
+    fsize += GetVarint(src + fsize, lsn);
+    dpt_[upid] = lsn;
   }
   // LAB 2 END
 }
 
 size_t CheckpointLog::Store(Byte *dst) {
-  LogManager &log_manager = LogManager::GetInstance();
   size_t fsize = Log::Store(dst);
+  fsize += PutVarint(dst + fsize, lsn_ - begin_lsn_);
   // TODO: 存储当前事务编号
   // LAB 3 BEGIN
-  XID xid = TxManager::GetInstance().GetXID();
-  memcpy(dst + fsize, &xid, sizeof(XID));
-  fsize += sizeof(XID);
+  fsize += PutVarint(dst + fsize, xid_);
   // LAB 3 END
   // TODO: 存储LogManager相关信息，返回Store的数据长度
   // TIPS: 不添加缓存机制情况下，仅需要保存ATT和DPT
-  // TIPS: 考虑缓存机制情况下，需要额外存储Flushed LSN
   // LAB 2 BEGIN
-  // map size
-  size_t len_of_att = log_manager.att_.size();
-  memcpy(dst + fsize, &len_of_att, sizeof(size_t));
-  fsize += sizeof(size_t);
-  // map content
-  for (auto pair: log_manager.att_) {
-    XID xid = pair.first;
-    LSN lsn = pair.second;
-    memcpy(dst + fsize, &xid, sizeof(XID));
-    fsize += sizeof(XID);
-    memcpy(dst + fsize, &lsn, sizeof(LSN));
-    fsize += sizeof(LSN);
+  fsize += PutVarint(dst + fsize, att_.size());
+  for (const auto &pair : att_) {
+    fsize += PutVarint(dst + fsize, pair.first);
+    fsize += PutVarint(dst + fsize, pair.second.last_lsn);
+    fsize += PutVarint(dst + fsize, pair.second.last_lsn - pair.second.first_lsn);
   }
-  // map size
-  size_t len_of_dpt = log_manager.dpt_.size();
-  memcpy(dst + fsize, &len_of_dpt, sizeof(size_t));
-  fsize += sizeof(size_t);
-  // map content
-  for (auto pair: log_manager.dpt_) {
-    UniquePageID upid = pair.first;
-    LSN lsn = pair.second;
-    // variable length string
-    size_t len_of_string = upid.table_name.size() + 1;
-    memcpy(dst + fsize, &len_of_string, sizeof(size_t));
-    fsize += sizeof(size_t);
-    memcpy(dst + fsize, upid.table_name.c_str(), len_of_string);
-    fsize += len_of_string;
-
-    memcpy(dst + fsize, &upid.page_id, sizeof(PageID));
-    fsize += sizeof(PageID);
-    memcpy(dst + fsize, &lsn, sizeof(LSN));
-    fsize += sizeof(LSN);
+  fsize += PutVarint(dst + fsize, dpt_.size());
+  for (const auto &pair : dpt_) {
+    fsize += PutVarint(dst + fsize, pair.first.table_id);
+    fsize += PutVarint(dst + fsize, pair.first.page_id);
+    fsize += PutVarint(dst + fsize, pair.second);
   }
   // LAB 2 END
   return fsize;
 }
+
 LogType CheckpointLog::GetType() const { return LogType::CHECKPOINT; }
 
 size_t CheckpointLog::GetLength() const {
-  size_t length = Log::GetLength() + 2 * sizeof(LSN) + sizeof(XID);
-  length += 2 * sizeof(size_t);
-  LogManager &log_manager = LogManager::GetInstance();
-  length += log_manager.att_.size() * (sizeof(XID) + sizeof(LSN));
-  length += log_manager.dpt_.size() * (sizeof(LSN) + sizeof(PageID) + sizeof(size_t));
-  for (const auto &dpt_pair : log_manager.dpt_) {
-    length += dpt_pair.first.table_name.size();
+  size_t length = Log::GetLength() + VarintLength(lsn_ - begin_lsn_) + VarintLength(xid_);
+  length += VarintLength(att_.size()) + VarintLength(dpt_.size());
+  for (const auto &pair : att_) {
+    length += VarintLength(pair.first) + VarintLength(pair.second.last_lsn) +
+              VarintLength(pair.second.last_lsn - pair.second.first_lsn);
+  }
+  for (const auto &pair : dpt_) {
+    length += VarintLength(pair.first.table_id) + VarintLength(pair.first.page_id) + VarintLength(pair.second);
   }
   return length;
 }
 
+LSN CheckpointLog::GetBeginLSN() const { return begin_lsn_; }
+
+XID CheckpointLog::GetXID() const { return xid_; }
+
+const std::map<XID, TxEntry> &CheckpointLog::GetATT() const { return att_; }
+
+const std::map<UniquePageID, LSN> &CheckpointLog::GetDPT() const { return dpt_; }
+
 }  // namespace dbtrain
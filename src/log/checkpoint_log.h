@@ -1,23 +1,48 @@
 #ifndef DBTRAIN_CHECKPOINT_LOG_H
 #define DBTRAIN_CHECKPOINT_LOG_H
 
+#include <map>
+
 #include "../defines.h"
 #include "log.h"
 #include "log_manager.h"
 
 namespace dbtrain {
 
+// 模糊检查点的开始记录，恢复时从该记录之后开始分析
+class BeginCheckpointLog : public Log {
+ public:
+  BeginCheckpointLog() = default;
+  ~BeginCheckpointLog() = default;
+  BeginCheckpointLog(LSN lsn);
+  LogType GetType() const override;
+};
+
+// 模糊检查点的结束记录，保存开始记录之后取得的 ATT 与 DPT 快照，MasterRecord 指向该记录
 class CheckpointLog : public Log {
  public:
   CheckpointLog();
   ~CheckpointLog() = default;
-  CheckpointLog(LSN lsn);
+  CheckpointLog(LSN lsn, LSN begin_lsn, XID xid, const std::map<XID, TxEntry> &att,
+                const std::map<UniquePageID, LSN> &dpt);
   void Load(const Byte *src) override;
   size_t Store(Byte *dst) override;
   LogType GetType() const override;
   size_t GetLength() const override;
+
+  LSN GetBeginLSN() const;
+  XID GetXID() const;
+  // 运行中事务的第一条与最后一条日志，恢复后回滚完成前据此截断日志
+  const std::map<XID, TxEntry> &GetATT() const;
+  const std::map<UniquePageID, LSN> &GetDPT() const;
+
+ private:
+  LSN begin_lsn_;
+  XID xid_;
+  std::map<XID, TxEntry> att_;
+  std::map<UniquePageID, LSN> dpt_;
 };
 
 }  // namespace dbtrain
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,153 @@
+#include "index_log.h"
+
+#include "log_manager.h"
+#include "../index/index.h"
+#include "../index/index_node.h"
+#include "../system/system_manager.h"
+#include "../utils/varint.h"
+
+namespace dbtrain {
+
+IndexLog::IndexLog(LSN lsn, LSN prev_lsn, XID xid, TableID index_id, std::vector<IndexPageOp> ops)
+    : TxLog(lsn, prev_lsn, xid), index_id_(index_id), ops_(std::move(ops)) {}
+
+bool IndexLog::Redo() {
+  Index *index = SystemManager::GetInstance().GetIndex(index_id_);
+  if (index == nullptr) return false;
+  bool applied = false;
+  size_t i = 0;
+  while (i < ops_.size()) {
+    // 逐页加锁，同一页面的修改一次完成
+    size_t end = i;
+    while (end < ops_.size() && ops_[end].page_id == ops_[i].page_id) end++;
+    PageGuard page = index->GetNode(ops_[i].page_id);
+    page->WLatch();
+    Byte *data = page->GetData();
+    PageHeader *header = (PageHeader *)data;
+    if (header->page_lsn < lsn_) {
+      LogManager::GetInstance().AddDirtyPage({index_id_, ops_[i].page_id}, lsn_);
+      for (; i < end; i++) {
+        const IndexPageOp &op = ops_[i];
+        if (op.type == IndexPageOp::Type::INSERT) {
+          InsertNodeEntry(data, op.pos, op.bytes.data(), op.length);
+        } else if (op.type == IndexPageOp::Type::DELETE) {
+          DeleteNodeEntry(data, op.pos, op.length);
+        } else {
+          size_t bytes_pos = 0;
+          for (const auto &range : op.ranges) {
+            memcpy(data + range.offset, op.bytes.data() + bytes_pos, range.length);
+            bytes_pos += range.length;
+          }
+        }
+      }
+      header->page_lsn = lsn_;
+      page->SetLSN(lsn_);
+      page->SetDirty();
+      applied = true;
+    }
+    page->WUnlatch();
+    i = end;
+  }
+  return applied;
+}
+
+void IndexLog::Load(const Byte *src) {
+  TxLog::Load(src);
+  // TxLog 的长度包含由 LogFactory 读取的类型字节
+  size_t offset = TxLog::GetLength() - Log::GetLength();
+  offset += GetVarint(src + offset, index_id_);
+  size_t count = 0;
+  offset += GetVarint(src + offset, count);
+  ops_.resize(count);
+  for (auto &op : ops_) {
+    op.type = (IndexPageOp::Type)src[offset++];
+    offset += GetVarint(src + offset, op.page_id);
+    if (op.type == IndexPageOp::Type::PATCH) {
+      size_t range_count = 0;
+      offset += GetVarint(src + offset, range_count);
+      op.ranges.resize(range_count);
+      // 范围的起点以与上一个范围结尾的距离存储
+      size_t pos = 0;
+      for (auto &range : op.ranges) {
+        size_t gap = 0;
+        offset += GetVarint(src + offset, gap);
+        offset += GetVarint(src + offset, range.length);
+        range.offset = pos + gap;
+        pos = range.offset + range.length;
+        op.bytes.insert(op.bytes.end(), src + offset, src + offset + range.length);
+        offset += range.length;
+      }
+    } else {
+      offset += GetVarint(src + offset, op.pos);
+      offset += GetVarint(src + offset, op.length);
+      if (op.type == IndexPageOp::Type::INSERT) {
+        op.bytes.assign(src + offset, src + offset + op.length);
+        offset += op.length;
+      }
+    }
+  }
+}
+
+size_t IndexLog::Store(Byte *dst) {
+  size_t offset = TxLog::Store(dst);
+  offset += PutVarint(dst + offset, index_id_);
+  offset += PutVarint(dst + offset, ops_.size());
+  for (const auto &op : ops_) {
+    dst[offset++] = (uint8_t)op.type;
+    offset += PutVarint(dst + offset, op.page_id);
+    if (op.type == IndexPageOp::Type::PATCH) {
+      offset += PutVarint(dst + offset, op.ranges.size());
+      size_t pos = 0;
+      size_t bytes_pos = 0;
+      for (const auto &range : op.ranges) {
+        offset += PutVarint(dst + offset, range.offset - pos);
+        offset += PutVarint(dst + offset, range.length);
+        pos = range.offset + range.length;
+        memcpy(dst + offset, op.bytes.data() + bytes_pos, range.length);
+        offset += range.length;
+        bytes_pos += range.length;
+      }
+    } else {
+      offset += PutVarint(dst + offset, op.pos);
+      offset += PutVarint(dst + offset, op.length);
+      if (op.type == IndexPageOp::Type::INSERT) {
+        memcpy(dst + offset, op.bytes.data(), op.length);
+        offset += op.length;
+      }
+    }
+  }
+  return offset;
+}
+
+std::vector<UniquePageID> IndexLog::GetUniPageIDs() const {
+  std::vector<UniquePageID> upids;
+  for (const auto &op : ops_) {
+    if (upids.empty() || upids.back().page_id != op.page_id) upids.push_back({index_id_, op.page_id});
+  }
+  return upids;
+}
+
+TableID IndexLog::GetIndexID() const { return index_id_; }
+
+LogType IndexLog::GetType() const { return LogType::INDEX; }
+
+size_t IndexLog::GetLength() const {
+  size_t length = TxLog::GetLength() + VarintLength(index_id_) + VarintLength(ops_.size());
+  for (const auto &op : ops_) {
+    length += sizeof(uint8_t) + VarintLength(op.page_id);
+    if (op.type == IndexPageOp::Type::PATCH) {
+      length += VarintLength(op.ranges.size());
+      size_t pos = 0;
+      for (const auto &range : op.ranges) {
+        length += VarintLength(range.offset - pos) + VarintLength(range.length) + range.length;
+        pos = range.offset + range.length;
+      }
+    } else {
+      length += VarintLength(op.pos) + VarintLength(op.length);
+      if (op.type == IndexPageOp::Type::INSERT) length += op.length;
+    }
+  }
+  return length;
+}
+
+}  // namespace dbtrain
@@ -0,0 +1,51 @@
+#ifndef DBTRAIN_INDEX_LOG_H
+#define DBTRAIN_INDEX_LOG_H
+
+#include "basic_log.h"
+#include "log_image.h"
+#include "log_manager.h"
+
+namespace dbtrain {
+
+// 索引页面上的一个修改：在 pos 处插入或删除一项，或按字节范围覆盖页面内容
+struct IndexPageOp {
+  enum class Type : uint8_t { INSERT, DELETE, PATCH };
+  Type type;
+  PageID page_id;
+  // INSERT 与 DELETE 的项位置与项长度
+  size_t pos;
+  size_t length;
+  // PATCH 修改的字节范围，偏移相对于页面开头
+  std::vector<ByteRange> ranges;
+  // INSERT 为插入的项，PATCH 为各范围修改后的内容
+  std::vector<Byte> bytes;
+};
+
+// 索引页面的修改日志，一次节点分裂涉及的所有页面记录在同一条日志中，重做时一并完成
+// 只重做不回滚：回滚事务时跳过，已回滚记录留下的索引项由扫描时的条件复查过滤，由清理移除
+class IndexLog : public TxLog {
+ public:
+  IndexLog() = default;
+  IndexLog(LSN lsn, LSN prev_lsn, XID xid, TableID index_id, std::vector<IndexPageOp> ops);
+  ~IndexLog() = default;
+
+  void Load(const Byte *src) override;
+  size_t Store(Byte *dst) override;
+
+  // 修改页面 LSN 小于日志 LSN 的页面，索引已被删除时跳过，返回是否修改了页面
+  bool Redo();
+  std::vector<UniquePageID> GetUniPageIDs() const;
+  TableID GetIndexID() const;
+
+  LogType GetType() const override;
+  size_t GetLength() const override;
+
+ private:
+  TableID index_id_;
+  // 同一页面的修改相邻存放
+  std::vector<IndexPageOp> ops_;
+};
+
+}  // namespace dbtrain
+
+#endif
@@ -4,15 +4,12 @@ namespace dbtrain {
 
 Log::Log(LSN lsn) : lsn_(lsn) {}
 
-void Log::Load(const Byte *src) { memcpy(&lsn_, src, sizeof(LSN)); }
-size_t Log::Store(Byte *dst) {
-  memcpy(dst, &lsn_, sizeof(LSN));
-  return sizeof(LSN);
-}
+void Log::Load(const Byte *src) {}
+size_t Log::Store(Byte *dst) { return 0; }
 
 size_t Log::GetLength() const {
-  // TIPS: LogType由LogFactory进行管理
-  return sizeof(LSN) + sizeof(LogType);
+  // TIPS: LogType由LogFactory进行管理，只占一个字节
+  return sizeof(uint8_t);
 }
 
 LSN Log::GetLSN() const { return lsn_; }
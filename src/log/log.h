@@ -7,7 +7,8 @@ namespace dbtrain {
 
 const LSN NULL_LSN = UINT32_MAX;
 
-enum class LogType { UNDEFINED = 0, UPDATE, COMMIT, ABORT, BEGIN, END, CLR, CHECKPOINT };
+// CHECKPOINT 为模糊检查点的结束记录，BEGIN_CHECKPOINT 为开始记录，INDEX 为索引页面的修改
+enum class LogType { UNDEFINED = 0, UPDATE, COMMIT, ABORT, BEGIN, END, CLR, CHECKPOINT, BEGIN_CHECKPOINT, INDEX };
 
 class Log {
  public:
@@ -23,7 +24,11 @@ class Log {
   LSN GetLSN() const;
 
  protected:
+  // LSN 保存在日志存储的头部，不写入日志内容，由 LogFactory 读取时或 LogManager 写入缓冲时设置
   LSN lsn_;
+
+  friend class LogFactory;
+  friend class LogManager;
 };
 
 }  // namespace dbtrain
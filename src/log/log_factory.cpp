@@ -5,10 +5,9 @@
 
 namespace dbtrain {
 
-Log *LogFactory::LoadLog(const Byte *src) {
+Log *LogFactory::LoadLog(LSN lsn, const Byte *src) {
   Log *log = nullptr;
-  LogType log_type = LogType::UNDEFINED;
-  memcpy(&log_type, src, sizeof(LogType));
+  LogType log_type = (LogType)src[0];
   if (log_type == LogType::BEGIN) {
     log = new BeginLog();
   } else if (log_type == LogType::ABORT) {
@@ -17,66 +16,114 @@ Log *LogFactory::LoadLog(const Byte *src) {
     log = new CommitLog();
   } else if (log_type == LogType::CHECKPOINT) {
     log = new CheckpointLog();
+  } else if (log_type == LogType::BEGIN_CHECKPOINT) {
+    log = new BeginCheckpointLog();
+  } else if (log_type == LogType::END) {
+    log = new EndLog();
   } else if (log_type == LogType::UPDATE) {
     log = new UpdateLog();
+  } else if (log_type == LogType::CLR) {
+    log = new CompensationLog();
+  } else if (log_type == LogType::INDEX) {
+    log = new IndexLog();
   } else {
     assert(false);
   }
-  log->Load(src + sizeof(LogType));
+  log->lsn_ = lsn;
+  log->Load(src + sizeof(uint8_t));
   return log;
 }
 
 size_t LogFactory::StoreLog(Byte *dst, Log *log) {
   // TIPS: 建议将类型存在起始位置
-  auto log_type = log->GetType();
-  memcpy(dst, &log_type, sizeof(LogType));
-  size_t length = log->Store(dst + sizeof(LogType)) + sizeof(LogType);
+  dst[0] = (uint8_t)log->GetType();
+  size_t length = log->Store(dst + sizeof(uint8_t)) + sizeof(uint8_t);
   return length;
 }
 
-Log *LogFactory::NewDeleteLog(const TxInfo &info, const string &table_name, Rid rid, size_t old_len,
-                              const void *old_val) {
+UpdateLog *LogFactory::NewRecordLog(const TxInfo &info, TableID table_id, Rid rid, size_t len) {
   UpdateLog *log = new UpdateLog(info.lsn, info.prev_lsn, info.xid);
+  log->log_image_.table_id_ = table_id;
   log->log_image_.page_id_ = rid.page_no;
   log->log_image_.slot_id_ = rid.slot_no;
-  log->log_image_.table_name_ = table_name;
-
-  log->log_image_.op_type_ = PhysiologicalImage::LogOpType::DELETE;
-  log->log_image_.old_len_ = old_len;
-  log->log_image_.old_val_ = new Byte[old_len];
-  memcpy(log->log_image_.old_val_, old_val, old_len);
+  log->log_image_.length_ = len;
   return log;
 }
 
-Log *LogFactory::NewInsertLog(const TxInfo &info, const string &table_name, Rid rid, size_t new_len,
-                              const void *new_val) {
-  UpdateLog *log = new UpdateLog(info.lsn, info.prev_lsn, info.xid);
-  log->log_image_.page_id_ = rid.page_no;
-  log->log_image_.slot_id_ = rid.slot_no;
-  log->log_image_.table_name_ = table_name;
+Log *LogFactory::NewInsertLog(const TxInfo &info, TableID table_id, Rid rid, size_t len, const void *new_val,
+                              bool compress) {
+  UpdateLog *log = NewRecordLog(info, table_id, rid, len);
+  log->log_image_.op_type_ = PhysiologicalImage::LogOpType::INSERT;
+  log->log_image_.new_val_.assign((const Byte *)new_val, (const Byte *)new_val + len);
+  if (compress) log->log_image_.Compress();
+  return log;
+}
 
+Log *LogFactory::NewInsertLog(const TxInfo &info, TableID table_id, Rid rid, size_t len, const void *new_val,
+                              SlotID base_slot, const void *base_val) {
+  UpdateLog *log = NewRecordLog(info, table_id, rid, len);
   log->log_image_.op_type_ = PhysiologicalImage::LogOpType::INSERT;
-  log->log_image_.new_len_ = new_len;
-  log->log_image_.new_val_ = new Byte[new_len];
-  memcpy(log->log_image_.new_val_, new_val, new_len);
+  log->log_image_.base_slot_ = base_slot;
+  log->log_image_.SetDelta((const Byte *)base_val, (const Byte *)new_val, false);
   return log;
 }
 
-Log *LogFactory::NewUpdateLog(const TxInfo &info, const string &table_name, Rid rid, size_t old_len,
-                              const void *old_val, size_t new_len, const void *new_val) {
-  UpdateLog *log = new UpdateLog(info.lsn, info.prev_lsn, info.xid);
-  log->log_image_.page_id_ = rid.page_no;
-  log->log_image_.slot_id_ = rid.slot_no;
-  log->log_image_.table_name_ = table_name;
+Log *LogFactory::NewDeleteLog(const TxInfo &info, TableID table_id, Rid rid, size_t len, const void *old_val,
+                              const void *new_val) {
+  UpdateLog *log = NewRecordLog(info, table_id, rid, len);
+  log->log_image_.op_type_ = PhysiologicalImage::LogOpType::DELETE;
+  log->log_image_.base_slot_ = rid.slot_no;
+  log->log_image_.SetDelta((const Byte *)old_val, (const Byte *)new_val, true);
+  return log;
+}
 
+Log *LogFactory::NewUpdateLog(const TxInfo &info, TableID table_id, Rid rid, size_t len, const void *old_val,
+                              const void *new_val) {
+  UpdateLog *log = NewRecordLog(info, table_id, rid, len);
   log->log_image_.op_type_ = PhysiologicalImage::LogOpType::UPDATE;
-  log->log_image_.old_len_ = old_len;
-  log->log_image_.old_val_ = new Byte[old_len];
-  memcpy(log->log_image_.old_val_, old_val, old_len);
-  log->log_image_.new_len_ = new_len;
-  log->log_image_.new_val_ = new Byte[new_len];
-  memcpy(log->log_image_.new_val_, new_val, new_len);
+  log->log_image_.base_slot_ = rid.slot_no;
+  log->log_image_.SetDelta((const Byte *)old_val, (const Byte *)new_val, true);
   return log;
 }
 
+CompensationLog *LogFactory::NewCompensationLog(const TxInfo &info, const UpdateLog &log, LSN undo_next_lsn) {
+  CompensationLog *clr = new CompensationLog(info.lsn, info.prev_lsn, info.xid, undo_next_lsn);
+  const PhysiologicalImage &image = log.log_image_;
+  clr->log_image_.table_id_ = image.table_id_;
+  clr->log_image_.page_id_ = image.page_id_;
+  clr->log_image_.slot_id_ = image.slot_id_;
+  clr->log_image_.length_ = image.length_;
+  clr->log_image_.delta_ = true;
+  clr->log_image_.redo_only_ = true;
+  clr->log_image_.base_slot_ = image.slot_id_;
+  if (image.op_type_ == PhysiologicalImage::LogOpType::INSERT) {
+    // 回滚插入只需释放记录所在的槽
+    clr->log_image_.op_type_ = PhysiologicalImage::LogOpType::DELETE;
+  } else {
+    // 回滚删除与更新时写回修改前的字节
+    clr->log_image_.op_type_ = PhysiologicalImage::LogOpType::UPDATE;
+    clr->log_image_.ranges_ = image.ranges_;
+    clr->log_image_.new_bytes_ = image.old_bytes_;
+  }
+  return clr;
+}
+
+CompensationLog *LogFactory::NewVacuumLog(const TxInfo &info, TableID table_id, Rid rid, size_t len) {
+  // undo_next_lsn 为清理事务的前一条日志，与回滚插入的补偿日志一样只释放记录所在的槽
+  CompensationLog *clr = new CompensationLog(info.lsn, info.prev_lsn, info.xid, info.prev_lsn);
+  clr->log_image_.table_id_ = table_id;
+  clr->log_image_.page_id_ = rid.page_no;
+  clr->log_image_.slot_id_ = rid.slot_no;
+  clr->log_image_.length_ = len;
+  clr->log_image_.delta_ = true;
+  clr->log_image_.redo_only_ = true;
+  clr->log_image_.base_slot_ = rid.slot_no;
+  clr->log_image_.op_type_ = PhysiologicalImage::LogOpType::DELETE;
+  return clr;
+}
+
+IndexLog *LogFactory::NewIndexLog(const TxInfo &info, TableID index_id, std::vector<IndexPageOp> ops) {
+  return new IndexLog(info.lsn, info.prev_lsn, info.xid, index_id, std::move(ops));
+}
+
 }  // namespace dbtrain
@@ -6,6 +6,11 @@
 
 namespace dbtrain {
 
+class UpdateLog;
+class CompensationLog;
+class IndexLog;
+struct IndexPageOp;
+
 class LogFactory {
  public:
   struct TxInfo {
@@ -13,13 +18,30 @@ class LogFactory {
     LSN prev_lsn;
     XID xid;
   };
-  static Log *LoadLog(const Byte *src);
+  // 日志内容不含 LSN，由读取位置给出
+  static Log *LoadLog(LSN lsn, const Byte *src);
   static size_t StoreLog(Byte *dst, Log *log);
 
-  static Log *NewInsertLog(const TxInfo &info, const string &table_name, Rid rid, size_t new_len, const void *new_val);
-  static Log *NewDeleteLog(const TxInfo &info, const string &table_name, Rid rid, size_t old_len, const void *old_val);
-  static Log *NewUpdateLog(const TxInfo &info, const string &table_name, Rid rid, size_t old_len, const void *old_val,
-                           size_t new_len, const void *new_val);
+  // compress 为 true 时压缩较大的记录镜像
+  static Log *NewInsertLog(const TxInfo &info, TableID table_id, Rid rid, size_t len, const void *new_val,
+                           bool compress);
+  // 新记录与同一页面 base_slot 中的记录只有少量字节不同时使用，只记录不同的字节
+  static Log *NewInsertLog(const TxInfo &info, TableID table_id, Rid rid, size_t len, const void *new_val,
+                           SlotID base_slot, const void *base_val);
+  // new_val 为标记删除后的记录
+  static Log *NewDeleteLog(const TxInfo &info, TableID table_id, Rid rid, size_t len, const void *old_val,
+                           const void *new_val);
+  static Log *NewUpdateLog(const TxInfo &info, TableID table_id, Rid rid, size_t len, const void *old_val,
+                           const void *new_val);
+  // 回滚 log 的补偿日志，重做补偿日志即完成回滚
+  static CompensationLog *NewCompensationLog(const TxInfo &info, const UpdateLog &log, LSN undo_next_lsn);
+  // 清理释放 rid 处长为 len 的记录，以补偿日志的形式只重做不回滚，回滚清理事务时直接跳过
+  static CompensationLog *NewVacuumLog(const TxInfo &info, TableID table_id, Rid rid, size_t len);
+  // 索引页面的修改，同一页面的修改需相邻
+  static IndexLog *NewIndexLog(const TxInfo &info, TableID index_id, std::vector<IndexPageOp> ops);
+
+ private:
+  static UpdateLog *NewRecordLog(const TxInfo &info, TableID table_id, Rid rid, size_t len);
 };
 
 }  // namespace dbtrain
@@ -1,15 +1,58 @@
 #include "log_image.h"
 #include <iostream>
 
-#include "../system/system_manager.h"
+#include "../exception/exceptions.h"
+#include "../utils/lz4.h"
+#include "../utils/varint.h"
 
 namespace dbtrain {
 
-PhysiologicalImage::PhysiologicalImage() : old_val_(nullptr), new_val_(nullptr) {}
+// 操作类型与镜像格式共用一个字节
+static const uint8_t IMAGE_OP_MASK = 0x0F;
+static const uint8_t IMAGE_DELTA = 0x10;
+static const uint8_t IMAGE_COMPRESSED = 0x20;
+static const uint8_t IMAGE_REDO_ONLY = 0x40;
+// 小于该长度的镜像不压缩
+static const size_t LOG_COMPRESS_MIN_SIZE = 128;
+// 两段修改之间相同的字节不超过该值时合并为一个范围，省去一个范围的头部
+static const size_t LOG_DELTA_MERGE_GAP = 2;
 
-PhysiologicalImage::~PhysiologicalImage() {
-  if (old_val_ != nullptr) delete[] old_val_;
-  if (new_val_ != nullptr) delete[] new_val_;
+void DiffBytes(const Byte *old_val, const Byte *new_val, size_t begin, size_t end, std::vector<ByteRange> &ranges,
+               std::vector<Byte> *old_bytes, std::vector<Byte> &new_bytes) {
+  size_t i = begin;
+  while (i < end) {
+    if (old_val[i] == new_val[i]) {
+      i++;
+      continue;
+    }
+    size_t range_end = i + 1;
+    for (size_t j = range_end; j < end && j - range_end <= LOG_DELTA_MERGE_GAP; j++) {
+      if (old_val[j] != new_val[j]) range_end = j + 1;
+    }
+    ranges.push_back({i, range_end - i});
+    if (old_bytes != nullptr) old_bytes->insert(old_bytes->end(), old_val + i, old_val + range_end);
+    new_bytes.insert(new_bytes.end(), new_val + i, new_val + range_end);
+    i = range_end;
+  }
+}
+
+void PhysiologicalImage::SetDelta(const Byte *old_val, const Byte *new_val, bool keep_old) {
+  delta_ = true;
+  ranges_.clear();
+  old_bytes_.clear();
+  new_bytes_.clear();
+  DiffBytes(old_val, new_val, 0, length_, ranges_, keep_old ? &old_bytes_ : nullptr, new_bytes_);
+}
+
+void PhysiologicalImage::Compress() {
+  compressed_.clear();
+  if (delta_ || new_val_.size() < LOG_COMPRESS_MIN_SIZE) return;
+  std::vector<Byte> compressed(new_val_.size());
+  // 压缩后不短于原镜像时放弃
+  size_t compressed_len = Lz4Compress(new_val_.data(), new_val_.size(), compressed.data(), compressed.size() - 1);
+  if (compressed_len == 0) return;
+  compressed.resize(compressed_len);
+  compressed_ = std::move(compressed);
 }
 
 void PhysiologicalImage::Load(const Byte *src) {
@@ -17,43 +60,47 @@ void PhysiologicalImage::Load(const Byte *src) {
   // TIPS: 根据操作类型区分
   // LAB 2 BEGIN
   size_t offset = 0;
-  // string table_name_
-  size_t len_of_string = 0; // store '\0'
-  memcpy(&len_of_string, src + offset, sizeof(size_t));
-  offset += sizeof(size_t);
-
-  char* table_name = new char[len_of_string];
-  memcpy(table_name, src + offset, len_of_string);
-  offset += len_of_string;
-  table_name_.assign(table_name);
-  // PageID page_id_
-  memcpy(&page_id_, src + offset, sizeof(PageID));
-  offset += sizeof(PageID);
-  // SlotID slot_id_
-  memcpy(&slot_id_, src + offset, sizeof(SlotID));
-  offset += sizeof(SlotID);
-  // LogOpType op_type_
-  memcpy(&op_type_, src + offset, sizeof(LogOpType));
-  offset += sizeof(LogOpType);
-
-  if (op_type_ == LogOpType::DELETE || op_type_ == LogOpType::UPDATE) {
-    // size_t old_len_
-    memcpy(&old_len_, src + offset, sizeof(size_t));
-    offset += sizeof(size_t);
-    // Byte *old_val_
-    old_val_ = new Byte[old_len_];
-    memcpy(old_val_, src + offset, old_len_);
-    offset += old_len_;
+  offset += GetVarint(src + offset, table_id_);
+  offset += GetVarint(src + offset, page_id_);
+  offset += GetVarint(src + offset, slot_id_);
+  uint8_t flags = src[offset++];
+  op_type_ = (LogOpType)(flags & IMAGE_OP_MASK);
+  delta_ = (flags & IMAGE_DELTA) != 0;
+  redo_only_ = (flags & IMAGE_REDO_ONLY) != 0;
+  offset += GetVarint(src + offset, length_);
+  if (!delta_) {
+    new_val_.resize(length_);
+    if (flags & IMAGE_COMPRESSED) {
+      size_t compressed_len = 0;
+      offset += GetVarint(src + offset, compressed_len);
+      if (!Lz4Decompress(src + offset, compressed_len, new_val_.data(), length_)) {
+        std::cerr << "Error in PhysiologicalImage::Load\n";
+        throw UnknownError();
+      }
+    } else {
+      memcpy(new_val_.data(), src + offset, length_);
+    }
+    return;
   }
-  
-  if (op_type_ == LogOpType::INSERT || op_type_ == LogOpType::UPDATE) {
-    // size_t new_len_
-    memcpy(&new_len_, src + offset, sizeof(size_t));
-    offset += sizeof(size_t);
-    // Byte *new_val_
-    new_val_ = new Byte[new_len_];
-    memcpy(new_val_, src + offset, new_len_);
-    offset += new_len_;
+  base_slot_ = slot_id_;
+  if (op_type_ == LogOpType::INSERT) offset += GetVarint(src + offset, base_slot_);
+  size_t count = 0;
+  offset += GetVarint(src + offset, count);
+  ranges_.resize(count);
+  // 范围的起点以与上一个范围结尾的距离存储
+  size_t pos = 0;
+  for (auto &range : ranges_) {
+    size_t gap = 0;
+    offset += GetVarint(src + offset, gap);
+    offset += GetVarint(src + offset, range.length);
+    range.offset = pos + gap;
+    pos = range.offset + range.length;
+    if (op_type_ != LogOpType::INSERT && !redo_only_) {
+      old_bytes_.insert(old_bytes_.end(), src + offset, src + offset + range.length);
+      offset += range.length;
+    }
+    new_bytes_.insert(new_bytes_.end(), src + offset, src + offset + range.length);
+    offset += range.length;
   }
   // LAB 2 END
 }
@@ -63,76 +110,69 @@ size_t PhysiologicalImage::Store(Byte *dst) {
   // TIPS: 根据操作类型区分，返回Store的数据长度
   // LAB 2 BEGIN
   size_t offset = 0;
-  // string table_name_
-  size_t len_of_string = table_name_.size() + 1; // store '\0'
-  memcpy(dst + offset, &len_of_string, sizeof(size_t));
-  offset += sizeof(size_t);
-  memcpy(dst + offset, table_name_.c_str(), len_of_string);
-  offset += len_of_string;
-  // PageID page_id_
-  memcpy(dst + offset, &page_id_, sizeof(PageID));
-  offset += sizeof(PageID);
-  // SlotID slot_id_
-  memcpy(dst + offset, &slot_id_, sizeof(SlotID));
-  offset += sizeof(SlotID);
-  // LogOpType op_type_
-  memcpy(dst + offset, &op_type_, sizeof(LogOpType));
-  offset += sizeof(LogOpType);
-
-  if (op_type_ == LogOpType::DELETE || op_type_ == LogOpType::UPDATE) {
-    // size_t old_len_
-    memcpy(dst + offset, &old_len_, sizeof(size_t));
-    offset += sizeof(size_t);
-    // Byte *old_val_
-    memcpy(dst + offset, old_val_, old_len_);
-    offset += old_len_;
+  offset += PutVarint(dst + offset, table_id_);
+  offset += PutVarint(dst + offset, page_id_);
+  offset += PutVarint(dst + offset, slot_id_);
+  uint8_t flags = (uint8_t)op_type_;
+  if (delta_) flags |= IMAGE_DELTA;
+  if (!compressed_.empty()) flags |= IMAGE_COMPRESSED;
+  if (redo_only_) flags |= IMAGE_REDO_ONLY;
+  dst[offset++] = flags;
+  offset += PutVarint(dst + offset, length_);
+  if (!delta_) {
+    if (!compressed_.empty()) {
+      offset += PutVarint(dst + offset, compressed_.size());
+      memcpy(dst + offset, compressed_.data(), compressed_.size());
+      offset += compressed_.size();
+    } else {
+      memcpy(dst + offset, new_val_.data(), length_);
+      offset += length_;
+    }
+    return offset;
   }
-
-  if (op_type_ == LogOpType::INSERT || op_type_ == LogOpType::UPDATE) {
-    // size_t new_len_
-    memcpy(dst + offset, &new_len_, sizeof(size_t));
-    offset += sizeof(size_t);
-    // Byte *new_val_
-    memcpy(dst + offset, new_val_, new_len_);
-    offset += new_len_;
+  if (op_type_ == LogOpType::INSERT) offset += PutVarint(dst + offset, base_slot_);
+  offset += PutVarint(dst + offset, ranges_.size());
+  size_t pos = 0;
+  size_t bytes_pos = 0;
+  for (const auto &range : ranges_) {
+    offset += PutVarint(dst + offset, range.offset - pos);
+    offset += PutVarint(dst + offset, range.length);
+    pos = range.offset + range.length;
+    if (op_type_ != LogOpType::INSERT && !redo_only_) {
+      memcpy(dst + offset, old_bytes_.data() + bytes_pos, range.length);
+      offset += range.length;
+    }
+    memcpy(dst + offset, new_bytes_.data() + bytes_pos, range.length);
+    offset += range.length;
+    bytes_pos += range.length;
   }
-  
   return offset;
   // LAB 2 END
 }
 
+size_t PhysiologicalImage::GetRangesLength() const {
+  size_t length = VarintLength(ranges_.size());
+  size_t pos = 0;
+  for (const auto &range : ranges_) {
+    length += VarintLength(range.offset - pos) + VarintLength(range.length);
+    pos = range.offset + range.length;
+  }
+  return length + old_bytes_.size() + new_bytes_.size();
+}
+
 // get the length of the image(includes the variable info like len_of_string)
 size_t PhysiologicalImage::GetLength() const {
   // TODO: 获取Log Image的长度
   // TIPS: 根据操作类型区分
   // LAB 2 BEGIN
-  size_t offset = 0;
-  // string table_name_
-  size_t len_of_string = table_name_.size() + 1; // store '\0'
-  offset += sizeof(size_t);
-  offset += len_of_string;
-  // PageID page_id_
-  offset += sizeof(PageID);
-  // SlotID slot_id_
-  offset += sizeof(SlotID);
-  // LogOpType op_type_
-  offset += sizeof(LogOpType);
-
-  if (op_type_ == LogOpType::DELETE || op_type_ == LogOpType::UPDATE) {
-    // size_t old_len_
-    offset += sizeof(size_t);
-    // Byte *old_val_
-    offset += old_len_;
-  }
-
-  if (op_type_ == LogOpType::INSERT || op_type_ == LogOpType::UPDATE) {
-    // size_t new_len_
-    offset += sizeof(size_t);
-    // Byte *new_val_
-    offset += new_len_;
+  size_t length = VarintLength(table_id_) + VarintLength(page_id_) + VarintLength(slot_id_) + sizeof(uint8_t) +
+                  VarintLength(length_);
+  if (!delta_) {
+    if (compressed_.empty()) return length + length_;
+    return length + VarintLength(compressed_.size()) + compressed_.size();
   }
-  
-  return offset;
+  if (op_type_ == LogOpType::INSERT) length += VarintLength(base_slot_);
+  return length + GetRangesLength();
   // LAB 2 END
 }
 
@@ -1,15 +1,31 @@
 #ifndef DBTRAIN_LOG_IMAGE_H
 #define DBTRAIN_LOG_IMAGE_H
+#include <vector>
+
 #include "../defines.h"
 
 namespace dbtrain {
 
+// 记录内的一段字节
+struct ByteRange {
+  size_t offset;
+  size_t length;
+};
+
+// 比较 old_val 与 new_val 中 [begin, end) 的字节，不同的范围追加到 ranges，修改后的内容追加到 new_bytes，
+// old_bytes 不为空时同时保存修改前的内容
+void DiffBytes(const Byte *old_val, const Byte *new_val, size_t begin, size_t end, std::vector<ByteRange> &ranges,
+               std::vector<Byte> *old_bytes, std::vector<Byte> &new_bytes);
+
+// 页面内单条记录的修改
+// 插入保存新记录的完整镜像，较大的镜像可以压缩；更新时新版本与旧版本在同一页面中则只保存与旧版本不同的字节
+// 删除与原地更新只保存修改的字节范围及其修改前后的内容，重做与回滚都只覆盖这些字节，重复执行结果不变
 class PhysiologicalImage {
   enum class LogOpType { UPDATE, DELETE, INSERT };
 
  public:
-  PhysiologicalImage();
-  ~PhysiologicalImage();
+  PhysiologicalImage() = default;
+  ~PhysiologicalImage() = default;
 
   void Load(const Byte *src);
   size_t Store(Byte *dst);
@@ -17,12 +33,29 @@ class PhysiologicalImage {
   size_t GetLength() const;
 
  private:
-  string table_name_;
+  // 计算 old_val 与 new_val 不同的字节范围，keep_old 为 false 时只保存新内容
+  void SetDelta(const Byte *old_val, const Byte *new_val, bool keep_old);
+  // 镜像不小于 LOG_COMPRESS_MIN_SIZE 且压缩后更短时保存压缩结果
+  void Compress();
+  size_t GetRangesLength() const;
+
+  TableID table_id_;
   PageID page_id_;
   SlotID slot_id_;
   LogOpType op_type_;
-  Byte *old_val_, *new_val_;
-  size_t old_len_, new_len_;
+  // 记录长度
+  size_t length_;
+  // 完整镜像：插入的新记录，读取时已解压
+  std::vector<Byte> new_val_;
+  // 非空时为 new_val_ 的压缩结果，写入日志的是该数据
+  std::vector<Byte> compressed_;
+  // 增量镜像：以 base_slot_ 中的记录为基础，按 ranges_ 覆盖 old_bytes_ 或 new_bytes_ 中的内容
+  bool delta_ = false;
+  SlotID base_slot_ = 0;
+  std::vector<ByteRange> ranges_;
+  std::vector<Byte> old_bytes_, new_bytes_;
+  // 补偿日志只需重做，不保存修改前的内容
+  bool redo_only_ = false;
 
   friend class LogFactory;
   friend class UpdateLog;
@@ -30,4 +63,4 @@ class PhysiologicalImage {
 
 }  // namespace dbtrain
 
-#endif
\ No newline at end of file
+#endif
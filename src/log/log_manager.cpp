@@ -4,207 +4,684 @@
 #include "log.h"
 #include "log_factory.h"
 #include "logs.h"
+#include "../exception/exceptions.h"
+#include "../index/index.h"
+#include "../storage/buffer_manager.h"
+#include "../system/config_manager.h"
 #include "../system/system_manager.h"
 #include "../tx/tx_manager.h"
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <deque>
+#include <exception>
 #include <iostream>
+#include <queue>
+#include <thread>
 
 namespace dbtrain {
 
+// 队列满时读日志的线程等待，限制读入内存的日志数量
+static const size_t REDO_QUEUE_LIMIT = 1024;
+// 后台检查点线程检查是否需要执行检查点的间隔
+static const int CHECKPOINTER_POLL_MS = 1000;
+// 环形日志缓冲的大小范围，以及日志槽数量的下限
+static const size_t LOG_RING_MIN_SIZE = 64 * 1024;
+static const size_t LOG_RING_MAX_SIZE = 1 << 30;
+static const size_t LOG_SLOT_MIN_COUNT = 4096;
+
+static int64_t SteadyMillis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
 LogManager &LogManager::GetInstance() {
   static LogManager log_manager;
   return log_manager;
 }
 
 LogManager::LogManager() {
-  att_ = std::map<XID, LSN>();
-  dpt_ = std::map<UniquePageID, LSN>();
-  flushed_lsn_ = 0;
-  current_lsn_ = INIT_LSN;
   checkpoint_lsn_ = NULL_LSN;
+  checkpoint_begin_lsn_ = 0;
+  truncate_lsn_ = 0;
   TxManager::GetInstance().SetXID(INIT_XID);
+  flushing_ = false;
+  append_waiters_ = 0;
+  reserve_retries_ = 0;
+  buffer_full_waits_ = 0;
+  ConfigManager &config = ConfigManager::GetInstance();
+  buffer_limit_ = config.GetSize("wal-buffer-size", 1024 * 1024);
+  // 缓冲达到 wal-buffer-size 时提前落盘，其后写入的日志仍有空间
+  size_t ring_size = LOG_RING_MIN_SIZE;
+  while (ring_size < buffer_limit_ * 2 && ring_size < LOG_RING_MAX_SIZE) ring_size *= 2;
+  ring_.resize(ring_size);
+  slots_ = std::vector<LogSlot>(std::max(ring_size / 64, LOG_SLOT_MIN_COUNT));
+  ResetBuffer(INIT_LSN);
+  commit_delay_us_ = config.GetInt("commit-delay", 0);
+  if (commit_delay_us_ < 0) throw InvalidConfigError("commit-delay", std::to_string(commit_delay_us_));
+  std::string compression = config.GetString("wal-compression", "off");
+  if (compression != "off" && compression != "lz4") throw InvalidConfigError("wal-compression", compression);
+  compression_ = compression == "lz4";
+  commits_ = 0;
+  flushes_ = 0;
+  int workers = std::min<int>(std::max<int>(std::thread::hardware_concurrency(), 1), 8);
+  redo_workers_ = config.GetInt("recovery-workers", workers);
+  if (redo_workers_ < 1) throw InvalidConfigError("recovery-workers", std::to_string(redo_workers_));
+  analysed_logs_ = 0;
+  redo_logs_ = 0;
+  redo_applied_ = 0;
+  clr_logs_ = 0;
+  undo_running_ = false;
+  undo_stop_ = false;
+  checkpoint_wal_size_ = config.GetSize("checkpoint-wal-size", 16 * 1024 * 1024);
+  checkpoint_timeout_s_ = config.GetInt("checkpoint-timeout", 300);
+  if (checkpoint_timeout_s_ < 0) throw InvalidConfigError("checkpoint-timeout", std::to_string(checkpoint_timeout_s_));
+  checkpoints_ = 0;
+  wal_bytes_ = 0;
+  checkpoint_wal_bytes_ = 0;
+  checkpoint_time_ms_ = SteadyMillis();
+  checkpointer_stop_ = false;
+}
+
+LogManager::~LogManager() {
+  StopUndo();
+  StopCheckpointer();
 }
 
 void LogManager::Init() {
   // LogManager参数初始化
-  att_.clear();
-  dpt_.clear();
-  flushed_lsn_ = 0;
-  current_lsn_ = INIT_LSN;
+  LoadATT({});
+  LoadDPT({});
+  {
+    std::lock_guard<std::mutex> undo_lock(undo_mutex_);
+    undo_xids_.clear();
+  }
+  TxManager::GetInstance().SetRecovering({});
+  // 未落盘的日志随崩溃丢失
+  ResetBuffer(INIT_LSN);
   checkpoint_lsn_ = NULL_LSN;
+  checkpoint_begin_lsn_ = 0;
+  truncate_lsn_ = 0;
   TxManager::GetInstance().SetXID(INIT_XID);
 }
 
 void LogManager::Close() {
-  // TIPS: 可以实现缓存机制
-  // TIPS: 当使用日志缓存且存在未落盘日志时，先将剩余日志落盘
+  // 先将剩余日志落盘
+  Flush(GetCurrent());
 
   // LogManager参数初始化
-  flushed_lsn_ = 0;
-  current_lsn_ = INIT_LSN;
-  att_.clear();
-  dpt_.clear();
+  ResetBuffer(INIT_LSN);
+  checkpoint_begin_lsn_ = 0;
+  truncate_lsn_ = 0;
+  LoadATT({});
+  LoadDPT({});
 }
 
 void LogManager::Begin(XID xid) {
-  // 记录事务开始日志
-  LSN lsn = AppendLog();
-  LSN prev_lsn = NULL_LSN;
-  Log *log = new BeginLog(lsn, prev_lsn, xid);
-  WriteLog(log);
-  // 更新ATT
-  att_[xid] = lsn;
+  // 记录事务开始日志，同时将事务加入ATT
+  Log *log = new BeginLog(NULL_LSN, NULL_LSN, xid);
+  WriteTxLog(log, xid);
   delete log;
 }
 
 void LogManager::Commit(XID xid) {
   // 记录事务提交日志
-  LSN lsn = AppendLog();
-  LSN prev_lsn = att_[xid];
-  Log *log = new CommitLog(lsn, prev_lsn, xid);
-  WriteLog(log);
-  // 更新ATT
-  att_.erase(xid);
+  // 分配 LSN 后移出 ATT，之后的检查点在提交日志落盘后才会生效
+  Log *log = new CommitLog(NULL_LSN, GetLastLSN(xid), xid);
+  LSN lsn = FinishTxLog(log, xid);
+  // 提交日志落盘后事务才算提交
+  Flush(lsn);
+  commits_++;
   delete log;
 }
 
 void LogManager::Abort(XID xid) {
-  // 记录事务中止日志后回滚事务
-  // TIPS: 考虑回滚失败的情况需要添加CLR日志
+  // 记录事务中止日志后回滚事务，回滚完成后写入结束日志
   std::cerr << "< ---------- LogManager::Abort ----------->\n";
-  LSN lsn = AppendLog();
-  LSN prev_lsn = att_[xid];
-  Log *log = new AbortLog(lsn, prev_lsn, xid);
-  WriteLog(log);
+  // 与恢复时的分析过程一致，ATT 中记录中止日志的 LSN
+  Log *log = new AbortLog(NULL_LSN, GetLastLSN(xid), xid);
+  LSN lsn = WriteTxLog(log, xid);
+  // Undo 需要从磁盘读取该事务的日志
+  Flush(lsn);
   // Undo操作
   Undo(xid);
-  // 更新ATT
-  att_.erase(xid);
   delete log;
 }
 
 void LogManager::Checkpoint() {
-  // 记录Checkpoint日志后更新MasterRecord
-  LSN lsn = AppendLog();
-  Log *log = new CheckpointLog(lsn);
-  WriteLog(log);
+  // 模糊检查点：记录开始日志后取得 ATT 与 DPT 的快照，写入结束日志并落盘后更新MasterRecord
+  // 快照期间不阻塞事务，开始日志之后的修改可能已包含在快照中，恢复时重新分析这些日志即可
+  std::lock_guard<std::mutex> checkpoint_lock(checkpoint_mutex_);
+  Log *begin_log = new BeginCheckpointLog(NULL_LSN);
+  LSN begin_lsn = WriteLog(begin_log);
+  delete begin_log;
+  {
+    // LSN 小于 begin_lsn 的日志都已写入缓冲，它们对 ATT 与 DPT 的修改均已完成
+    std::unique_lock<std::mutex> log_lock(log_mutex_);
+    WaitBuffered(log_lock, begin_lsn);
+  }
+  // 检查点完成后，LSN 小于检查点开始日志、DPT 中最小的 recLSN 与运行中事务第一条日志的日志不再需要
+  LSN truncate_lsn = begin_lsn;
+  std::map<XID, TxEntry> att = GetATT();
+  for (const auto &pair : att) truncate_lsn = std::min(truncate_lsn, pair.second.first_lsn);
+  std::map<UniquePageID, LSN> dpt = GetDPT();
+  for (const auto &pair : dpt) truncate_lsn = std::min(truncate_lsn, pair.second);
+  Log *log = new CheckpointLog(NULL_LSN, begin_lsn, TxManager::GetInstance().GetXID(), att, dpt);
+  LSN lsn = WriteLog(log);
   delete log;
-  SystemManager::GetInstance().StoreMasterRecord();
+  Flush(lsn);
+  SystemManager::GetInstance().StoreMasterRecord(lsn);
+  // MASTER 落盘之后，恢复不会再读取更早的检查点
+  SystemManager::GetInstance().TruncateLog(truncate_lsn);
+  truncate_lsn_ = truncate_lsn;
+  checkpoint_lsn_ = lsn;
+  checkpoint_begin_lsn_ = begin_lsn;
+  checkpoint_wal_bytes_ = wal_bytes_.load();
+  checkpoint_time_ms_ = SteadyMillis();
+  checkpoints_++;
+}
+
+void LogManager::StartCheckpointer() {
+  if (checkpointer_.joinable() || (checkpoint_wal_size_ == 0 && checkpoint_timeout_s_ == 0)) return;
+  checkpointer_stop_ = false;
+  checkpoint_wal_bytes_ = wal_bytes_.load();
+  checkpoint_time_ms_ = SteadyMillis();
+  checkpointer_ = std::thread(&LogManager::CheckpointerLoop, this);
+}
+
+void LogManager::StopCheckpointer() {
+  if (!checkpointer_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> checkpointer_lock(checkpointer_mutex_);
+    checkpointer_stop_ = true;
+  }
+  checkpointer_cv_.notify_all();
+  checkpointer_.join();
 }
 
-void LogManager::InsertRecordLog(XID xid, const string &table_name, Rid rid, size_t new_len, const void *new_val) {
+bool LogManager::CheckpointDue() const {
+  size_t wal_bytes = wal_bytes_ - checkpoint_wal_bytes_;
+  if (checkpoint_wal_size_ > 0 && wal_bytes >= checkpoint_wal_size_) return true;
+  // 没有新日志时不需要按时间执行检查点
+  return checkpoint_timeout_s_ > 0 && wal_bytes > 0 &&
+         SteadyMillis() - checkpoint_time_ms_ >= (int64_t)checkpoint_timeout_s_ * 1000;
+}
+
+void LogManager::CheckpointerLoop() {
+  std::unique_lock<std::mutex> checkpointer_lock(checkpointer_mutex_);
+  while (!checkpointer_stop_) {
+    checkpointer_cv_.wait_for(checkpointer_lock, std::chrono::milliseconds(CHECKPOINTER_POLL_MS),
+                              [this] { return checkpointer_stop_ || CheckpointDue(); });
+    if (checkpointer_stop_ || !CheckpointDue()) continue;
+    checkpointer_lock.unlock();
+    try {
+      Checkpoint();
+    } catch (DbError &e) {
+      std::cerr << "LogManager: background checkpoint failed\n";
+    }
+    checkpointer_lock.lock();
+  }
+}
+
+LSN LogManager::InsertRecordLog(XID xid, TableID table_id, Rid rid, size_t len, const void *new_val) {
   // TODO: 记录数据插入日志
   // TIPS: 利用LogFactory生成日志信息
-  // TIPS: 注意需要按照算法更新ATT和DPT
-  // LAB 2 BEGIN
-  LSN lsn = AppendLog();
-  LSN prev_lsn = att_[xid];
-  LogFactory::TxInfo info = {lsn, prev_lsn, xid};
-  Log* log = LogFactory::NewInsertLog(info, table_name, rid, new_len, new_val);
-  WriteLog(log);
+  // LSN 在写入缓冲时分配
+  LogFactory::TxInfo info = {NULL_LSN, GetLastLSN(xid), xid};
+  Log *log = LogFactory::NewInsertLog(info, table_id, rid, len, new_val, compression_);
+  UniquePageID upid = {table_id, rid.page_no};
+  LSN lsn = WriteTxLog(log, xid, &upid);
   delete log;
-  att_[xid] = lsn;
-  UniquePageID upid = {table_name, rid.page_no};
-  if (dpt_.find(upid) == dpt_.end()) {
-    dpt_[upid] = lsn; // 找不到，说明是第一次修改该页面，添加到 dpt 中
-  }
-  // LAB 2 END
+  return lsn;
 }
 
-void LogManager::DeleteRecordLog(XID xid, const string &table_name, Rid rid, size_t old_len, const void *old_val) {
+LSN LogManager::InsertRecordLog(XID xid, TableID table_id, Rid rid, size_t len, const void *new_val,
+                                SlotID base_slot, const void *base_val) {
+  LogFactory::TxInfo info = {NULL_LSN, GetLastLSN(xid), xid};
+  Log *log = LogFactory::NewInsertLog(info, table_id, rid, len, new_val, base_slot, base_val);
+  UniquePageID upid = {table_id, rid.page_no};
+  LSN lsn = WriteTxLog(log, xid, &upid);
+  delete log;
+  return lsn;
+}
+
+LSN LogManager::DeleteRecordLog(XID xid, TableID table_id, Rid rid, size_t len, const void *old_val,
+                                const void *new_val) {
   // TODO: 记录数据删除日志
   // TIPS: 利用LogFactory生成日志信息
-  // TIPS: 注意需要按照算法更新ATT和DPT
-  // LAB 2 BEGIN
-  LSN lsn = AppendLog();
-  LSN prev_lsn = att_[xid];
-  LogFactory::TxInfo info = {lsn, prev_lsn, xid};
-  Log* log = LogFactory::NewDeleteLog(info, table_name, rid, old_len, old_val);
-  WriteLog(log);
+  LogFactory::TxInfo info = {NULL_LSN, GetLastLSN(xid), xid};
+  Log *log = LogFactory::NewDeleteLog(info, table_id, rid, len, old_val, new_val);
+  UniquePageID upid = {table_id, rid.page_no};
+  LSN lsn = WriteTxLog(log, xid, &upid);
   delete log;
-  att_[xid] = lsn;
-  UniquePageID upid = {table_name, rid.page_no};
-  if (dpt_.find(upid) == dpt_.end()) {
-    dpt_[upid] = lsn; // 找不到，说明是第一次修改该页面，添加到 dpt 中
-  }
-  // LAB 2 END
+  return lsn;
 }
 
-void LogManager::UpdateRecordLog(XID xid, const string &table_name, Rid rid, size_t old_len, const void *old_val,
-                                 size_t new_len, const void *new_val) {
+void LogManager::UpdateRecordLog(XID xid, TableID table_id, Rid rid, size_t len, const void *old_val,
+                                 const void *new_val) {
   // TODO: 记录数据更新日志
   // TIPS: 利用LogFactory生成日志信息
-  // TIPS: 注意需要按照算法更新ATT和DPT
-  // LAB 2 BEGIN
-  LSN lsn = AppendLog();
-  LSN prev_lsn = att_[xid];
-  LogFactory::TxInfo info = {lsn, prev_lsn, xid};
-  Log* log = LogFactory::NewUpdateLog(info, table_name, rid, old_len, old_val, new_len, new_val);
-  WriteLog(log);
+  LogFactory::TxInfo info = {NULL_LSN, GetLastLSN(xid), xid};
+  Log *log = LogFactory::NewUpdateLog(info, table_id, rid, len, old_val, new_val);
+  UniquePageID upid = {table_id, rid.page_no};
+  WriteTxLog(log, xid, &upid);
+  delete log;
+}
+
+LSN LogManager::VacuumRecordLog(XID xid, TableID table_id, Rid rid, size_t len) {
+  LogFactory::TxInfo info = {NULL_LSN, GetLastLSN(xid), xid};
+  Log *log = LogFactory::NewVacuumLog(info, table_id, rid, len);
+  UniquePageID upid = {table_id, rid.page_no};
+  LSN lsn = WriteTxLog(log, xid, &upid);
   delete log;
-  att_[xid] = lsn;
-  UniquePageID upid = {table_name, rid.page_no};
-  if (dpt_.find(upid) == dpt_.end()) {
-    dpt_[upid] = lsn; // 找不到，说明是第一次修改该页面，添加到 dpt 中
+  return lsn;
+}
+
+LSN LogManager::IndexPageLog(XID xid, TableID index_id, std::vector<IndexPageOp> ops) {
+  LogFactory::TxInfo info = {NULL_LSN, GetLastLSN(xid), xid};
+  IndexLog *log = LogFactory::NewIndexLog(info, index_id, std::move(ops));
+  std::vector<UniquePageID> upids = log->GetUniPageIDs();
+  LSN lsn = WriteTxLog(log, xid, upids.data(), upids.size());
+  // 与补偿日志一样先写日志再修改页面
+  try {
+    log->Redo();
+  } catch (...) {
+    delete log;
+    throw;
   }
-  // LAB 2 END
+  delete log;
+  return lsn;
 }
 
-void LogManager::WritePage(int fd, PageID page_id) {
+void LogManager::WritePage(int fd, PageID page_id, LSN page_lsn) {
   // 更新DPT
-  string table_name = SystemManager::GetInstance().GetTableByFd(fd);
-  if (dpt_.find({table_name, page_id}) != dpt_.end()) dpt_.erase({table_name, page_id});
+  TableID table_id = SystemManager::GetInstance().GetTableIDByFd(fd);
+  if (table_id == INVALID_TABLE_ID) return;
+  UniquePageID upid = {table_id, page_id};
+  LogTableShard<UniquePageID, PageEntry, UniquePageIDHash> &shard = GetDPTShard(upid);
+  std::lock_guard<std::mutex> dpt_lock(shard.mutex);
+  auto iter = shard.map.find(upid);
+  // 写回的页面不包含之后的日志的修改，保留该页面，下次写回时再删除
+  if (iter != shard.map.end() && iter->second.last_lsn <= page_lsn) shard.map.erase(iter);
 }
 
-LSN LogManager::GetCurrent() const { return current_lsn_ - 1; }
-
-void LogManager::WriteLog(Log *log) {
-  // TIPS: 可以在此处暂存部分Log实现缓存机制
-  // TIPS: 添加缓存机制时需要保证Commit时日志刷盘
-  log_mutex_.lock();
-  SystemManager::GetInstance().WriteLog(log);
-  log_mutex_.unlock();
+void LogManager::AddDirtyPage(const UniquePageID &upid, LSN lsn) {
+  LogTableShard<UniquePageID, PageEntry, UniquePageIDHash> &shard = GetDPTShard(upid);
+  std::lock_guard<std::mutex> dpt_lock(shard.mutex);
+  auto iter = shard.map.find(upid);
+  if (iter == shard.map.end()) {
+    shard.map[upid] = {lsn, lsn};
+  } else {
+    // 并发分配的 LSN 不一定按顺序到达，较小的 LSN 后到时也要降低 rec_lsn，否则检查点会截断或跳过它
+    iter->second.rec_lsn = std::min(iter->second.rec_lsn, lsn);
+    iter->second.last_lsn = std::max(iter->second.last_lsn, lsn);
+  }
 }
 
-LSN LogManager::AppendLog() {
+LSN LogManager::GetCurrent() const { return (LSN)(reserve_.load() >> 32) - 1; }
+
+LSN LogManager::GetFlushedLSN() const { return flushed_lsn_; }
+
+LSN LogManager::GetRedoTarget() const { return checkpoint_begin_lsn_; }
+
+LogReservation LogManager::Reserve(Log *log) {
   SystemManager::GetInstance().UsingTest();
-  lsn_mutex_.lock();
-  auto lsn = current_lsn_++;
-  lsn_mutex_.unlock();
-  return lsn;
+  // 日志长度依赖 LSN（前一条日志以差值记录），因此 LSN 与缓冲空间需在同一次 CAS 中分配
+  uint32_t ring_size = ring_.size();
+  uint64_t reserve = reserve_.load();
+  while (true) {
+    LSN lsn = reserve >> 32;
+    uint32_t pos = (uint32_t)reserve;
+    log->lsn_ = lsn;
+    uint32_t length = log->GetLength();
+    // 超过环形缓冲一半的日志单独存放在日志槽中，不占用环形缓冲
+    bool large = length > ring_size / 2;
+    uint32_t pad = 0;
+    uint32_t need = 0;
+    if (!large) {
+      // 日志在环形缓冲中连续存放，跨越末尾时跳过剩余空间
+      uint32_t offset = pos & (ring_size - 1);
+      if (offset + length > ring_size) pad = ring_size - offset;
+      need = pad + length;
+    }
+    uint64_t released = released_.load();
+    if (lsn - (LSN)(released >> 32) >= slots_.size() || pos + need - (uint32_t)released > ring_size) {
+      // 缓冲已满，将之前的日志落盘后重试
+      buffer_full_waits_++;
+      Flush(lsn - 1);
+      reserve = reserve_.load();
+      continue;
+    }
+    uint64_t next = ((uint64_t)(lsn + 1) << 32) | (uint32_t)(pos + need);
+    if (reserve_.compare_exchange_weak(reserve, next)) return {lsn, pos + pad, large ? 0 : length};
+    reserve_retries_++;
+  }
+}
+
+void LogManager::Publish(Log *log, const LogReservation &reservation) {
+  LogSlot &slot = slots_[reservation.lsn & (slots_.size() - 1)];
+  if (reservation.length == 0) {
+    slot.large.resize(log->GetLength());
+    LogFactory::StoreLog(slot.large.data(), log);
+  } else {
+    LogFactory::StoreLog(ring_.data() + (reservation.offset & (ring_.size() - 1)), log);
+  }
+  slot.offset = reservation.offset;
+  slot.length = reservation.length;
+  slot.ready.store(true);
+  // 先标记写入完成再检查等待者，等待者先登记再检查日志槽，二者至少有一方能看到对方
+  if (append_waiters_.load() > 0) {
+    std::lock_guard<std::mutex> log_lock(log_mutex_);
+    append_cv_.notify_all();
+  }
+  // 日志只写入缓冲，Commit 时再落盘，缓冲超过 wal-buffer-size 时提前落盘
+  if (reservation.length == 0 ||
+      reservation.offset + reservation.length - (uint32_t)released_.load() >= buffer_limit_) {
+    Flush(reservation.lsn);
+  }
+}
+
+LSN LogManager::WriteLog(Log *log) {
+  LogReservation reservation = Reserve(log);
+  Publish(log, reservation);
+  return reservation.lsn;
+}
+
+LSN LogManager::WriteTxLog(Log *log, XID xid, const UniquePageID *upids, size_t count) {
+  LogReservation reservation = Reserve(log);
+  {
+    LogTableShard<XID, TxEntry> &shard = GetATTShard(xid);
+    std::lock_guard<std::mutex> att_lock(shard.mutex);
+    auto iter = shard.map.find(xid);
+    if (iter == shard.map.end()) {
+      shard.map[xid] = {reservation.lsn, reservation.lsn};
+    } else {
+      iter->second.last_lsn = reservation.lsn;
+    }
+  }
+  for (size_t i = 0; upids != nullptr && i < count; i++) AddDirtyPage(upids[i], reservation.lsn);
+  Publish(log, reservation);
+  return reservation.lsn;
+}
+
+LSN LogManager::FinishTxLog(Log *log, XID xid) {
+  LogReservation reservation = Reserve(log);
+  {
+    LogTableShard<XID, TxEntry> &shard = GetATTShard(xid);
+    std::lock_guard<std::mutex> att_lock(shard.mutex);
+    shard.map.erase(xid);
+  }
+  Publish(log, reservation);
+  return reservation.lsn;
+}
+
+LSN LogManager::GetLastLSN(XID xid) {
+  LogTableShard<XID, TxEntry> &shard = GetATTShard(xid);
+  std::lock_guard<std::mutex> att_lock(shard.mutex);
+  auto iter = shard.map.find(xid);
+  return iter == shard.map.end() ? NULL_LSN : iter->second.last_lsn;
+}
+
+void LogManager::WaitBuffered(std::unique_lock<std::mutex> &log_lock, LSN lsn) {
+  size_t mask = slots_.size() - 1;
+  append_waiters_++;
+  while (true) {
+    // 日志槽在落盘后才会清空，已分配的 LSN 对应的槽写入完成即属于该 LSN
+    LSN next_lsn = reserve_.load() >> 32;
+    while (buffered_lsn_ + 1 < next_lsn && slots_[(buffered_lsn_ + 1) & mask].ready.load()) buffered_lsn_++;
+    if (buffered_lsn_ >= lsn) break;
+    append_cv_.wait(log_lock);
+  }
+  append_waiters_--;
+}
+
+void LogManager::Flush(LSN lsn) {
+  std::unique_lock<std::mutex> log_lock(log_mutex_);
+  while (flushed_lsn_ < lsn) {
+    if (flushing_) {
+      // 其他线程正在落盘，等待其完成后再检查
+      flush_cv_.wait(log_lock);
+      continue;
+    }
+    flushing_ = true;
+    if (commit_delay_us_ > 0 && TxManager::GetInstance().ActiveCount() > 1) {
+      // 还有其他事务在运行时，等待它们的提交日志进入缓冲，一并落盘
+      log_lock.unlock();
+      std::this_thread::sleep_for(std::chrono::microseconds(commit_delay_us_));
+      log_lock.lock();
+    }
+    // 日志文件按 LSN 顺序排列，需等待更小的 LSN 写入缓冲
+    WaitBuffered(log_lock, lsn);
+    LSN first_lsn = flushed_lsn_ + 1;
+    LSN batch_lsn = buffered_lsn_;
+    log_lock.unlock();
+    // 落盘期间只有当前线程读取这些日志槽，写入线程不会复用它们
+    size_t mask = slots_.size() - 1;
+    std::vector<Byte> raw_data;
+    std::vector<size_t> lengths;
+    for (LSN iter_lsn = first_lsn; iter_lsn <= batch_lsn; iter_lsn++) {
+      const LogSlot &slot = slots_[iter_lsn & mask];
+      if (slot.length == 0) {
+        raw_data.insert(raw_data.end(), slot.large.begin(), slot.large.end());
+        lengths.push_back(slot.large.size());
+      } else {
+        const Byte *data = ring_.data() + (slot.offset & (ring_.size() - 1));
+        raw_data.insert(raw_data.end(), data, data + slot.length);
+        lengths.push_back(slot.length);
+      }
+    }
+    try {
+      SystemManager::GetInstance().WriteLog(first_lsn, raw_data.data(), lengths);
+    } catch (DbError &e) {
+      log_lock.lock();
+      flushing_ = false;
+      flush_cv_.notify_all();
+      throw;
+    }
+    const LogSlot &last = slots_[batch_lsn & mask];
+    uint32_t released_pos = last.offset + last.length;
+    for (LSN iter_lsn = first_lsn; iter_lsn <= batch_lsn; iter_lsn++) {
+      LogSlot &slot = slots_[iter_lsn & mask];
+      slot.ready.store(false);
+      std::vector<Byte>().swap(slot.large);
+    }
+    log_lock.lock();
+    // 释放已落盘日志占用的缓冲空间与日志槽
+    released_ = ((uint64_t)(batch_lsn + 1) << 32) | released_pos;
+    flushed_lsn_ = batch_lsn;
+    flushes_++;
+    wal_bytes_ += raw_data.size();
+    flushing_ = false;
+    flush_cv_.notify_all();
+    if (checkpoint_wal_size_ > 0 && wal_bytes_ - checkpoint_wal_bytes_ >= checkpoint_wal_size_) {
+      checkpointer_cv_.notify_one();
+    }
+  }
+}
+
+void LogManager::ResetBuffer(LSN next_lsn) {
+  std::lock_guard<std::mutex> log_lock(log_mutex_);
+  for (LogSlot &slot : slots_) {
+    slot.ready.store(false);
+    std::vector<Byte>().swap(slot.large);
+  }
+  reserve_ = (uint64_t)next_lsn << 32;
+  released_ = (uint64_t)next_lsn << 32;
+  buffered_lsn_ = next_lsn - 1;
+  flushed_lsn_ = next_lsn - 1;
+}
+
+LogStatus LogManager::GetStatus() {
+  LogStatus status;
+  uint64_t reserve = reserve_.load();
+  uint64_t released = released_.load();
+  status.current_lsn = (LSN)(reserve >> 32) - 1;
+  status.flushed_lsn = flushed_lsn_;
+  status.buffered_logs = (LSN)(reserve >> 32) - (LSN)(released >> 32);
+  status.buffered_bytes = (uint32_t)reserve - (uint32_t)released;
+  status.reserve_retries = reserve_retries_;
+  status.buffer_full_waits = buffer_full_waits_;
+  status.commits = commits_;
+  status.flushes = flushes_;
+  status.fsyncs = flushes_;
+  status.commit_delay_us = commit_delay_us_;
+  status.wal_bytes = wal_bytes_;
+  status.compression = compression_;
+  status.analysed_logs = analysed_logs_;
+  status.redo_logs = redo_logs_;
+  status.redo_applied = redo_applied_;
+  status.redo_workers = redo_workers_;
+  status.clr_logs = clr_logs_;
+  {
+    std::lock_guard<std::mutex> undo_lock(undo_mutex_);
+    status.undo_pending_txns = undo_xids_.size();
+  }
+  status.checkpoints = checkpoints_;
+  status.checkpoint_begin_lsn = checkpoint_begin_lsn_;
+  status.checkpoint_lsn = checkpoint_lsn_;
+  status.checkpoint_wal_bytes = wal_bytes_ - checkpoint_wal_bytes_;
+  status.truncate_lsn = truncate_lsn_;
+  status.redo_start_lsn = NULL_LSN;
+  for (const auto &pair : GetDPT()) status.redo_start_lsn = std::min(status.redo_start_lsn, pair.second);
+  return status;
+}
+
+LogTableShard<XID, TxEntry> &LogManager::GetATTShard(XID xid) { return att_[xid % LOG_TABLE_SHARDS]; }
+
+LogTableShard<UniquePageID, PageEntry, UniquePageIDHash> &LogManager::GetDPTShard(const UniquePageID &upid) {
+  return dpt_[UniquePageIDHash()(upid) % LOG_TABLE_SHARDS];
+}
+
+std::map<XID, TxEntry> LogManager::GetATT() {
+  std::map<XID, TxEntry> att;
+  for (auto &shard : att_) {
+    std::lock_guard<std::mutex> att_lock(shard.mutex);
+    att.insert(shard.map.begin(), shard.map.end());
+  }
+  return att;
+}
+
+std::map<UniquePageID, LSN> LogManager::GetDPT() {
+  std::map<UniquePageID, LSN> dpt;
+  for (auto &shard : dpt_) {
+    std::lock_guard<std::mutex> dpt_lock(shard.mutex);
+    for (const auto &pair : shard.map) dpt[pair.first] = pair.second.rec_lsn;
+  }
+  return dpt;
+}
+
+void LogManager::LoadATT(const std::map<XID, TxEntry> &att) {
+  for (auto &shard : att_) {
+    std::lock_guard<std::mutex> att_lock(shard.mutex);
+    shard.map.clear();
+  }
+  for (const auto &pair : att) {
+    LogTableShard<XID, TxEntry> &shard = GetATTShard(pair.first);
+    std::lock_guard<std::mutex> att_lock(shard.mutex);
+    shard.map[pair.first] = pair.second;
+  }
+}
+
+void LogManager::LoadDPT(const std::map<UniquePageID, LSN> &dpt) {
+  for (auto &shard : dpt_) {
+    std::lock_guard<std::mutex> dpt_lock(shard.mutex);
+    shard.map.clear();
+  }
+  for (const auto &pair : dpt) {
+    LogTableShard<UniquePageID, PageEntry, UniquePageIDHash> &shard = GetDPTShard(pair.first);
+    std::lock_guard<std::mutex> dpt_lock(shard.mutex);
+    // 重做修改页面前会推后 last_lsn
+    shard.map[pair.first] = {pair.second, pair.second};
+  }
 }
 
 void LogManager::Analyse(LSN checkpoint_lsn) {
   // 根据ATT和DPT确定需要REDO的XID
-  LSN iter_lsn = checkpoint_lsn + 1;
-  Log *log = SystemManager::GetInstance().ReadLog(iter_lsn);
+  // 从检查点记录的 ATT 与 DPT 开始，分析检查点开始日志之后的所有日志
+  LSN iter_lsn = INIT_LSN;
+  std::map<XID, TxEntry> att;
+  std::map<UniquePageID, LSN> dpt;
+  if (checkpoint_lsn != 0) {
+    Log *log = SystemManager::GetInstance().ReadLog(checkpoint_lsn);
+    CheckpointLog *checkpoint_log = dynamic_cast<CheckpointLog *>(log);
+    if (checkpoint_log == nullptr) {
+      std::cerr << "Error in LogManager::Analyse\n";
+      delete log;
+      throw UnknownError();
+    }
+    att = checkpoint_log->GetATT();
+    dpt = checkpoint_log->GetDPT();
+    TxManager::GetInstance().SetXID(checkpoint_log->GetXID());
+    iter_lsn = checkpoint_log->GetBeginLSN() + 1;
+    checkpoint_begin_lsn_ = checkpoint_log->GetBeginLSN();
+    delete log;
+  }
+  // 顺序扫描检查点之后的日志，遇到校验失败的尾部即停止
+  LogReader reader = SystemManager::GetInstance().ScanLog(iter_lsn);
+  Log *log = reader.Next();
+  analysed_logs_ = 0;
+  // 新事务的编号需大于日志中出现过的所有事务，否则可能与待回滚的事务重复
+  XID max_xid = INVALID_XID;
+  // 检查点快照中的事务保留快照中的第一条日志，之后才出现的事务从其第一条日志开始
+  auto track = [&att](XID xid, LSN lsn) {
+    auto iter = att.find(xid);
+    if (iter == att.end()) {
+      att[xid] = {lsn, lsn};
+    } else {
+      iter->second.last_lsn = lsn;
+    }
+  };
   while (log != nullptr) {
     assert(log->GetLSN() == iter_lsn);
-    if (log->GetType() == LogType::COMMIT) {
-      CommitLog *commit_log = dynamic_cast<CommitLog *>(log);
-      XID xid = commit_log->GetXID();
-      assert(att_.find(xid) != att_.end());
-      att_.erase(xid);
-    } else if (log->GetType() == LogType::UPDATE) {
+    analysed_logs_++;
+    TxLog *tx_log = dynamic_cast<TxLog *>(log);
+    if (tx_log != nullptr) max_xid = std::max(max_xid, tx_log->GetXID());
+    if ((log->GetType() == LogType::COMMIT) || (log->GetType() == LogType::END)) {
+      XID xid = tx_log->GetXID();
+      // 在检查点快照之前提交或回滚完成的事务已不在 ATT 中
+      att.erase(xid);
+    } else if ((log->GetType() == LogType::UPDATE) || (log->GetType() == LogType::CLR)) {
       UpdateLog *update_log = dynamic_cast<UpdateLog *>(log);
-      XID xid = update_log->GetXID();
-      att_[xid] = log->GetLSN();
+      track(update_log->GetXID(), log->GetLSN());
       // 更新DPT
       UniquePageID uid = update_log->GetUniPageID();
-      if (dpt_.find(uid) == dpt_.end()) dpt_[uid] = log->GetLSN();
+      if (dpt.find(uid) == dpt.end()) dpt[uid] = log->GetLSN();
+    } else if (log->GetType() == LogType::INDEX) {
+      track(tx_log->GetXID(), log->GetLSN());
+      for (const auto &uid : dynamic_cast<IndexLog *>(log)->GetUniPageIDs()) {
+        if (dpt.find(uid) == dpt.end()) dpt[uid] = log->GetLSN();
+      }
     } else if ((log->GetType() == LogType::BEGIN) || (log->GetType() == LogType::ABORT)) {
-      TxLog *tx_log = dynamic_cast<TxLog *>(log);
-      XID xid = tx_log->GetXID();
-      att_[xid] = log->GetLSN();
-    } else {
+      track(tx_log->GetXID(), log->GetLSN());
+    } else if ((log->GetType() != LogType::CHECKPOINT) && (log->GetType() != LogType::BEGIN_CHECKPOINT)) {
       assert(false);
     }
     delete log;
     ++iter_lsn;
-    log = SystemManager::GetInstance().ReadLog(iter_lsn);
+    log = reader.Next();
+  }
+  if (max_xid != INVALID_XID && max_xid >= TxManager::GetInstance().GetXID()) {
+    TxManager::GetInstance().SetXID(max_xid + 1);
   }
   checkpoint_lsn_ = checkpoint_lsn;
-  current_lsn_ = iter_lsn;
+  // 已删除的表与索引的页面不再重做
+  SystemManager &system_manager = SystemManager::GetInstance();
+  for (auto iter = dpt.begin(); iter != dpt.end();) {
+    iter = system_manager.Exists(iter->first.table_id) ? std::next(iter) : dpt.erase(iter);
+  }
+  // 后台回滚期间的检查点只保留未完成事务第一条日志之后的日志
+  LoadATT(att);
+  LoadDPT(dpt);
+  for (const auto &pair : dpt) {
+    Index *index = system_manager.GetIndex(pair.first.table_id);
+    if (index != nullptr) {
+      index->ExtendTo(pair.first.page_id + 1);
+    } else {
+      system_manager.GetTable(pair.first.table_id)->ExtendTo(pair.first.page_id + 1);
+    }
+  }
+  // 读到的日志均已落盘
+  ResetBuffer(iter_lsn);
 }
 
 void LogManager::Redo() {
@@ -212,58 +689,185 @@ void LogManager::Redo() {
   // TIPS: 按照ARIES算法，需要读取DPT获取最小的Record LSN
   // TIPS: 从最小RecLSN开始REDO，根据PageLSN部分数据不需要REDO
   // LAB 2 BEGIN
+  // 使用分析阶段得到的 DPT 决定是否重做，dpt_ 按重做实际修改的页面重建
+  // 重做时发现已包含全部修改的页面不再加入，否则恢复后直到该页面再次写回，检查点都无法截断其 recLSN 之后的日志
+  std::map<UniquePageID, LSN> dpt = GetDPT();
+  LoadDPT({});
   LSN min_record_lsn = UINT_MAX;
-  // LSN current_lsn = current_lsn_;
-  for (auto& pair: dpt_) {
+  for (auto& pair: dpt) {
     LSN lsn = pair.second;
     if (min_record_lsn > lsn) {
       min_record_lsn = lsn;
     }
   }
-  LSN iter_lsn = min_record_lsn;
-  Log *log = SystemManager::GetInstance().ReadLog(iter_lsn);
-  while (log != nullptr) {
-    assert(log->GetLSN() == iter_lsn);
-    if (log->GetType() == LogType::UPDATE) {
-      UpdateLog *update_log = dynamic_cast<UpdateLog *>(log);
-      // 查找 dpt，只有该 log 对应的 page 在 dpt 中，才有可能要 redo
-      UniquePageID uid = update_log->GetUniPageID();
-      if (dpt_.find(uid) != dpt_.end()) {
-        LSN rec_lsn = dpt_[uid];
-        // 只有 iter_lsn >= rec_lsn，才有可能要 redo
-        if (iter_lsn >= rec_lsn) {
-          Table* table = SystemManager::GetInstance().GetTable(uid.table_name);
-          PageHandle page_handle = table->GetPage(uid.page_id);
-          // 只有 iter_lsn > page_lsn，才需要 redo
-          if (iter_lsn > page_handle.GetLSN()) {
-            // redo!
-            update_log->Redo();
+  redo_logs_ = 0;
+  redo_applied_ = 0;
+  if (dpt.empty()) return;
+  // 按 DPT 预读脏页，最多占用缓冲池的一半，其余页面由各 Redo 线程按需并行读入
+  size_t prefetch_limit = BufferManager::GetInstance().GetStatus().capacity / 2;
+  std::map<TableID, vector<PageID>> prefetch_pages;
+  size_t prefetch_count = 0;
+  for (const auto &pair : dpt) {
+    if (prefetch_count++ >= prefetch_limit) break;
+    prefetch_pages[pair.first.table_id].push_back(pair.first.page_id);
+  }
+  for (const auto &pair : prefetch_pages) {
+    Index *index = SystemManager::GetInstance().GetIndex(pair.first);
+    if (index != nullptr) {
+      index->Prefetch(pair.second);
+    } else {
+      SystemManager::GetInstance().GetTable(pair.first)->Prefetch(pair.second);
+    }
+  }
+
+  std::vector<RedoQueue> queues(redo_workers_);
+  std::vector<std::thread> workers;
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  if (queues.size() > 1) {
+    for (auto &queue : queues) {
+      workers.emplace_back([this, &queue, &error_mutex, &error] {
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        while (true) {
+          queue.cv.wait(lock, [&queue] { return queue.done || !queue.logs.empty(); });
+          if (queue.logs.empty()) break;
+          TxLog *log = queue.logs.front();
+          queue.logs.pop_front();
+          lock.unlock();
+          queue.cv.notify_all();
+          try {
+            if (RedoLog(log)) redo_applied_++;
+          } catch (...) {
+            std::lock_guard<std::mutex> error_lock(error_mutex);
+            if (!error) error = std::current_exception();
           }
+          delete log;
+          lock.lock();
         }
-      }
+      });
     }
-    delete log;
-    ++iter_lsn;
-    if (iter_lsn == checkpoint_lsn_) { // 跳过 checkpoint_lsn
-      ++iter_lsn;
-    }
-    log = SystemManager::GetInstance().ReadLog(iter_lsn);
   }
 
+  try {
+    RedoDispatch(min_record_lsn, dpt, queues);
+  } catch (...) {
+    std::lock_guard<std::mutex> error_lock(error_mutex);
+    if (!error) error = std::current_exception();
+  }
+  for (auto &queue : queues) {
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.done = true;
+    }
+    queue.cv.notify_all();
+  }
+  for (auto &worker : workers) worker.join();
+  if (error) std::rethrow_exception(error);
+  // 空闲空间映射不记录日志，按重做后的页面更新 DPT 中的页面
+  for (const auto &pair : dpt) {
+    if (SystemManager::GetInstance().GetIndex(pair.first.table_id) != nullptr) continue;
+    Table *table = SystemManager::GetInstance().GetTable(pair.first.table_id);
+    PageHandle page_handle = table->GetPage(pair.first.page_id);
+    table->UpdateFreeSpace(page_handle);
+  }
   // LAB 2 END
 }
 
+void LogManager::RedoDispatch(LSN min_record_lsn, const std::map<UniquePageID, LSN> &dpt,
+                              std::vector<RedoQueue> &queues) {
+  LSN iter_lsn = min_record_lsn;
+  LogReader reader = SystemManager::GetInstance().ScanLog(iter_lsn);
+  Log *log = reader.Next();
+  while (log != nullptr) {
+    iter_lsn = log->GetLSN();
+    // 补偿日志、索引日志与修改日志一样重做
+    TxLog *redo_log = nullptr;
+    std::vector<UniquePageID> uids;
+    if ((log->GetType() == LogType::UPDATE) || (log->GetType() == LogType::CLR)) {
+      uids.push_back(dynamic_cast<UpdateLog *>(log)->GetUniPageID());
+    } else if (log->GetType() == LogType::INDEX) {
+      uids = dynamic_cast<IndexLog *>(log)->GetUniPageIDs();
+    }
+    // 查找 dpt，只有该 log 修改的某个 page 在 dpt 中，且 iter_lsn >= rec_lsn，才有可能要 redo
+    for (const auto &uid : uids) {
+      auto iter = dpt.find(uid);
+      if (iter != dpt.end() && iter_lsn >= iter->second) redo_log = dynamic_cast<TxLog *>(log);
+    }
+    if (redo_log == nullptr) {
+      // checkpoint 等不需要重做的日志直接跳过
+      delete log;
+    } else if (queues.size() == 1) {
+      redo_logs_++;
+      bool applied = false;
+      try {
+        applied = RedoLog(redo_log);
+      } catch (...) {
+        delete log;
+        throw;
+      }
+      if (applied) redo_applied_++;
+      delete log;
+    } else {
+      redo_logs_++;
+      // 索引日志按索引划分，修改同一索引的日志由同一线程按 LSN 顺序重做
+      UniquePageID uid = uids.front();
+      if (log->GetType() == LogType::INDEX) uid.page_id = 0;
+      size_t hash = std::hash<TableID>()(uid.table_id) * 31 + uid.page_id;
+      RedoQueue &queue = queues[hash % queues.size()];
+      std::unique_lock<std::mutex> lock(queue.mutex);
+      queue.cv.wait(lock, [&queue] { return queue.logs.size() < REDO_QUEUE_LIMIT; });
+      queue.logs.push_back(redo_log);
+      lock.unlock();
+      queue.cv.notify_all();
+    }
+    log = reader.Next();
+  }
+}
+
+bool LogManager::RedoLog(TxLog *log) {
+  // 索引日志按各页面的 LSN 分别判断
+  if (log->GetType() == LogType::INDEX) return dynamic_cast<IndexLog *>(log)->Redo();
+  UpdateLog *update_log = dynamic_cast<UpdateLog *>(log);
+  UniquePageID uid = update_log->GetUniPageID();
+  Table *table = SystemManager::GetInstance().GetTable(uid.table_id);
+  PageHandle page_handle = table->GetPage(uid.page_id);
+  // 只有 lsn > page_lsn，才需要 redo
+  if (log->GetLSN() <= page_handle.GetLSN()) return false;
+  AddDirtyPage(uid, log->GetLSN());
+  update_log->Redo();
+  return true;
+}
+
 void LogManager::Undo() {
   // 在目前实现方法下，所有处于ATT中的事务都为正在运行状态
-  // Undo过程需要回滚所有的ATT表中事务
-  std::cerr << "att_size: " << att_.size() << "\n";
-  for (const auto &att_pair : att_) {
-    std::cerr << "in the loop\n";
-    Undo(att_pair.first);
-    // 清除ATT表对应项
+  // Undo过程需要回滚所有的ATT表中事务，Redo 完成后即可接受新事务，回滚在后台进行
+  std::map<XID, LSN> next_lsns;
+  std::set<XID> xids;
+  for (const auto &att_pair : GetATT()) {
+    next_lsns[att_pair.first] = att_pair.second.last_lsn;
+    xids.insert(att_pair.first);
+  }
+  std::cerr << "att_size: " << next_lsns.size() << "\n";
+  if (next_lsns.empty()) return;
+  {
+    std::lock_guard<std::mutex> undo_lock(undo_mutex_);
+    undo_xids_ = xids;
   }
-  std::cerr << "ending: " << att_.size() << "\n";
-  att_.clear();
+  TxManager::GetInstance().SetRecovering(xids);
+  StopUndo();
+  undo_running_ = true;
+  undoer_ = std::thread([this, next_lsns] {
+    try {
+      UndoTransactions(next_lsns, true);
+    } catch (DbError &e) {
+      std::cerr << "LogManager: background undo failed\n";
+    }
+    {
+      std::lock_guard<std::mutex> undo_lock(undo_mutex_);
+      undo_running_ = false;
+    }
+    undo_cv_.notify_all();
+  });
 }
 
 bool LogManager::Undo(XID xid) {
@@ -272,34 +876,102 @@ bool LogManager::Undo(XID xid) {
   // TIPS: 每次读取Previous LSN读取之前的日志
   // TIPS: 直到事务开始时停止回滚过程
   // TIPS: 利用Update Log的Undo功能可以实现数据恢复
-  // TIPS: 基础功能下不需要考虑回滚过程中CRASH
   // LAB 2 BEGIN
-  // std::cerr << " < ----- LogManager::Undo ----- >\n";
-  std::cerr << "undoing xid: " << xid << "\n";
-  LSN last_lsn = att_[xid];
-  Log *log = SystemManager::GetInstance().ReadLog(last_lsn);
-  // std::cerr << " < ----- begining loop\n";
-  while(log != nullptr) {
-    if (log->GetType() == LogType::UPDATE) {
-      UpdateLog *update_log = dynamic_cast<UpdateLog *>(log);
-      update_log->Undo();
+  {
+    LogTableShard<XID, TxEntry> &shard = GetATTShard(xid);
+    std::lock_guard<std::mutex> att_lock(shard.mutex);
+    if (shard.map.find(xid) == shard.map.end()) return false;
+  }
+  LSN last_lsn = GetLastLSN(xid);
+  return UndoTransactions({{xid, last_lsn}}, false);
+  // LAB 2 END
+}
+
+void LogManager::WaitUndo() {
+  if (!undo_running_) return;
+  std::unique_lock<std::mutex> undo_lock(undo_mutex_);
+  undo_cv_.wait(undo_lock, [this] { return !undo_running_; });
+}
+
+void LogManager::StopUndo() {
+  if (!undoer_.joinable()) return;
+  undo_stop_ = true;
+  undoer_.join();
+  undo_stop_ = false;
+}
+
+bool LogManager::UndoTransactions(std::map<XID, LSN> next_lsns, bool stoppable) {
+  // 大根堆，每次取出所有事务中 LSN 最大的待回滚日志，页面按修改的相反顺序回滚
+  std::priority_queue<std::pair<LSN, XID>> to_undo;
+  for (const auto &pair : next_lsns) {
+    if (pair.second == NULL_LSN) {
+      EndUndo(pair.first);
+    } else {
+      to_undo.push({pair.second, pair.first});
     }
-    TxLog *tx_log = dynamic_cast<TxLog *>(log);
-    LSN prev_lsn = tx_log->GetPrevLSN();
-    std::cerr << "log lsn: "<< log->GetLSN() << ", type: " << (int)log->GetType() << ", prev_lsn: " << prev_lsn << "\n";
-    if (prev_lsn == NULL_LSN) {
-      break;
+  }
+  while (!to_undo.empty()) {
+    if (stoppable && undo_stop_) return false;
+    auto [lsn, xid] = to_undo.top();
+    to_undo.pop();
+    Log *log = SystemManager::GetInstance().ReadLog(lsn);
+    if (log == nullptr) {
+      std::cerr << "Error in LogManager::UndoTransactions\n";
+      throw UnknownError();
+    }
+    LSN next_lsn = NULL_LSN;
+    if (log->GetType() == LogType::CLR) {
+      // 补偿日志之后的修改均已回滚，跳到被补偿日志的前一条继续
+      next_lsn = dynamic_cast<CompensationLog *>(log)->GetUndoNextLSN();
+    } else {
+      if (log->GetType() == LogType::UPDATE) {
+        try {
+          UndoLog(dynamic_cast<UpdateLog *>(log));
+        } catch (...) {
+          delete log;
+          throw;
+        }
+      }
+      next_lsn = dynamic_cast<TxLog *>(log)->GetPrevLSN();
     }
     delete log;
-    log = SystemManager::GetInstance().ReadLog(prev_lsn);
+    if (next_lsn == NULL_LSN) {
+      EndUndo(xid);
+    } else {
+      to_undo.push({next_lsn, xid});
+    }
   }
-  // std::cerr << " < ----- ending loop\n";
-  // LSN lsn = AppendLog();
-  // LSN prev_lsn = att_[xid];
-  // Log *abort_log = new AbortLog(lsn, prev_lsn, xid);
-  // WriteLog(log);
   return true;
-  // LAB 2 END
+}
+
+void LogManager::UndoLog(UpdateLog *log) {
+  LogFactory::TxInfo info = {NULL_LSN, GetLastLSN(log->GetXID()), log->GetXID()};
+  CompensationLog *clr = LogFactory::NewCompensationLog(info, *log, log->GetPrevLSN());
+  UniquePageID upid = log->GetUniPageID();
+  // 补偿日志写入后再修改页面，页面 LSN 随之增大，崩溃后重做补偿日志即可恢复回滚结果
+  // 后台回滚与其他事务并发修改同一页面，修改完成前页面不能写回
+  try {
+    PageHandle page_handle = SystemManager::GetInstance().GetTable(upid.table_id)->GetPage(upid.page_id);
+    PageUpdate update = page_handle.BeginUpdate();
+    WriteTxLog(clr, log->GetXID(), &upid);
+    clr->Redo();
+  } catch (...) {
+    delete clr;
+    throw;
+  }
+  clr_logs_++;
+  delete clr;
+}
+
+void LogManager::EndUndo(XID xid) {
+  Log *log = new EndLog(NULL_LSN, GetLastLSN(xid), xid);
+  FinishTxLog(log, xid);
+  delete log;
+  {
+    std::lock_guard<std::mutex> undo_lock(undo_mutex_);
+    undo_xids_.erase(xid);
+  }
+  TxManager::GetInstance().EndRecovering(xid);
 }
 
 }  // namespace dbtrain
@@ -1,30 +1,138 @@
 #ifndef DBTRAIN_LOG_MANAGER_H
 #define DBTRAIN_LOG_MANAGER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "../defines.h"
 #include "log.h"
+#include "log_factory.h"
 
 namespace dbtrain {
 
 struct UniquePageID {
-  string table_name;
+  TableID table_id;
   PageID page_id;
   bool operator<(const UniquePageID &uid) const {
-    if (table_name != uid.table_name) {
-      return table_name < uid.table_name;
+    if (table_id != uid.table_id) {
+      return table_id < uid.table_id;
     } else {
       return page_id < uid.page_id;
     }
   }
+  bool operator==(const UniquePageID &uid) const { return table_id == uid.table_id && page_id == uid.page_id; }
 };
 
+struct UniquePageIDHash {
+  size_t operator()(const UniquePageID &uid) const { return std::hash<TableID>()(uid.table_id) * 31 + uid.page_id; }
+};
+
+// ATT 中一个事务的日志范围，回滚需要读取 first_lsn 之后该事务的所有日志
+struct TxEntry {
+  LSN first_lsn;
+  LSN last_lsn;
+};
+
+// DPT 中一个页面的日志范围，rec_lsn 为页面写回后第一条修改它的日志，last_lsn 为最后一条
+struct PageEntry {
+  LSN rec_lsn;
+  LSN last_lsn;
+};
+
+static const int LOG_TABLE_SHARDS = 16;
+
+// ATT 与 DPT 按键分片，不同分片的修改互不阻塞
+template <class K, class V, class Hash = std::hash<K>>
+struct LogTableShard {
+  std::mutex mutex;
+  std::unordered_map<K, V, Hash> map;
+};
+
+// 日志缓冲中的一条日志，按 LSN 取模存放
+// 写入线程写完日志内容后设置 ready，落盘线程按 LSN 顺序收集连续的 ready 日志，落盘后清除
+struct LogSlot {
+  std::atomic<bool> ready{false};
+  // 在环形缓冲中的位置，单调增加，对缓冲大小取模后为实际偏移
+  uint32_t offset;
+  uint32_t length;
+  // 超过缓冲一半的日志不放入环形缓冲，单独存放
+  std::vector<Byte> large;
+};
+
+// 为一条日志预留的 LSN 与缓冲空间
+struct LogReservation {
+  LSN lsn;
+  uint32_t offset;
+  uint32_t length;
+};
+
+class TxLog;
+class UpdateLog;
+class CompensationLog;
+struct IndexPageOp;
+
+// 每个 Redo 线程一个队列，同一页面的日志总是进入同一个队列，保证页面内按 LSN 顺序重做
+// 同一索引的日志进入同一个队列，一条日志可以修改多个索引页面
+struct RedoQueue {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<TxLog *> logs;
+  bool done = false;
+};
+
+// 日志运行状态，用于 SHOW LOG STATUS
+struct LogStatus {
+  LSN current_lsn;
+  LSN flushed_lsn;
+  // 日志缓冲中尚未落盘的日志条数与字节数
+  size_t buffered_logs;
+  size_t buffered_bytes;
+  // 预留缓冲时 CAS 失败重试的次数，以及缓冲已满需先落盘的次数
+  size_t reserve_retries;
+  size_t buffer_full_waits;
+  size_t commits;
+  // 日志落盘次数，每次落盘对数据与索引文件各 fsync 一次
+  size_t flushes;
+  size_t fsyncs;
+  int commit_delay_us;
+  // 已落盘的日志字节数，不含日志存储的头部
+  size_t wal_bytes;
+  bool compression;
+  // 最近一次恢复：分析的日志数、分发给 Redo 线程的日志数、实际重做的日志数与 Redo 线程数
+  size_t analysed_logs;
+  size_t redo_logs;
+  size_t redo_applied;
+  int redo_workers;
+  // 后台尚未回滚完成的事务数，以及启动以来写入的补偿日志数
+  size_t undo_pending_txns;
+  size_t clr_logs;
+  // 已完成的检查点数量、最近一次检查点的开始与结束 LSN，以及之后新写入的日志字节数
+  size_t checkpoints;
+  LSN checkpoint_begin_lsn;
+  LSN checkpoint_lsn;
+  size_t checkpoint_wal_bytes;
+  // 最近一次检查点后可以截断的日志上界，LSN 小于该值的日志段可以移除
+  LSN truncate_lsn;
+  // 当前 DPT 中最小的 recLSN，即此时崩溃后 Redo 的起点
+  LSN redo_start_lsn;
+};
+
+// 日志先写入内存缓冲，事务提交、回滚与写回页面前按需落盘
+// 写入缓冲不加锁：每条日志用一次 CAS 同时取得 LSN 与环形缓冲中的空间，各线程并行写入各自的空间
+// 组提交：同一时间只有一个线程执行落盘，其余等待的线程由该次落盘一并完成
+// 模糊检查点：检查点期间事务照常运行，后台检查点线程按日志量或时间间隔自动执行
+// 回滚写入补偿日志，恢复在 Redo 完成后即可接受新事务，未完成事务在后台回滚
 class LogManager {
  public:
   static LogManager &GetInstance();
-  ~LogManager() = default;
+  ~LogManager();
   LogManager(const LogManager &) = delete;
   void operator=(const LogManager &) = delete;
 
@@ -32,42 +140,159 @@ class LogManager {
   void Commit(XID xid);
   void Abort(XID xid);
   void Checkpoint();
+  // 打开数据库后启动后台检查点线程，关闭或崩溃前停止
+  void StartCheckpointer();
+  void StopCheckpointer();
 
-  void InsertRecordLog(XID xid, const string &table_name, Rid rid, size_t new_len, const void *new_val);
-  void DeleteRecordLog(XID xid, const string &table_name, Rid rid, size_t old_len, const void *old_val);
-  void UpdateRecordLog(XID xid, const string &table_name, Rid rid, size_t old_len, const void *old_val, size_t new_len,
-                       const void *new_val);
+  // 记录日志只保存修改的字节，插入的完整镜像在 wal-compression 打开时压缩，返回日志的 LSN
+  LSN InsertRecordLog(XID xid, TableID table_id, Rid rid, size_t len, const void *new_val);
+  // 更新时新版本与同一页面 base_slot 中的旧版本只有少量字节不同，只记录不同的字节
+  LSN InsertRecordLog(XID xid, TableID table_id, Rid rid, size_t len, const void *new_val, SlotID base_slot,
+                      const void *base_val);
+  // new_val 为标记删除后的记录
+  LSN DeleteRecordLog(XID xid, TableID table_id, Rid rid, size_t len, const void *old_val, const void *new_val);
+  void UpdateRecordLog(XID xid, TableID table_id, Rid rid, size_t len, const void *old_val, const void *new_val);
+  // 清理事务释放 rid 处对所有事务都不可见的记录
+  LSN VacuumRecordLog(XID xid, TableID table_id, Rid rid, size_t len);
+  // 记录索引页面的修改并修改页面，返回日志的 LSN
+  LSN IndexPageLog(XID xid, TableID index_id, std::vector<IndexPageOp> ops);
 
-  void WritePage(int fd, PageID page_id);
+  // 页面已写回，page_lsn 为写回的页面内容的 LSN
+  // 写回期间页面可能又被新的日志修改，只有 last_lsn 不大于 page_lsn 时才从 DPT 中删除
+  void WritePage(int fd, PageID page_id, LSN page_lsn);
+  // 页面将被 LSN 为 lsn 的日志修改，加入 DPT 或推后其 last_lsn；重做修改页面之前调用
+  void AddDirtyPage(const UniquePageID &upid, LSN lsn);
   // 切换数据库初始化
   void Close();
   LSN GetCurrent() const;
+  // 已经落盘的最大 LSN，LSN 大于该值的页面不能被写回
+  LSN GetFlushedLSN() const;
+  // 最近一次检查点的开始 LSN，recLSN 早于该值的脏页应优先写回，使下一次检查点的 Redo 起点不早于本次检查点
+  LSN GetRedoTarget() const;
+  // 保证 LSN 不超过 lsn 的日志均已落盘
+  void Flush(LSN lsn);
+  LogStatus GetStatus();
   void Init();
 
   void Analyse(LSN checkpoint_lsn);
   void Redo();
+  // 启动后台线程回滚分析得到的未完成事务
   void Undo();
   bool Undo(XID xid);
+  // 等待后台回滚完成，修改已有记录前调用，避免与回滚修改同一条记录
+  void WaitUndo();
+  // 崩溃前停止后台回滚，剩余的部分由下次恢复根据补偿日志继续
+  void StopUndo();
 
  private:
   LogManager();
-  void WriteLog(Log *log);
-  LSN AppendLog();
+  // 顺序读取日志，将需要重做的日志按页面分发到各个队列，只有一个队列时直接重做
+  void RedoDispatch(LSN min_record_lsn, const std::map<UniquePageID, LSN> &dpt, std::vector<RedoQueue> &queues);
+  // 页面 LSN 小于日志 LSN 时重做该日志，返回是否重做
+  bool RedoLog(TxLog *log);
+  // 按 LSN 从大到小依次回滚各事务的日志，合并为一次扫描，next_lsns 为各事务下一条待回滚的日志
+  // stoppable 为 true 时可被 StopUndo 停止，此时返回 false
+  bool UndoTransactions(std::map<XID, LSN> next_lsns, bool stoppable);
+  // 回滚 log 并写入补偿日志
+  void UndoLog(UpdateLog *log);
+  // 事务回滚完成，写入结束日志并移出 ATT
+  void EndUndo(XID xid);
+  void CheckpointerLoop();
+  bool CheckpointDue() const;
+  // 为日志分配 LSN 与缓冲空间，日志的 LSN 此时才确定；缓冲已满时先落盘再重试
+  LogReservation Reserve(Log *log);
+  // 将日志写入预留的空间，之后落盘线程才能读取该日志
+  void Publish(Log *log, const LogReservation &reservation);
+  // 不需要修改 ATT 与 DPT 的日志直接写入缓冲，返回日志的 LSN
+  LSN WriteLog(Log *log);
+  // 写入事务日志，分配 LSN 后、写入缓冲前记为事务的最后一条日志，upids 不为空时同时把其中 count 个页面加入 DPT
+  LSN WriteTxLog(Log *log, XID xid, const UniquePageID *upids = nullptr, size_t count = 1);
+  // 写入事务的提交或结束日志，分配 LSN 后、写入缓冲前将事务移出 ATT
+  LSN FinishTxLog(Log *log, XID xid);
+  // 事务最后一条日志的 LSN，不在 ATT 中时返回 NULL_LSN
+  LSN GetLastLSN(XID xid);
+  // 在持有 log_mutex_ 时推进 buffered_lsn_，并等待其不小于 lsn
+  void WaitBuffered(std::unique_lock<std::mutex> &log_lock, LSN lsn);
+  // 清空日志缓冲，下一条日志的 LSN 为 next_lsn
+  void ResetBuffer(LSN next_lsn);
+  LogTableShard<XID, TxEntry> &GetATTShard(XID xid);
+  LogTableShard<UniquePageID, PageEntry, UniquePageIDHash> &GetDPTShard(const UniquePageID &upid);
+  std::map<XID, TxEntry> GetATT();
+  std::map<UniquePageID, LSN> GetDPT();
+  void LoadATT(const std::map<XID, TxEntry> &att);
+  void LoadDPT(const std::map<UniquePageID, LSN> &dpt);
 
-  std::map<XID, LSN> att_;          // 事务表，记录事务 xid 最后所关联日志的 LSN
-  std::map<UniquePageID, LSN> dpt_; // 脏页表，记录某个页 PageId 最早是在 LSN 日志处修改的
+  // 日志写入缓冲前先更新 ATT 与 DPT，检查点据此保证快照包含开始记录之前所有日志的修改
+  // 事务表，记录事务 xid 第一条与最后一条日志的 LSN；同一事务的日志只由一个线程写入
+  LogTableShard<XID, TxEntry> att_[LOG_TABLE_SHARDS];
+  // 脏页表，记录某个页 PageId 最早与最后是在哪条日志处修改的，后台写回线程会在 WritePage 中修改
+  LogTableShard<UniquePageID, PageEntry, UniquePageIDHash> dpt_[LOG_TABLE_SHARDS];
 
   // TIPS: 仅需在设计Log缓存时使用
   // TIPS: 所有更新时间>FlushedLSN的页面不能被写回
   // TIPS: 需要定期将日志写入磁盘来更新FlushedLSN
-  LSN flushed_lsn_;
-  LSN current_lsn_;
-  LSN checkpoint_lsn_;
+  std::atomic<LSN> flushed_lsn_;
+  std::atomic<LSN> checkpoint_lsn_;
+  std::atomic<LSN> checkpoint_begin_lsn_;
+  std::atomic<LSN> truncate_lsn_;
 
+  // 高 32 位为下一条日志的 LSN，低 32 位为环形缓冲中下一段空闲空间的位置
+  std::atomic<uint64_t> reserve_;
+  // 高 32 位为第一条未落盘日志的 LSN，低 32 位为其在环形缓冲中的位置，之前的空间可以复用
+  std::atomic<uint64_t> released_;
+  // 环形缓冲与日志槽，大小均为 2 的幂，位置取模时不受 32 位回绕影响
+  std::vector<Byte> ring_;
+  std::vector<LogSlot> slots_;
+  std::atomic<size_t> reserve_retries_;
+  std::atomic<size_t> buffer_full_waits_;
+  // 保护落盘状态
   std::mutex log_mutex_;
-  std::mutex lsn_mutex_;
+  // 日志写入缓冲时通知等待连续 LSN 的落盘线程，只有存在等待者时写入线程才获取 log_mutex_
+  std::condition_variable append_cv_;
+  std::atomic<int> append_waiters_;
+  // 一次落盘完成时通知等待的提交线程
+  std::condition_variable flush_cv_;
+  // LSN 不超过该值的日志均已在缓冲中或已落盘
+  LSN buffered_lsn_;
+  bool flushing_;
+  // 缓冲超过 wal-buffer-size 时提前落盘，环形缓冲的大小至少为其两倍
+  size_t buffer_limit_;
+  // wal-compression 打开时压缩插入日志中较大的记录镜像
+  bool compression_;
+  // 组提交的等待窗口，单位微秒，由 commit-delay 参数决定，只有其他事务在运行时才等待
+  int commit_delay_us_;
+  std::atomic<size_t> commits_;
+  std::atomic<size_t> flushes_;
+  // 并行 Redo 的线程数，由 recovery-workers 参数决定，按页面划分日志
+  int redo_workers_;
+  size_t analysed_logs_;
+  size_t redo_logs_;
+  std::atomic<size_t> redo_applied_;
+  std::atomic<size_t> clr_logs_;
+  // 后台回滚线程
+  std::thread undoer_;
+  std::mutex undo_mutex_;
+  std::condition_variable undo_cv_;
+  std::atomic<bool> undo_running_;
+  std::atomic<bool> undo_stop_;
+  // 后台回滚中的事务，由 undo_mutex_ 保护
+  std::set<XID> undo_xids_;
 
-  friend class CheckpointLog;
+  // 同一时间只执行一个检查点
+  std::mutex checkpoint_mutex_;
+  // 自上次检查点后写入 checkpoint-wal-size 字节日志或经过 checkpoint-timeout 秒时自动执行检查点，0 表示关闭
+  size_t checkpoint_wal_size_;
+  int checkpoint_timeout_s_;
+  std::atomic<size_t> checkpoints_;
+  // 已落盘的日志总字节数，以及最近一次检查点完成时的值
+  std::atomic<size_t> wal_bytes_;
+  std::atomic<size_t> checkpoint_wal_bytes_;
+  // 最近一次检查点完成的时间，单位毫秒
+  std::atomic<int64_t> checkpoint_time_ms_;
+  std::thread checkpointer_;
+  std::mutex checkpointer_mutex_;
+  std::condition_variable checkpointer_cv_;
+  bool checkpointer_stop_;
 };
 
 }  // namespace dbtrain
@@ -0,0 +1,281 @@
+#include "log_storage.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+#include "../exception/exceptions.h"
+#include "../utils/crc32c.h"
+#include "log_factory.h"
+
+namespace dbtrain {
+
+// 顺序读取时每次读入的数据量
+static const size_t LOG_READ_CHUNK = 1 << 20;
+
+static uint32_t RecordCrc(LSN lsn, const Byte *payload, size_t length) {
+  return Crc32c(payload, length, Crc32c(&lsn, sizeof(LSN)));
+}
+
+LogReader::LogReader(LogStorage *storage, LSN lsn)
+    : storage_(storage), start_lsn_(lsn), fd_(-1), size_(0), file_offset_(0), buffer_pos_(0), buffer_end_(0) {
+  std::lock_guard<std::mutex> lock(storage_->mutex_);
+  LogSegment *segment = storage_->FindSegment(lsn);
+  if (segment == nullptr && !storage_->segments_.empty()) segment = &storage_->segments_.begin()->second;
+  if (segment != nullptr) OpenSegment(*segment);
+}
+
+LogReader::LogReader(const LogSegment &segment) : storage_(nullptr), start_lsn_(segment.first_lsn) {
+  OpenSegment(segment);
+}
+
+void LogReader::OpenSegment(const LogSegment &segment) {
+  segment_lsn_ = segment.first_lsn;
+  segment_path_ = segment.path;
+  next_lsn_ = segment.first_lsn;
+  fd_ = segment.fd;
+  size_ = segment.size;
+  file_offset_ = 0;
+  buffer_pos_ = buffer_end_ = 0;
+}
+
+bool LogReader::Fill(size_t need) {
+  size_t avail = buffer_end_ - buffer_pos_;
+  if (avail >= need) return true;
+  if (size_ - file_offset_ < need - avail) return false;
+  // 将未解析的数据移到缓冲开头，再读入下一块
+  std::copy(buffer_.begin() + buffer_pos_, buffer_.begin() + buffer_end_, buffer_.begin());
+  buffer_end_ -= buffer_pos_;
+  buffer_pos_ = 0;
+  size_t read_len = std::min(size_ - file_offset_, std::max(LOG_READ_CHUNK, need - buffer_end_));
+  if (buffer_.size() < buffer_end_ + read_len) buffer_.resize(buffer_end_ + read_len);
+  DiskManager::GetInstance().ReadRaw(fd_, buffer_.data() + buffer_end_, read_len, file_offset_);
+  file_offset_ += read_len;
+  buffer_end_ += read_len;
+  return true;
+}
+
+bool LogReader::NextSegment() {
+  if (storage_ == nullptr) return false;
+  std::lock_guard<std::mutex> lock(storage_->mutex_);
+  auto iter = storage_->segments_.upper_bound(segment_lsn_);
+  if (iter == storage_->segments_.end()) return false;
+  // 只有最后一段可能以写了一半的日志结束，之前的段必须恰好读到下一段的第一条日志之前，否则中间的日志已损坏
+  if (iter->first != next_lsn_) throw LogCorruptedError(segment_path_, next_lsn_);
+  OpenSegment(iter->second);
+  return true;
+}
+
+bool LogReader::NextRecord(LogRecordHeader &header, const Byte *&payload, size_t &offset) {
+  if (fd_ < 0) return false;
+  while (true) {
+    // 读到段末尾、LSN 不连续或校验失败时当前段结束，之后是预分配的空间、复用前的旧日志或写了一半的日志
+    // 不是最后一段时下一段须从 next_lsn_ 开始，由 NextSegment 检查
+    bool valid = Fill(sizeof(LogRecordHeader));
+    if (valid) {
+      offset = file_offset_ - (buffer_end_ - buffer_pos_);
+      memcpy(&header, buffer_.data() + buffer_pos_, sizeof(LogRecordHeader));
+      valid = header.lsn == next_lsn_ && header.length <= size_ && Fill(sizeof(LogRecordHeader) + header.length);
+    }
+    if (valid) {
+      payload = buffer_.data() + buffer_pos_ + sizeof(LogRecordHeader);
+      valid = RecordCrc(header.lsn, payload, header.length) == header.crc;
+    }
+    if (!valid) {
+      if (!NextSegment()) return false;
+      continue;
+    }
+    buffer_pos_ += sizeof(LogRecordHeader) + header.length;
+    next_lsn_++;
+    if (header.lsn >= start_lsn_) return true;
+  }
+}
+
+Log *LogReader::Next() {
+  LogRecordHeader header;
+  const Byte *payload = nullptr;
+  size_t offset = 0;
+  if (!NextRecord(header, payload, offset)) return nullptr;
+  return LogFactory::LoadLog(header.lsn, payload);
+}
+
+LogStorage::LogStorage(size_t segment_size, size_t recycle_segments, bool archive)
+    : disk_manager_(DiskManager::GetInstance()),
+      segment_size_(segment_size),
+      recycle_limit_(recycle_segments),
+      archive_(archive),
+      removed_segments_(0),
+      archived_segments_(0),
+      recycled_segments_(0) {
+  std::vector<std::string> files;
+  disk_manager_.ListFiles(".", LOG_SEGMENT_PREFIX, files);
+  for (const auto &file : files) {
+    LSN first_lsn = std::stoul(file.substr(LOG_SEGMENT_PREFIX.size()), nullptr, 16);
+    int fd = disk_manager_.OpenFile(file);
+    size_t file_size = disk_manager_.FileSize(fd);
+    segments_[first_lsn] = {first_lsn, file, fd, file_size, file_size, false, {}};
+  }
+  files.clear();
+  disk_manager_.ListFiles(".", LOG_RECYCLE_PREFIX, files);
+  for (const auto &file : files) free_segments_.push_back({file, disk_manager_.FileSize(file)});
+  if (!segments_.empty()) {
+    // 只有最后一段可能在写入时崩溃，有效日志之后的数据全部丢弃，并重新预分配空间
+    LogSegment &last = segments_.rbegin()->second;
+    IndexSegment(last);
+    if (last.size < last.capacity) {
+      LogRecordHeader header = {0, 0, 0};
+      if (last.capacity - last.size >= sizeof(LogRecordHeader)) {
+        disk_manager_.ReadRaw(last.fd, (Byte *)&header, sizeof(LogRecordHeader), last.size);
+      }
+      if (header.lsn == last.first_lsn + last.offsets.size()) {
+        std::cerr << "LogStorage: truncating torn log tail in " << last.path << "\n";
+      }
+      disk_manager_.TruncateFile(last.fd, last.size);
+      last.capacity = last.size;
+      if (disk_manager_.AllocateFile(last.fd, std::max(last.size, segment_size_))) {
+        last.capacity = std::max(last.size, segment_size_);
+      }
+    }
+  }
+  if (archive_ && !disk_manager_.DirectoryExists(LOG_ARCHIVE_DIR)) disk_manager_.CreateDirectory(LOG_ARCHIVE_DIR);
+}
+
+LogStorage::~LogStorage() {
+  for (auto &pair : segments_) disk_manager_.CloseFile(pair.second.fd);
+}
+
+LogSegment *LogStorage::FindSegment(LSN lsn) {
+  auto iter = segments_.upper_bound(lsn);
+  if (iter == segments_.begin()) return nullptr;
+  return &(--iter)->second;
+}
+
+void LogStorage::IndexSegment(LogSegment &segment) {
+  LogReader reader(segment);
+  LogRecordHeader header;
+  const Byte *payload = nullptr;
+  size_t offset = 0;
+  segment.offsets.clear();
+  size_t end = 0;
+  while (reader.NextRecord(header, payload, offset)) {
+    segment.offsets.push_back(offset);
+    end = offset + sizeof(LogRecordHeader) + header.length;
+  }
+  segment.size = end;
+  segment.indexed = true;
+}
+
+LogSegment &LogStorage::CreateSegment(LSN first_lsn) {
+  char name[32];
+  snprintf(name, sizeof(name), "%s%08X", LOG_SEGMENT_PREFIX.c_str(), first_lsn);
+  size_t capacity = 0;
+  if (!free_segments_.empty()) {
+    // 复用截断的段文件，其中旧日志的 LSN 小于新段的第一条日志，读取时会被忽略
+    auto free_segment = free_segments_.back();
+    free_segments_.pop_back();
+    disk_manager_.RenameFile(free_segment.first, name);
+    capacity = free_segment.second;
+  } else {
+    disk_manager_.CreateFile(name);
+  }
+  int fd = disk_manager_.OpenFile(name);
+  if (capacity < segment_size_ && disk_manager_.AllocateFile(fd, segment_size_)) capacity = segment_size_;
+  // 新段的目录项必须在其中的日志之前落盘
+  disk_manager_.FlushDirectory(".");
+  segments_[first_lsn] = {first_lsn, name, fd, 0, capacity, true, {}};
+  return segments_[first_lsn];
+}
+
+void LogStorage::RemoveSegment(LogSegment &segment) {
+  disk_manager_.CloseFile(segment.fd);
+  if (archive_) {
+    disk_manager_.RenameFile(segment.path, LOG_ARCHIVE_DIR + "/" + segment.path);
+    archived_segments_++;
+  } else if (free_segments_.size() < recycle_limit_) {
+    std::string free_path = LOG_RECYCLE_PREFIX + segment.path;
+    disk_manager_.RenameFile(segment.path, free_path);
+    free_segments_.push_back({free_path, segment.capacity});
+    recycled_segments_++;
+  } else {
+    disk_manager_.DeleteFile(segment.path);
+    removed_segments_++;
+  }
+}
+
+void LogStorage::Append(LSN first_lsn, const Byte *data, const std::vector<size_t> &lengths) {
+  std::vector<Byte> raw_data;
+  std::vector<size_t> offsets;
+  size_t pos = 0;
+  for (size_t i = 0; i < lengths.size(); i++) {
+    LogRecordHeader header = {(uint32_t)lengths[i], RecordCrc(first_lsn + i, data + pos, lengths[i]),
+                              (LSN)(first_lsn + i)};
+    offsets.push_back(raw_data.size());
+    raw_data.insert(raw_data.end(), (Byte *)&header, (Byte *)&header + sizeof(LogRecordHeader));
+    raw_data.insert(raw_data.end(), data + pos, data + pos + lengths[i]);
+    pos += lengths[i];
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  LogSegment *segment = segments_.empty() ? nullptr : &segments_.rbegin()->second;
+  if (segment == nullptr || (segment->size > 0 && segment->size + raw_data.size() > segment_size_)) {
+    segment = &CreateSegment(first_lsn);
+  }
+  if (!segment->indexed) IndexSegment(*segment);
+  disk_manager_.WriteRaw(segment->fd, raw_data.data(), raw_data.size(), segment->size);
+  if (segment->size + raw_data.size() <= segment->capacity) {
+    // 写入预分配的空间，文件大小不变
+    disk_manager_.FlushFileData(segment->fd);
+  } else {
+    disk_manager_.FlushFile(segment->fd);
+    segment->capacity = segment->size + raw_data.size();
+  }
+  for (size_t offset : offsets) segment->offsets.push_back(segment->size + offset);
+  segment->size += raw_data.size();
+}
+
+Log *LogStorage::Read(LSN lsn) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  LogSegment *segment = FindSegment(lsn);
+  if (segment == nullptr) return nullptr;
+  if (!segment->indexed) IndexSegment(*segment);
+  size_t idx = lsn - segment->first_lsn;
+  if (idx >= segment->offsets.size()) return nullptr;
+  LogRecordHeader header;
+  disk_manager_.ReadRaw(segment->fd, (Byte *)&header, sizeof(LogRecordHeader), segment->offsets[idx]);
+  std::vector<Byte> payload(header.length);
+  disk_manager_.ReadRaw(segment->fd, payload.data(), header.length, segment->offsets[idx] + sizeof(LogRecordHeader));
+  if (header.lsn != lsn || RecordCrc(lsn, payload.data(), header.length) != header.crc) {
+    std::cerr << "Error in LogStorage::Read: checksum mismatch at LSN " << lsn << "\n";
+    throw UnknownError();
+  }
+  return LogFactory::LoadLog(lsn, payload.data());
+}
+
+LogReader LogStorage::Scan(LSN lsn) { return LogReader(this, lsn); }
+
+void LogStorage::Truncate(LSN lsn) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (segments_.size() > 1) {
+    // 下一段的第一条日志不超过 lsn 时，第一段的日志均小于 lsn
+    auto next = std::next(segments_.begin());
+    if (next->first > lsn) break;
+    RemoveSegment(segments_.begin()->second);
+    segments_.erase(segments_.begin());
+  }
+}
+
+LogStorageStatus LogStorage::GetStatus() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  LogStorageStatus status;
+  status.segments = segments_.size();
+  status.free_segments = free_segments_.size();
+  status.first_lsn = segments_.empty() ? NULL_LSN : segments_.begin()->first;
+  status.disk_bytes = 0;
+  for (const auto &pair : segments_) status.disk_bytes += pair.second.capacity;
+  for (const auto &free_segment : free_segments_) status.disk_bytes += free_segment.second;
+  status.removed_segments = removed_segments_;
+  status.archived_segments = archived_segments_;
+  status.recycled_segments = recycled_segments_;
+  return status;
+}
+
+}  // namespace dbtrain
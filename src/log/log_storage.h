@@ -0,0 +1,136 @@
+#ifndef DBTRAIN_LOG_STORAGE_H
+#define DBTRAIN_LOG_STORAGE_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../defines.h"
+#include "../storage/disk_manager.h"
+#include "log.h"
+
+namespace dbtrain {
+
+// 每条日志前的头部，crc 覆盖 lsn 与日志内容，用于发现写了一半的日志
+struct LogRecordHeader {
+  uint32_t length;  // 日志内容长度，不含头部
+  uint32_t crc;
+  LSN lsn;
+};
+
+// 日志段，段内日志按 LSN 连续存放
+// 段文件预先分配空间，有效数据之后可能是 0 或复用前的旧日志，读取时遇到 LSN 不连续即认为该段结束
+struct LogSegment {
+  LSN first_lsn;
+  std::string path;
+  int fd;
+  // 有效数据长度
+  size_t size;
+  // 文件大小
+  size_t capacity;
+  // 第 i 项为 LSN first_lsn + i 的日志头部偏移，随机读取前扫描建立
+  bool indexed;
+  std::vector<size_t> offsets;
+};
+
+// 日志文件运行状态，用于 SHOW LOG STATUS
+struct LogStorageStatus {
+  size_t segments;
+  // 留待复用的段文件数
+  size_t free_segments;
+  // 仍保存在磁盘上的最小 LSN
+  LSN first_lsn;
+  // 日志段与待复用段占用的磁盘空间
+  size_t disk_bytes;
+  // 截断时删除、归档与回收的段数
+  size_t removed_segments;
+  size_t archived_segments;
+  size_t recycled_segments;
+};
+
+class LogStorage;
+
+// 顺序读取日志，每次从段文件读入一大块再在内存中解析
+class LogReader {
+ public:
+  // 从 LSN 不小于 lsn 的第一条日志开始读取
+  LogReader(LogStorage *storage, LSN lsn);
+  // 只读取一个段，用于建立段内索引
+  explicit LogReader(const LogSegment &segment);
+
+  // 读到末尾时返回 nullptr，最后一段之前的段中有日志缺失或校验失败时抛出 LogCorruptedError
+  Log *Next();
+  // 返回下一条日志的头部、内容与其在段内的偏移，不解析日志
+  bool NextRecord(LogRecordHeader &header, const Byte *&payload, size_t &offset);
+
+ private:
+  // 保证缓冲中至少有 need 字节未解析的数据，段内数据不足时返回 false
+  bool Fill(size_t need);
+  // 切换到下一段，没有下一段时返回 false，下一段的第一条日志不是 next_lsn_ 时抛出 LogCorruptedError
+  bool NextSegment();
+  void OpenSegment(const LogSegment &segment);
+
+  LogStorage *storage_;
+  LSN start_lsn_;
+  LSN segment_lsn_;
+  std::string segment_path_;
+  // 段内下一条日志应有的 LSN
+  LSN next_lsn_;
+  int fd_;
+  size_t size_;
+  // 下一次从段文件读取的位置
+  size_t file_offset_;
+  std::vector<Byte> buffer_;
+  size_t buffer_pos_;
+  size_t buffer_end_;
+};
+
+// 分段存储的日志
+// 段文件名为 LOG_SEGMENT_PREFIX 加上段内第一条日志的 LSN，段超过 wal-segment-size 后切换到新段
+// 新段预先分配 wal-segment-size 字节，追加日志不改变文件大小，只需 fdatasync
+class LogStorage {
+  friend class LogReader;
+
+ public:
+  LogStorage(const LogStorage &) = delete;
+  void operator=(const LogStorage &) = delete;
+  // 打开当前目录下的日志段，并清除最后一段末尾写了一半的日志
+  // 截断的段在 archive 为 true 时移入 LOG_ARCHIVE_DIR，否则最多保留 recycle_segments 个留待复用，其余删除
+  LogStorage(size_t segment_size, size_t recycle_segments, bool archive);
+  ~LogStorage();
+
+  // 追加一批 LSN 连续的日志并落盘，lengths 为每条日志的长度
+  void Append(LSN first_lsn, const Byte *data, const std::vector<size_t> &lengths);
+  // 随机读取一条日志，不存在时返回 nullptr
+  Log *Read(LSN lsn);
+  // 顺序读取期间不能截断日志，只在恢复时使用
+  LogReader Scan(LSN lsn);
+  // 移除所有日志 LSN 均小于 lsn 的段，最后一段总是保留
+  void Truncate(LSN lsn);
+  LogStorageStatus GetStatus();
+
+ private:
+  // 以下函数调用时需持有 mutex_
+  // 返回包含 lsn 的段，即第一条日志的 LSN 不超过 lsn 的最后一段
+  LogSegment *FindSegment(LSN lsn);
+  void IndexSegment(LogSegment &segment);
+  LogSegment &CreateSegment(LSN first_lsn);
+  void RemoveSegment(LogSegment &segment);
+
+  DiskManager &disk_manager_;
+  size_t segment_size_;
+  size_t recycle_limit_;
+  bool archive_;
+  std::mutex mutex_;
+  std::map<LSN, LogSegment> segments_;
+  // 留待复用的段文件名与大小
+  std::vector<std::pair<std::string, size_t>> free_segments_;
+  size_t removed_segments_;
+  size_t archived_segments_;
+  size_t recycled_segments_;
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_LOG_STORAGE_H
@@ -1,3 +1,4 @@
 #include "basic_log.h"
 #include "checkpoint_log.h"
+#include "index_log.h"
 #include "update_log.h"
\ No newline at end of file
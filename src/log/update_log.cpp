@@ -1,7 +1,7 @@
 #include "update_log.h"
 
 #include "../system/system_manager.h"
-#include "../record/record_factory.h"
+#include "../utils/varint.h"
 
 namespace dbtrain {
 
@@ -15,64 +15,44 @@ void UpdateLog::Redo() {
   // TIPS: 可以直接基于Image定位页面并按照操作类型进行Redo
   // TIPS: 基础功能不需要考虑Meta信息和页头信息的变化
   // LAB 2 BEGIN
-  Table* table = SystemManager::GetInstance().GetTable(log_image_.table_name_);
+  Table *table = SystemManager::GetInstance().GetTable(log_image_.table_id_);
   PageHandle page_handle = table->GetPage(log_image_.page_id_);
-  TableMeta meta = table->GetMeta();
-  RecordFactory record_factory(&meta);
+  const LogImage &image = log_image_;
 
-  switch (log_image_.op_type_) {
-    case PhysiologicalImage::LogOpType::INSERT : {
-      page_handle.InsertRecord(log_image_.slot_id_, log_image_.new_val_, lsn_);
+  switch (image.op_type_) {
+    case PhysiologicalImage::LogOpType::INSERT: {
+      if (image.delta_) {
+        page_handle.PatchRecord(image.slot_id_, image.base_slot_, image.ranges_, image.new_bytes_.data(), true, lsn_);
+      } else {
+        page_handle.InsertRecord(image.slot_id_, image.new_val_.data(), image.length_, lsn_);
+      }
       break;
     }
-    case PhysiologicalImage::LogOpType::DELETE : {
-      page_handle.DeleteRecord(log_image_.slot_id_, lsn_);
+    case PhysiologicalImage::LogOpType::DELETE: {
+      // 标记删除与运行时一样保留记录所在的槽，只有回滚插入的补偿日志释放槽
+      page_handle.PatchRecord(image.slot_id_, image.slot_id_, image.ranges_, image.new_bytes_.data(),
+                              !image.redo_only_, lsn_);
       break;
     }
-    case PhysiologicalImage::LogOpType::UPDATE : {
-      page_handle.UpdateRecord(log_image_.slot_id_, log_image_.new_val_, lsn_);
-      break;
-    }
-    default: {
-      assert(false);
-    }
-  }
-  // LAB 2 END
-}
-
-void UpdateLog::Undo() {
-  // TODO: 根据Image进行Undo操作
-  // TIPS: 可以直接基于Image定位页面并按照操作类型进行Undo
-  // TIPS: 基础功能不需要考虑Meta信息和页头信息的变化
-  // LAB 2 BEGIN
-  Table* table = SystemManager::GetInstance().GetTable(log_image_.table_name_);
-  PageHandle page_handle = table->GetPage(log_image_.page_id_);
-  TableMeta meta = table->GetMeta();
-  RecordFactory record_factory(&meta);
-
-  switch (log_image_.op_type_) {
-    case PhysiologicalImage::LogOpType::INSERT : {
-      page_handle.DeleteRecord(log_image_.slot_id_, lsn_);
-      break;
-    }
-    case PhysiologicalImage::LogOpType::DELETE : {
-      page_handle.InsertRecord(log_image_.slot_id_, log_image_.old_val_, lsn_);
-      break;
-    }
-    case PhysiologicalImage::LogOpType::UPDATE : {
-      page_handle.UpdateRecord(log_image_.slot_id_, log_image_.old_val_, lsn_);
+    case PhysiologicalImage::LogOpType::UPDATE: {
+      page_handle.PatchRecord(image.slot_id_, image.slot_id_, image.ranges_, image.new_bytes_.data(), true, lsn_);
       break;
     }
     default: {
       assert(false);
     }
   }
+  // 回滚插入的补偿日志释放槽，重做也可能改变页面的空闲空间
+  table->UpdateFreeSpace(page_handle);
+  // 删除只会缩小页面摘要的范围
+  if (image.op_type_ != PhysiologicalImage::LogOpType::DELETE) table->InvalidateZone(log_image_.page_id_);
   // LAB 2 END
 }
 
 void UpdateLog::Load(const Byte *src) {
   TxLog::Load(src);
-  auto src_ = src + 2 * sizeof(LSN) + sizeof(XID);
+  // TxLog 的长度包含由 LogFactory 读取的类型字节
+  auto src_ = src + TxLog::GetLength() - Log::GetLength();
   log_image_.Load(src_);
 }
 
@@ -83,10 +63,33 @@ size_t UpdateLog::Store(Byte *dst) {
   return length + img_length;
 }
 
-UniquePageID UpdateLog::GetUniPageID() const { return {log_image_.table_name_, log_image_.page_id_}; }
+UniquePageID UpdateLog::GetUniPageID() const { return {log_image_.table_id_, log_image_.page_id_}; }
 
 LogType UpdateLog::GetType() const { return LogType::UPDATE; }
 
 size_t UpdateLog::GetLength() const { return TxLog::GetLength() + log_image_.GetLength(); }
 
+CompensationLog::CompensationLog(LSN lsn, LSN prev_lsn, XID xid, LSN undo_next_lsn)
+    : UpdateLog(lsn, prev_lsn, xid), undo_next_lsn_(undo_next_lsn) {}
+
+void CompensationLog::Load(const Byte *src) {
+  UpdateLog::Load(src);
+  LSN undo_next_delta = 0;
+  GetVarint(src + UpdateLog::GetLength() - Log::GetLength(), undo_next_delta);
+  undo_next_lsn_ = undo_next_delta == 0 ? NULL_LSN : lsn_ - undo_next_delta;
+}
+
+size_t CompensationLog::Store(Byte *dst) {
+  size_t length = UpdateLog::Store(dst);
+  return length + PutVarint(dst + length, UndoNextDelta());
+}
+
+LSN CompensationLog::GetUndoNextLSN() const { return undo_next_lsn_; }
+
+LogType CompensationLog::GetType() const { return LogType::CLR; }
+
+size_t CompensationLog::GetLength() const { return UpdateLog::GetLength() + VarintLength(UndoNextDelta()); }
+
+LSN CompensationLog::UndoNextDelta() const { return undo_next_lsn_ == NULL_LSN ? 0 : lsn_ - undo_next_lsn_; }
+
 }  // namespace dbtrain
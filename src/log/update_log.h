@@ -17,7 +17,6 @@ class UpdateLog : public TxLog {
   size_t Store(Byte *dst) override;
 
   void Redo();
-  void Undo();
   UniquePageID GetUniPageID() const;
 
   LogType GetType() const override;
@@ -29,6 +28,29 @@ class UpdateLog : public TxLog {
   friend class LogFactory;
 };
 
+// 补偿日志：回滚一条修改日志时写入，内容为回滚所做的修改，只重做不回滚
+// undo_next_lsn 为被回滚日志的前一条日志，再次回滚该事务时从这里继续，已回滚的修改不会重复回滚
+class CompensationLog : public UpdateLog {
+ public:
+  CompensationLog() = default;
+  CompensationLog(LSN lsn, LSN prev_lsn, XID xid, LSN undo_next_lsn);
+  ~CompensationLog() = default;
+
+  void Load(const Byte *src) override;
+  size_t Store(Byte *dst) override;
+
+  LSN GetUndoNextLSN() const;
+
+  LogType GetType() const override;
+  size_t GetLength() const override;
+
+ private:
+  // 与 prev_lsn 相同，以与本日志 LSN 的差值存储
+  LSN UndoNextDelta() const;
+
+  LSN undo_next_lsn_;
+};
+
 }  // namespace dbtrain
 
 #endif
@@ -44,6 +44,8 @@ bool OrCondition::Fit(Record *record) const {
   return false;
 }
 
+vector<Condition *> OrCondition::GetConditions() const { return conds_; }
+
 void OrCondition::Display() const {
   for (int i = 0; i < conds_.size() - 1; ++i) {
     conds_[i]->Display();
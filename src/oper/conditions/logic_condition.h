@@ -29,6 +29,8 @@ class OrCondition : public Condition {
 
   virtual void Display() const override;
 
+  vector<Condition *> GetConditions() const;
+
  private:
   vector<Condition *> conds_;
 };
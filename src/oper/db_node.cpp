@@ -41,15 +41,18 @@ UpdateNode::~UpdateNode() {
 }
 
 RecordList UpdateNode::Next() {
+  // 先取出所有待更新记录再更新，新版本可能写入扫描尚未到达的页面，边扫描边更新会重复更新同一条记录
   auto child = childs_[0];
+  RecordList records;
   auto next_list = child->Next();
   while (next_list.size() > 0) {
-    for (const auto &record : next_list) {
-      UpdateRecord(record);
-      delete record;
-    }
+    records.insert(records.end(), next_list.begin(), next_list.end());
     next_list = child->Next();
   }
+  for (const auto &record : records) {
+    UpdateRecord(record);
+    delete record;
+  }
   return {};
 }
 
@@ -1,11 +1,55 @@
 #include "scan_node.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include "../optim/stats_manager.h"
+#include "../record/fields.h"
 #include "../tx/tx_manager.h"
+#include "conditions/conditions.h"
 
 namespace dbtrain {
 
-TableScanNode::TableScanNode(Table *table) : OperNode({}), table_(table) { cur_page_ = 0; }
+// 索引扫描与按页面摘要跳过页面的全表扫描每次预读的页面数
+static const size_t INDEX_SCAN_PREFETCH_PAGES = 16;
+
+TableScanNode::TableScanNode(Table *table, Condition *cond, const std::vector<int> &cols)
+    : OperNode({}), table_(table), prefetched_(0), cols_(cols) {
+  cur_page_ = 0;
+  if (cond != nullptr) AddBounds(cond);
+}
+
+void TableScanNode::AddBounds(Condition *cond) {
+  // 只使用 And 条件中的比较条件，Or 与 Not 条件不限制页面
+  AndCondition *and_cond = dynamic_cast<AndCondition *>(cond);
+  if (and_cond != nullptr) {
+    for (Condition *child : and_cond->GetConditions()) AddBounds(child);
+    return;
+  }
+  AlgebraCondition *algebra_cond = dynamic_cast<AlgebraCondition *>(cond);
+  if (algebra_cond == nullptr || !table_->ZoneTracks(algebra_cond->GetIdx())) return;
+  const Field *field = algebra_cond->GetField();
+  double value;
+  if (field->GetType() == FieldType::INT) {
+    value = dynamic_cast<const IntField *>(field)->GetValue();
+  } else if (field->GetType() == FieldType::FLOAT) {
+    value = dynamic_cast<const FloatField *>(field)->GetValue();
+  } else {
+    return;
+  }
+  ZoneBound bound = {algebra_cond->GetIdx(), -INFINITY, INFINITY, false, false};
+  if (dynamic_cast<EqualCondition *>(cond) != nullptr) {
+    bound.low = bound.high = value;
+  } else if (dynamic_cast<GreaterCondition *>(cond) != nullptr) {
+    bound.low = value;
+    bound.low_open = true;
+  } else if (dynamic_cast<LessCondition *>(cond) != nullptr) {
+    bound.high = value;
+    bound.high_open = true;
+  } else {
+    return;
+  }
+  bounds_.push_back(bound);
+}
 
 TableScanNode::~TableScanNode() {}
 
@@ -17,18 +61,93 @@ RecordList TableScanNode::Next() {
   while (outlist.size() == 0) {
     std::cerr << " -------------- in the loop -------------- \n";
     std::cerr << "xid: " << xid << "\n";
-    if (cur_page_ >= table_->GetMeta().GetTableEnd()) return {};
+    PageID table_end = table_->GetMeta().GetTableEnd();
+    if (cur_page_ >= table_end) return {};
+    if (bounds_.empty()) {
+      table_->ReadAhead(cur_page_, read_ahead_);
+    } else {
+      if (!table_->PageMayMatch(cur_page_, bounds_)) {
+        table_->CountSkippedPage();
+        ++cur_page_;
+        continue;
+      }
+      // 只预读之后摘要未排除的页面，读取的页面摘要未知时顺带计算
+      if (cur_page_ >= prefetched_) {
+        std::vector<PageID> pages;
+        for (prefetched_ = cur_page_; prefetched_ < table_end && pages.size() < INDEX_SCAN_PREFETCH_PAGES;
+             prefetched_++) {
+          if (table_->PageMayMatch(prefetched_, bounds_)) pages.push_back(prefetched_);
+        }
+        table_->Prefetch(pages);
+      }
+      table_->FillZone(cur_page_);
+    }
     PageHandle page_handle = table_->GetPage(cur_page_);
     if (xid == INVALID_XID)
       outlist = page_handle.LoadRecords();
     else
-      outlist = page_handle.LoadRecords(xid, active_xids);
+      outlist = page_handle.LoadRecords(xid, active_xids, cols_);
     ++cur_page_;
   }
   std::cerr << "record list size: " << outlist.size() << "\n";
   return outlist;
 }
 
+IndexScanNode::IndexScanNode(Table *table, Index *index, const Field *low, const Field *high)
+    : OperNode({}), table_(table), index_(index), scanned_(false), cur_(0), prefetched_(0) {
+  low_ = low == nullptr ? nullptr : low->Copy();
+  high_ = high == nullptr ? nullptr : high->Copy();
+}
+
+IndexScanNode::~IndexScanNode() {
+  delete low_;
+  delete high_;
+}
+
+RecordList IndexScanNode::Next() {
+  if (!scanned_) {
+    // 同一页面中的记录一次读取，页面按页号顺序访问
+    rids_ = index_->Scan(low_, high_);
+    std::sort(rids_.begin(), rids_.end(), [](const Rid &a, const Rid &b) {
+      return a.page_no != b.page_no ? a.page_no < b.page_no : a.slot_no < b.slot_no;
+    });
+    rids_.erase(std::unique(rids_.begin(), rids_.end(),
+                            [](const Rid &a, const Rid &b) { return a.page_no == b.page_no && a.slot_no == b.slot_no; }),
+                rids_.end());
+    scanned_ = true;
+  }
+  XID xid = TxManager::GetInstance().Get(std::this_thread::get_id());
+  auto active_xids = TxManager::GetInstance().GetActiveSet(xid);
+  RecordList outlist = {};
+  while (outlist.empty() && cur_ < rids_.size()) {
+    if (cur_ >= prefetched_) {
+      // 一次预读之后若干个将要访问的页面
+      std::vector<PageID> pages;
+      for (prefetched_ = cur_; prefetched_ < rids_.size(); prefetched_++) {
+        if (pages.empty() || pages.back() != rids_[prefetched_].page_no) {
+          if (pages.size() == INDEX_SCAN_PREFETCH_PAGES) break;
+          pages.push_back(rids_[prefetched_].page_no);
+        }
+      }
+      table_->Prefetch(pages);
+    }
+    PageID page_no = rids_[cur_].page_no;
+    std::vector<SlotID> slots;
+    for (; cur_ < rids_.size() && rids_[cur_].page_no == page_no; cur_++) slots.push_back(rids_[cur_].slot_no);
+    PageHandle page_handle = table_->GetPage(page_no);
+    outlist = page_handle.LoadRecords(slots, xid, active_xids);
+  }
+  return outlist;
+}
+
+double IndexScanNode::Cost() { return StatsManager::GetInstance().GetRecordNum(table_->GetName(), 0); }
+
+void IndexScanNode::Display(int depth) const {
+  for (int i = 0; i < depth; ++i) printf("\t");
+  printf("Index Scan Node(%s, %s):\n", table_->GetName().c_str(), index_->GetName().c_str());
+  for (const auto &child : childs_) child->Display(depth + 1);
+}
+
 double TableScanNode::Cost() { return StatsManager::GetInstance().GetRecordNum(table_->GetName(), 0); }
 
 void TableScanNode::Display(int depth) const {
@@ -3,13 +3,17 @@
 
 #include "conditions/condition.h"
 #include "oper_node.h"
+#include "../index/index.h"
 #include "../table/table.h"
 
 namespace dbtrain {
 
+// 顺序扫描表中的页面；cond 中与数值常量比较的条件用于按页面摘要跳过页面，
+// 条件仍需由上层的 FilterNode 检查，节点不持有 cond
+// cols 不为空时只解析其中的列，其余列为空指针，上层只能访问这些列
 class TableScanNode : public OperNode {
  public:
-  TableScanNode(Table *table);
+  TableScanNode(Table *table, Condition *cond = nullptr, const std::vector<int> &cols = {});
   ~TableScanNode();
 
   RecordList Next() override;
@@ -20,7 +24,39 @@ class TableScanNode : public OperNode {
  private:
   Table *table_;
   PageID cur_page_;
-  Condition *cond_;
+  // 无条件时的顺序预读进度
+  ReadAheadState read_ahead_;
+  // 有条件时不使用顺序预读，prefetched_ 之前的页面已预读
+  std::vector<ZoneBound> bounds_;
+  PageID prefetched_;
+  std::vector<int> cols_;
+
+  void AddBounds(Condition *cond);
+};
+
+// 通过索引找到键在 [low, high] 中的记录位置，按页面顺序读取其中可见的记录
+// 结果可能包含不满足条件的记录，需由上层的 FilterNode 复查
+class IndexScanNode : public OperNode {
+ public:
+  // low 与 high 为空时该端不限，节点持有其副本
+  IndexScanNode(Table *table, Index *index, const Field *low, const Field *high);
+  ~IndexScanNode();
+
+  RecordList Next() override;
+  double Cost() override;
+
+  virtual void Display(int depth) const override;
+
+ private:
+  Table *table_;
+  Index *index_;
+  Field *low_;
+  Field *high_;
+  bool scanned_;
+  // 按页号与槽号排序去重后的记录位置，cur_ 为下一个未读取的位置，prefetched_ 之前的页面已预读
+  std::vector<Rid> rids_;
+  size_t cur_;
+  size_t prefetched_;
 };
 
 }  // namespace dbtrain
@@ -1,7 +1,9 @@
 #include "optim.h"
 
 #include <cfloat>
+#include <cmath>
 #include <queue>
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -42,12 +44,112 @@ std::any Optimizer::visit(Insert *insert) {
   return plan;
 }
 
+// 由直方图估计的索引扫描读取记录的比例超过该值时使用全表扫描
+static const double INDEX_SCAN_MAX_RATIO = 0.2;
+
+// 展开 And 条件中的各个子条件
+static void CollectConjuncts(Condition *cond, vector<Condition *> &conds) {
+  AndCondition *and_cond = dynamic_cast<AndCondition *>(cond);
+  if (and_cond == nullptr) {
+    conds.push_back(cond);
+    return;
+  }
+  for (Condition *child : and_cond->GetConditions()) CollectConjuncts(child, conds);
+}
+
+static double NumericValue(const Field *field) {
+  if (field->GetType() == FieldType::INT) return dynamic_cast<const IntField *>(field)->GetValue();
+  return dynamic_cast<const FloatField *>(field)->GetValue();
+}
+
+// 条件用到的列，包含 And、Or 与比较以外的条件时返回 false
+static bool CollectColumns(Condition *cond, std::set<int> &cols) {
+  AlgebraCondition *algebra_cond = dynamic_cast<AlgebraCondition *>(cond);
+  if (algebra_cond != nullptr) {
+    cols.insert(algebra_cond->GetIdx());
+    return true;
+  }
+  vector<Condition *> children{};
+  if (AndCondition *and_cond = dynamic_cast<AndCondition *>(cond)) {
+    children = and_cond->GetConditions();
+  } else if (OrCondition *or_cond = dynamic_cast<OrCondition *>(cond)) {
+    children = or_cond->GetConditions();
+  } else {
+    return false;
+  }
+  for (Condition *child : children) {
+    if (child != nullptr && !CollectColumns(child, cols)) return false;
+  }
+  return true;
+}
+
+vector<int> Optimizer::ScanColumns(Select *select) {
+  // 连接与未指定投影列时需要完整的记录
+  if (select->tables_.size() != 1 || select->cols_.empty()) return {};
+  const string &table_name = select->tables_[0];
+  Table *table = meta_->GetTable(table_name);
+  std::set<int> cols{};
+  for (const auto &col : select->cols_) cols.insert(table->GetColumnIdx(col->col_name_));
+  auto it = table_filter_.find(table_name);
+  if (it != table_filter_.end() && !CollectColumns(it->second, cols)) return {};
+  return vector<int>(cols.begin(), cols.end());
+}
+
+OperNode *Optimizer::ScanTable(const string &table_name, const vector<int> &cols) {
+  Table *table = meta_->GetTable(table_name);
+  auto it = table_filter_.find(table_name);
+  if (it == table_filter_.end()) return new TableScanNode(table, nullptr, cols);
+  // 全表扫描按页面摘要跳过不可能满足条件的页面
+  Condition *filter = it->second;
+  vector<Condition *> conds{};
+  CollectConjuncts(it->second, conds);
+  // 优先使用等值条件，其次使用同一列上的大于与小于条件；哈希索引只用于等值条件
+  Index *index = nullptr;
+  Field *low = nullptr, *high = nullptr;
+  for (Condition *cond : conds) {
+    EqualCondition *equal_cond = dynamic_cast<EqualCondition *>(cond);
+    if (equal_cond == nullptr) continue;
+    Index *equal_index = table->GetIndex(equal_cond->GetIdx(), false);
+    if (equal_index != nullptr && equal_index->Accepts(equal_cond->GetField())) {
+      index = equal_index;
+      low = high = equal_cond->GetField();
+      break;
+    }
+  }
+  for (size_t i = 0; index == nullptr && i < conds.size(); i++) {
+    AlgebraCondition *range_cond = dynamic_cast<GreaterCondition *>(conds[i]);
+    if (range_cond == nullptr) range_cond = dynamic_cast<LessCondition *>(conds[i]);
+    if (range_cond == nullptr) continue;
+    Index *range_index = table->GetIndex(range_cond->GetIdx(), true);
+    if (range_index == nullptr || !range_index->Accepts(range_cond->GetField())) continue;
+    // 同一列上的每一侧取第一个条件，其余条件由 FilterNode 检查
+    index = range_index;
+    for (Condition *cond : conds) {
+      AlgebraCondition *bound = dynamic_cast<AlgebraCondition *>(cond);
+      if (bound == nullptr || bound->GetIdx() != index->GetColumn() || !index->Accepts(bound->GetField())) continue;
+      if (low == nullptr && dynamic_cast<GreaterCondition *>(cond) != nullptr) low = bound->GetField();
+      if (high == nullptr && dynamic_cast<LessCondition *>(cond) != nullptr) high = bound->GetField();
+    }
+  }
+  if (index == nullptr) return new TableScanNode(table, filter, cols);
+  // 数值列上有直方图时估计读取的比例，比例较大时随机读取记录不如顺序扫描
+  FieldType type = table->GetColumnType(index->GetColumn());
+  if (type != FieldType::STRING && StatsManager::GetInstance().HasHistogram(table_name, index->GetColumn())) {
+    double lower = low == nullptr ? -DBL_MAX : NumericValue(low);
+    double upper = high == nullptr ? DBL_MAX : NumericValue(high) + EPSILON;
+    if (low == high && type == FieldType::INT) upper = std::ceil(lower + EPSILON);
+    double ratio = StatsManager::GetInstance().RangeBound(table_name, index->GetColumn(), lower, upper);
+    if (ratio > INDEX_SCAN_MAX_RATIO) return new TableScanNode(table, filter, cols);
+  }
+  return new IndexScanNode(table, index, low, high);
+}
+
 std::any Optimizer::visit(Delete *delete_) {
   string table_name = delete_->table_name_;
-  // 初始化全表扫描结点
-  OperNode *plan = new TableScanNode(meta_->GetTable(table_name));
-  // 添加选择条件算子
+  // 先解析选择条件，再按条件选择扫描方式
   if (delete_->condition_ != nullptr) delete_->condition_->accept(this);
+  OperNode *plan = ScanTable(table_name);
+  // 添加选择条件算子
 
   auto it = table_filter_.find(table_name);
   if (it != table_filter_.end()) {
@@ -63,10 +165,10 @@ std::any Optimizer::visit(Delete *delete_) {
 
 std::any Optimizer::visit(Update *update) {
   string table_name = update->table_name_;
-  // 初始化全表扫描结点
-  OperNode *plan = new TableScanNode(meta_->GetTable(table_name));
-  // 添加选择条件算子
+  // 先解析选择条件，再按条件选择扫描方式
   if (update->condition_ != nullptr) update->condition_->accept(this);
+  OperNode *plan = ScanTable(table_name);
+  // 添加选择条件算子
   auto it = table_filter_.find(table_name);
   if (it != table_filter_.end()) {
     FilterNode *node = new FilterNode(plan, table_filter_[table_name]);
@@ -93,14 +195,15 @@ std::any Optimizer::visit(Update *update) {
 
 std::any Optimizer::visit(Select *select) {
   auto uf_set = UFSet<string>(select->tables_);
-  // 初始化全表扫描结点
+  // 先解析选择条件，再按各表的条件选择扫描方式
+  if (select->condition_ != nullptr) select->condition_->accept(this);
   std::unordered_map<string, OperNode *> table_map{};
+  vector<int> scan_cols = ScanColumns(select);
   for (const auto &table_name : select->tables_) {
-    table_map[table_name] = new TableScanNode(meta_->GetTable(table_name));
+    table_map[table_name] = ScanTable(table_name, scan_cols);
     table_shift_[table_name] = 0;
   }
   // 添加选择条件算子
-  if (select->condition_ != nullptr) select->condition_->accept(this);
   for (const auto &table_name : select->tables_) {
     auto it = table_filter_.find(table_name);
     if (it != table_filter_.end()) {
@@ -37,6 +37,12 @@ class Optimizer : public Visitor {
   SystemManager *meta_;
   std::unordered_map<string, Condition *> table_filter_{};
   std::unordered_map<string, int> table_shift_{};
+
+  // 表上的选择条件可以使用索引时返回索引扫描结点，否则返回全表扫描结点，选择条件仍由 FilterNode 检查
+  // cols 不为空时全表扫描只解析其中的列
+  OperNode *ScanTable(const string &table_name, const vector<int> &cols = {});
+  // 单表查询中投影与选择条件用到的列，需要所有列时返回空
+  vector<int> ScanColumns(Select *select);
 };
 
 }  // namespace dbtrain
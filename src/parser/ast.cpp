@@ -15,8 +15,14 @@ std::any UseDatabase::accept(Visitor *v) { return v->visit(this); }
 std::any DropDatabase::accept(Visitor *v) { return v->visit(this); }
 std::any CreateTable::accept(Visitor *v) { return v->visit(this); }
 std::any ShowTables::accept(Visitor *v) { return v->visit(this); }
+std::any ShowBufferStatus::accept(Visitor *v) { return v->visit(this); }
+std::any ShowLogStatus::accept(Visitor *v) { return v->visit(this); }
+std::any ShowTableStatus::accept(Visitor *v) { return v->visit(this); }
 std::any DescTable::accept(Visitor *v) { return v->visit(this); }
 std::any DropTable::accept(Visitor *v) { return v->visit(this); }
+std::any CreateIndex::accept(Visitor *v) { return v->visit(this); }
+std::any DropIndex::accept(Visitor *v) { return v->visit(this); }
+std::any ShowIndexes::accept(Visitor *v) { return v->visit(this); }
 std::any Col::accept(Visitor *v) { return v->visit(this); }
 std::any Insert::accept(Visitor *v) { return v->visit(this); }
 std::any Delete::accept(Visitor *v) { return v->visit(this); }
@@ -24,6 +30,7 @@ std::any Update::accept(Visitor *v) { return v->visit(this); }
 std::any Select::accept(Visitor *v) { return v->visit(this); }
 std::any Explain::accept(Visitor *v) { return v->visit(this); }
 std::any Analyze::accept(Visitor *v) { return v->visit(this); }
+std::any Vacuum::accept(Visitor *v) { return v->visit(this); }
 std::any Declare::accept(Visitor *v) { return v->visit(this); }
 std::any EndDeclare::accept(Visitor *v) { return v->visit(this); }
 std::any Run::accept(Visitor *v) { return v->visit(this); }
@@ -3,6 +3,7 @@
 
 #include <any>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -77,11 +78,14 @@ class FieldNode : public SQL {
 
 class CreateTable : public SQL {
  public:
-  CreateTable(std::string table_name, std::vector<std::shared_ptr<FieldNode>> fields)
-      : table_name_(std::move(table_name)), fields_(std::move(fields)) {}
+  CreateTable(std::string table_name, std::vector<std::shared_ptr<FieldNode>> fields,
+              std::map<std::string, std::string> options)
+      : table_name_(std::move(table_name)), fields_(std::move(fields)), options_(std::move(options)) {}
   virtual std::any accept(Visitor *v);
   std::string table_name_;
   std::vector<std::shared_ptr<FieldNode>> fields_;
+  // WITH (key = value, ...) 中的表选项
+  std::map<std::string, std::string> options_;
 };
 
 class ShowTables : public SQL {
@@ -89,6 +93,21 @@ class ShowTables : public SQL {
   virtual std::any accept(Visitor *v);
 };
 
+class ShowBufferStatus : public SQL {
+ public:
+  virtual std::any accept(Visitor *v);
+};
+
+class ShowLogStatus : public SQL {
+ public:
+  virtual std::any accept(Visitor *v);
+};
+
+class ShowTableStatus : public SQL {
+ public:
+  virtual std::any accept(Visitor *v);
+};
+
 class DescTable : public SQL {
  public:
   DescTable(std::string table_name) : table_name_(std::move(table_name)) {}
@@ -103,6 +122,33 @@ class DropTable : public SQL {
   std::string table_name_;
 };
 
+class CreateIndex : public SQL {
+ public:
+  CreateIndex(std::string index_name, std::string table_name, std::string col_name, std::string index_type)
+      : index_name_(std::move(index_name)),
+        table_name_(std::move(table_name)),
+        col_name_(std::move(col_name)),
+        index_type_(std::move(index_type)) {}
+  virtual std::any accept(Visitor *v);
+  std::string index_name_;
+  std::string table_name_;
+  std::string col_name_;
+  // USING 之后的索引类型，为空时使用 B+ 树
+  std::string index_type_;
+};
+
+class DropIndex : public SQL {
+ public:
+  DropIndex(std::string index_name) : index_name_(std::move(index_name)) {}
+  virtual std::any accept(Visitor *v);
+  std::string index_name_;
+};
+
+class ShowIndexes : public SQL {
+ public:
+  virtual std::any accept(Visitor *v);
+};
+
 class Col : public SQL {
  public:
   Col(std::string table_name, std::string col_name) : table_name_(std::move(table_name)), col_name_(col_name) {}
@@ -263,6 +309,14 @@ class Analyze : public SQL {
   virtual std::any accept(Visitor *v);
 };
 
+// table_name_ 为空时清理所有表
+class Vacuum : public SQL {
+ public:
+  Vacuum(std::string table_name) : table_name_(std::move(table_name)) {}
+  virtual std::any accept(Visitor *v);
+  std::string table_name_;
+};
+
 class Declare : public SQL {
  public:
   Declare(std::string declaring) : declaring_(declaring) {}
@@ -340,6 +394,7 @@ struct SemValue {
   std::string sv_str;
   bool sv_bool;
   std::vector<std::string> sv_strs;
+  std::map<std::string, std::string> sv_options;
   SvOp sv_op;
   SvLogicOp sv_logic_op;
   std::shared_ptr<SQL> sv_node;
@@ -28,11 +28,15 @@ using namespace dbtrain::ast;
 %token <sv_int> VALUE_INT
 %token <sv_float> VALUE_FLOAT
 %token <sv_str> VALUE_STRING IDENTIFIER
+/* 非保留关键字：携带原文本，可回退为标识符 */
+%token <sv_str> BUFFER STATUS LOG WITH INDEX INDEXES ON USING VACUUM
 
 %type <sv_node> stmt select_stmt explainable_stmt
 %type <sv_bool> opt_if_exists
 %type <sv_field> field
 %type <sv_fields> field_list
+%type <sv_options> opt_table_options table_options
+%type <sv_str> opt_index_type identifier
 %type <sv_strs> identifiers
 %type <sv_cols> selectors selector_list
 %type <sv_val> value
@@ -67,34 +71,58 @@ stmt:
         {
             $$ = std::make_shared<ShowDatabases>();
         }
-    |   CREATE DATABASE IDENTIFIER
+    |   CREATE DATABASE identifier
         {
             $$ = std::make_shared<CreateDatabase>($3);
         }
-    |   USE IDENTIFIER
+    |   USE identifier
         {
             $$ = std::make_shared<UseDatabase>($2);
         }
-    |   DROP DATABASE opt_if_exists IDENTIFIER
+    |   DROP DATABASE opt_if_exists identifier
         {
             $$ = std::make_shared<DropDatabase>($4, $3);
         }
-    |   CREATE TABLE IDENTIFIER '(' field_list ')'
+    |   CREATE TABLE identifier '(' field_list ')' opt_table_options
         {
-            $$ = std::make_shared<CreateTable>($3, $5);
+            $$ = std::make_shared<CreateTable>($3, $5, $7);
         }
     |   SHOW TABLES
         {
             $$ = std::make_shared<ShowTables>();
         }
-    |   DESC IDENTIFIER
+    |   SHOW BUFFER STATUS
+        {
+            $$ = std::make_shared<ShowBufferStatus>();
+        }
+    |   SHOW LOG STATUS
+        {
+            $$ = std::make_shared<ShowLogStatus>();
+        }
+    |   SHOW TABLE STATUS
+        {
+            $$ = std::make_shared<ShowTableStatus>();
+        }
+    |   DESC identifier
         {
             $$ = std::make_shared<DescTable>($2);
         }
-    |   DROP TABLE IDENTIFIER
+    |   DROP TABLE identifier
         {
             $$ = std::make_shared<DropTable>($3);
         }
+    |   CREATE INDEX identifier ON identifier '(' identifier ')' opt_index_type
+        {
+            $$ = std::make_shared<CreateIndex>($3, $5, $7, $9);
+        }
+    |   DROP INDEX identifier
+        {
+            $$ = std::make_shared<DropIndex>($3);
+        }
+    |   SHOW INDEXES
+        {
+            $$ = std::make_shared<ShowIndexes>();
+        }
     |   BEGIN_
         {
             $$ = std::make_shared<Begin>();
@@ -119,15 +147,15 @@ stmt:
         {
             $$ = std::make_shared<Flush>();
         }
-    |   INSERT INTO IDENTIFIER VALUES value_lists
+    |   INSERT INTO identifier VALUES value_lists
         {
             $$ = std::make_shared<Insert>($3, $5);
         }
-    |   DELETE FROM IDENTIFIER where_clause
+    |   DELETE FROM identifier where_clause
         {
             $$ = std::make_shared<Delete>($3, $4);
         }
-    |   UPDATE IDENTIFIER SET set_clauses where_clause
+    |   UPDATE identifier SET set_clauses where_clause
         {
             $$ = std::make_shared<Update>($2, $4, $5);
         }
@@ -143,11 +171,19 @@ stmt:
         {
             $$ = std::make_shared<Analyze>();
         }
-    |   DECLARE IDENTIFIER
+    |   VACUUM
+        {
+            $$ = std::make_shared<Vacuum>("");
+        }
+    |   VACUUM identifier
+        {
+            $$ = std::make_shared<Vacuum>($2);
+        }
+    |   DECLARE identifier
         {
             $$ = std::make_shared<Declare>($2);
         }
-    |   ENDDECL IDENTIFIER
+    |   ENDDECL identifier
         {
             $$ = std::make_shared<EndDeclare>($2);
         }
@@ -155,16 +191,27 @@ stmt:
         {
             $$ = std::make_shared<Run>($2);
         }
-    |   SIGNAL_ IDENTIFIER
+    |   SIGNAL_ identifier
         {
             $$ = std::make_shared<Signal>($2);
         }
-    |   WAIT_ IDENTIFIER
+    |   WAIT_ identifier
         {
             $$ = std::make_shared<Wait>($2);
         }
     ;
 
+opt_index_type:
+        /* */
+        {
+            $$ = "";
+        }
+    |   USING identifier
+        {
+            $$ = $2;
+        }
+    ;
+
 opt_if_exists:
         /* */
         {
@@ -203,22 +250,44 @@ set_clauses:
     ;
 
 set_clause:
-        IDENTIFIER '=' value
+        identifier '=' value
         {
             $$ = std::make_shared<SetClause>($1, $3);
         }
 
 identifiers:
-        IDENTIFIER
+        identifier
         {
             $$ = std::vector<std::string>{$1};
         }
-    |   identifiers ',' IDENTIFIER
+    |   identifiers ',' identifier
         {
             $$.push_back($3);
         }
     ;
 
+opt_table_options:
+        /* */
+        {
+            $$ = std::map<std::string, std::string>();
+        }
+    |   WITH '(' table_options ')'
+        {
+            $$ = $3;
+        }
+    ;
+
+table_options:
+        identifier '=' identifier
+        {
+            $$ = std::map<std::string, std::string>{{$1, $3}};
+        }
+    |   table_options ',' identifier '=' identifier
+        {
+            $$[$3] = $5;
+        }
+    ;
+
 field_list:
         field
         {
@@ -231,7 +300,7 @@ field_list:
     ;
 
 field:
-        IDENTIFIER col_type
+        identifier col_type
         {
             $$ = std::make_shared<FieldNode>($1, $2);
         }
@@ -424,16 +493,29 @@ value:
     ;
 
 col:
-        IDENTIFIER
+        identifier
         {
             $$ = std::make_shared<Col>("", $1);
         }
-    |   IDENTIFIER '.' IDENTIFIER
+    |   identifier '.' identifier
         {
             $$ = std::make_shared<Col>($1, $3);
         }
     ;
 
+identifier:
+        IDENTIFIER
+    |   BUFFER
+    |   STATUS
+    |   LOG
+    |   WITH
+    |   INDEX
+    |   INDEXES
+    |   ON
+    |   USING
+    |   VACUUM
+    ;
+
 %%
 void yyerror(const char *s) {
     std::cerr << "Error " << s << std::endl;
@@ -56,11 +56,17 @@ std::any Visitor::visit(CreateTable *create_table) {
     }
     cols.push_back(Column{type_map[field->type_len_->type_], field->type_len_->len_, field->col_name_});
   }
-  return SystemManager::GetInstance().CreateTable(create_table->table_name_, cols);
+  return SystemManager::GetInstance().CreateTable(create_table->table_name_, cols, create_table->options_);
 }
 
 std::any Visitor::visit(ShowTables *) { return SystemManager::GetInstance().ShowTables(); }
 
+std::any Visitor::visit(ShowBufferStatus *) { return SystemManager::GetInstance().ShowBufferStatus(); }
+
+std::any Visitor::visit(ShowLogStatus *) { return SystemManager::GetInstance().ShowLogStatus(); }
+
+std::any Visitor::visit(ShowTableStatus *) { return SystemManager::GetInstance().ShowTableStatus(); }
+
 std::any Visitor::visit(DescTable *desc_table) {
   return SystemManager::GetInstance().DescTable(desc_table->table_name_);
 }
@@ -69,6 +75,17 @@ std::any Visitor::visit(DropTable *drop_table) {
   return SystemManager::GetInstance().DropTable(drop_table->table_name_);
 }
 
+std::any Visitor::visit(CreateIndex *create_index) {
+  return SystemManager::GetInstance().CreateIndex(create_index->index_name_, create_index->table_name_,
+                                                  create_index->col_name_, create_index->index_type_);
+}
+
+std::any Visitor::visit(DropIndex *drop_index) {
+  return SystemManager::GetInstance().DropIndex(drop_index->index_name_);
+}
+
+std::any Visitor::visit(ShowIndexes *) { return SystemManager::GetInstance().ShowIndexes(); }
+
 std::any Visitor::visit(Insert *insert) {
   // 优化器
   Optimizer *optimizer = new Optimizer();
@@ -183,6 +200,8 @@ std::any Visitor::visit(Analyze *analyze) {
   return Result({"ANALYZE"});
 }
 
+std::any Visitor::visit(Vacuum *vacuum) { return SystemManager::GetInstance().Vacuum(vacuum->table_name_); }
+
 std::any Visitor::visit(Declare *declare) {
   assert(executor_ == nullptr);
   assert(!DeclareMode());
@@ -22,8 +22,14 @@ class Visitor {
 
   virtual std::any visit(CreateTable *);
   virtual std::any visit(ShowTables *);
+  virtual std::any visit(ShowBufferStatus *);
+  virtual std::any visit(ShowLogStatus *);
+  virtual std::any visit(ShowTableStatus *);
   virtual std::any visit(DescTable *);
   virtual std::any visit(DropTable *);
+  virtual std::any visit(CreateIndex *);
+  virtual std::any visit(DropIndex *);
+  virtual std::any visit(ShowIndexes *);
 
   virtual std::any visit(Insert *);
   virtual std::any visit(Delete *);
@@ -32,6 +38,7 @@ class Visitor {
 
   virtual std::any visit(Explain *);
   virtual std::any visit(Analyze *);
+  virtual std::any visit(Vacuum *);
 
   virtual std::any visit(Declare *);
   virtual std::any visit(EndDeclare *);
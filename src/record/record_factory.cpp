@@ -7,6 +7,8 @@
 #include "field.h"
 #include "fields.h"
 #include "../table/hidden.h"
+#include "../table/page_handle.h"
+#include "../utils/varint.h"
 #include "float_field.h"
 #include "int_field.h"
 #include "record.h"
@@ -110,6 +112,92 @@ void RecordFactory::StoreRecord(void *dst, Record *record) const {
   // LAB 1 END
 }
 
+// 字符串长度左移一位，最低位为 1 表示溢出存放
+static const uint64_t VAR_STRING_OVERFLOW = 1;
+
+static const OverflowValue *FindOverflow(const std::vector<OverflowValue> &overflow, size_t col) {
+  for (const auto &value : overflow) {
+    if (value.col == col) return &value;
+  }
+  return nullptr;
+}
+
+size_t RecordFactory::GetVarLength(Record *record, const std::vector<OverflowValue> &overflow) const {
+  size_t length = sizeof(uint8_t);
+  for (size_t i = 0; i < record->GetSize(); ++i) {
+    const auto &col = meta_->cols_[i];
+    if (col.type_ != FieldType::STRING) {
+      length += col.len_;
+      continue;
+    }
+    const OverflowValue *value = FindOverflow(overflow, i);
+    if (value != nullptr) {
+      length += VarintLength(value->length << 1 | VAR_STRING_OVERFLOW) + VarintLength(value->rid.page_no) +
+                VarintLength(value->rid.slot_no);
+    } else {
+      size_t size = record->GetField(i)->ToString().size();
+      length += VarintLength(size << 1) + size;
+    }
+  }
+  return length;
+}
+
+void RecordFactory::StoreVarRecord(void *dst, Record *record, const std::vector<OverflowValue> &overflow) const {
+  uint8_t *dst_ = static_cast<uint8_t *>(dst);
+  size_t offset = 0;
+  dst_[offset++] = (uint8_t)SlottedRecordType::TUPLE;
+  for (size_t i = 0; i < record->GetSize(); ++i) {
+    Field *field = record->GetField(i);
+    const auto &col = meta_->cols_[i];
+    if (field->GetType() != col.type_) throw UnsupportFieldError();
+    if (col.type_ != FieldType::STRING) {
+      StoreField(dst_ + offset, field, col.type_, col.len_);
+      offset += col.len_;
+      continue;
+    }
+    const OverflowValue *value = FindOverflow(overflow, i);
+    if (value != nullptr) {
+      offset += PutVarint(dst_ + offset, value->length << 1 | VAR_STRING_OVERFLOW);
+      offset += PutVarint(dst_ + offset, value->rid.page_no);
+      offset += PutVarint(dst_ + offset, value->rid.slot_no);
+    } else {
+      string str = field->ToString();
+      offset += PutVarint(dst_ + offset, str.size() << 1);
+      memcpy(dst_ + offset, str.data(), str.size());
+      offset += str.size();
+    }
+  }
+}
+
+Record *RecordFactory::LoadVarRecord(const void *src, std::vector<OverflowValue> *overflow) const {
+  const uint8_t *src_ = static_cast<const uint8_t *>(src);
+  assert(src_[0] == (uint8_t)SlottedRecordType::TUPLE);
+  Record *record = new Record();
+  size_t offset = sizeof(uint8_t);
+  for (size_t i = 0; i < meta_->cols_.size(); ++i) {
+    const auto &col = meta_->cols_[i];
+    if (col.type_ != FieldType::STRING) {
+      record->PushBack(LoadField(src_ + offset, col.type_, col.len_));
+      offset += col.len_;
+      continue;
+    }
+    uint64_t header = 0;
+    offset += GetVarint(src_ + offset, header);
+    size_t size = header >> 1;
+    if (header & VAR_STRING_OVERFLOW) {
+      OverflowValue value = {i, {0, 0}, size};
+      offset += GetVarint(src_ + offset, value.rid.page_no);
+      offset += GetVarint(src_ + offset, value.rid.slot_no);
+      overflow->push_back(value);
+      record->PushBack(new StrField("", 0));
+    } else {
+      record->PushBack(new StrField((const char *)src_ + offset, size));
+      offset += size;
+    }
+  }
+  return record;
+}
+
 Rid RecordFactory::GetRid(Record *record) {
   // 读取隐藏列的RID信息
   PageID page_id = dynamic_cast<IntField *>(record->field_list_[record->GetSize() - PAGE_ID_OFFSET])->GetValue();
@@ -7,6 +7,13 @@
 
 namespace dbtrain {
 
+// 溢出存放的字符串：col 列的值长度为 length，保存在从 rid 开始的溢出记录链中
+struct OverflowValue {
+  size_t col;
+  Rid rid;
+  size_t length;
+};
+
 class RecordFactory {
  public:
   static Record *ConstInt(int v);
@@ -19,6 +26,13 @@ class RecordFactory {
   Record *LoadRecord(const void *src) const;
   void StoreRecord(void *dst, Record *record) const;
 
+  // SLOTTED 布局的变长记录：首字节为记录类型，字符串以 varint 长度加实际内容存放，
+  // 溢出的字符串只存放长度与溢出记录的位置；隐藏列仍位于记录末尾
+  size_t GetVarLength(Record *record, const std::vector<OverflowValue> &overflow) const;
+  void StoreVarRecord(void *dst, Record *record, const std::vector<OverflowValue> &overflow) const;
+  // 溢出的字符串先以空串代替，位置追加到 overflow 中
+  Record *LoadVarRecord(const void *src, std::vector<OverflowValue> *overflow) const;
+
   static Field *LoadField(const void *src, FieldType ft, FieldSize fs);
   static void StoreField(void *dst, Field *field, FieldType ft, FieldSize fs);
 
@@ -1,116 +1,671 @@
 #include "buffer_manager.h"
 
+#include <sys/mman.h>
+
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+
+#include "../exception/exceptions.h"
+#include "../system/config_manager.h"
 
 namespace dbtrain {
 
-BufferManager::BufferManager() : disk_manager_(DiskManager::GetInstance()), log_manager_(LogManager::GetInstance()) {
-  for (int i = 0; i < BUFFER_SIZE; i++) {
-    free_list_.push_back(i);
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// 按文件与页号排序，多个页面加锁时统一使用该顺序
+static bool PageOrder(Page *a, Page *b) {
+  FilePageId page_a = a->GetPageId(), page_b = b->GetPageId();
+  return page_a.fd != page_b.fd ? page_a.fd < page_b.fd : page_a.page_no < page_b.page_no;
+}
+
+BufferManager::BufferManager()
+    : disk_manager_(DiskManager::GetInstance()),
+      log_manager_(LogManager::GetInstance()),
+      hits_(0),
+      misses_(0),
+      evictions_(0),
+      read_ahead_calls_(0),
+      read_ahead_pages_read_(0),
+      read_ahead_hits_(0),
+      writer_stop_(false),
+      writer_paused_(false),
+      writer_cursor_({-1, 0}),
+      foreground_writes_(0),
+      background_writes_(0),
+      background_write_calls_(0),
+      checkpoint_writes_(0) {
+  ConfigManager &config = ConfigManager::GetInstance();
+  capacity_ = config.GetSize("buffer-size", (size_t)BUFFER_SIZE * PAGE_SIZE) / PAGE_SIZE;
+  if (capacity_ < BUFFER_SIZE) capacity_ = BUFFER_SIZE;
+  AllocFrames();
+  policy_ = config.GetString("buffer-policy", "lru");
+  replacer_ = Replacer::Create(policy_, capacity_);
+  for (size_t i = 0; i < capacity_; i++) {
+    free_list_.push_back((int)i);
+  }
+  // 预读窗口不超过缓冲池的 1/4，避免预读挤掉正在使用的页面
+  read_ahead_pages_ = config.GetSize("read-ahead", 128 * 1024) / PAGE_SIZE;
+  if (read_ahead_pages_ > capacity_ / 4) read_ahead_pages_ = capacity_ / 4;
+  writer_delay_ms_ = config.GetInt("bgwriter-delay", 200);
+  writer_clean_target_ = config.GetInt("bgwriter-clean-target", capacity_ / 4);
+  writer_max_pages_ = config.GetInt("bgwriter-max-pages", 64);
+  if (writer_delay_ms_ <= 0) throw InvalidConfigError("bgwriter-delay", std::to_string(writer_delay_ms_));
+  if (config.GetBool("bgwriter", true)) writer_ = std::thread(&BufferManager::WriterLoop, this);
+}
+
+BufferManager::~BufferManager() {
+  if (writer_.joinable()) {
+    {
+      std::lock_guard<std::mutex> writer_lock(writer_mutex_);
+      writer_stop_ = true;
+    }
+    writer_cv_.notify_all();
+    writer_.join();
   }
+  FlushAll();
+  delete replacer_;
+  munmap(slab_, slab_size_);
 }
 
-BufferManager::~BufferManager() { FlushAll(); }
+void BufferManager::AllocFrames() {
+  // 所有帧一次性分配为一整块按页对齐的内存
+  // 开启 buffer-huge-pages 时优先使用 HugeTLB，失败则退回普通页并建议内核使用透明大页
+  slab_size_ = capacity_ * PAGE_SIZE;
+  huge_pages_ = false;
+  void *addr = MAP_FAILED;
+  if (ConfigManager::GetInstance().GetBool("buffer-huge-pages", false)) {
+    size_t huge_size = (slab_size_ + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    addr = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr != MAP_FAILED) {
+      slab_size_ = huge_size;
+      huge_pages_ = true;
+    } else {
+      std::cerr << "BufferManager: huge pages unavailable, fallback to normal pages\n";
+    }
+  }
+  if (addr == MAP_FAILED) {
+    addr = mmap(nullptr, slab_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+      std::cerr << "Error in BufferManager::AllocFrames\n";
+      throw UnknownError();
+    }
+    if (slab_size_ >= HUGE_PAGE_SIZE) madvise(addr, slab_size_, MADV_HUGEPAGE);
+  }
+  slab_ = (Byte *)addr;
+  // Page 含有闩，不可移动，只能整体构造
+  frames_ = std::vector<Page>(capacity_);
+  for (size_t i = 0; i < capacity_; i++) {
+    frames_[i].data_ = slab_ + i * PAGE_SIZE;
+  }
+}
 
 BufferManager &BufferManager::GetInstance() {
   static BufferManager buffer_manager;
   return buffer_manager;
 }
 
-Page *BufferManager::AllocPage(int fd, PageID page_no) {
-  Page *page = FetchPage(fd, page_no);
-  return page;
+PageGuard BufferManager::AllocPage(int fd, PageID page_no) { return PageGuard(FetchPage(fd, page_no, false)); }
+
+PageGuard BufferManager::GetPage(int fd, PageID page_no) { return PageGuard(FetchPage(fd, page_no, true)); }
+
+PageTableShard &BufferManager::GetShard(const FilePageId &page_id) const {
+  return shards_[PageIdHash()(page_id) % PAGE_TABLE_SHARDS];
+}
+
+void BufferManager::Pin(int frame_no) {
+  bool first_pin = frames_[frame_no].pin_count_++ == 0;
+  std::lock_guard<std::mutex> frame_lock(frame_mutex_);
+  if (first_pin) replacer_->SetEvictable(frame_no, false);
+  replacer_->Access(frame_no);
+}
+
+void BufferManager::PinPage(Page *page) {
+  // 调用者已经持有一次 pin，帧不会被替换，也不会改变可替换状态
+  assert(page->pin_count_ > 0);
+  page->pin_count_++;
+}
+
+void BufferManager::UnpinPage(Page *page) {
+  PageTableShard &shard = GetShard(page->page_id_);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  // Clear() 之后残留的 PageGuard 不再生效
+  if (page->pin_count_ <= 0) return;
+  if (--page->pin_count_ == 0) {
+    std::lock_guard<std::mutex> frame_lock(frame_mutex_);
+    replacer_->SetEvictable(page - frames_.data(), true);
+  }
+}
+
+void BufferManager::ReleaseFrame(int frame_no) {
+  std::lock_guard<std::mutex> frame_lock(frame_mutex_);
+  replacer_->Remove(frame_no);
+  free_list_.push_front(frame_no);
 }
 
-Page *BufferManager::GetPage(int fd, PageID page_no) {
-  Page *page;
+void BufferManager::InstallFrame(int frame_no, const FilePageId &page_id, bool loading) {
+  Page *page = &frames_[frame_no];
+  page->page_id_ = page_id;
+  page->is_dirty_ = false;
+  page->page_lsn_ = 0;
+  page->rec_lsn_ = 0;
+  page->loading_ = loading;
+  page->prefetched_ = false;
+  GetShard(page_id).map[page_id] = frame_no;
+}
+
+void BufferManager::FailLoad(PageTableShard &shard, int frame_no) {
+  Page *page = &frames_[frame_no];
+  shard.map.erase(page->page_id_);
+  // 等待该页面的线程发现页号失效后会释放各自的 pin 并重试
+  page->page_id_ = {-1, 0};
+  page->loading_ = false;
+  if (--page->pin_count_ == 0) ReleaseFrame(frame_no);
+  shard.cv.notify_all();
+}
+
+bool BufferManager::WaitLoaded(std::unique_lock<std::mutex> &lock, PageTableShard &shard, Page *page,
+                               const FilePageId &page_id) {
+  shard.cv.wait(lock, [page] { return !page->loading_; });
+  if (page->page_id_ == page_id) return true;
+  if (--page->pin_count_ == 0) ReleaseFrame(page - frames_.data());
+  return false;
+}
+
+Page *BufferManager::FetchPage(int fd, PageID page_no, bool read) {
   FilePageId page_id = {fd, page_no};
-  auto iter_page = hashmap_.find(page_id);
-  if (iter_page != hashmap_.end()) {
-    int frame_no = iter_page->second;
-    Access(frame_no);
-    page = &frames_[frame_no];
-  } else {
-    page = FetchPage(fd, page_no);
-    disk_manager_.ReadPage(fd, page_no, page->data_);
+  PageTableShard &shard = GetShard(page_id);
+  int frame_no = -1;
+  bool first_try = true;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(shard.mutex);
+      auto iter_page = shard.map.find(page_id);
+      if (iter_page != shard.map.end()) {
+        // 其他线程已经载入了该页面，归还空帧
+        if (frame_no != -1) ReleaseFrame(frame_no);
+        frame_no = iter_page->second;
+        Page *page = &frames_[frame_no];
+        Pin(frame_no);
+        if (first_try) hits_++;
+        if (!WaitLoaded(lock, shard, page, page_id)) {
+          frame_no = -1;
+          first_try = false;
+          continue;
+        }
+        if (page->prefetched_) {
+          page->prefetched_ = false;
+          read_ahead_hits_++;
+        }
+        return page;
+      }
+      if (frame_no != -1) {
+        InstallFrame(frame_no, page_id, read);
+        Pin(frame_no);
+        break;
+      }
+    }
+    if (first_try) misses_++;
+    first_try = false;
+    // 取得空帧时不持有分片锁，写回被替换页面不会阻塞本分片的查找
+    frame_no = AcquireFrame();
+  }
+  Page *page = &frames_[frame_no];
+  if (read) {
+    try {
+      disk_manager_.ReadPage(fd, page_no, page->data_);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      FailLoad(shard, frame_no);
+      throw;
+    }
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      page->loading_ = false;
+    }
+    shard.cv.notify_all();
   }
   return page;
 }
 
-void BufferManager::Clear() {
-  free_list_.insert(free_list_.end(), busy_list_.begin(), busy_list_.end());
-  busy_list_.clear();
-  hashmap_.clear();
+void BufferManager::ReadAhead(int fd, PageID page_no, PageID end_page, ReadAheadState &state) {
+  if (read_ahead_pages_ == 0 || page_no == state.last_page) return;
+  bool sequential = (page_no == state.last_page + 1);
+  state.last_page = page_no;
+  // 扫描跳过页面后从当前页重新预读，已预读区间消耗过半时继续预读下一批
+  if (!sequential || state.ahead_until < page_no) state.ahead_until = page_no;
+  if (page_no + read_ahead_pages_ / 2 < state.ahead_until) return;
+  PageID first = state.ahead_until;
+  PageID last = std::min<PageID>(page_no + read_ahead_pages_, end_page);
+  if (first >= last) return;
+  state.ahead_until = last;
+  vector<PageID> pages;
+  for (PageID page_no = first; page_no < last; page_no++) pages.push_back(page_no);
+  Prefetch(fd, pages);
 }
 
-void BufferManager::FlushFile(int fd) {
-  auto iter = hashmap_.begin();
-  while (iter != hashmap_.end()) {
-    auto prev = iter;
-    iter++;
-    if (prev->first.fd == fd) {
-      FlushPage(&frames_[prev->second]);
+void BufferManager::Prefetch(int fd, const vector<PageID> &pages) {
+  // 只预读文件中已经存在的页面
+  PageID file_pages = disk_manager_.FileSize(fd) / PAGE_SIZE;
+  vector<PageID> runs_first;
+  vector<vector<int>> runs_frames;
+  vector<int> run_frames;
+  PageID run_next = NULL_PAGE;
+  for (PageID page_no : pages) {
+    if (page_no >= file_pages) break;
+    if (!run_frames.empty() && page_no != run_next) {
+      runs_frames.push_back(std::move(run_frames));
+      run_frames.clear();
     }
+    FilePageId page_id = {fd, page_no};
+    PageTableShard &shard = GetShard(page_id);
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      if (shard.map.count(page_id) > 0) continue;
+    }
+    int frame_no = -1;
+    try {
+      frame_no = AcquireFrame();
+    } catch (DbError &e) {
+      // 没有可用的帧，放弃剩余的预读
+      break;
+    }
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.map.count(page_id) > 0) {
+      ReleaseFrame(frame_no);
+      continue;
+    }
+    // 预读期间 pin 住页面，但不记录访问，未被使用的预读页面会被优先替换
+    InstallFrame(frame_no, page_id, true);
+    frames_[frame_no].prefetched_ = true;
+    frames_[frame_no].pin_count_ = 1;
+    if (run_frames.empty()) runs_first.push_back(page_no);
+    run_frames.push_back(frame_no);
+    run_next = page_no + 1;
   }
+  if (!run_frames.empty()) runs_frames.push_back(std::move(run_frames));
+  if (!runs_frames.empty()) ReadRuns(fd, runs_first, runs_frames);
 }
 
-void BufferManager::FlushAll() {
-  for (auto frame_no : busy_list_) {
-    WriteBack(&frames_[frame_no]);
+void BufferManager::ReadRuns(int fd, const vector<PageID> &runs_first, const vector<vector<int>> &runs_frames) {
+  vector<PageRun> runs;
+  for (size_t i = 0; i < runs_frames.size(); i++) {
+    PageRun run = {fd, runs_first[i], {}, 0};
+    for (int frame_no : runs_frames[i]) run.pages.push_back(frames_[frame_no].data_);
+    runs.push_back(std::move(run));
+  }
+  try {
+    disk_manager_.ReadPageRuns(runs);
+  } catch (DbError &e) {
+    // 读入失败的页面会在下次访问时重新读取
+  }
+  for (size_t i = 0; i < runs.size(); i++) {
+    read_ahead_calls_++;
+    read_ahead_pages_read_ += runs[i].done;
+    for (size_t j = 0; j < runs_frames[i].size(); j++) {
+      Page *page = &frames_[runs_frames[i][j]];
+      PageTableShard &shard = GetShard(page->page_id_);
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (j >= runs[i].done) {
+          FailLoad(shard, runs_frames[i][j]);
+          continue;
+        }
+        page->loading_ = false;
+      }
+      shard.cv.notify_all();
+      UnpinPage(page);
+    }
   }
-  free_list_.insert(free_list_.end(), busy_list_.begin(), busy_list_.end());
-  busy_list_.clear();
-  hashmap_.clear();
 }
 
-bool BufferManager::PageInCache(const FilePageId file_page_id) { return hashmap_.count(file_page_id) > 0; }
-
-void BufferManager::FlushPage(Page *page) {
-  assert(PageInCache(page->page_id_));
-  WriteBack(page);
-  int frame_no = hashmap_[page->page_id_];
-  busy_list_.remove(frame_no);
-  free_list_.push_front(frame_no);
-  hashmap_.erase(page->page_id_);
-  assert(!PageInCache(page->page_id_));
+int BufferManager::AcquireFrame() {
+  while (true) {
+    int frame_no = -1;
+    {
+      std::lock_guard<std::mutex> frame_lock(frame_mutex_);
+      if (!free_list_.empty()) {
+        frame_no = free_list_.front();
+        free_list_.pop_front();
+        return frame_no;
+      }
+      if (!replacer_->Victim(&frame_no)) {
+        std::cerr << "Error in BufferManager::AcquireFrame: all frames are pinned\n";
+        throw UnknownError();
+      }
+    }
+    Page *page = &frames_[frame_no];
+    PageTableShard &shard = GetShard(page->page_id_);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    // 选出后、加锁前被其他线程重新 pin，放弃该帧，unpin 时会重新成为候选帧
+    if (page->pin_count_ > 0) continue;
+    if (page->is_dirty_) {
+      // 脏页先 pin 住留在页表中，释放分片锁后再写回，写回可能等待日志落盘，不阻塞同一分片的其他页面
+      // 写回期间其他线程仍从内存取得该页面，不会从磁盘读到旧页面
+      page->pin_count_++;
+      lock.unlock();
+      page->RLatch();
+      bool written = WriteBack(page);
+      page->RUnlatch();
+      if (written) foreground_writes_++;
+      lock.lock();
+      // 写回期间被其他线程 pin 或再次修改，放弃该帧
+      if (--page->pin_count_ > 0) continue;
+      if (page->is_dirty_) {
+        std::lock_guard<std::mutex> frame_lock(frame_mutex_);
+        replacer_->SetEvictable(frame_no, true);
+        continue;
+      }
+    }
+    shard.map.erase(page->page_id_);
+    {
+      std::lock_guard<std::mutex> frame_lock(frame_mutex_);
+      replacer_->Remove(frame_no);
+    }
+    evictions_++;
+    return frame_no;
+  }
 }
 
-Page *BufferManager::FetchPage(int fd, PageID page_no) {
-  Page *page;
-  int frame_no = -1;
-  FilePageId page_id = {fd, page_no};
-  auto iter_page = hashmap_.find(page_id);
-  assert(iter_page == hashmap_.end());  // Page not in memory
-  if (free_list_.empty()) {
-    // Buffer full
-    frame_no = busy_list_.back();
-    busy_list_.pop_back();
-    WriteBack(&frames_[frame_no]);
-    hashmap_.erase(frames_[frame_no].page_id_);
-  } else {
-    // Buffer not full
-    frame_no = free_list_.front();
-    free_list_.pop_front();
-  }
-  page = &frames_[frame_no];
-  page->page_id_ = page_id;
-  page->is_dirty_ = false;
-  busy_list_.push_front(frame_no);
-  hashmap_[page_id] = frame_no;
-  return page;
+void BufferManager::Clear() {
+  std::lock_guard<std::mutex> writer_lock(writer_mutex_);
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::lock_guard<std::mutex> frame_lock(frame_mutex_);
+    for (const auto &pair : shard.map) {
+      frames_[pair.second].pin_count_ = 0;
+      frames_[pair.second].loading_ = false;
+      replacer_->Remove(pair.second);
+      free_list_.push_back(pair.second);
+    }
+    shard.map.clear();
+  }
 }
 
-void BufferManager::Access(int frame_no) {
-  busy_list_.remove(frame_no);
-  busy_list_.push_front(frame_no);
+void BufferManager::FlushIf(bool all, int fd) {
+  std::lock_guard<std::mutex> writer_lock(writer_mutex_);
+  // 先在分片锁内 pin 住需要写回的页面，之后不持有分片锁加读锁，所有页面合并为一批写入
+  vector<Page *> pages;
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (const auto &pair : shard.map) {
+      if (!all && pair.first.fd != fd) continue;
+      // 写回不算作访问，不影响替换顺序
+      if (frames_[pair.second].pin_count_++ == 0) {
+        std::lock_guard<std::mutex> frame_lock(frame_mutex_);
+        replacer_->SetEvictable(pair.second, false);
+      }
+      pages.push_back(&frames_[pair.second]);
+    }
+  }
+  // 与后台写回相同，按页号顺序加锁
+  std::sort(pages.begin(), pages.end(), PageOrder);
+  for (Page *page : pages) page->RLatch();
+  try {
+    WriteBack(pages);
+  } catch (...) {
+    for (Page *page : pages) {
+      page->RUnlatch();
+      UnpinPage(page);
+    }
+    throw;
+  }
+  for (Page *page : pages) {
+    page->RUnlatch();
+    FilePageId page_id = page->page_id_;
+    PageTableShard &shard = GetShard(page_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // 仍在使用的页面只写回，不释放
+    if (--page->pin_count_ > 0 || page->is_dirty_) {
+      if (page->pin_count_ == 0) {
+        std::lock_guard<std::mutex> frame_lock(frame_mutex_);
+        replacer_->SetEvictable(page - frames_.data(), true);
+      }
+      continue;
+    }
+    shard.map.erase(page_id);
+    ReleaseFrame(page - frames_.data());
+  }
 }
 
-void BufferManager::WriteBack(Page *page) {
-  if (page->is_dirty_) {
-    log_manager_.WritePage(page->page_id_.fd, page->page_id_.page_no);
+void BufferManager::FlushFile(int fd) { FlushIf(false, fd); }
+
+void BufferManager::FlushAll() { FlushIf(true, 0); }
+
+bool BufferManager::WriteBack(Page *page) {
+  // 已写日志、尚未修改完成的页面暂不写回
+  if (page->is_dirty_ && !page->UpdatePending()) {
+    // WAL：页面写回前，修改该页面的日志必须已经落盘
+    log_manager_.Flush(page->GetLSN());
     disk_manager_.WritePage(page->page_id_.fd, page->page_id_.page_no, page->data_);
+    log_manager_.WritePage(page->page_id_.fd, page->page_id_.page_no, page->GetLSN());
     page->is_dirty_ = false;
+    page->rec_lsn_ = 0;
+    return true;
+  }
+  return false;
+}
+
+size_t BufferManager::WriteBack(const vector<Page *> &pages) {
+  vector<Page *> dirty;
+  LSN max_lsn = 0;
+  for (Page *page : pages) {
+    if (!page->is_dirty_ || page->UpdatePending()) continue;
+    dirty.push_back(page);
+    max_lsn = std::max(max_lsn, page->GetLSN());
+  }
+  if (dirty.empty()) return 0;
+  // WAL：一次落盘覆盖所有页面的日志
+  log_manager_.Flush(max_lsn);
+  std::sort(dirty.begin(), dirty.end(), PageOrder);
+  vector<PageRun> runs;
+  for (Page *page : dirty) {
+    if (runs.empty() || runs.back().fd != page->page_id_.fd ||
+        runs.back().first_page + runs.back().pages.size() != page->page_id_.page_no) {
+      runs.push_back({page->page_id_.fd, page->page_id_.page_no, {}, 0});
+    }
+    runs.back().pages.push_back(page->data_);
+  }
+  disk_manager_.WritePageRuns(runs);
+  for (const auto &run : runs) {
+    if (run.done != run.pages.size()) {
+      std::cerr << "Error in BufferManager::WriteBack\n";
+      throw UnknownError();
+    }
+  }
+  for (Page *page : dirty) {
+    log_manager_.WritePage(page->page_id_.fd, page->page_id_.page_no, page->GetLSN());
+    page->is_dirty_ = false;
+    page->rec_lsn_ = 0;
+  }
+  return dirty.size();
+}
+
+void BufferManager::PauseWriter() {
+  std::lock_guard<std::mutex> writer_lock(writer_mutex_);
+  writer_paused_ = true;
+}
+
+void BufferManager::ResumeWriter() {
+  std::lock_guard<std::mutex> writer_lock(writer_mutex_);
+  writer_paused_ = false;
+}
+
+void BufferManager::WriterLoop() {
+  std::unique_lock<std::mutex> writer_lock(writer_mutex_);
+  while (!writer_stop_) {
+    writer_cv_.wait_for(writer_lock, std::chrono::milliseconds(writer_delay_ms_), [this] { return writer_stop_; });
+    if (writer_stop_ || writer_paused_) continue;
+    WriterRound();
+  }
+}
+
+size_t BufferManager::WriterRound() {
+  LSN flushed_lsn = log_manager_.GetFlushedLSN();
+  LSN redo_target = log_manager_.GetRedoTarget();
+  size_t clean = 0;
+  {
+    std::lock_guard<std::mutex> frame_lock(frame_mutex_);
+    clean = free_list_.size();
+  }
+  // 统计干净的可替换帧，并收集满足 WAL 条件的可替换脏页
+  // recLSN 早于最近一次检查点开始的脏页单独收集，无论干净帧是否充足都优先写回
+  vector<pair<FilePageId, int>> candidates;
+  vector<pair<LSN, pair<FilePageId, int>>> aged;
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (const auto &pair : shard.map) {
+      const Page &page = frames_[pair.second];
+      if (page.pin_count_ > 0 || page.loading_) continue;
+      if (!page.is_dirty_) {
+        clean++;
+      } else if (page.page_lsn_ <= flushed_lsn) {
+        LSN rec_lsn = page.rec_lsn_;
+        if (rec_lsn != 0 && rec_lsn < redo_target) {
+          aged.push_back({rec_lsn, pair});
+        } else {
+          candidates.push_back(pair);
+        }
+      }
+    }
+  }
+  if ((clean >= writer_clean_target_ || candidates.empty()) && aged.empty()) return 0;
+  std::sort(aged.begin(), aged.end(),
+            [](const pair<LSN, pair<FilePageId, int>> &a, const pair<LSN, pair<FilePageId, int>> &b) {
+              return a.first < b.first;
+            });
+  if (aged.size() > writer_max_pages_) aged.resize(writer_max_pages_);
+
+  // 按文件与页号排序，从上一轮结束的位置继续，便于合并相邻页面
+  auto page_less = [](const FilePageId &a, const FilePageId &b) {
+    return a.fd != b.fd ? a.fd < b.fd : a.page_no < b.page_no;
+  };
+  std::sort(candidates.begin(), candidates.end(),
+            [&page_less](const pair<FilePageId, int> &a, const pair<FilePageId, int> &b) {
+              return page_less(a.first, b.first);
+            });
+  auto start = std::upper_bound(candidates.begin(), candidates.end(), writer_cursor_,
+                                [&page_less](const FilePageId &cursor, const pair<FilePageId, int> &candidate) {
+                                  return page_less(cursor, candidate.first);
+                                });
+  std::rotate(candidates.begin(), start, candidates.end());
+  size_t limit = clean >= writer_clean_target_ ? 0 : std::min(writer_clean_target_ - clean, writer_max_pages_);
+  limit = std::min(limit, writer_max_pages_ - aged.size());
+  if (candidates.size() > limit) candidates.resize(limit);
+  if (!candidates.empty()) writer_cursor_ = candidates.back().first;
+  for (const auto &page : aged) candidates.push_back(page.second);
+  std::sort(candidates.begin(), candidates.end(),
+            [&page_less](const pair<FilePageId, int> &a, const pair<FilePageId, int> &b) {
+              return page_less(a.first, b.first);
+            });
+
+  // 写回期间 pin 住页面，但不改变其在替换策略中的位置；收集之后又被使用的页面本轮不写回
+  vector<Page *> pages;
+  for (const auto &candidate : candidates) {
+    PageTableShard &shard = GetShard(candidate.first);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto iter = shard.map.find(candidate.first);
+    if (iter == shard.map.end() || iter->second != candidate.second) continue;
+    if (frames_[candidate.second].pin_count_ > 0) continue;
+    frames_[candidate.second].pin_count_++;
+    pages.push_back(&frames_[candidate.second]);
+  }
+
+  size_t written = 0;
+  vector<vector<Page *>> runs;
+  vector<Page *> run;
+  for (Page *page : pages) {
+    page->RLatch();
+    if (!page->is_dirty_ || page->page_lsn_ > flushed_lsn || page->UpdatePending()) {
+      page->RUnlatch();
+      UnpinPage(page);
+      continue;
+    }
+    if (page->rec_lsn_ != 0 && page->rec_lsn_ < redo_target) checkpoint_writes_++;
+    if (!run.empty() && (run.back()->page_id_.fd != page->page_id_.fd ||
+                         run.back()->page_id_.page_no + 1 != page->page_id_.page_no)) {
+      written += run.size();
+      runs.push_back(std::move(run));
+      run.clear();
+    }
+    run.push_back(page);
+  }
+  if (!run.empty()) {
+    written += run.size();
+    runs.push_back(std::move(run));
+  }
+  if (!runs.empty()) WriteRuns(runs);
+  return written;
+}
+
+void BufferManager::WriteRuns(const vector<vector<Page *>> &runs) {
+  vector<PageRun> page_runs;
+  for (const auto &run : runs) {
+    PageRun page_run = {run.front()->page_id_.fd, run.front()->page_id_.page_no, {}, 0};
+    for (Page *page : run) {
+      // 先清除脏标记，写回期间页面持有读闩，不会被修改
+      page->is_dirty_ = false;
+      page_run.pages.push_back(page->data_);
+    }
+    page_runs.push_back(std::move(page_run));
+  }
+  try {
+    disk_manager_.WritePageRuns(page_runs);
+  } catch (DbError &e) {
+    // 所有页面都会被重新标记为脏页
+  }
+  for (size_t i = 0; i < runs.size(); i++) {
+    if (page_runs[i].done == runs[i].size()) {
+      for (Page *page : runs[i]) {
+        log_manager_.WritePage(page->page_id_.fd, page->page_id_.page_no, page->GetLSN());
+        page->rec_lsn_ = 0;
+      }
+      background_writes_ += runs[i].size();
+      background_write_calls_++;
+    } else {
+      std::cerr << "BufferManager: background write failed\n";
+      for (Page *page : runs[i]) page->is_dirty_ = true;
+    }
+    for (Page *page : runs[i]) {
+      page->RUnlatch();
+      UnpinPage(page);
+    }
+  }
+}
+
+BufferStatus BufferManager::GetStatus() const {
+  BufferStatus status;
+  status.capacity = capacity_;
+  status.policy = policy_;
+  status.used = 0;
+  status.dirty = 0;
+  status.pinned = 0;
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    status.used += shard.map.size();
+    for (const auto &pair : shard.map) {
+      if (frames_[pair.second].is_dirty_) status.dirty++;
+      if (frames_[pair.second].pin_count_ > 0) status.pinned++;
+    }
   }
+  status.hits = hits_;
+  status.misses = misses_;
+  status.evictions = evictions_;
+  status.huge_pages = huge_pages_;
+  status.bgwriter = writer_.joinable();
+  status.foreground_writes = foreground_writes_;
+  status.background_writes = background_writes_;
+  status.background_write_calls = background_write_calls_;
+  status.checkpoint_writes = checkpoint_writes_;
+  status.read_ahead_calls = read_ahead_calls_;
+  status.read_ahead_pages = read_ahead_pages_read_;
+  status.read_ahead_hits = read_ahead_hits_;
+  status.io_backend = disk_manager_.GetIoBackendName();
+  status.direct_io = disk_manager_.IsDirectIo();
+  status.disk = disk_manager_.GetStatus();
+  return status;
 }
 
 }  // namespace dbtrain
@@ -1,42 +1,167 @@
 #ifndef DBTRAIN_BUFFER_MANAGER_H
 #define DBTRAIN_BUFFER_MANAGER_H
 
+#include <condition_variable>
 #include <list>
+#include <mutex>
 
 #include "../defines.h"
 #include "../log/log_manager.h"
 #include "../storage/disk_manager.h"
 #include "../storage/page.h"
+#include "../storage/page_guard.h"
+#include "../storage/replacer.h"
 
 namespace dbtrain {
 
+// 缓冲池运行状态，用于 SHOW BUFFER STATUS
+struct BufferStatus {
+  size_t capacity;  // 帧数
+  string policy;
+  size_t used;
+  size_t dirty;
+  size_t pinned;
+  size_t hits;
+  size_t misses;
+  size_t evictions;
+  bool huge_pages;
+  bool bgwriter;
+  // 替换时由查询线程同步写回的页面数
+  size_t foreground_writes;
+  // 后台写回的页面数与向量写次数
+  size_t background_writes;
+  size_t background_write_calls;
+  // 后台写回中因 recLSN 早于最近一次检查点而写回的页面数
+  size_t checkpoint_writes;
+  // 预读的向量读次数、读入页面数，以及预读页面被实际访问的次数
+  size_t read_ahead_calls;
+  size_t read_ahead_pages;
+  size_t read_ahead_hits;
+  // 实际使用的 I/O 后端
+  string io_backend;
+  bool direct_io;
+  // 页面校验与双写
+  DiskStatus disk;
+};
+
+static const int PAGE_TABLE_SHARDS = 16;
+
+// 一次顺序扫描的预读进度，由扫描者持有，多个会话同时扫描同一张表时互不干扰，命中时不需要加锁
+struct ReadAheadState {
+  PageID last_page = NULL_PAGE;
+  // 已经发起预读的页号上界
+  PageID ahead_until = 0;
+};
+
+// 页表分片，不同分片的查找互不阻塞
+struct PageTableShard {
+  std::mutex mutex;
+  // 等待其他线程完成页面读入
+  std::condition_variable cv;
+  std::unordered_map<FilePageId, int, PageIdHash> map;
+};
+
+// 线程安全的缓冲池
+// GetPage/AllocPage 返回已 pin 的页面，PageGuard 析构时 unpin，被 pin 的帧不会被替换
+// 锁顺序：页表分片锁 -> frame_mutex_，页面读写闩由 PageHandle 在 pin 期间获取
 class BufferManager {
  public:
   BufferManager(const BufferManager &) = delete;
   void operator=(const BufferManager &) = delete;
   ~BufferManager();
   static BufferManager &GetInstance();
-  Page *AllocPage(int fd, PageID page_no);
-  Page *GetPage(int fd, PageID page_no);
+  PageGuard AllocPage(int fd, PageID page_no);
+  PageGuard GetPage(int fd, PageID page_no);
+  // 对已经 pin 的页面再 pin 一次，用于复制 PageGuard
+  void PinPage(Page *page);
+  void UnpinPage(Page *page);
   void Clear();  // Used for crash test
+  // 写回文件的所有脏页，并释放其中未被 pin 的帧
   void FlushFile(int fd);
   void FlushAll();
-  void WriteBack(Page *page);
+  // 顺序扫描读取 page_no 前调用，state 为该次扫描的预读进度
+  // 预读范围为 [page_no, min(page_no + read-ahead 窗口, end_page))，已预读区间消耗过半时才发起下一批，已缓存的页面会被跳过
+  void ReadAhead(int fd, PageID page_no, PageID end_page, ReadAheadState &state);
+  // 将按页号升序排列的页面中未缓存的部分读入缓冲池，连续的页面合并为一次向量读，所有区间一次提交
+  void Prefetch(int fd, const vector<PageID> &pages);
+  // 恢复过程中暂停后台写回，避免写回与 Redo 同时修改 DPT
+  void PauseWriter();
+  void ResumeWriter();
+
+  BufferStatus GetStatus() const;
 
  private:
   BufferManager();
-  Page *FetchPage(int fd, PageID page_no);
-  bool PageInCache(const FilePageId file_page_id);
-  void FlushPage(Page *page);
-  void Access(int frame_no);
+  Page *FetchPage(int fd, PageID page_no, bool read);
+  // 从空闲链表或替换策略中取得一个空帧，必要时写回被替换的页面
+  int AcquireFrame();
+  // 以下函数调用时需持有页面所在分片的锁
+  void Pin(int frame_no);
+  void InstallFrame(int frame_no, const FilePageId &page_id, bool loading);
+  // 页面读入失败，从页表中移除并唤醒等待的线程
+  void FailLoad(PageTableShard &shard, int frame_no);
+  // 等待页面读入完成，读入失败时释放 pin 并返回 false
+  bool WaitLoaded(std::unique_lock<std::mutex> &lock, PageTableShard &shard, Page *page, const FilePageId &page_id);
+  void ReleaseFrame(int frame_no);
+  // 返回是否发生了写回
+  bool WriteBack(Page *page);
+  // 将其中的脏页合并为一批写回，连续的页面合并为一次向量写，返回写回的页面数
+  size_t WriteBack(const vector<Page *> &pages);
+  void FlushIf(bool all, int fd);
+  PageTableShard &GetShard(const FilePageId &page_id) const;
+  void AllocFrames();
+
+  void ReadRuns(int fd, const vector<PageID> &runs_first, const vector<vector<int>> &runs_frames);
+
+  // 后台写回线程：定期检查干净的可替换帧数量，不足 bgwriter-clean-target 时提前写回脏页
+  void WriterLoop();
+  size_t WriterRound();
+  // 写回若干组页号连续的页面，所有组一次提交，调用时已持有这些页面的读闩
+  void WriteRuns(const vector<vector<Page *>> &runs);
 
   DiskManager &disk_manager_;
   LogManager &log_manager_;
-  Page frames_[BUFFER_SIZE];
-  std::unordered_map<FilePageId, int, PageIdHash> hashmap_;
+  // 缓冲池大小在启动时由 buffer-size 参数决定，默认 BUFFER_SIZE 帧
+  size_t capacity_;
+  // 所有帧的数据位于同一块按页对齐的内存中
+  Byte *slab_;
+  size_t slab_size_;
+  bool huge_pages_;
+  string policy_;
+  std::vector<Page> frames_;
+  mutable PageTableShard shards_[PAGE_TABLE_SHARDS];
 
-  std::list<int> busy_list_;
+  // 保护 replacer_ 与 free_list_
+  std::mutex frame_mutex_;
+  // 替换策略由 buffer-policy 参数决定
+  Replacer *replacer_;
   std::list<int> free_list_;
+
+  std::atomic<size_t> hits_;
+  std::atomic<size_t> misses_;
+  std::atomic<size_t> evictions_;
+
+  // 预读窗口，单位为页，0 表示关闭预读
+  size_t read_ahead_pages_;
+  std::atomic<size_t> read_ahead_calls_;
+  std::atomic<size_t> read_ahead_pages_read_;
+  std::atomic<size_t> read_ahead_hits_;
+
+  std::thread writer_;
+  // 写回线程在每一轮写回期间持有，Clear/Flush 需等待当前一轮结束
+  std::mutex writer_mutex_;
+  std::condition_variable writer_cv_;
+  bool writer_stop_;
+  bool writer_paused_;
+  int writer_delay_ms_;
+  size_t writer_clean_target_;
+  size_t writer_max_pages_;
+  // 下一轮从该页面之后开始选择脏页
+  FilePageId writer_cursor_;
+  std::atomic<size_t> foreground_writes_;
+  std::atomic<size_t> background_writes_;
+  std::atomic<size_t> background_write_calls_;
+  std::atomic<size_t> checkpoint_writes_;
 };
 
 }  // namespace dbtrain
@@ -0,0 +1,47 @@
+#include "clock_replacer.h"
+
+namespace dbtrain {
+
+ClockReplacer::ClockReplacer(size_t capacity)
+    : present_(capacity, false), referenced_(capacity, false), hand_(0), size_(0) {}
+
+void ClockReplacer::Access(int frame_no) { referenced_[frame_no] = true; }
+
+void ClockReplacer::SetEvictable(int frame_no, bool evictable) {
+  if (present_[frame_no] == evictable) return;
+  present_[frame_no] = evictable;
+  if (evictable) {
+    size_++;
+  } else {
+    size_--;
+  }
+}
+
+bool ClockReplacer::Victim(int *frame_no) {
+  if (size_ == 0) return false;
+  while (true) {
+    if (present_[hand_]) {
+      if (referenced_[hand_]) {
+        referenced_[hand_] = false;
+      } else {
+        *frame_no = hand_;
+        present_[hand_] = false;
+        size_--;
+        hand_ = (hand_ + 1) % present_.size();
+        return true;
+      }
+    }
+    hand_ = (hand_ + 1) % present_.size();
+  }
+}
+
+void ClockReplacer::Remove(int frame_no) {
+  referenced_[frame_no] = false;
+  if (!present_[frame_no]) return;
+  present_[frame_no] = false;
+  size_--;
+}
+
+size_t ClockReplacer::Size() const { return size_; }
+
+}  // namespace dbtrain
@@ -0,0 +1,31 @@
+#ifndef DBTRAIN_CLOCK_REPLACER_H
+#define DBTRAIN_CLOCK_REPLACER_H
+
+#include "replacer.h"
+
+namespace dbtrain {
+
+// CLOCK 近似 LRU：访问时仅设置引用位，替换时时钟指针跳过并清除引用位为 1 的帧
+// 指针最多转两圈即可找到候选帧，均摊 O(1)
+// present_ 表示帧可替换，被 pin 的帧保留引用位但不参与替换
+class ClockReplacer : public Replacer {
+ public:
+  ClockReplacer(size_t capacity);
+  ~ClockReplacer() = default;
+
+  void Access(int frame_no) override;
+  void SetEvictable(int frame_no, bool evictable) override;
+  bool Victim(int *frame_no) override;
+  void Remove(int frame_no) override;
+  size_t Size() const override;
+
+ private:
+  vector<bool> present_;
+  vector<bool> referenced_;
+  size_t hand_;
+  size_t size_;
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_CLOCK_REPLACER_H
@@ -1,18 +1,62 @@
 #include "disk_manager.h"
 
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <set>
 
 #include "../defines.h"
 #include "../exception/exceptions.h"
 #include "../storage/buffer_manager.h"
+#include "../system/config_manager.h"
+#include "../utils/crc32c.h"
+#include "../utils/lz4.h"
 
 namespace dbtrain {
 
-DiskManager::DiskManager() {
+// 双写文件一批最多容纳的页面数
+static const size_t DOUBLE_WRITE_PAGES = 64;
+// 双写文件头部：校验值、页面数、头部页数，之后为各页面的页号、文件名长度与文件名
+static const size_t DOUBLE_WRITE_HEADER_SIZE = 3 * sizeof(uint32_t);
+// 校验工具每次读入的页面数
+static const size_t VERIFY_BATCH_PAGES = 64;
+
+struct AlignedFree {
+  void operator()(Byte *data) const { free(data); }
+};
+
+// 数据文件可能以 O_DIRECT 打开，直接读写文件的缓冲需按页对齐
+static std::unique_ptr<Byte, AlignedFree> AllocAligned(size_t size) {
+  Byte *data = (Byte *)aligned_alloc(PAGE_SIZE, size);
+  if (data == nullptr) {
+    std::cerr << "Error in DiskManager: aligned_alloc failed\n";
+    throw UnknownError();
+  }
+  return std::unique_ptr<Byte, AlignedFree>(data);
+}
+
+DiskManager::DiskManager()
+    : compressed_files_(0),
+      double_write_fd_(-1),
+      double_write_pages_(0),
+      double_write_batches_(0),
+      checksum_failures_(0),
+      repaired_pages_(0),
+      compressed_writes_(0),
+      compressed_reads_(0),
+      compressed_bytes_written_(0),
+      compressed_bytes_read_(0),
+      compress_ns_(0),
+      decompress_ns_(0) {
+  io_backend_ = IoBackend::Create(ConfigManager::GetInstance().GetString("io-backend", "posix"));
+  direct_io_ = ConfigManager::GetInstance().GetBool("direct-io", false);
+  double_write_ = ConfigManager::GetInstance().GetBool("double-write", false);
   if (!DirectoryExists(BASE_PATH)) {
     CreateDirectory(BASE_PATH);
   }
@@ -66,6 +110,43 @@ void DiskManager::ListTables(const std::string &path, std::vector<std::string> &
   }
 }
 
+void DiskManager::ListIndexes(const std::string &path, std::vector<std::string> &files) {
+  DIR *dir;
+  struct dirent *ent;
+  if (!DirectoryExists(path)) {
+    throw FileNotExistsError(path);
+  } else if ((dir = opendir(path.c_str())) != nullptr) {
+    while ((ent = readdir(dir)) != nullptr) {
+      if (ent->d_type == DT_REG && Endswith(ent->d_name, DB_INDEX_SUFFIX)) {
+        std::string filename = ent->d_name;
+        files.push_back(filename.substr(0, filename.size() - DB_INDEX_SUFFIX.size()));
+      }
+    }
+    closedir(dir);
+  } else {
+    std::cerr << "Error in DiskManager::ListIndexes\n";
+    throw UnknownError();
+  }
+}
+
+void DiskManager::ListFiles(const std::string &path, const std::string &prefix, std::vector<std::string> &files) {
+  DIR *dir;
+  struct dirent *ent;
+  if (!DirectoryExists(path)) {
+    throw FileNotExistsError(path);
+  } else if ((dir = opendir(path.c_str())) != nullptr) {
+    while ((ent = readdir(dir)) != nullptr) {
+      if (ent->d_type == DT_REG && strncmp(ent->d_name, prefix.c_str(), prefix.size()) == 0) {
+        files.push_back(ent->d_name);
+      }
+    }
+    closedir(dir);
+  } else {
+    std::cerr << "Error in DiskManager::ListFiles\n";
+    throw UnknownError();
+  }
+}
+
 void DiskManager::CreateDirectory(const std::string &path) {
   if (DirectoryExists(path)) {
     throw FileExistsError(path);
@@ -113,17 +194,61 @@ void DiskManager::CreateFile(const std::string &path) {
   }
 }
 
+void DiskManager::CreateFile(const std::string &path, bool compressed) {
+  if (FileExists(path)) {
+    throw FileExistsError(path);
+  }
+  // 先处理页面映射文件，上次创建到一半遗留的映射文件不能沿用
+  std::string map_path = GetPageMapPath(path);
+  if (compressed) {
+    int fd = open(map_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR);
+    if (fd < 0 || close(fd) != 0) {
+      std::cerr << "Error in DiskManager::CreateFile: page map\n";
+      throw UnknownError();
+    }
+  } else if (FileExists(map_path) && unlink(map_path.c_str()) != 0) {
+    std::cerr << "Error in DiskManager::CreateFile: unlink page map\n";
+    throw UnknownError();
+  }
+  CreateFile(path);
+}
+
 void DiskManager::DeleteFile(const std::string &path) {
   if (!FileExists(path)) {
     throw FileNotExistsError(path);
   }
+  std::unique_lock<std::mutex> file_lock(file_mutex_);
   if (path2fd_.count(path)) {
     throw FileNotClosedError(path);
   }
+  file_lock.unlock();
   if (unlink(path.c_str()) != 0) {
     std::cerr << "Error in DiskManager::DeleteFile\n";
     throw UnknownError();
   }
+  std::string map_path = GetPageMapPath(path);
+  if (!map_path.empty() && FileExists(map_path) && unlink(map_path.c_str()) != 0) {
+    std::cerr << "Error in DiskManager::DeleteFile: page map\n";
+    throw UnknownError();
+  }
+}
+
+void DiskManager::RenameFile(const std::string &path, const std::string &new_path) {
+  if (!FileExists(path)) {
+    throw FileNotExistsError(path);
+  }
+  std::unique_lock<std::mutex> file_lock(file_mutex_);
+  if (path2fd_.count(path)) {
+    throw FileNotClosedError(path);
+  }
+  file_lock.unlock();
+  if (FileExists(new_path)) {
+    throw FileExistsError(new_path);
+  }
+  if (rename(path.c_str(), new_path.c_str()) != 0) {
+    std::cerr << "Error in DiskManager::RenameFile\n";
+    throw UnknownError();
+  }
 }
 
 size_t DiskManager::FileSize(const std::string &path) {
@@ -138,57 +263,597 @@ size_t DiskManager::FileSize(const std::string &path) {
   return st.st_size;
 }
 
+size_t DiskManager::FileSize(int fd) {
+  PageMap *page_map = GetPageMap(fd);
+  if (page_map != nullptr) return (size_t)page_map->GetPageCount() * PAGE_SIZE;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    std::cerr << "Error in DiskManager::FileSize\n";
+    throw UnknownError();
+  }
+  return st.st_size;
+}
+
 int DiskManager::OpenFile(const std::string &path) {
   if (!FileExists(path)) {
     throw FileNotExistsError(path);
   }
+  std::lock_guard<std::mutex> file_lock(file_mutex_);
   if (path2fd_.count(path)) {
     throw FileNotClosedError(path);
   }
-  int fd = open(path.c_str(), O_RDWR);
+  // 压缩存放的页面按扇区对齐，不能以 O_DIRECT 读写
+  std::string map_path = GetPageMapPath(path);
+  bool compressed = !map_path.empty() && FileExists(map_path);
+  int fd = -1;
+  if (direct_io_ && !compressed && Endswith(path, DB_DATA_SUFFIX)) {
+    fd = open(path.c_str(), O_RDWR | O_DIRECT);
+    if (fd < 0 && errno == EINVAL) {
+      // 文件系统不支持 O_DIRECT（如 tmpfs），之后全部使用普通 I/O
+      std::cerr << "DiskManager: O_DIRECT is not supported, falling back to buffered I/O\n";
+      direct_io_ = false;
+    }
+  }
+  if (fd < 0) fd = open(path.c_str(), O_RDWR);
   if (fd < 0) {
     std::cerr << "Error in DiskManager::OpenFile\n";
     throw UnknownError();
   }
+  if (compressed) {
+    int map_fd = open(map_path.c_str(), O_RDWR);
+    struct stat st;
+    if (map_fd < 0 || fstat(map_fd, &st) != 0) {
+      std::cerr << "Error in DiskManager::OpenFile: page map\n";
+      throw UnknownError();
+    }
+    // 扩展映射文件时可能只写入了部分映射项，不完整的项丢弃
+    std::vector<PageMapEntry> entries(st.st_size / sizeof(PageMapEntry));
+    size_t size = entries.size() * sizeof(PageMapEntry);
+    if (size > 0 && io_backend_->Read(map_fd, (Byte *)entries.data(), size, 0) != (ssize_t)size) {
+      std::cerr << "Error in DiskManager::OpenFile: read page map\n";
+      throw UnknownError();
+    }
+    page_maps_[fd] = std::unique_ptr<PageMap>(new PageMap(map_fd, std::move(entries)));
+    compressed_files_++;
+  }
   path2fd_[path] = fd;
   fd2path_[fd] = path;
   return fd;
 }
 
 void DiskManager::CloseFile(int fd) {
-  if (!fd2path_.count(fd)) {
-    throw FileNotOpenError(fd);
+  {
+    std::lock_guard<std::mutex> file_lock(file_mutex_);
+    if (!fd2path_.count(fd)) {
+      throw FileNotOpenError(fd);
+    }
   }
   BufferManager::GetInstance().FlushFile(fd);
-  path2fd_.erase(fd2path_[fd]);
-  fd2path_.erase(fd);
+  std::unique_ptr<PageMap> page_map;
+  {
+    std::lock_guard<std::mutex> file_lock(file_mutex_);
+    path2fd_.erase(fd2path_[fd]);
+    fd2path_.erase(fd);
+    auto iter = page_maps_.find(fd);
+    if (iter != page_maps_.end()) {
+      page_map = std::move(iter->second);
+      page_maps_.erase(iter);
+      compressed_files_--;
+    }
+  }
+  if (page_map != nullptr && close(page_map->GetFd()) != 0) {
+    std::cerr << "Error in DiskManager::CloseFile: page map\n";
+    throw UnknownError();
+  }
   if (close(fd) != 0) {
     std::cerr << "Error in DiskManager::CloseFile\n";
     throw UnknownError();
   }
 }
 
+// 所有读写均通过 io_backend_ 以定位读写完成，不依赖共享的文件偏移
 void DiskManager::ReadPage(int fd, int page_id, Byte *page_data) {
-  lseek(fd, page_id * PAGE_SIZE, SEEK_SET);
-  ssize_t bytes_read = read(fd, page_data, PAGE_SIZE);
+  if (GetPageMap(fd) != nullptr) {
+    std::vector<PageRun> runs = {{fd, (PageID)page_id, {page_data}, 0}};
+    std::vector<bool> corrupted = ReadCompressedRuns(runs);
+    if (runs[0].done == 1) return;
+    if (corrupted[0]) {
+      checksum_failures_++;
+      throw PageCorruptedError(GetPath(fd), page_id);
+    }
+    std::cerr << "Error in DiskManager::ReadPage\n";
+    throw UnknownError();
+  }
+  ssize_t bytes_read = io_backend_->Read(fd, page_data, PAGE_SIZE, (off_t)page_id * PAGE_SIZE);
   if (bytes_read != PAGE_SIZE) {
     std::cerr << "Error in DiskManager::ReadPage\n";
     throw UnknownError();
   }
+  VerifyPage(fd, page_id, page_data);
+}
+
+void DiskManager::VerifyPage(int fd, PageID page_no, const Byte *page_data) {
+  if (VerifyPageChecksum(page_data, page_no)) return;
+  checksum_failures_++;
+  throw PageCorruptedError(GetPath(fd), page_no);
+}
+
+size_t DiskManager::ReadPages(int fd, int first_page_id, const std::vector<Byte *> &pages_data) {
+  std::vector<PageRun> runs = {{fd, (PageID)first_page_id, pages_data, 0}};
+  ReadPageRuns(runs);
+  return runs[0].done;
 }
 
-void DiskManager::WritePage(int fd, int page_id, const Byte *page_data) {
-  lseek(fd, page_id * PAGE_SIZE, SEEK_SET);
-  ssize_t bytes_write = write(fd, page_data, PAGE_SIZE);
-  if (bytes_write != PAGE_SIZE) {
+void DiskManager::WritePage(int fd, int page_id, Byte *page_data) {
+  std::vector<PageRun> runs = {{fd, (PageID)page_id, {page_data}, 0}};
+  WritePageRuns(runs);
+  if (runs[0].done != 1) {
     std::cerr << "Error in DiskManager::WritePage\n";
     throw UnknownError();
   }
 }
 
+void DiskManager::WritePages(int fd, int first_page_id, const std::vector<const Byte *> &pages_data) {
+  std::vector<PageRun> runs = {{fd, (PageID)first_page_id, {}, 0}};
+  for (const Byte *data : pages_data) runs[0].pages.push_back((Byte *)data);
+  WritePageRuns(runs);
+  if (runs[0].done != pages_data.size()) {
+    std::cerr << "Error in DiskManager::WritePages\n";
+    throw UnknownError();
+  }
+}
+
+void DiskManager::SubmitPageRuns(std::vector<PageRun> &runs, IoRequest::Op op) {
+  std::vector<std::vector<struct iovec>> iovs(runs.size());
+  std::vector<IoRequest> requests;
+  for (size_t i = 0; i < runs.size(); i++) {
+    for (Byte *data : runs[i].pages) iovs[i].push_back({data, (size_t)PAGE_SIZE});
+    requests.push_back({op, runs[i].fd, (off_t)runs[i].first_page * PAGE_SIZE, iovs[i].data(), (int)iovs[i].size(), 0});
+  }
+  io_backend_->Submit(requests);
+  for (size_t i = 0; i < runs.size(); i++) {
+    runs[i].done = requests[i].result < 0 ? 0 : requests[i].result / PAGE_SIZE;
+  }
+}
+
+// 把压缩存放的文件的页面段从 runs 中分出，compressed 标记各段所属的文件是否压缩存放
+static std::vector<PageRun> SplitCompressedRuns(std::vector<PageRun> &runs, const std::vector<bool> &compressed) {
+  std::vector<PageRun> compressed_runs;
+  std::vector<PageRun> plain_runs;
+  for (size_t i = 0; i < runs.size(); i++) {
+    if (compressed[i]) {
+      compressed_runs.push_back(std::move(runs[i]));
+    } else {
+      plain_runs.push_back(std::move(runs[i]));
+    }
+  }
+  runs = std::move(plain_runs);
+  return compressed_runs;
+}
+
+// SplitCompressedRuns 的逆操作，恢复各段原来的顺序
+static void MergeCompressedRuns(std::vector<PageRun> &runs, std::vector<PageRun> &compressed_runs,
+                                const std::vector<bool> &compressed) {
+  std::vector<PageRun> merged;
+  size_t plain_next = 0;
+  size_t compressed_next = 0;
+  for (bool is_compressed : compressed) {
+    merged.push_back(std::move(is_compressed ? compressed_runs[compressed_next++] : runs[plain_next++]));
+  }
+  runs = std::move(merged);
+}
+
+void DiskManager::ReadPageRuns(std::vector<PageRun> &runs) {
+  std::vector<bool> compressed(runs.size());
+  bool any_compressed = false;
+  for (size_t i = 0; i < runs.size(); i++) {
+    compressed[i] = GetPageMap(runs[i].fd) != nullptr;
+    any_compressed = any_compressed || compressed[i];
+  }
+  if (any_compressed) {
+    std::vector<PageRun> compressed_runs = SplitCompressedRuns(runs, compressed);
+    ReadCompressedRuns(compressed_runs);
+    if (!runs.empty()) ReadPageRuns(runs);
+    MergeCompressedRuns(runs, compressed_runs, compressed);
+    return;
+  }
+  SubmitPageRuns(runs, IoRequest::Op::READ);
+  // 未通过校验的页面及其之后的页面视为未读入，访问时由 ReadPage 重新读取并报错
+  for (auto &run : runs) {
+    for (size_t i = 0; i < run.done; i++) {
+      if (!VerifyPageChecksum(run.pages[i], run.first_page + i)) {
+        run.done = i;
+        break;
+      }
+    }
+  }
+}
+
+void DiskManager::WritePageRuns(std::vector<PageRun> &runs) {
+  std::vector<bool> compressed(runs.size());
+  bool any_compressed = false;
+  for (size_t i = 0; i < runs.size(); i++) {
+    compressed[i] = GetPageMap(runs[i].fd) != nullptr;
+    any_compressed = any_compressed || compressed[i];
+  }
+  if (any_compressed) {
+    std::vector<PageRun> compressed_runs = SplitCompressedRuns(runs, compressed);
+    WriteCompressedRuns(compressed_runs);
+    if (!runs.empty()) WritePageRuns(runs);
+    MergeCompressedRuns(runs, compressed_runs, compressed);
+    return;
+  }
+  for (auto &run : runs) {
+    for (size_t i = 0; i < run.pages.size(); i++) SetPageChecksum(run.pages[i], run.first_page + i);
+  }
+  std::unique_lock<std::mutex> double_write_lock(double_write_mutex_, std::defer_lock);
+  if (double_write_) double_write_lock.lock();
+  if (double_write_fd_ < 0) {
+    SubmitPageRuns(runs, IoRequest::Op::WRITE);
+    return;
+  }
+  // 双写：一批页面先写入双写文件并落盘，再写入原位置并落盘，之后双写文件才能被下一批覆盖
+  // 每批不超过双写文件的容量，较长的连续页面会被拆到多批中
+  for (auto &run : runs) run.done = 0;
+  std::vector<bool> failed(runs.size(), false);
+  size_t run_no = 0;
+  size_t offset = 0;
+  while (run_no < runs.size()) {
+    std::vector<PageRun> batch;
+    std::vector<size_t> origins;
+    size_t pages = 0;
+    while (run_no < runs.size() && pages < DOUBLE_WRITE_PAGES) {
+      const PageRun &run = runs[run_no];
+      size_t count = std::min(run.pages.size() - offset, DOUBLE_WRITE_PAGES - pages);
+      if (count > 0) {
+        std::vector<Byte *> run_pages(run.pages.begin() + offset, run.pages.begin() + offset + count);
+        batch.push_back({run.fd, run.first_page + (PageID)offset, std::move(run_pages), 0});
+        origins.push_back(run_no);
+      }
+      pages += count;
+      offset += count;
+      if (offset == run.pages.size()) {
+        run_no++;
+        offset = 0;
+      }
+    }
+    if (batch.empty()) continue;
+    WriteDoubleWrite(batch);
+    SubmitPageRuns(batch, IoRequest::Op::WRITE);
+    std::set<int> fds;
+    for (const auto &part : batch) fds.insert(part.fd);
+    for (int fd : fds) FlushFileData(fd);
+    for (size_t i = 0; i < batch.size(); i++) {
+      if (failed[origins[i]]) continue;
+      runs[origins[i]].done += batch[i].done;
+      if (batch[i].done != batch[i].pages.size()) failed[origins[i]] = true;
+    }
+  }
+}
+
+static size_t ElapsedNs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<bool> DiskManager::ReadCompressedRuns(std::vector<PageRun> &runs) {
+  // 未压缩的镜像直接读入页面，压缩的镜像读入 images 后解压
+  std::vector<std::vector<std::vector<Byte>>> images(runs.size());
+  std::vector<std::vector<PageMapEntry>> entries(runs.size());
+  std::vector<std::vector<size_t>> request_no(runs.size());
+  std::vector<struct iovec> iovs;
+  std::vector<IoRequest> requests;
+  size_t request_count = 0;
+  for (size_t i = 0; i < runs.size(); i++) {
+    PageMap *page_map = GetPageMap(runs[i].fd);
+    images[i].resize(runs[i].pages.size());
+    for (size_t j = 0; j < runs[i].pages.size(); j++) {
+      PageMapEntry entry;
+      // 超出文件的页面及其之后的页面不读入
+      if (!page_map->Get(runs[i].first_page + j, entry)) break;
+      entries[i].push_back(entry);
+      request_no[i].push_back(request_count);
+      if (entry.length != 0) request_count++;
+    }
+  }
+  iovs.reserve(request_count);
+  for (size_t i = 0; i < runs.size(); i++) {
+    for (size_t j = 0; j < entries[i].size(); j++) {
+      const PageMapEntry &entry = entries[i][j];
+      if (entry.length == 0) continue;
+      Byte *dst = runs[i].pages[j];
+      size_t size = PageMap::Sectors(entry.length) * COMPRESSED_SECTOR_SIZE;
+      if (entry.length < PAGE_SIZE) {
+        images[i][j].resize(size);
+        dst = images[i][j].data();
+      }
+      iovs.push_back({dst, size});
+      off_t offset = (off_t)((size_t)entry.sector * COMPRESSED_SECTOR_SIZE);
+      requests.push_back({IoRequest::Op::READ, runs[i].fd, offset, &iovs.back(), 1, 0});
+    }
+  }
+  io_backend_->Submit(requests);
+  std::vector<bool> corrupted(runs.size(), false);
+  size_t pages_read = 0;
+  size_t bytes_read = 0;
+  for (size_t i = 0; i < runs.size(); i++) {
+    PageRun &run = runs[i];
+    run.done = 0;
+    for (size_t j = 0; j < entries[i].size(); j++) {
+      const PageMapEntry &entry = entries[i][j];
+      Byte *page_data = run.pages[j];
+      if (entry.length == 0) {
+        // 从未写入的页面读为全零的空页面
+        memset(page_data, 0, PAGE_SIZE);
+      } else {
+        const IoRequest &request = requests[request_no[i][j]];
+        if (request.result != (ssize_t)request.iov[0].iov_len) break;
+        bytes_read += request.result;
+        if (entry.length < PAGE_SIZE) {
+          auto start = std::chrono::steady_clock::now();
+          bool ok = Lz4Decompress(images[i][j].data(), entry.length, page_data, PAGE_SIZE);
+          decompress_ns_ += ElapsedNs(start);
+          if (!ok) {
+            corrupted[i] = true;
+            break;
+          }
+        }
+        pages_read++;
+      }
+      if (!VerifyPageChecksum(page_data, run.first_page + j)) {
+        corrupted[i] = true;
+        break;
+      }
+      run.done++;
+    }
+  }
+  compressed_reads_ += pages_read;
+  compressed_bytes_read_ += bytes_read;
+  return corrupted;
+}
+
+void DiskManager::WriteCompressedRuns(std::vector<PageRun> &runs) {
+  // 压缩后至少节省一个扇区时才压缩存放，否则存放原页面
+  static const size_t COMPRESSED_CAPACITY = PAGE_SIZE - COMPRESSED_SECTOR_SIZE;
+  std::vector<std::vector<std::vector<Byte>>> images(runs.size());
+  std::vector<std::vector<PageMapEntry>> entries(runs.size());
+  std::vector<struct iovec> iovs;
+  std::vector<IoRequest> requests;
+  size_t page_count = 0;
+  for (const auto &run : runs) page_count += run.pages.size();
+  iovs.reserve(page_count);
+  for (size_t i = 0; i < runs.size(); i++) {
+    PageRun &run = runs[i];
+    PageMap *page_map = GetPageMap(run.fd);
+    images[i].resize(run.pages.size());
+    for (size_t j = 0; j < run.pages.size(); j++) {
+      SetPageChecksum(run.pages[j], run.first_page + j);
+      std::vector<Byte> &image = images[i][j];
+      image.assign(COMPRESSED_CAPACITY, 0);
+      auto start = std::chrono::steady_clock::now();
+      size_t length = Lz4Compress(run.pages[j], PAGE_SIZE, image.data(), COMPRESSED_CAPACITY);
+      compress_ns_ += ElapsedNs(start);
+      const Byte *data = image.data();
+      if (length == 0) {
+        length = PAGE_SIZE;
+        data = run.pages[j];
+      }
+      PageMapEntry entry = page_map->Alloc(length);
+      entries[i].push_back(entry);
+      iovs.push_back({(void *)data, PageMap::Sectors(length) * COMPRESSED_SECTOR_SIZE});
+      off_t offset = (off_t)((size_t)entry.sector * COMPRESSED_SECTOR_SIZE);
+      requests.push_back({IoRequest::Op::WRITE, run.fd, offset, &iovs.back(), 1, 0});
+    }
+  }
+  io_backend_->Submit(requests);
+  // 写入失败的页面及其之后的页面不修改映射，归还分配的扇区
+  size_t request_no = 0;
+  size_t bytes_written = 0;
+  std::set<int> fds;
+  for (size_t i = 0; i < runs.size(); i++) {
+    PageRun &run = runs[i];
+    PageMap *page_map = GetPageMap(run.fd);
+    run.done = 0;
+    bool failed = false;
+    for (size_t j = 0; j < run.pages.size(); j++, request_no++) {
+      const IoRequest &request = requests[request_no];
+      failed = failed || request.result != (ssize_t)request.iov[0].iov_len;
+      if (failed) {
+        page_map->Free(entries[i][j]);
+      } else {
+        run.done++;
+        bytes_written += request.result;
+      }
+    }
+    if (run.done > 0) fds.insert(run.fd);
+  }
+  // 页面落盘后再写入映射项，映射项落盘后才释放旧镜像的扇区，与 double-write 参数无关：
+  // 否则映射项可能先于镜像落盘，或旧扇区在新映射项落盘前被其他页面重用，崩溃后映射文件中的旧项指向其他页面的镜像
+  for (int fd : fds) FlushFileData(fd);
+  std::vector<IoRequest> map_requests;
+  std::vector<struct iovec> map_iovs;
+  map_iovs.reserve(runs.size());
+  for (size_t i = 0; i < runs.size(); i++) {
+    if (runs[i].done == 0) continue;
+    map_iovs.push_back({entries[i].data(), runs[i].done * sizeof(PageMapEntry)});
+    map_requests.push_back({IoRequest::Op::WRITE, GetPageMap(runs[i].fd)->GetFd(),
+                            (off_t)runs[i].first_page * (off_t)sizeof(PageMapEntry), &map_iovs.back(), 1, 0});
+  }
+  io_backend_->Submit(map_requests);
+  for (const auto &request : map_requests) {
+    if (request.result != (ssize_t)request.iov[0].iov_len) {
+      std::cerr << "Error in DiskManager::WriteCompressedRuns\n";
+      throw UnknownError();
+    }
+  }
+  for (int fd : fds) FlushFileData(GetPageMap(fd)->GetFd());
+  size_t pages_written = 0;
+  for (size_t i = 0; i < runs.size(); i++) {
+    PageMap *page_map = GetPageMap(runs[i].fd);
+    for (size_t j = 0; j < runs[i].done; j++) page_map->Replace(runs[i].first_page + j, entries[i][j]);
+    pages_written += runs[i].done;
+  }
+  compressed_writes_ += pages_written;
+  compressed_bytes_written_ += bytes_written;
+}
+
+void DiskManager::WriteDoubleWrite(const std::vector<PageRun> &runs) {
+  std::vector<Byte> header(DOUBLE_WRITE_HEADER_SIZE);
+  uint32_t count = 0;
+  for (const auto &run : runs) {
+    std::string path = GetPath(run.fd);
+    uint16_t path_length = path.size();
+    for (size_t i = 0; i < run.pages.size(); i++) {
+      PageID page_no = run.first_page + i;
+      const Byte *entry = (const Byte *)&page_no;
+      header.insert(header.end(), entry, entry + sizeof(page_no));
+      entry = (const Byte *)&path_length;
+      header.insert(header.end(), entry, entry + sizeof(path_length));
+      header.insert(header.end(), path.begin(), path.end());
+      count++;
+    }
+  }
+  uint32_t header_pages = (header.size() + PAGE_SIZE - 1) / PAGE_SIZE;
+  header.resize((size_t)header_pages * PAGE_SIZE);
+  memcpy(header.data() + sizeof(uint32_t), &count, sizeof(count));
+  memcpy(header.data() + 2 * sizeof(uint32_t), &header_pages, sizeof(header_pages));
+  uint32_t checksum = Crc32c(header.data() + sizeof(uint32_t), header.size() - sizeof(uint32_t));
+  memcpy(header.data(), &checksum, sizeof(checksum));
+
+  std::vector<struct iovec> iovs = {{header.data(), header.size()}};
+  for (const auto &run : runs) {
+    for (Byte *data : run.pages) iovs.push_back({data, (size_t)PAGE_SIZE});
+  }
+  std::vector<IoRequest> requests = {
+      {IoRequest::Op::WRITE, double_write_fd_, 0, iovs.data(), (int)iovs.size(), 0}};
+  io_backend_->Submit(requests);
+  if (requests[0].result != (ssize_t)(header.size() + (size_t)count * PAGE_SIZE)) {
+    std::cerr << "Error in DiskManager::WriteDoubleWrite\n";
+    throw UnknownError();
+  }
+  FlushFileData(double_write_fd_);
+  double_write_pages_ += count;
+  double_write_batches_++;
+}
+
+void DiskManager::OpenDoubleWrite() {
+  // 上次关闭前可能有未完成的原地写入，无论 double-write 是否打开都先尝试修复
+  if (FileExists(DOUBLE_WRITE_FILE)) {
+    size_t repaired = RestoreDoubleWrite();
+    repaired_pages_ += repaired;
+    if (repaired > 0) std::cerr << "DiskManager: repaired " << repaired << " torn pages from double write file\n";
+  }
+  if (!double_write_) return;
+  if (!FileExists(DOUBLE_WRITE_FILE)) CreateFile(DOUBLE_WRITE_FILE);
+  int fd = OpenFile(DOUBLE_WRITE_FILE);
+  std::lock_guard<std::mutex> double_write_lock(double_write_mutex_);
+  double_write_fd_ = fd;
+}
+
+void DiskManager::CloseDoubleWrite() {
+  if (!double_write_) return;
+  int fd = -1;
+  {
+    // 正在进行的一批写入完成后才关闭，关闭文件时会写回缓冲池，不能持有 double_write_mutex_
+    std::lock_guard<std::mutex> double_write_lock(double_write_mutex_);
+    fd = double_write_fd_;
+    double_write_fd_ = -1;
+  }
+  if (fd >= 0) CloseFile(fd);
+}
+
+size_t DiskManager::RestoreDoubleWrite() {
+  int fd = OpenFile(DOUBLE_WRITE_FILE);
+  size_t file_size = FileSize(fd);
+  std::vector<Byte> header(DOUBLE_WRITE_HEADER_SIZE);
+  uint32_t count = 0;
+  uint32_t header_pages = 0;
+  if (file_size >= PAGE_SIZE) {
+    ReadRaw(fd, header.data(), header.size(), 0);
+    memcpy(&count, header.data() + sizeof(uint32_t), sizeof(count));
+    memcpy(&header_pages, header.data() + 2 * sizeof(uint32_t), sizeof(header_pages));
+  }
+  // 头部不完整时双写文件本身没有写完，原位置的页面尚未开始写入
+  bool valid = header_pages > 0 && ((size_t)header_pages + count) * PAGE_SIZE <= file_size;
+  if (valid) {
+    header.resize((size_t)header_pages * PAGE_SIZE);
+    ReadRaw(fd, header.data(), header.size(), 0);
+    uint32_t checksum;
+    memcpy(&checksum, header.data(), sizeof(checksum));
+    valid = checksum == Crc32c(header.data() + sizeof(uint32_t), header.size() - sizeof(uint32_t));
+  }
+  size_t repaired = 0;
+  size_t pos = DOUBLE_WRITE_HEADER_SIZE;
+  auto image = AllocAligned(PAGE_SIZE);
+  auto page = AllocAligned(PAGE_SIZE);
+  for (uint32_t i = 0; valid && i < count; i++) {
+    PageID page_no;
+    uint16_t path_length;
+    if (pos + sizeof(page_no) + sizeof(path_length) > header.size()) break;
+    memcpy(&page_no, header.data() + pos, sizeof(page_no));
+    pos += sizeof(page_no);
+    memcpy(&path_length, header.data() + pos, sizeof(path_length));
+    pos += sizeof(path_length);
+    if (pos + path_length > header.size()) break;
+    std::string path((const char *)header.data() + pos, path_length);
+    pos += path_length;
+    // 表已被删除，或副本本身未通过校验
+    if (!FileExists(path)) continue;
+    ReadRaw(fd, image.get(), PAGE_SIZE, ((size_t)header_pages + i) * PAGE_SIZE);
+    if (!VerifyPageChecksum(image.get(), page_no)) continue;
+    int page_fd = OpenFile(path);
+    bool torn = FileSize(page_fd) < ((size_t)page_no + 1) * PAGE_SIZE;
+    if (!torn) {
+      ReadRaw(page_fd, page.get(), PAGE_SIZE, (size_t)page_no * PAGE_SIZE);
+      torn = !VerifyPageChecksum(page.get(), page_no);
+    }
+    if (torn) {
+      WriteRaw(page_fd, image.get(), PAGE_SIZE, (size_t)page_no * PAGE_SIZE);
+      FlushFile(page_fd);
+      repaired++;
+    }
+    CloseFile(page_fd);
+  }
+  // 修复完成后清空双写文件，避免之后再用旧副本覆盖页面
+  TruncateFile(fd, 0);
+  FlushFile(fd);
+  CloseFile(fd);
+  return repaired;
+}
+
+std::vector<PageID> DiskManager::VerifyFile(const std::string &path, PageID &page_count) {
+  std::vector<PageID> corrupted;
+  int fd = OpenFile(path);
+  page_count = FileSize(fd) / PAGE_SIZE;
+  auto data = AllocAligned(VERIFY_BATCH_PAGES * PAGE_SIZE);
+  bool compressed = GetPageMap(fd) != nullptr;
+  try {
+    for (PageID first = 0; first < page_count; first += VERIFY_BATCH_PAGES) {
+      size_t count = std::min<size_t>(VERIFY_BATCH_PAGES, page_count - first);
+      if (compressed) {
+        // 每个页面单独成段，一个页面失败不影响其余页面
+        std::vector<PageRun> runs;
+        for (size_t i = 0; i < count; i++) runs.push_back({fd, first + (PageID)i, {data.get() + i * PAGE_SIZE}, 0});
+        ReadCompressedRuns(runs);
+        for (size_t i = 0; i < count; i++) {
+          if (runs[i].done != 1) corrupted.push_back(first + i);
+        }
+        continue;
+      }
+      ReadRaw(fd, data.get(), count * PAGE_SIZE, (size_t)first * PAGE_SIZE);
+      for (size_t i = 0; i < count; i++) {
+        if (!VerifyPageChecksum(data.get() + i * PAGE_SIZE, first + i)) corrupted.push_back(first + i);
+      }
+    }
+  } catch (DbError &e) {
+    CloseFile(fd);
+    throw;
+  }
+  CloseFile(fd);
+  return corrupted;
+}
+
 void DiskManager::ReadRaw(int fd, Byte *data, size_t size) {
-  lseek(fd, 0, SEEK_SET);
-  ssize_t bytes_read = read(fd, data, size);
+  ssize_t bytes_read = io_backend_->Read(fd, data, size, 0);
   if (bytes_read != size) {
     std::cerr << "Error in DiskManager::ReadRaw 1\n";
     throw UnknownError();
@@ -196,50 +861,167 @@ void DiskManager::ReadRaw(int fd, Byte *data, size_t size) {
 }
 
 void DiskManager::ReadRaw(int fd, Byte *data, size_t size, size_t offset) {
-  lseek(fd, offset, SEEK_SET);
-  ssize_t bytes_read = read(fd, data, size);
+  ssize_t bytes_read = io_backend_->Read(fd, data, size, offset);
   if (bytes_read != size) {
     std::cerr << "Error in DiskManager::ReadRaw 2\n";
     throw UnknownError();
   }
 }
 
-void DiskManager::AppendRaw(int fd, const Byte *data, size_t size) {
-  lseek(fd, 0, SEEK_END);
-  ssize_t bytes_write = write(fd, data, size);
-  if (bytes_write != size) {
-    std::cerr << "Error in DiskManager::AppendRaw\n";
-    throw UnknownError();
+void DiskManager::AppendRaw(int fd, const Byte *data, size_t size) { AppendRaw({{fd, data, size}}); }
+
+void DiskManager::AppendRaw(const std::vector<RawWrite> &writes) {
+  std::vector<struct iovec> iovs(writes.size());
+  std::vector<IoRequest> requests;
+  for (size_t i = 0; i < writes.size(); i++) {
+    iovs[i] = {(void *)writes[i].data, writes[i].size};
+    requests.push_back({IoRequest::Op::WRITE, writes[i].fd, (off_t)FileSize(writes[i].fd), &iovs[i], 1, 0});
+  }
+  io_backend_->Submit(requests);
+  for (size_t i = 0; i < writes.size(); i++) {
+    if (requests[i].result != (ssize_t)writes[i].size) {
+      std::cerr << "Error in DiskManager::AppendRaw\n";
+      throw UnknownError();
+    }
   }
 }
 
 void DiskManager::WriteRaw(int fd, const Byte *data, size_t size) {
-  lseek(fd, 0, SEEK_SET);
-  ssize_t bytes_write = write(fd, data, size);
+  ssize_t bytes_write = io_backend_->Write(fd, data, size, 0);
   if (bytes_write != size) {
     std::cerr << "Error in DiskManager::WriteRaw\n";
     throw UnknownError();
   }
 }
 
-size_t DiskManager::ReadIndex(int fd, size_t idx) {
-  lseek(fd, idx * sizeof(size_t), SEEK_SET);
-  size_t idx_val = 0;
-  ssize_t bytes_write = read(fd, &idx_val, sizeof(size_t));
-  if (bytes_write != sizeof(size_t)) {
-    std::cerr << "Error in DiskManager::ReadIndex\n";
+void DiskManager::WriteRaw(int fd, const Byte *data, size_t size, size_t offset) {
+  ssize_t bytes_write = io_backend_->Write(fd, data, size, offset);
+  if (bytes_write != size) {
+    std::cerr << "Error in DiskManager::WriteRaw 2\n";
     throw UnknownError();
   }
-  return idx_val;
 }
 
-void DiskManager::FlushFile(int fd) {
-  if (fsync(fd) != 0) {
-    std::cerr << "Error in DiskManager::FlushFile\n";
+void DiskManager::TruncateFile(int fd, size_t size) {
+  PageMap *page_map = GetPageMap(fd);
+  if (page_map != nullptr) {
+    // 只修改映射，截去页面的扇区留在文件中供之后的页面使用
+    PageID page_count = size / PAGE_SIZE;
+    if (ftruncate(page_map->GetFd(), (size_t)page_count * sizeof(PageMapEntry)) != 0) {
+      std::cerr << "Error in DiskManager::TruncateFile: page map\n";
+      throw UnknownError();
+    }
+    page_map->Resize(page_count);
+    return;
+  }
+  if (ftruncate(fd, size) != 0) {
+    std::cerr << "Error in DiskManager::TruncateFile\n";
     throw UnknownError();
   }
 }
 
+bool DiskManager::AllocateFile(int fd, size_t size) { return posix_fallocate(fd, 0, size) == 0; }
+
+void DiskManager::FlushFile(int fd) { FlushFiles({fd}); }
+
+void DiskManager::FlushDirectory(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0 || fsync(fd) != 0) {
+    std::cerr << "Error in DiskManager::FlushDirectory\n";
+    if (fd >= 0) close(fd);
+    throw UnknownError();
+  }
+  close(fd);
+}
+
+void DiskManager::FlushFileData(int fd) {
+  std::vector<IoRequest> requests = {{IoRequest::Op::FDATASYNC, fd, 0, nullptr, 0, 0}};
+  io_backend_->Submit(requests);
+  if (requests[0].result != 0) {
+    std::cerr << "Error in DiskManager::FlushFileData\n";
+    throw UnknownError();
+  }
+}
+
+void DiskManager::FlushFiles(const std::vector<int> &fds) {
+  std::vector<IoRequest> requests;
+  for (int fd : fds) requests.push_back({IoRequest::Op::FSYNC, fd, 0, nullptr, 0, 0});
+  io_backend_->Submit(requests);
+  for (const auto &request : requests) {
+    if (request.result != 0) {
+      std::cerr << "Error in DiskManager::FlushFile\n";
+      throw UnknownError();
+    }
+  }
+  // 页面映射在数据之后落盘，映射项不会指向未落盘的镜像
+  std::vector<int> map_fds;
+  for (int fd : fds) {
+    PageMap *page_map = GetPageMap(fd);
+    if (page_map != nullptr) map_fds.push_back(page_map->GetFd());
+  }
+  if (!map_fds.empty()) FlushFiles(map_fds);
+}
+
+string DiskManager::GetIoBackendName() const { return io_backend_->GetName(); }
+
+bool DiskManager::IsDirectIo() const { return direct_io_; }
+
+DiskStatus DiskManager::GetStatus() const {
+  DiskStatus status;
+  status.double_write = double_write_;
+  status.double_write_pages = double_write_pages_;
+  status.double_write_batches = double_write_batches_;
+  status.checksum_failures = checksum_failures_;
+  status.repaired_pages = repaired_pages_;
+  status.compressed_writes = compressed_writes_;
+  status.compressed_reads = compressed_reads_;
+  status.compressed_bytes_written = compressed_bytes_written_;
+  status.compressed_bytes_read = compressed_bytes_read_;
+  status.compress_ns = compress_ns_;
+  status.decompress_ns = decompress_ns_;
+  return status;
+}
+
+bool DiskManager::IsCompressed(int fd) { return GetPageMap(fd) != nullptr; }
+
+FileSpace DiskManager::GetFileSpace(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    std::cerr << "Error in DiskManager::GetFileSpace\n";
+    throw UnknownError();
+  }
+  FileSpace space = {false, (size_t)st.st_size, (size_t)st.st_blocks * 512};
+  PageMap *page_map = GetPageMap(fd);
+  if (page_map != nullptr) {
+    space.compressed = true;
+    space.stored_bytes = page_map->GetStoredBytes();
+    if (fstat(page_map->GetFd(), &st) != 0) {
+      std::cerr << "Error in DiskManager::GetFileSpace\n";
+      throw UnknownError();
+    }
+    space.disk_bytes += (size_t)st.st_blocks * 512;
+  }
+  return space;
+}
+
+PageMap *DiskManager::GetPageMap(int fd) {
+  if (compressed_files_ == 0) return nullptr;
+  std::lock_guard<std::mutex> file_lock(file_mutex_);
+  auto iter = page_maps_.find(fd);
+  return iter == page_maps_.end() ? nullptr : iter->second.get();
+}
+
+std::string DiskManager::GetPageMapPath(const std::string &path) {
+  if (!Endswith(path, DB_DATA_SUFFIX)) return "";
+  return path.substr(0, path.size() - DB_DATA_SUFFIX.size()) + DB_PAGE_MAP_SUFFIX;
+}
+
+std::string DiskManager::GetPath(int fd) {
+  std::lock_guard<std::mutex> file_lock(file_mutex_);
+  auto iter = fd2path_.find(fd);
+  return iter == fd2path_.end() ? "fd " + std::to_string(fd) : iter->second;
+}
+
 bool DiskManager::FileExists(const std::string &path) {
   struct stat buffer;
   return (stat(path.c_str(), &buffer) == 0 && S_ISREG(buffer.st_mode));
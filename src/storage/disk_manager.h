@@ -5,15 +5,62 @@
 #include <limits.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "../defines.h"
+#include "../storage/io_backend.h"
+#include "../storage/page_map.h"
 
 namespace dbtrain {
 
+// 一段页号连续的页面，done 为完整读写的页面数
+struct PageRun {
+  int fd;
+  PageID first_page;
+  std::vector<Byte *> pages;
+  size_t done;
+};
+
+struct RawWrite {
+  int fd;
+  const Byte *data;
+  size_t size;
+};
+
+// 页面校验与双写的运行状态，用于 SHOW BUFFER STATUS
+struct DiskStatus {
+  bool double_write;
+  // 经过双写文件写入的页面数与批次数，每批落盘两次
+  size_t double_write_pages;
+  size_t double_write_batches;
+  // 读入时未通过校验的页面数
+  size_t checksum_failures;
+  // 打开数据库时用双写文件中的副本修复的页面数
+  size_t repaired_pages;
+  // 压缩存放的页面的读写次数、实际读写的字节数与压缩、解压耗时
+  size_t compressed_writes;
+  size_t compressed_reads;
+  size_t compressed_bytes_written;
+  size_t compressed_bytes_read;
+  size_t compress_ns;
+  size_t decompress_ns;
+};
+
+// 数据文件的空间占用，用于 SHOW TABLE STATUS
+struct FileSpace {
+  bool compressed;
+  // 页面镜像占用的字节数，未压缩存放时为文件大小
+  size_t stored_bytes;
+  // 文件在磁盘上实际分配的字节数，压缩存放时包括页面映射文件与空闲扇区
+  size_t disk_bytes;
+};
+
 class DiskManager {
   friend class BufferManager;
 
@@ -27,32 +74,115 @@ class DiskManager {
   void DeleteDirectory(const std::string &path);
   void ListDirectories(const std::string &path, std::vector<std::string> &dirs);
   void ListTables(const std::string &path, std::vector<std::string> &files);
+  void ListIndexes(const std::string &path, std::vector<std::string> &files);
+  bool DirectoryExists(const std::string &path);
+  // 列出目录下以 prefix 开头的普通文件
+  void ListFiles(const std::string &path, const std::string &prefix, std::vector<std::string> &files);
   void CreateFile(const std::string &path);
+  // 创建数据文件，compressed 为 true 时同时创建页面映射文件，之后该文件的页面经 LZ4 压缩后存放
+  // 压缩存放的文件按页号读写的接口不变，FileSize 与 TruncateFile 以页面映射中的页面数为文件大小
+  void CreateFile(const std::string &path, bool compressed);
+  // 删除数据文件时同时删除其页面映射文件
   void DeleteFile(const std::string &path);
+  // 文件需已关闭，目标文件已存在时报错
+  void RenameFile(const std::string &path, const std::string &new_path);
   size_t FileSize(const std::string &path);
+  size_t FileSize(int fd);
   int OpenFile(const std::string &path);
   void CloseFile(int fd);
 
   void ReadRaw(int fd, Byte *data, size_t size);
   void ReadRaw(int fd, Byte *data, size_t size, size_t offset);
   void AppendRaw(int fd, const Byte *data, size_t size);
+  // 多个文件的追加写作为一批提交
+  void AppendRaw(const std::vector<RawWrite> &writes);
   void WriteRaw(int fd, const Byte *data, size_t size);
+  void WriteRaw(int fd, const Byte *data, size_t size, size_t offset);
+  void TruncateFile(int fd, size_t size);
+  // 为文件预先分配 size 字节的空间，未分配部分读出为 0，文件系统不支持时返回 false
+  bool AllocateFile(int fd, size_t size);
   void FlushFile(int fd);
+  void FlushFiles(const std::vector<int> &fds);
+  // 只同步文件数据，用于写入范围在文件大小之内的情况
+  void FlushFileData(int fd);
+  // 同步目录项，使新建、重命名的文件在崩溃后仍然存在
+  void FlushDirectory(const std::string &path);
 
-  size_t ReadIndex(int fs, size_t idx);
+  string GetIoBackendName() const;
+  // 数据文件是否以 O_DIRECT 打开
+  bool IsDirectIo() const;
+  DiskStatus GetStatus() const;
+  bool IsCompressed(int fd);
+  FileSpace GetFileSpace(int fd);
+
+  // 打开数据库时调用，先用上次遗留的双写文件修复撕裂的页面
+  // double-write 参数打开时，之后的页面先写入双写文件并落盘，再写入原位置并落盘
+  void OpenDoubleWrite();
+  void CloseDoubleWrite();
+  // 校验文件中的所有页面，返回未通过校验的页号，不经过缓冲池
+  std::vector<PageID> VerifyFile(const std::string &path, PageID &page_count);
+  // 页面未通过校验时抛出 PageCorruptedError
+  void VerifyPage(int fd, PageID page_no, const Byte *page_data);
 
  private:
   DiskManager();
 
+  // 页面读入后检查校验值，写入前计算校验值
   void ReadPage(int fd, int page_id, Byte *page_data);
-  void WritePage(int fd, int page_id, const Byte *page_data);
+  void WritePage(int fd, int page_id, Byte *page_data);
+  // 读入连续的多个页面，返回完整读入的页面数
+  size_t ReadPages(int fd, int first_page_id, const std::vector<Byte *> &pages_data);
+  // 多段连续页面作为一批提交，每段一个向量读写请求
+  void ReadPageRuns(std::vector<PageRun> &runs);
+  void WritePageRuns(std::vector<PageRun> &runs);
+  void SubmitPageRuns(std::vector<PageRun> &runs, IoRequest::Op op);
+  // 将连续的多个页面合并为一次向量写
+  void WritePages(int fd, int first_page_id, const std::vector<const Byte *> &pages_data);
+  // 压缩存放的文件的页面段，每个页面一个读写请求，作为一批提交
+  // 读入失败的页面及其之后的页面视为未读入，返回各段是否因解压或校验失败而停止
+  std::vector<bool> ReadCompressedRuns(std::vector<PageRun> &runs);
+  // 页面写入空闲扇区并落盘后再写入映射项，映射项落盘后才释放旧镜像的扇区，不经过双写
+  void WriteCompressedRuns(std::vector<PageRun> &runs);
+  // 文件未压缩存放时返回 nullptr
+  PageMap *GetPageMap(int fd);
+  std::string GetPageMapPath(const std::string &path);
 
   bool FileExists(const std::string &path);
-  bool DirectoryExists(const std::string &path);
+  std::string GetPath(int fd);
+  // 将一批页面写入双写文件并落盘，页面数不超过双写文件的容量
+  void WriteDoubleWrite(const std::vector<PageRun> &runs);
+  // 用双写文件中通过校验的副本覆盖原位置未通过校验的页面，返回修复的页面数
+  size_t RestoreDoubleWrite();
 
+  // 由 io-backend 参数选择
+  IoBackend *io_backend_;
+  // direct-io 参数打开时 .data 文件绕过内核页缓存，页面只缓存在缓冲池中
+  // 数据文件只经由缓冲池以整页读写，帧内存按页对齐，满足 O_DIRECT 的对齐要求
+  bool direct_io_;
   std::vector<std::string> database_names_;
+  // 后台写回线程也会查找文件路径
+  std::mutex file_mutex_;
   std::unordered_map<std::string, int> path2fd_;
   std::unordered_map<int, std::string> fd2path_;
+  // 压缩存放的数据文件的页面映射，由 file_mutex_ 保护
+  std::unordered_map<int, std::unique_ptr<PageMap>> page_maps_;
+  // 没有打开压缩存放的文件时读写不查找页面映射
+  std::atomic<size_t> compressed_files_;
+  // double-write 参数打开且已打开数据库时为双写文件，否则为 -1
+  bool double_write_;
+  int double_write_fd_;
+  // 同一时间只有一批页面使用双写文件
+  std::mutex double_write_mutex_;
+  std::atomic<size_t> double_write_pages_;
+  std::atomic<size_t> double_write_batches_;
+  std::atomic<size_t> checksum_failures_;
+  std::atomic<size_t> repaired_pages_;
+  std::atomic<size_t> compressed_writes_;
+  std::atomic<size_t> compressed_reads_;
+  std::atomic<size_t> compressed_bytes_written_;
+  std::atomic<size_t> compressed_bytes_read_;
+  std::atomic<size_t> compress_ns_;
+  std::atomic<size_t> decompress_ns_;
   char db_dir[PATH_MAX];
 };
 
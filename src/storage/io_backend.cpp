@@ -0,0 +1,52 @@
+#include "io_backend.h"
+
+#include <iostream>
+
+#include "../exception/exceptions.h"
+#include "io_backends.h"
+
+namespace dbtrain {
+
+ssize_t IoBackend::Read(int fd, void *buf, size_t size, off_t offset) {
+  struct iovec iov = {buf, size};
+  return ReadV(fd, &iov, 1, offset);
+}
+
+ssize_t IoBackend::Write(int fd, const void *buf, size_t size, off_t offset) {
+  struct iovec iov = {(void *)buf, size};
+  return WriteV(fd, &iov, 1, offset);
+}
+
+ssize_t IoBackend::ReadV(int fd, const struct iovec *iov, int iovcnt, off_t offset) {
+  vector<IoRequest> requests = {{IoRequest::Op::READ, fd, offset, iov, iovcnt, 0}};
+  Submit(requests);
+  return requests[0].result;
+}
+
+ssize_t IoBackend::WriteV(int fd, const struct iovec *iov, int iovcnt, off_t offset) {
+  vector<IoRequest> requests = {{IoRequest::Op::WRITE, fd, offset, iov, iovcnt, 0}};
+  Submit(requests);
+  return requests[0].result;
+}
+
+int IoBackend::Sync(int fd) {
+  vector<IoRequest> requests = {{IoRequest::Op::FSYNC, fd, 0, nullptr, 0, 0}};
+  Submit(requests);
+  return requests[0].result;
+}
+
+IoBackend *IoBackend::Create(const string &name) {
+  if (name == "posix") {
+    return new PosixIoBackend();
+  } else if (name == "io_uring") {
+    try {
+      return new UringIoBackend(URING_ENTRIES);
+    } catch (DbError &e) {
+      std::cerr << "DiskManager: io_uring unavailable, fallback to posix\n";
+      return new PosixIoBackend();
+    }
+  }
+  throw InvalidConfigError("io-backend", name);
+}
+
+}  // namespace dbtrain
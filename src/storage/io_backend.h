@@ -0,0 +1,44 @@
+#ifndef DBTRAIN_IO_BACKEND_H
+#define DBTRAIN_IO_BACKEND_H
+
+#include <sys/uio.h>
+
+#include "../defines.h"
+
+namespace dbtrain {
+
+// 一次定位读写请求，result 为完成的字节数，出错时为 -errno
+struct IoRequest {
+  // FDATASYNC 不同步与读取数据无关的元数据，用于不改变文件大小的写入
+  enum class Op { READ, WRITE, FSYNC, FDATASYNC };
+  Op op;
+  int fd;
+  off_t offset;
+  const struct iovec *iov;
+  int iovcnt;
+  ssize_t result;
+};
+
+// DiskManager 使用的 I/O 后端，由 io-backend 参数在启动时选择
+// 所有读写都是定位读写，不依赖也不修改文件偏移，可以被多个线程同时调用
+class IoBackend {
+ public:
+  virtual ~IoBackend() = default;
+
+  // 批量提交请求，全部完成后返回
+  virtual void Submit(vector<IoRequest> &requests) = 0;
+  virtual string GetName() const = 0;
+
+  ssize_t Read(int fd, void *buf, size_t size, off_t offset);
+  ssize_t Write(int fd, const void *buf, size_t size, off_t offset);
+  ssize_t ReadV(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+  ssize_t WriteV(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+  int Sync(int fd);
+
+  // posix (默认) 或 io_uring，io_uring 不可用时退回 posix
+  static IoBackend *Create(const string &name);
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_IO_BACKEND_H
@@ -0,0 +1,2 @@
+#include "posix_io_backend.h"
+#include "uring_io_backend.h"
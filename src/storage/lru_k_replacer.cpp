@@ -0,0 +1,68 @@
+#include "lru_k_replacer.h"
+
+namespace dbtrain {
+
+LRUKReplacer::LRUKReplacer(size_t capacity, int k)
+    : k_(k), positions_(capacity), access_count_(capacity, 0), evictable_(capacity, false) {}
+
+void LRUKReplacer::Link(int frame_no) {
+  if (access_count_[frame_no] < k_) {
+    history_list_.push_front(frame_no);
+    positions_[frame_no] = history_list_.begin();
+  } else {
+    cache_list_.push_front(frame_no);
+    positions_[frame_no] = cache_list_.begin();
+  }
+}
+
+void LRUKReplacer::Unlink(int frame_no) {
+  if (!evictable_[frame_no]) return;
+  if (access_count_[frame_no] < k_) {
+    history_list_.erase(positions_[frame_no]);
+  } else {
+    cache_list_.erase(positions_[frame_no]);
+  }
+}
+
+void LRUKReplacer::Access(int frame_no) {
+  int count = access_count_[frame_no];
+  if (evictable_[frame_no] && count + 1 >= k_) {
+    // 进入或留在缓存链表，移动到头部；历史链表中的帧保持首次访问的先后顺序
+    Unlink(frame_no);
+    cache_list_.push_front(frame_no);
+    positions_[frame_no] = cache_list_.begin();
+  }
+  // 计数达到 K 后不再增长，避免溢出
+  if (count < k_) access_count_[frame_no] = count + 1;
+}
+
+void LRUKReplacer::SetEvictable(int frame_no, bool evictable) {
+  if (evictable_[frame_no] == evictable) return;
+  if (evictable) {
+    evictable_[frame_no] = true;
+    Link(frame_no);
+  } else {
+    Unlink(frame_no);
+    evictable_[frame_no] = false;
+  }
+}
+
+bool LRUKReplacer::Victim(int *frame_no) {
+  std::list<int> *victim_list = !history_list_.empty() ? &history_list_ : &cache_list_;
+  if (victim_list->empty()) return false;
+  *frame_no = victim_list->back();
+  victim_list->pop_back();
+  access_count_[*frame_no] = 0;
+  evictable_[*frame_no] = false;
+  return true;
+}
+
+void LRUKReplacer::Remove(int frame_no) {
+  Unlink(frame_no);
+  access_count_[frame_no] = 0;
+  evictable_[frame_no] = false;
+}
+
+size_t LRUKReplacer::Size() const { return history_list_.size() + cache_list_.size(); }
+
+}  // namespace dbtrain
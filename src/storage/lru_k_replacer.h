@@ -0,0 +1,40 @@
+#ifndef DBTRAIN_LRU_K_REPLACER_H
+#define DBTRAIN_LRU_K_REPLACER_H
+
+#include <list>
+
+#include "replacer.h"
+
+namespace dbtrain {
+
+// LRU-K 的 O(1) 近似实现（与 2Q 相同的两级链表）
+// 访问次数不足 K 次的帧位于历史链表，按首次访问先进先出
+// 访问达到 K 次的帧进入缓存链表，按最近访问排序
+// 替换时优先淘汰历史链表中的帧，一次顺序扫描只会挤占历史链表，不会淘汰反复访问的热点页面
+// 链表中只保存可替换的帧，被 pin 的帧只累计访问次数
+class LRUKReplacer : public Replacer {
+ public:
+  LRUKReplacer(size_t capacity, int k);
+  ~LRUKReplacer() = default;
+
+  void Access(int frame_no) override;
+  void SetEvictable(int frame_no, bool evictable) override;
+  bool Victim(int *frame_no) override;
+  void Remove(int frame_no) override;
+  size_t Size() const override;
+
+ private:
+  void Link(int frame_no);
+  void Unlink(int frame_no);
+
+  int k_;
+  std::list<int> history_list_;
+  std::list<int> cache_list_;
+  vector<std::list<int>::iterator> positions_;
+  vector<int> access_count_;
+  vector<bool> evictable_;
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_LRU_K_REPLACER_H
@@ -0,0 +1,44 @@
+#include "lru_replacer.h"
+
+namespace dbtrain {
+
+LRUReplacer::LRUReplacer(size_t capacity)
+    : positions_(capacity), in_list_(capacity, false), evictable_(capacity, false) {}
+
+void LRUReplacer::Access(int frame_no) {
+  if (!evictable_[frame_no]) return;
+  if (in_list_[frame_no]) lru_list_.erase(positions_[frame_no]);
+  lru_list_.push_front(frame_no);
+  positions_[frame_no] = lru_list_.begin();
+  in_list_[frame_no] = true;
+}
+
+void LRUReplacer::SetEvictable(int frame_no, bool evictable) {
+  if (evictable_[frame_no] == evictable) return;
+  evictable_[frame_no] = evictable;
+  if (evictable) {
+    Access(frame_no);
+  } else if (in_list_[frame_no]) {
+    lru_list_.erase(positions_[frame_no]);
+    in_list_[frame_no] = false;
+  }
+}
+
+bool LRUReplacer::Victim(int *frame_no) {
+  if (lru_list_.empty()) return false;
+  *frame_no = lru_list_.back();
+  lru_list_.pop_back();
+  in_list_[*frame_no] = false;
+  evictable_[*frame_no] = false;
+  return true;
+}
+
+void LRUReplacer::Remove(int frame_no) {
+  if (in_list_[frame_no]) lru_list_.erase(positions_[frame_no]);
+  in_list_[frame_no] = false;
+  evictable_[frame_no] = false;
+}
+
+size_t LRUReplacer::Size() const { return lru_list_.size(); }
+
+}  // namespace dbtrain
@@ -0,0 +1,33 @@
+#ifndef DBTRAIN_LRU_REPLACER_H
+#define DBTRAIN_LRU_REPLACER_H
+
+#include <list>
+
+#include "replacer.h"
+
+namespace dbtrain {
+
+// 最近最少使用，链表头部为最近访问的帧
+// 每个帧记录自身在链表中的位置，命中时无需遍历链表
+// 链表中只保存可替换的帧，帧被 pin 时移出链表，unpin 时重新放到链表头部
+class LRUReplacer : public Replacer {
+ public:
+  LRUReplacer(size_t capacity);
+  ~LRUReplacer() = default;
+
+  void Access(int frame_no) override;
+  void SetEvictable(int frame_no, bool evictable) override;
+  bool Victim(int *frame_no) override;
+  void Remove(int frame_no) override;
+  size_t Size() const override;
+
+ private:
+  std::list<int> lru_list_;
+  vector<std::list<int>::iterator> positions_;
+  vector<bool> in_list_;
+  vector<bool> evictable_;
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_LRU_REPLACER_H
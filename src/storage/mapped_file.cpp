@@ -0,0 +1,62 @@
+#include "mapped_file.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include "../exception/exceptions.h"
+#include "../storage/disk_manager.h"
+#include "../system/config_manager.h"
+
+namespace dbtrain {
+
+MappedFile::MappedFile(int fd) : fd_(fd), data_(nullptr) {
+  size_ = DiskManager::GetInstance().FileSize(fd_);
+  page_count_ = size_ / PAGE_SIZE;
+  size_ = (size_t)page_count_ * PAGE_SIZE;
+  if (size_ > 0) {
+    void *addr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+      std::cerr << "Error in MappedFile::MappedFile\n";
+      throw UnknownError();
+    }
+    data_ = (Byte *)addr;
+  }
+  read_ahead_pages_ = ConfigManager::GetInstance().GetSize("read-ahead", 128 * 1024) / PAGE_SIZE;
+  pages_ = std::vector<Page>(page_count_);
+  verified_.reset(new std::atomic<bool>[page_count_]());
+  for (PageID i = 0; i < page_count_; i++) {
+    pages_[i].page_id_ = {fd_, i};
+    pages_[i].data_ = data_ + (size_t)i * PAGE_SIZE;
+    pages_[i].mapped_ = true;
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) munmap(data_, size_);
+}
+
+PageID MappedFile::GetPageCount() const { return page_count_; }
+
+Page *MappedFile::GetPage(PageID page_no) {
+  if (page_no >= page_count_) {
+    std::cerr << "Error in MappedFile::GetPage\n";
+    throw UnknownError();
+  }
+  if (!verified_[page_no].load()) {
+    DiskManager::GetInstance().VerifyPage(fd_, page_no, pages_[page_no].data_);
+    verified_[page_no] = true;
+  }
+  return &pages_[page_no];
+}
+
+void MappedFile::ReadAhead(PageID page_no) {
+  if (data_ == nullptr || page_no >= page_count_) return;
+  if (page_no == 0) madvise(data_, size_, MADV_SEQUENTIAL);
+  if (read_ahead_pages_ == 0 || page_no % read_ahead_pages_ != 0) return;
+  size_t count = std::min(read_ahead_pages_, (size_t)(page_count_ - page_no));
+  madvise(data_ + (size_t)page_no * PAGE_SIZE, count * PAGE_SIZE, MADV_WILLNEED);
+}
+
+}  // namespace dbtrain
@@ -0,0 +1,43 @@
+#ifndef DBTRAIN_MAPPED_FILE_H
+#define DBTRAIN_MAPPED_FILE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "../defines.h"
+#include "../storage/page.h"
+
+namespace dbtrain {
+
+// 只读数据文件的内存映射
+// 页面直接指向映射区域，读取时不经过缓冲池的页表查找与复制，映射区域不可写
+class MappedFile {
+ public:
+  MappedFile(const MappedFile &) = delete;
+  void operator=(const MappedFile &) = delete;
+  // 映射文件当前的全部页面，之后文件不能再增长
+  explicit MappedFile(int fd);
+  ~MappedFile();
+
+  PageID GetPageCount() const;
+  // 页面第一次被访问时检查校验值
+  Page *GetPage(PageID page_no);
+  // 顺序扫描提示：从第 0 页开始时建议内核顺序预读，之后每隔 read-ahead 窗口提前载入下一个窗口
+  void ReadAhead(PageID page_no);
+
+ private:
+  int fd_;
+  Byte *data_;
+  size_t size_;
+  PageID page_count_;
+  size_t read_ahead_pages_;
+  // Page 含有闩，不可移动，只能整体构造
+  std::vector<Page> pages_;
+  // 映射区域不可写，每个页面只需校验一次
+  std::unique_ptr<std::atomic<bool>[]> verified_;
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_MAPPED_FILE_H
@@ -1,3 +1,26 @@
 #include "page.h"
 
-namespace dbtrain {}  // namespace dbtrain
+#include "../utils/crc32c.h"
+
+namespace dbtrain {
+
+static uint32_t PageChecksum(const Byte *data, PageID page_no) {
+  return Crc32c(data + PAGE_CHECKSUM_SIZE, PAGE_SIZE - PAGE_CHECKSUM_SIZE, page_no);
+}
+
+void SetPageChecksum(Byte *data, PageID page_no) {
+  uint32_t checksum = PageChecksum(data, page_no);
+  memcpy(data, &checksum, PAGE_CHECKSUM_SIZE);
+}
+
+bool VerifyPageChecksum(const Byte *data, PageID page_no) {
+  uint32_t checksum;
+  memcpy(&checksum, data, PAGE_CHECKSUM_SIZE);
+  if (checksum == PageChecksum(data, page_no)) return true;
+  for (size_t i = 0; i < PAGE_SIZE; i++) {
+    if (data[i] != 0) return false;
+  }
+  return true;
+}
+
+}  // namespace dbtrain
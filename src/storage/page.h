@@ -1,6 +1,9 @@
 #ifndef DBTRAIN_PAGE_H
 #define DBTRAIN_PAGE_H
 
+#include <atomic>
+#include <shared_mutex>
+
 #include "../defines.h"
 
 namespace dbtrain {
@@ -16,20 +19,90 @@ struct PageIdHash {
   size_t operator()(const FilePageId &page_id) const { return (page_id.fd << FD_BITS) | page_id.page_no; }
 };
 
+// 经由缓冲池读写的页面前 4 字节为 CRC32C 校验值，由 DiskManager 在写入时计算、读入时检查，页面内容从其后开始
+static const size_t PAGE_CHECKSUM_SIZE = sizeof(uint32_t);
+
+// 校验值覆盖校验字段之后的全部内容，以页号为初值，写到错误位置的页面也无法通过校验
+void SetPageChecksum(Byte *data, PageID page_no);
+// 全零的页面视为尚未写入过，可以通过校验
+bool VerifyPageChecksum(const Byte *data, PageID page_no);
+
 class Page {
   friend class BufferManager;
+  friend class MappedFile;
 
  public:
-  Page() : is_dirty_(false) {}
+  Page()
+      : data_(nullptr),
+        is_dirty_(false),
+        page_lsn_(0),
+        rec_lsn_(0),
+        pin_count_(0),
+        loading_(false),
+        prefetched_(false),
+        mapped_(false),
+        pending_updates_(0) {}
   ~Page() = default;
   void SetDirty() { is_dirty_ = true; }
   uint8_t *GetData() { return data_; }
   FilePageId GetPageId() { return page_id_; }
+  int GetPinCount() const { return pin_count_; }
+  // 已应用到页面的最大日志 LSN，后台写回时需满足 WAL：page_lsn <= flushed_lsn
+  // 不同事务的修改先写日志再各自加锁修改页面，应用顺序可能与 LSN 顺序不同，只增不减
+  // rec_lsn 取最小值、page_lsn 取最大值，均用 CAS 更新，避免并发设置时较小或较大的 LSN 被覆盖
+  void SetLSN(LSN lsn) {
+    LSN rec_lsn = rec_lsn_.load();
+    while ((rec_lsn == 0 || lsn < rec_lsn) && !rec_lsn_.compare_exchange_weak(rec_lsn, lsn)) {
+    }
+    LSN page_lsn = page_lsn_.load();
+    while (lsn > page_lsn && !page_lsn_.compare_exchange_weak(page_lsn, lsn)) {
+    }
+  }
+  LSN GetLSN() const { return page_lsn_; }
+  // 页面位于只读的文件映射中，不属于缓冲池，无需 pin
+  bool IsMapped() const { return mapped_; }
+
+  // 页面读写闩，保护页面内容，只能在页面被 pin 期间使用
+  void RLatch() { latch_.lock_shared(); }
+  void RUnlatch() { latch_.unlock_shared(); }
+  void WLatch() { latch_.lock(); }
+  void WUnlatch() { latch_.unlock(); }
+
+  // 已写入日志、尚未应用到页面的修改数，只能在页面被 pin 期间修改
+  // 大于 0 时页面 LSN 可能已超过其中某条日志，写回后重做会跳过该日志，因此不写回
+  void BeginUpdate() { pending_updates_++; }
+  void EndUpdate() { pending_updates_--; }
+  bool UpdatePending() const { return pending_updates_ > 0; }
 
  private:
   FilePageId page_id_;
-  uint8_t data_[PAGE_SIZE];
-  bool is_dirty_;
+  // 指向缓冲池连续内存中对应的帧
+  uint8_t *data_;
+  std::atomic<bool> is_dirty_;
+  std::atomic<LSN> page_lsn_;
+  // 页面写回后第一次修改的日志 LSN，0 表示页面自上次写回后未被日志修改
+  std::atomic<LSN> rec_lsn_;
+  // pin 计数大于 0 的帧不会被替换
+  std::atomic<int> pin_count_;
+  // 页面正在从磁盘读入，其他线程需等待读入完成
+  bool loading_;
+  // 页面由预读载入且尚未被访问
+  bool prefetched_;
+  bool mapped_;
+  std::atomic<int> pending_updates_;
+  std::shared_mutex latch_;
+};
+
+// 先写日志再修改页面时，在分配 LSN 之前构造，修改页面之后析构，期间页面不会被写回
+class PageUpdate {
+ public:
+  explicit PageUpdate(Page *page) : page_(page) { page_->BeginUpdate(); }
+  ~PageUpdate() { page_->EndUpdate(); }
+  PageUpdate(const PageUpdate &) = delete;
+  PageUpdate &operator=(const PageUpdate &) = delete;
+
+ private:
+  Page *page_;
 };
 
 }  // namespace dbtrain
@@ -0,0 +1,40 @@
+#include "page_guard.h"
+
+#include "buffer_manager.h"
+
+namespace dbtrain {
+
+PageGuard::PageGuard(const PageGuard &guard) : page_(guard.page_) {
+  if (page_ != nullptr && !page_->IsMapped()) BufferManager::GetInstance().PinPage(page_);
+}
+
+PageGuard::PageGuard(PageGuard &&guard) noexcept : page_(guard.page_) { guard.page_ = nullptr; }
+
+PageGuard &PageGuard::operator=(const PageGuard &guard) {
+  if (this != &guard) {
+    Release();
+    page_ = guard.page_;
+    if (page_ != nullptr && !page_->IsMapped()) BufferManager::GetInstance().PinPage(page_);
+  }
+  return *this;
+}
+
+PageGuard &PageGuard::operator=(PageGuard &&guard) noexcept {
+  if (this != &guard) {
+    Release();
+    page_ = guard.page_;
+    guard.page_ = nullptr;
+  }
+  return *this;
+}
+
+PageGuard::~PageGuard() { Release(); }
+
+void PageGuard::Release() {
+  if (page_ != nullptr) {
+    if (!page_->IsMapped()) BufferManager::GetInstance().UnpinPage(page_);
+    page_ = nullptr;
+  }
+}
+
+}  // namespace dbtrain
@@ -0,0 +1,34 @@
+#ifndef DBTRAIN_PAGE_GUARD_H
+#define DBTRAIN_PAGE_GUARD_H
+
+#include "../storage/page.h"
+
+namespace dbtrain {
+
+// 持有一次页面 pin，析构时自动 unpin
+// 复制时再 pin 一次，保证每个副本都能独立释放
+// 只读映射中的页面不属于缓冲池，不做 pin
+class PageGuard {
+ public:
+  PageGuard() : page_(nullptr) {}
+  // 接管一次已经完成的 pin
+  explicit PageGuard(Page *page) : page_(page) {}
+  PageGuard(const PageGuard &guard);
+  PageGuard(PageGuard &&guard) noexcept;
+  PageGuard &operator=(const PageGuard &guard);
+  PageGuard &operator=(PageGuard &&guard) noexcept;
+  ~PageGuard();
+
+  Page *Get() const { return page_; }
+  Page *operator->() const { return page_; }
+  explicit operator bool() const { return page_ != nullptr; }
+  // 提前释放 pin
+  void Release();
+
+ private:
+  Page *page_;
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_PAGE_GUARD_H
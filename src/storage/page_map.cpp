@@ -0,0 +1,97 @@
+#include "page_map.h"
+
+#include <algorithm>
+
+namespace dbtrain {
+
+PageMap::PageMap(int map_fd, std::vector<PageMapEntry> entries)
+    : map_fd_(map_fd), entries_(std::move(entries)), end_sector_(0), stored_sectors_(0) {
+  // 重建空闲空间：有效镜像之间的空隙
+  std::vector<std::pair<uint32_t, uint32_t>> used;
+  for (const PageMapEntry &entry : entries_) {
+    if (entry.length == 0) continue;
+    used.push_back({entry.sector, entry.sector + Sectors(entry.length)});
+    stored_sectors_ += Sectors(entry.length);
+  }
+  std::sort(used.begin(), used.end());
+  for (const auto &extent : used) {
+    if (extent.first > end_sector_) FreeExtent(end_sector_, extent.first - end_sector_);
+    end_sector_ = std::max(end_sector_, extent.second);
+  }
+}
+
+int PageMap::GetFd() const { return map_fd_; }
+
+PageID PageMap::GetPageCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+void PageMap::Resize(PageID page_count) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t page_no = page_count; page_no < entries_.size(); page_no++) {
+    const PageMapEntry &entry = entries_[page_no];
+    if (entry.length == 0) continue;
+    FreeExtent(entry.sector, Sectors(entry.length));
+    stored_sectors_ -= Sectors(entry.length);
+  }
+  entries_.resize(page_count, {0, 0, 0});
+}
+
+bool PageMap::Get(PageID page_no, PageMapEntry &entry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if ((size_t)page_no >= entries_.size()) return false;
+  entry = entries_[page_no];
+  return true;
+}
+
+PageMapEntry PageMap::Alloc(size_t length) {
+  size_t sectors = Sectors(length);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t size = sectors; size <= PAGE_SECTORS; size++) {
+    if (free_[size].empty()) continue;
+    uint32_t sector = free_[size].back();
+    free_[size].pop_back();
+    if (size > sectors) free_[size - sectors].push_back(sector + sectors);
+    return {sector, (uint16_t)length, 0};
+  }
+  uint32_t sector = end_sector_;
+  end_sector_ += sectors;
+  return {sector, (uint16_t)length, 0};
+}
+
+void PageMap::Free(const PageMapEntry &entry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FreeExtent(entry.sector, Sectors(entry.length));
+}
+
+void PageMap::Replace(PageID page_no, const PageMapEntry &entry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if ((size_t)page_no >= entries_.size()) entries_.resize(page_no + 1, {0, 0, 0});
+  PageMapEntry &old_entry = entries_[page_no];
+  if (old_entry.length != 0) {
+    FreeExtent(old_entry.sector, Sectors(old_entry.length));
+    stored_sectors_ -= Sectors(old_entry.length);
+  }
+  old_entry = entry;
+  stored_sectors_ += Sectors(entry.length);
+}
+
+size_t PageMap::GetStoredBytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stored_sectors_ * COMPRESSED_SECTOR_SIZE;
+}
+
+size_t PageMap::Sectors(size_t length) { return (length + COMPRESSED_SECTOR_SIZE - 1) / COMPRESSED_SECTOR_SIZE; }
+
+void PageMap::FreeExtent(uint32_t sector, size_t sectors) {
+  // 较长的空隙拆成不超过一个页面的段
+  while (sectors > 0) {
+    size_t size = std::min(sectors, PAGE_SECTORS);
+    free_[size].push_back(sector);
+    sector += size;
+    sectors -= size;
+  }
+}
+
+}  // namespace dbtrain
@@ -0,0 +1,63 @@
+#ifndef DBTRAIN_PAGE_MAP_H
+#define DBTRAIN_PAGE_MAP_H
+
+#include <mutex>
+#include <vector>
+
+#include "../defines.h"
+
+namespace dbtrain {
+
+// 压缩存放的数据文件以扇区为单位分配空间，一个页面的镜像最多占 PAGE_SECTORS 个扇区
+static const size_t COMPRESSED_SECTOR_SIZE = 512;
+static const size_t PAGE_SECTORS = PAGE_SIZE / COMPRESSED_SECTOR_SIZE;
+
+// 页面镜像在数据文件中的位置：length 为 0 表示页面从未写入，读出为全零页面；为 PAGE_SIZE 时未压缩
+struct PageMapEntry {
+  uint32_t sector;
+  uint16_t length;
+  uint16_t reserved;
+};
+
+static_assert(sizeof(PageMapEntry) == 8, "page map entries must not straddle sectors");
+
+// 压缩存放的数据文件的页面映射，第 i 项为第 i 页的镜像位置，保存在映射文件的第 i 个 PageMapEntry 中
+// 页面总是写入空闲的扇区，映射项写入后才替换内存中的映射项并释放旧镜像的扇区，
+// 映射项不跨扇区，写入不会撕裂，崩溃后映射文件中的每一项都指向完整的旧镜像或新镜像
+class PageMap {
+ public:
+  // entries 为映射文件中的所有项，未被引用的扇区作为空闲空间
+  PageMap(int map_fd, std::vector<PageMapEntry> entries);
+
+  int GetFd() const;
+  PageID GetPageCount();
+  // 扩展或截断到 page_count 个页面，新增页面从未写入，截去页面的扇区被释放
+  void Resize(PageID page_count);
+  // 页号超出映射时返回 false
+  bool Get(PageID page_no, PageMapEntry &entry);
+  // 为 length 字节的镜像分配扇区，返回的项还未写入映射
+  PageMapEntry Alloc(size_t length);
+  // 镜像写入失败时归还分配的扇区
+  void Free(const PageMapEntry &entry);
+  // 映射项写入映射文件后调用，释放旧镜像的扇区
+  void Replace(PageID page_no, const PageMapEntry &entry);
+  // 有效镜像占用的字节数，按扇区取整
+  size_t GetStoredBytes();
+
+  static size_t Sectors(size_t length);
+
+ private:
+  void FreeExtent(uint32_t sector, size_t sectors);
+
+  int map_fd_;
+  std::mutex mutex_;
+  std::vector<PageMapEntry> entries_;
+  // 空闲扇区段按扇区数分桶，分配时优先使用大小恰好的段，再拆分更大的段，都没有时从文件末尾分配
+  std::vector<uint32_t> free_[PAGE_SECTORS + 1];
+  uint32_t end_sector_;
+  size_t stored_sectors_;
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_PAGE_MAP_H
@@ -0,0 +1,31 @@
+#include "posix_io_backend.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+namespace dbtrain {
+
+void PosixIoBackend::Submit(vector<IoRequest> &requests) {
+  for (auto &request : requests) {
+    ssize_t res = 0;
+    switch (request.op) {
+      case IoRequest::Op::READ:
+        res = preadv(request.fd, request.iov, request.iovcnt, request.offset);
+        break;
+      case IoRequest::Op::WRITE:
+        res = pwritev(request.fd, request.iov, request.iovcnt, request.offset);
+        break;
+      case IoRequest::Op::FSYNC:
+        res = fsync(request.fd);
+        break;
+      case IoRequest::Op::FDATASYNC:
+        res = fdatasync(request.fd);
+        break;
+    }
+    request.result = res < 0 ? -errno : res;
+  }
+}
+
+string PosixIoBackend::GetName() const { return "posix"; }
+
+}  // namespace dbtrain
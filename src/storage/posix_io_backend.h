@@ -0,0 +1,20 @@
+#ifndef DBTRAIN_POSIX_IO_BACKEND_H
+#define DBTRAIN_POSIX_IO_BACKEND_H
+
+#include "io_backend.h"
+
+namespace dbtrain {
+
+// 使用 preadv/pwritev/fsync 逐个完成请求
+class PosixIoBackend : public IoBackend {
+ public:
+  PosixIoBackend() = default;
+  ~PosixIoBackend() = default;
+
+  void Submit(vector<IoRequest> &requests) override;
+  string GetName() const override;
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_POSIX_IO_BACKEND_H
@@ -0,0 +1,22 @@
+#include "replacer.h"
+
+#include "../exception/exceptions.h"
+#include "../system/config_manager.h"
+#include "replacers.h"
+
+namespace dbtrain {
+
+Replacer *Replacer::Create(const string &policy, size_t capacity) {
+  if (policy == "lru") {
+    return new LRUReplacer(capacity);
+  } else if (policy == "clock") {
+    return new ClockReplacer(capacity);
+  } else if (policy == "lru-k") {
+    int k = ConfigManager::GetInstance().GetInt("buffer-lru-k", 2);
+    if (k < 1) throw InvalidConfigError("buffer-lru-k", std::to_string(k));
+    return new LRUKReplacer(capacity, k);
+  }
+  throw InvalidConfigError("buffer-policy", policy);
+}
+
+}  // namespace dbtrain
@@ -0,0 +1,32 @@
+#ifndef DBTRAIN_REPLACER_H
+#define DBTRAIN_REPLACER_H
+
+#include "../defines.h"
+
+namespace dbtrain {
+
+// 缓冲池页面替换策略
+// 所有操作均为 O(1) 或均摊 O(1)，由 BufferManager 在持有替换策略锁时调用
+// 仅被标记为可替换（未被 pin）的帧会成为候选帧
+class Replacer {
+ public:
+  virtual ~Replacer() = default;
+
+  // 帧被访问（命中或新载入），新载入的帧默认不可替换
+  virtual void Access(int frame_no) = 0;
+  // pin 计数归零时设为可替换，重新被 pin 时设为不可替换
+  virtual void SetEvictable(int frame_no, bool evictable) = 0;
+  // 选出被替换的帧并将其移出候选集合，没有候选帧时返回 false
+  virtual bool Victim(int *frame_no) = 0;
+  // 帧被释放，清除其访问记录
+  virtual void Remove(int frame_no) = 0;
+  // 候选帧数量
+  virtual size_t Size() const = 0;
+
+  // 根据 buffer-policy 参数创建替换策略：lru (默认), clock, lru-k
+  static Replacer *Create(const string &policy, size_t capacity);
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_REPLACER_H
@@ -0,0 +1,3 @@
+#include "clock_replacer.h"
+#include "lru_k_replacer.h"
+#include "lru_replacer.h"
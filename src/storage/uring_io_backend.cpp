@@ -0,0 +1,177 @@
+#include "uring_io_backend.h"
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+#include "../exception/exceptions.h"
+
+namespace dbtrain {
+
+static int io_uring_setup(unsigned entries, struct io_uring_params *params) {
+  return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+UringRing::UringRing(unsigned entries)
+    : ring_fd_(-1), sq_ptr_(MAP_FAILED), cq_ptr_(MAP_FAILED), sqes_((struct io_uring_sqe *)MAP_FAILED) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = io_uring_setup(entries, &params);
+  if (ring_fd_ < 0) {
+    std::cerr << "Error in UringRing::UringRing: io_uring_setup\n";
+    throw UnknownError();
+  }
+  sq_entries_ = params.sq_entries;
+
+  sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  // 新内核中两个环形队列共用一次映射
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    if (cq_size_ > sq_size_) sq_size_ = cq_size_;
+    cq_size_ = sq_size_;
+  }
+  sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ptr_ == MAP_FAILED) {
+    close(ring_fd_);
+    std::cerr << "Error in UringRing::UringRing: mmap sq\n";
+    throw UnknownError();
+  }
+  if (single_mmap) {
+    cq_ptr_ = sq_ptr_;
+  } else {
+    cq_ptr_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ptr_ == MAP_FAILED) {
+      munmap(sq_ptr_, sq_size_);
+      close(ring_fd_);
+      std::cerr << "Error in UringRing::UringRing: mmap cq\n";
+      throw UnknownError();
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ = (struct io_uring_sqe *)mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                      ring_fd_, IORING_OFF_SQES);
+  if (sqes_ == MAP_FAILED) {
+    if (cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_size_);
+    munmap(sq_ptr_, sq_size_);
+    close(ring_fd_);
+    std::cerr << "Error in UringRing::UringRing: mmap sqes\n";
+    throw UnknownError();
+  }
+
+  Byte *sq = (Byte *)sq_ptr_;
+  sq_head_ = (unsigned *)(sq + params.sq_off.head);
+  sq_tail_ = (unsigned *)(sq + params.sq_off.tail);
+  sq_mask_ = (unsigned *)(sq + params.sq_off.ring_mask);
+  sq_array_ = (unsigned *)(sq + params.sq_off.array);
+  Byte *cq = (Byte *)cq_ptr_;
+  cq_head_ = (unsigned *)(cq + params.cq_off.head);
+  cq_tail_ = (unsigned *)(cq + params.cq_off.tail);
+  cq_mask_ = (unsigned *)(cq + params.cq_off.ring_mask);
+  cqes_ = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+}
+
+UringRing::~UringRing() {
+  munmap(sqes_, sqes_size_);
+  if (cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_size_);
+  munmap(sq_ptr_, sq_size_);
+  close(ring_fd_);
+}
+
+void UringRing::Submit(vector<IoRequest> &requests) {
+  for (size_t begin = 0; begin < requests.size(); begin += sq_entries_) {
+    size_t end = std::min(requests.size(), begin + sq_entries_);
+    SubmitChunk(requests, begin, end);
+  }
+}
+
+void UringRing::SubmitChunk(vector<IoRequest> &requests, size_t begin, size_t end) {
+  unsigned tail = *sq_tail_;
+  unsigned mask = *sq_mask_;
+  for (size_t i = begin; i < end; i++) {
+    const IoRequest &request = requests[i];
+    unsigned index = tail & mask;
+    struct io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    switch (request.op) {
+      case IoRequest::Op::READ:
+        sqe->opcode = IORING_OP_READV;
+        break;
+      case IoRequest::Op::WRITE:
+        sqe->opcode = IORING_OP_WRITEV;
+        break;
+      case IoRequest::Op::FSYNC:
+        sqe->opcode = IORING_OP_FSYNC;
+        break;
+      case IoRequest::Op::FDATASYNC:
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        break;
+    }
+    sqe->fd = request.fd;
+    sqe->off = request.offset;
+    sqe->addr = (unsigned long)request.iov;
+    sqe->len = request.iovcnt;
+    sqe->user_data = i;
+    sq_array_[index] = index;
+    tail++;
+  }
+  // 内核读取 tail 之前，请求内容必须可见
+  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+  unsigned to_submit = end - begin;
+  unsigned remaining = end - begin;
+  while (remaining > 0) {
+    int ret = io_uring_enter(ring_fd_, to_submit, 1, IORING_ENTER_GETEVENTS);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      std::cerr << "Error in UringRing::Submit: io_uring_enter\n";
+      throw UnknownError();
+    }
+    to_submit -= std::min<unsigned>(to_submit, ret);
+    unsigned head = *cq_head_;
+    while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      struct io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+      requests[cqe->user_data].result = cqe->res;
+      head++;
+      remaining--;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  }
+}
+
+UringIoBackend::UringIoBackend(unsigned entries) : entries_(entries) {
+  // 先创建一次，内核不支持时由 IoBackend::Create 退回 posix
+  UringRing probe(entries_);
+}
+
+void UringIoBackend::Submit(vector<IoRequest> &requests) {
+  // 进程中只有一个 UringIoBackend，各线程的 ring 不区分后端实例
+  static thread_local std::unique_ptr<UringRing> ring;
+  static thread_local bool unavailable = false;
+  if (ring == nullptr && !unavailable) {
+    try {
+      ring.reset(new UringRing(entries_));
+    } catch (DbError &e) {
+      unavailable = true;
+    }
+  }
+  if (ring == nullptr) {
+    fallback_.Submit(requests);
+  } else {
+    ring->Submit(requests);
+  }
+}
+
+string UringIoBackend::GetName() const { return "io_uring"; }
+
+}  // namespace dbtrain
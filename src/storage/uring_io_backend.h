@@ -0,0 +1,68 @@
+#ifndef DBTRAIN_URING_IO_BACKEND_H
+#define DBTRAIN_URING_IO_BACKEND_H
+
+#include <linux/io_uring.h>
+
+#include "io_backend.h"
+#include "posix_io_backend.h"
+
+namespace dbtrain {
+
+static const unsigned URING_ENTRIES = 64;
+
+// 一个 io_uring 实例，提交队列与完成队列只由创建它的线程使用，不需要加锁
+class UringRing {
+ public:
+  // 内核不支持 io_uring 或无法映射队列时抛出异常
+  UringRing(unsigned entries);
+  ~UringRing();
+  UringRing(const UringRing &) = delete;
+  void operator=(const UringRing &) = delete;
+
+  // 一批请求一次性放入提交队列，由一次 io_uring_enter 提交并等待全部完成
+  void Submit(vector<IoRequest> &requests);
+
+ private:
+  // 提交 [begin, end) 中的请求并等待完成
+  void SubmitChunk(vector<IoRequest> &requests, size_t begin, size_t end);
+
+  int ring_fd_;
+  unsigned sq_entries_;
+
+  void *sq_ptr_;
+  size_t sq_size_;
+  void *cq_ptr_;
+  size_t cq_size_;
+  struct io_uring_sqe *sqes_;
+  size_t sqes_size_;
+
+  unsigned *sq_head_;
+  unsigned *sq_tail_;
+  unsigned *sq_mask_;
+  unsigned *sq_array_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned *cq_mask_;
+  struct io_uring_cqe *cqes_;
+};
+
+// 基于 io_uring 的后端，直接使用系统调用，不依赖 liburing
+// 每个线程第一次提交时创建自己的 ring，线程退出时关闭，不同线程的批次互不等待
+// 线程无法创建 ring 时（例如超出 RLIMIT_MEMLOCK）该线程退回 posix
+class UringIoBackend : public IoBackend {
+ public:
+  // 内核不支持 io_uring 时抛出异常
+  UringIoBackend(unsigned entries);
+  ~UringIoBackend() = default;
+
+  void Submit(vector<IoRequest> &requests) override;
+  string GetName() const override;
+
+ private:
+  unsigned entries_;
+  PosixIoBackend fallback_;
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_URING_IO_BACKEND_H
@@ -0,0 +1,102 @@
+#include "config_manager.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "../exception/exceptions.h"
+
+namespace dbtrain {
+
+ConfigManager &ConfigManager::GetInstance() {
+  static ConfigManager config_manager;
+  return config_manager;
+}
+
+void ConfigManager::Init(int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg.size() <= 2 || arg.compare(0, 2, "--") != 0) continue;
+    arg = arg.substr(2);
+    size_t pos = arg.find('=');
+    if (pos != string::npos) {
+      Set(arg.substr(0, pos), arg.substr(pos + 1));
+    } else if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0 && argv[i + 1][0] != '-') {
+      Set(arg, argv[++i]);
+    } else {
+      // 单独出现的开关视为打开
+      Set(arg, "on");
+    }
+  }
+}
+
+void ConfigManager::Set(const string &key, const string &value) { options_[key] = value; }
+
+bool ConfigManager::Lookup(const string &key, string &value) const {
+  auto iter = options_.find(key);
+  if (iter != options_.end()) {
+    value = iter->second;
+    return true;
+  }
+  // buffer-size -> DBTRAIN_BUFFER_SIZE
+  string env_name = "DBTRAIN_" + key;
+  std::transform(env_name.begin(), env_name.end(), env_name.begin(),
+                 [](char c) { return c == '-' ? '_' : (char)toupper(c); });
+  const char *env_value = getenv(env_name.c_str());
+  if (env_value != nullptr) {
+    value = env_value;
+    return true;
+  }
+  return false;
+}
+
+bool ConfigManager::Has(const string &key) const {
+  string value;
+  return Lookup(key, value);
+}
+
+string ConfigManager::GetString(const string &key, const string &default_value) const {
+  string value;
+  if (!Lookup(key, value)) return default_value;
+  return value;
+}
+
+long long ConfigManager::GetInt(const string &key, long long default_value) const {
+  string value;
+  if (!Lookup(key, value)) return default_value;
+  char *end = nullptr;
+  long long res = strtoll(value.c_str(), &end, 10);
+  if (end == value.c_str() || *end != '\0') throw InvalidConfigError(key, value);
+  return res;
+}
+
+size_t ConfigManager::GetSize(const string &key, size_t default_value) const {
+  string value;
+  if (!Lookup(key, value)) return default_value;
+  char *end = nullptr;
+  double res = strtod(value.c_str(), &end);
+  if (end == value.c_str() || res < 0) throw InvalidConfigError(key, value);
+  string suffix = end;
+  std::transform(suffix.begin(), suffix.end(), suffix.begin(), ::toupper);
+  if (suffix == "" || suffix == "B") {
+  } else if (suffix == "K" || suffix == "KB") {
+    res *= 1024;
+  } else if (suffix == "M" || suffix == "MB") {
+    res *= 1024 * 1024;
+  } else if (suffix == "G" || suffix == "GB") {
+    res *= 1024.0 * 1024 * 1024;
+  } else {
+    throw InvalidConfigError(key, value);
+  }
+  return (size_t)res;
+}
+
+bool ConfigManager::GetBool(const string &key, bool default_value) const {
+  string value;
+  if (!Lookup(key, value)) return default_value;
+  std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+  if (value == "on" || value == "true" || value == "1" || value == "yes") return true;
+  if (value == "off" || value == "false" || value == "0" || value == "no") return false;
+  throw InvalidConfigError(key, value);
+}
+
+}  // namespace dbtrain
@@ -0,0 +1,40 @@
+#ifndef DBTRAIN_CONFIG_MANAGER_H
+#define DBTRAIN_CONFIG_MANAGER_H
+
+#include <map>
+
+#include "../defines.h"
+
+namespace dbtrain {
+
+// 运行参数管理
+// 参数来源优先级：命令行(--key=value 或 --key value) > 环境变量(DBTRAIN_KEY) > 默认值
+// 例如 --buffer-size=512M 与 DBTRAIN_BUFFER_SIZE=512M 等价
+class ConfigManager {
+ public:
+  ConfigManager(const ConfigManager &) = delete;
+  void operator=(const ConfigManager &) = delete;
+  static ConfigManager &GetInstance();
+
+  // 解析命令行参数，非 "--" 开头的参数会被忽略
+  void Init(int argc, char *argv[]);
+  void Set(const string &key, const string &value);
+
+  bool Has(const string &key) const;
+  string GetString(const string &key, const string &default_value) const;
+  long long GetInt(const string &key, long long default_value) const;
+  // 支持 K/M/G 后缀，单位为字节
+  size_t GetSize(const string &key, size_t default_value) const;
+  // 支持 on/off, true/false, 1/0
+  bool GetBool(const string &key, bool default_value) const;
+
+ private:
+  ConfigManager() = default;
+  bool Lookup(const string &key, string &value) const;
+
+  std::map<string, string> options_;
+};
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_CONFIG_MANAGER_H
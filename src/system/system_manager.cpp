@@ -1,20 +1,40 @@
 #include "system_manager.h"
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 
 #include "../defines.h"
 #include "../exception/exceptions.h"
+#include "../index/index_factory.h"
 #include "../log/log_factory.h"
 #include "../log/log_manager.h"
 #include "../optim/stats_manager.h"
+#include "../system/config_manager.h"
 #include "../record/fields.h"
 #include "../record/record_factory.h"
 #include "../table/hidden.h"
+#include "../tx/tx_manager.h"
 
 namespace dbtrain {
 
-SystemManager::SystemManager() : disk_manager_(DiskManager::GetInstance()), log_manager_(LogManager::GetInstance()) {
+SystemManager::SystemManager()
+    : disk_manager_(DiskManager::GetInstance()), log_manager_(LogManager::GetInstance()), log_storage_(nullptr), master_fd_(-1), recovery_ms_(0) {
+  next_table_id_ = INVALID_TABLE_ID + 1;
+  ConfigManager &config = ConfigManager::GetInstance();
+  read_only_ = config.GetBool("read-only", false);
+  autovacuum_ = config.GetBool("autovacuum", false);
+  autovacuum_naptime_ms_ = config.GetInt("autovacuum-naptime", 1000);
+  if (autovacuum_naptime_ms_ <= 0) {
+    throw InvalidConfigError("autovacuum-naptime", std::to_string(autovacuum_naptime_ms_));
+  }
+  long long threshold = config.GetInt("autovacuum-threshold", 50);
+  if (threshold < 0) throw InvalidConfigError("autovacuum-threshold", std::to_string(threshold));
+  autovacuum_threshold_ = threshold;
+  long long scale = config.GetInt("autovacuum-scale", 20);
+  if (scale < 0) throw InvalidConfigError("autovacuum-scale", std::to_string(scale));
+  autovacuum_scale_ = scale;
+  autovacuum_stop_ = false;
   disk_manager_.ListDirectories(".", db_names_);
 }
 
@@ -29,6 +49,12 @@ void SystemManager::UsingTest() {
   }
 }
 
+void SystemManager::WritableTest() {
+  if (read_only_) {
+    throw ReadOnlyError();
+  }
+}
+
 Result SystemManager::ShowDatabases() {
   RecordList records;
   for (const auto &db_name : db_names_) {
@@ -40,6 +66,7 @@ Result SystemManager::ShowDatabases() {
 }
 
 Result SystemManager::CreateDatabase(const std::string &db_name) {
+  WritableTest();
   if (std::find(db_names_.begin(), db_names_.end(), db_name) != db_names_.end()) {
     throw DatabaseExistsError(db_name);
   }
@@ -73,6 +100,12 @@ Result SystemManager::UseDatabase(const std::string &db_name) {
     std::cerr << "< ----- 4 ----- >\n";
     using_db_ = db_name;
     tables_.clear();
+    id2table_.clear();
+    indexes_.clear();
+    id2index_.clear();
+    next_table_id_ = INVALID_TABLE_ID + 1;
+    // 读取表文件前先修复上次断电时撕裂的页面
+    disk_manager_.OpenDoubleWrite();
     std::vector<std::string> table_names;
     disk_manager_.ListTables(".", table_names);
     std::cerr << "< ----- 5 ----- >\n";
@@ -81,19 +114,52 @@ Result SystemManager::UseDatabase(const std::string &db_name) {
       table2metafd_[table_name] = meta_fd;
       int data_fd = disk_manager_.OpenFile(table_name + DB_DATA_SUFFIX);
       table2datafd_[table_name] = data_fd;
-      // 反向映射
-      fd2table_[meta_fd] = table_name;
-      fd2table_[data_fd] = table_name;
 
-      tables_[table_name] = new Table(table_name, meta_fd, data_fd);
+      Table *table = new Table(table_name, meta_fd, data_fd);
+      tables_[table_name] = table;
+      id2table_[table->GetID()] = table;
+      next_table_id_ = std::max(next_table_id_, table->GetID() + 1);
+      // 反向映射
+      {
+        std::lock_guard<std::mutex> fd_lock(fd_mutex_);
+        fd2table_[data_fd] = table->GetID();
+      }
+    }
+    // 索引在恢复前打开，重做索引日志
+    std::vector<std::string> index_names;
+    disk_manager_.ListIndexes(".", index_names);
+    for (auto &index_name : index_names) {
+      int fd = disk_manager_.OpenFile(index_name + DB_INDEX_SUFFIX);
+      index2fd_[index_name] = fd;
+      Index *index = IndexFactory::LoadIndex(index_name, fd);
+      indexes_[index_name] = index;
+      id2index_[index->GetID()] = index;
+      next_table_id_ = std::max(next_table_id_, index->GetID() + 1);
+      {
+        std::lock_guard<std::mutex> fd_lock(fd_mutex_);
+        fd2table_[fd] = index->GetID();
+      }
+      GetTable(index->GetTableID())->AddIndex(index);
     }
     // 载入日志，准备开始
     LoadLogManager();
+    // 只读模式仍需先完成恢复，再切换为映射访问
+    if (read_only_) {
+      log_manager_.WaitUndo();
+      for (auto &table : tables_) table.second->MapData();
+    } else {
+      // 建立过程中崩溃的索引没有完成，恢复后删除
+      std::lock_guard<std::mutex> tables_lock(tables_mutex_);
+      for (auto &index_name : index_names) {
+        if (!indexes_[index_name]->IsValid()) RemoveIndex(index_name);
+      }
+    }
   }
   return Result(std::vector<std::string>{"SUCCESS"});
 }
 
 Result SystemManager::DropDatabase(const std::string &db_name, bool if_exists) {
+  WritableTest();
   if (using_db_ == db_name) {
     throw DropUsingDatabaseError();
   }
@@ -112,6 +178,50 @@ Result SystemManager::DropDatabase(const std::string &db_name, bool if_exists) {
   return Result(std::vector<std::string>{"SUCCESS"});
 }
 
+Result SystemManager::VerifyDatabase(const std::string &db_name, size_t &corrupted_pages) {
+  // 直接读取文件，不打开数据库，也不经过缓冲池
+  std::vector<std::string> db_names = db_names_;
+  if (!db_name.empty()) {
+    if (std::find(db_names_.begin(), db_names_.end(), db_name) == db_names_.end()) {
+      throw DatabaseNotExistsError(db_name);
+    }
+    db_names = {db_name};
+  }
+  std::string prefix = using_db_.empty() ? "" : "../";
+  corrupted_pages = 0;
+  RecordList records;
+  for (const auto &db : db_names) {
+    std::vector<std::string> table_names;
+    disk_manager_.ListTables(prefix + db, table_names);
+    std::sort(table_names.begin(), table_names.end());
+    std::vector<std::string> files;
+    for (const auto &table_name : table_names) {
+      for (const auto &suffix : {DB_META_SUFFIX, DB_DATA_SUFFIX}) {
+        files.push_back(table_name + suffix);
+      }
+    }
+    std::vector<std::string> index_names;
+    disk_manager_.ListIndexes(prefix + db, index_names);
+    std::sort(index_names.begin(), index_names.end());
+    for (const auto &index_name : index_names) files.push_back(index_name + DB_INDEX_SUFFIX);
+    for (const auto &file : files) {
+      PageID page_count = 0;
+      std::vector<PageID> corrupted = disk_manager_.VerifyFile(prefix + db + "/" + file, page_count);
+      for (PageID page_no : corrupted) {
+        std::cerr << "Page " << page_no << " of " << db << "/" << file << " failed checksum verification\n";
+      }
+      corrupted_pages += corrupted.size();
+      Record *record = new Record();
+      record->PushBack(new StrField(db.c_str(), db.size()));
+      record->PushBack(new StrField(file.c_str(), file.size()));
+      record->PushBack(new IntField(page_count));
+      record->PushBack(new IntField(corrupted.size()));
+      records.push_back(record);
+    }
+  }
+  return Result(std::vector<std::string>{"Database", "File", "Pages", "Corrupted"}, records);
+}
+
 void SystemManager::CloseDatabase() {
   if (using_db_.empty()) return;
   BufferManager::GetInstance().FlushAll();
@@ -119,48 +229,85 @@ void SystemManager::CloseDatabase() {
 }
 
 void SystemManager::CloseDatabase(const std::string &db_name) {
+  StopAutovacuum();
+  log_manager_.WaitUndo();
+  log_manager_.StopCheckpointer();
   // LAB 2: 日志写回
   StoreLogManager();
+  disk_manager_.CloseFile(master_fd_);
+  master_fd_ = -1;
 
   // 清除缓存
+  for (const auto &index : indexes_) {
+    delete index.second;
+    disk_manager_.CloseFile(index2fd_[index.first]);
+    {
+      std::lock_guard<std::mutex> fd_lock(fd_mutex_);
+      fd2table_.erase(index2fd_[index.first]);
+    }
+    index2fd_.erase(index.first);
+  }
   for (const auto &table : tables_) {
     delete table.second;
     disk_manager_.CloseFile(table2metafd_[table.first]);
     disk_manager_.CloseFile(table2datafd_[table.first]);
     // 反向映射
-    fd2table_.erase(table2datafd_[table.first]);
-    fd2table_.erase(table2metafd_[table.first]);
+    {
+      std::lock_guard<std::mutex> fd_lock(fd_mutex_);
+      fd2table_.erase(table2datafd_[table.first]);
+    }
 
     table2metafd_.erase(table.first);
     table2datafd_.erase(table.first);
   }
-  disk_manager_.CloseFile(log_data_fd_);
-  disk_manager_.CloseFile(log_index_fd_);
+  disk_manager_.CloseDoubleWrite();
+  delete log_storage_;
+  log_storage_ = nullptr;
 }
 
 void SystemManager::Crash() {
+  // 崩溃前停止后台清理、后台检查点与后台回滚
+  StopAutovacuum();
+  log_manager_.StopCheckpointer();
+  log_manager_.StopUndo();
   // 清除缓存
   BufferManager::GetInstance().Clear();
   LogManager::GetInstance().Init();
+  for (const auto &index : indexes_) {
+    disk_manager_.CloseFile(index2fd_[index.first]);
+    {
+      std::lock_guard<std::mutex> fd_lock(fd_mutex_);
+      fd2table_.erase(index2fd_[index.first]);
+    }
+    index2fd_.erase(index.first);
+  }
+  indexes_.clear();
+  id2index_.clear();
   for (const auto &table : tables_) {
     disk_manager_.CloseFile(table2metafd_[table.first]);
     disk_manager_.CloseFile(table2datafd_[table.first]);
     // 反向映射
-    fd2table_.erase(table2datafd_[table.first]);
-    fd2table_.erase(table2metafd_[table.first]);
+    {
+      std::lock_guard<std::mutex> fd_lock(fd_mutex_);
+      fd2table_.erase(table2datafd_[table.first]);
+    }
 
     table2metafd_.erase(table.first);
     table2datafd_.erase(table.first);
   }
   tables_.clear();
-  disk_manager_.CloseFile(log_data_fd_);
-  disk_manager_.CloseFile(log_index_fd_);
+  id2table_.clear();
+  disk_manager_.CloseDoubleWrite();
+  delete log_storage_;
+  log_storage_ = nullptr;
+  if (master_fd_ >= 0) {
+    disk_manager_.CloseFile(master_fd_);
+    master_fd_ = -1;
+  }
   if (!using_db_.empty()) {
     using_db_ = "";
     disk_manager_.ChangeDirectory("..");
   }
-  log_index_fd_ = -1;
-  log_data_fd_ = -1;
 }
 
 Table *SystemManager::GetTable(const std::string &table_name) {
@@ -174,26 +321,90 @@ Table *SystemManager::GetTable(const std::string &table_name) {
   return table->second;
 }
 
-Result SystemManager::CreateTable(const std::string &table_name, const std::vector<Column> &columns) {
+Table *SystemManager::GetTable(TableID table_id) {
+  if (using_db_.empty()) {
+    throw NoUsingDatabaseError();
+  }
+  auto table = id2table_.find(table_id);
+  if (table == id2table_.end()) {
+    throw TableNotExistsError(std::to_string(table_id));
+  }
+  return table->second;
+}
+
+static bool ParseTableLayout(std::string value, TableLayout &layout) {
+  std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+  if (value == "fixed") {
+    layout = TableLayout::FIXED;
+  } else if (value == "slotted") {
+    layout = TableLayout::SLOTTED;
+  } else if (value == "pax") {
+    layout = TableLayout::PAX;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// 数据文件是否压缩存放：off 或 lz4
+static bool ParseTableCompression(std::string value, bool &compressed) {
+  std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+  if (value == "off") {
+    compressed = false;
+  } else if (value == "lz4") {
+    compressed = true;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+Result SystemManager::CreateTable(const std::string &table_name, const std::vector<Column> &columns,
+                                  const std::map<std::string, std::string> &options) {
   if (using_db_.empty()) {
     throw NoUsingDatabaseError();
   }
+  WritableTest();
   if (tables_.find(table_name) != tables_.end()) {
     throw TableExistsError(table_name);
   }
+  // 未指定布局与压缩方式时使用 table-layout 与 table-compression 参数
+  TableLayout layout;
+  std::string default_layout = ConfigManager::GetInstance().GetString("table-layout", "fixed");
+  if (!ParseTableLayout(default_layout, layout)) throw InvalidConfigError("table-layout", default_layout);
+  bool compressed;
+  std::string default_compression = ConfigManager::GetInstance().GetString("table-compression", "off");
+  if (!ParseTableCompression(default_compression, compressed)) {
+    throw InvalidConfigError("table-compression", default_compression);
+  }
+  for (const auto &option : options) {
+    std::string key = option.first;
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+    bool valid = (key == "layout" && ParseTableLayout(option.second, layout)) ||
+                 (key == "compression" && ParseTableCompression(option.second, compressed));
+    if (!valid) throw InvalidTableOptionError(option.first, option.second);
+  }
+  log_manager_.WaitUndo();
 
   disk_manager_.CreateFile(table_name + DB_META_SUFFIX);
   int meta_fd = disk_manager_.OpenFile(table_name + DB_META_SUFFIX);
   table2metafd_[table_name] = meta_fd;
-  disk_manager_.CreateFile(table_name + DB_DATA_SUFFIX);
+  disk_manager_.CreateFile(table_name + DB_DATA_SUFFIX, compressed);
   int data_fd = disk_manager_.OpenFile(table_name + DB_DATA_SUFFIX);
   table2datafd_[table_name] = data_fd;
-  // 反向映射
-  fd2table_[meta_fd] = table_name;
-  fd2table_[data_fd] = table_name;
 
-  Table *table = new Table(table_name, meta_fd, data_fd, columns);
-  tables_[table_name] = table;
+  // 日志中以表编号代替表名
+  Table *table = new Table(table_name, meta_fd, data_fd, columns, AllocTableID(), layout);
+  {
+    std::lock_guard<std::mutex> tables_lock(tables_mutex_);
+    tables_[table_name] = table;
+    id2table_[table->GetID()] = table;
+  }
+  // 反向映射
+  {
+    std::lock_guard<std::mutex> fd_lock(fd_mutex_);
+    fd2table_[data_fd] = table->GetID();
+  }
   return Result(std::vector<std::string>{"SUCCESS"});
 }
 
@@ -218,19 +429,254 @@ Result SystemManager::DescTable(const std::string &table_name) {
   return GetTable(table_name)->Desc();
 }
 
+Result SystemManager::ShowBufferStatus() {
+  BufferStatus status = BufferManager::GetInstance().GetStatus();
+  size_t accesses = status.hits + status.misses;
+  double hit_ratio = accesses == 0 ? 0 : (double)status.hits / accesses;
+  // 压缩与解压的平均 CPU 耗时
+  double compress_us =
+      status.disk.compressed_writes == 0 ? 0 : status.disk.compress_ns / 1e3 / status.disk.compressed_writes;
+  double decompress_us =
+      status.disk.compressed_reads == 0 ? 0 : status.disk.decompress_ns / 1e3 / status.disk.compressed_reads;
+  std::vector<std::pair<std::string, std::string>> items = {
+      {"capacity_frames", std::to_string(status.capacity)},
+      {"capacity_bytes", std::to_string(status.capacity * PAGE_SIZE)},
+      {"policy", status.policy},
+      {"used_frames", std::to_string(status.used)},
+      {"dirty_frames", std::to_string(status.dirty)},
+      {"pinned_frames", std::to_string(status.pinned)},
+      {"hits", std::to_string(status.hits)},
+      {"misses", std::to_string(status.misses)},
+      {"hit_ratio", std::to_string(hit_ratio)},
+      {"evictions", std::to_string(status.evictions)},
+      {"huge_pages", status.huge_pages ? "ON" : "OFF"},
+      {"bgwriter", status.bgwriter ? "ON" : "OFF"},
+      {"foreground_writes", std::to_string(status.foreground_writes)},
+      {"background_writes", std::to_string(status.background_writes)},
+      {"background_write_calls", std::to_string(status.background_write_calls)},
+      {"checkpoint_writes", std::to_string(status.checkpoint_writes)},
+      {"read_ahead_calls", std::to_string(status.read_ahead_calls)},
+      {"read_ahead_pages", std::to_string(status.read_ahead_pages)},
+      {"read_ahead_hits", std::to_string(status.read_ahead_hits)},
+      {"io_backend", status.io_backend},
+      {"direct_io", status.direct_io ? "ON" : "OFF"},
+      {"double_write", status.disk.double_write ? "ON" : "OFF"},
+      {"double_write_pages", std::to_string(status.disk.double_write_pages)},
+      {"double_write_batches", std::to_string(status.disk.double_write_batches)},
+      {"checksum_failures", std::to_string(status.disk.checksum_failures)},
+      {"torn_pages_repaired", std::to_string(status.disk.repaired_pages)},
+      {"compressed_page_writes", std::to_string(status.disk.compressed_writes)},
+      {"compressed_page_reads", std::to_string(status.disk.compressed_reads)},
+      {"compressed_bytes_written", std::to_string(status.disk.compressed_bytes_written)},
+      {"compressed_bytes_read", std::to_string(status.disk.compressed_bytes_read)},
+      {"compress_us_per_page", std::to_string(compress_us)},
+      {"decompress_us_per_page", std::to_string(decompress_us)}};
+  RecordList records;
+  for (const auto &item : items) {
+    Record *record = new Record();
+    record->PushBack(new StrField(item.first.c_str(), item.first.size()));
+    record->PushBack(new StrField(item.second.c_str(), item.second.size()));
+    records.push_back(record);
+  }
+  return Result(std::vector<std::string>{"Name", "Value"}, records);
+}
+
+Result SystemManager::ShowLogStatus() {
+  LogStatus status = log_manager_.GetStatus();
+  LogStorageStatus storage_status = {0, 0, NULL_LSN, 0, 0, 0, 0};
+  if (log_storage_ != nullptr) storage_status = log_storage_->GetStatus();
+  double fsyncs_per_commit = status.commits == 0 ? 0 : (double)status.fsyncs / status.commits;
+  double wal_bytes_per_commit = status.commits == 0 ? 0 : (double)status.wal_bytes / status.commits;
+  std::vector<std::pair<std::string, std::string>> items = {
+      {"current_lsn", std::to_string(status.current_lsn)},
+      {"flushed_lsn", std::to_string(status.flushed_lsn)},
+      {"buffered_logs", std::to_string(status.buffered_logs)},
+      {"buffered_bytes", std::to_string(status.buffered_bytes)},
+      {"reserve_retries", std::to_string(status.reserve_retries)},
+      {"buffer_full_waits", std::to_string(status.buffer_full_waits)},
+      {"commits", std::to_string(status.commits)},
+      {"flushes", std::to_string(status.flushes)},
+      {"fsyncs", std::to_string(status.fsyncs)},
+      {"fsyncs_per_commit", std::to_string(fsyncs_per_commit)},
+      {"commit_delay_us", std::to_string(status.commit_delay_us)},
+      {"wal_bytes", std::to_string(status.wal_bytes)},
+      {"wal_bytes_per_commit", std::to_string(wal_bytes_per_commit)},
+      {"wal_compression", status.compression ? "lz4" : "off"},
+      {"segments", std::to_string(storage_status.segments)},
+      {"free_segments", std::to_string(storage_status.free_segments)},
+      {"log_first_lsn", storage_status.first_lsn == NULL_LSN ? "-" : std::to_string(storage_status.first_lsn)},
+      {"log_disk_bytes", std::to_string(storage_status.disk_bytes)},
+      {"removed_segments", std::to_string(storage_status.removed_segments)},
+      {"archived_segments", std::to_string(storage_status.archived_segments)},
+      {"recycled_segments", std::to_string(storage_status.recycled_segments)},
+      {"recovery_analysed_logs", std::to_string(status.analysed_logs)},
+      {"recovery_redo_logs", std::to_string(status.redo_logs)},
+      {"recovery_redo_applied", std::to_string(status.redo_applied)},
+      {"recovery_workers", std::to_string(status.redo_workers)},
+      {"recovery_undo_pending", std::to_string(status.undo_pending_txns)},
+      {"clr_logs", std::to_string(status.clr_logs)},
+      {"recovery_ms", std::to_string(recovery_ms_)},
+      {"checkpoints", std::to_string(status.checkpoints)},
+      {"checkpoint_begin_lsn", std::to_string(status.checkpoint_begin_lsn)},
+      {"checkpoint_lsn", status.checkpoint_lsn == NULL_LSN ? "-" : std::to_string(status.checkpoint_lsn)},
+      {"checkpoint_wal_bytes", std::to_string(status.checkpoint_wal_bytes)},
+      {"truncate_lsn", std::to_string(status.truncate_lsn)},
+      {"redo_start_lsn", status.redo_start_lsn == NULL_LSN ? "-" : std::to_string(status.redo_start_lsn)}};
+  RecordList records;
+  for (const auto &item : items) {
+    Record *record = new Record();
+    record->PushBack(new StrField(item.first.c_str(), item.first.size()));
+    record->PushBack(new StrField(item.second.c_str(), item.second.size()));
+    records.push_back(record);
+  }
+  return Result(std::vector<std::string>{"Name", "Value"}, records);
+}
+
+Result SystemManager::ShowTableStatus() {
+  UsingTest();
+  std::lock_guard<std::mutex> tables_lock(tables_mutex_);
+  std::vector<std::string> table_names;
+  for (const auto &table : tables_) table_names.push_back(table.first);
+  std::sort(table_names.begin(), table_names.end());
+  RecordList records;
+  for (const auto &table_name : table_names) {
+    Table *table = tables_[table_name];
+    VacuumStats stats = table->GetVacuumStats();
+    ZoneStats zone_stats = table->GetZoneStats();
+    double dead_ratio = stats.tuples == 0 ? 0 : (double)stats.dead_tuples / stats.tuples;
+    // 压缩比为页面大小之和与页面镜像实际占用的字节数之比
+    FileSpace space = disk_manager_.GetFileSpace(table2datafd_[table_name]);
+    size_t logical_bytes = disk_manager_.FileSize(table2datafd_[table_name]);
+    double compress_ratio = space.stored_bytes == 0 ? 1 : (double)logical_bytes / space.stored_bytes;
+    std::string compression = space.compressed ? "lz4" : "off";
+    Record *record = new Record();
+    record->PushBack(new StrField(table_name.c_str(), table_name.size()));
+    record->PushBack(new IntField(table->GetMeta().GetTableEnd()));
+    record->PushBack(new IntField(stats.tuples));
+    record->PushBack(new IntField(stats.dead_tuples));
+    record->PushBack(new FloatField(dead_ratio));
+    record->PushBack(new IntField(stats.vacuums));
+    record->PushBack(new IntField(stats.reclaimed));
+    record->PushBack(new IntField(zone_stats.known_pages));
+    record->PushBack(new IntField(zone_stats.skipped_pages));
+    record->PushBack(new StrField(compression.c_str(), compression.size()));
+    record->PushBack(new IntField(space.disk_bytes));
+    record->PushBack(new FloatField(compress_ratio));
+    records.push_back(record);
+  }
+  return Result(std::vector<std::string>{"Table", "Pages", "Tuples", "DeadTuples", "DeadRatio", "Vacuums", "Reclaimed",
+                                         "ZonePages", "SkippedPages", "Compression", "DiskBytes", "CompressRatio"},
+                records);
+}
+
+Result SystemManager::Vacuum(const std::string &table_name) {
+  UsingTest();
+  WritableTest();
+  // 清理使用单独的事务，事务中执行时该事务本身也会阻止清理
+  if (TxManager::GetInstance().Get(std::this_thread::get_id()) != INVALID_XID) throw VacuumInTransactionError();
+  std::lock_guard<std::mutex> tables_lock(tables_mutex_);
+  std::vector<std::string> table_names;
+  if (table_name.empty()) {
+    for (const auto &table : tables_) table_names.push_back(table.first);
+    std::sort(table_names.begin(), table_names.end());
+  } else {
+    GetTable(table_name);
+    table_names.push_back(table_name);
+  }
+  RecordList records;
+  for (const auto &name : table_names) {
+    VacuumResult result = VacuumTable(tables_[name]);
+    Record *record = new Record();
+    record->PushBack(new StrField(name.c_str(), name.size()));
+    record->PushBack(new IntField(result.pages));
+    record->PushBack(new IntField(result.reclaimed));
+    record->PushBack(new IntField(result.tuples));
+    record->PushBack(new IntField(result.dead_tuples));
+    records.push_back(record);
+  }
+  return Result(std::vector<std::string>{"Table", "Pages", "Reclaimed", "Tuples", "DeadTuples"}, records);
+}
+
+VacuumResult SystemManager::VacuumTable(Table *table) {
+  // 释放记录的日志只重做不回滚，清理事务失败时已释放的记录保持释放
+  TxManager &tx_manager = TxManager::GetInstance();
+  TID tid = std::this_thread::get_id();
+  XID xid = tx_manager.Push(tid);
+  log_manager_.Begin(xid);
+  VacuumResult result;
+  try {
+    result = table->Vacuum(xid, tx_manager.GetOldestXID());
+  } catch (...) {
+    log_manager_.Abort(xid);
+    tx_manager.Pop(tid);
+    throw;
+  }
+  log_manager_.Commit(xid);
+  tx_manager.Pop(tid);
+  return result;
+}
+
+void SystemManager::StartAutovacuum() {
+  if (!autovacuum_ || autovacuumer_.joinable()) return;
+  autovacuum_stop_ = false;
+  autovacuumer_ = std::thread(&SystemManager::AutovacuumLoop, this);
+}
+
+void SystemManager::StopAutovacuum() {
+  if (!autovacuumer_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> autovacuum_lock(autovacuum_mutex_);
+    autovacuum_stop_ = true;
+  }
+  autovacuum_cv_.notify_all();
+  autovacuumer_.join();
+}
+
+void SystemManager::AutovacuumLoop() {
+  std::unique_lock<std::mutex> autovacuum_lock(autovacuum_mutex_);
+  while (!autovacuum_stop_) {
+    autovacuum_cv_.wait_for(autovacuum_lock, std::chrono::milliseconds(autovacuum_naptime_ms_),
+                            [this] { return autovacuum_stop_.load(); });
+    if (autovacuum_stop_) break;
+    autovacuum_lock.unlock();
+    {
+      std::lock_guard<std::mutex> tables_lock(tables_mutex_);
+      for (const auto &table : tables_) {
+        if (autovacuum_stop_) break;
+        VacuumStats stats = table.second->GetVacuumStats();
+        if (stats.dead_tuples <= autovacuum_threshold_ + stats.tuples * autovacuum_scale_ / 100) continue;
+        try {
+          VacuumTable(table.second);
+        } catch (DbError &e) {
+          std::cerr << "SystemManager: autovacuum of " << table.first << " failed\n";
+        }
+      }
+    }
+    autovacuum_lock.lock();
+  }
+}
+
 Result SystemManager::DropTable(const std::string &table_name) {
   if (using_db_.empty()) {
     throw NoUsingDatabaseError();
   }
+  WritableTest();
   if (tables_.find(table_name) == tables_.end()) {
     throw TableNotExistsError(table_name);
   }
+  // 后台回滚通过表编号访问表
+  log_manager_.WaitUndo();
+  std::lock_guard<std::mutex> tables_lock(tables_mutex_);
+  for (Index *index : tables_[table_name]->GetIndexes()) RemoveIndex(index->GetName());
+  id2table_.erase(tables_[table_name]->GetID());
   delete tables_[table_name];
   disk_manager_.CloseFile(table2metafd_[table_name]);
   disk_manager_.CloseFile(table2datafd_[table_name]);
   // 反向映射
-  fd2table_.erase(table2datafd_[table_name]);
-  fd2table_.erase(table2metafd_[table_name]);
+  {
+    std::lock_guard<std::mutex> fd_lock(fd_mutex_);
+    fd2table_.erase(table2datafd_[table_name]);
+  }
 
   disk_manager_.DeleteFile(table_name + DB_META_SUFFIX);
   disk_manager_.DeleteFile(table_name + DB_DATA_SUFFIX);
@@ -240,6 +686,129 @@ Result SystemManager::DropTable(const std::string &table_name) {
   return Result(std::vector<std::string>{"SUCCESS"});
 }
 
+Result SystemManager::CreateIndex(const std::string &index_name, const std::string &table_name,
+                                  const std::string &col_name, const std::string &index_type) {
+  UsingTest();
+  WritableTest();
+  if (indexes_.find(index_name) != indexes_.end()) {
+    throw IndexExistsError(index_name);
+  }
+  std::string type_name = index_type;
+  std::transform(type_name.begin(), type_name.end(), type_name.begin(), ::tolower);
+  IndexType type = IndexType::BTREE;
+  if (type_name == "hash") {
+    type = IndexType::HASH;
+  } else if (!type_name.empty() && type_name != "btree") {
+    throw InvalidIndexTypeError(index_type);
+  }
+  Table *table = GetTable(table_name);
+  int col_idx = table->GetColumnIdx(col_name);
+  FieldType key_type = table->GetColumnType(col_idx);
+  if (key_type != FieldType::INT && key_type != FieldType::FLOAT && key_type != FieldType::STRING) {
+    throw InvalidIndexColumnError(col_name, type2str[key_type]);
+  }
+  log_manager_.WaitUndo();
+
+  disk_manager_.CreateFile(index_name + DB_INDEX_SUFFIX);
+  int fd = disk_manager_.OpenFile(index_name + DB_INDEX_SUFFIX);
+  index2fd_[index_name] = fd;
+  Index *index = IndexFactory::NewIndex(index_name, fd, type, AllocTableID(), table->GetID(), col_idx, key_type,
+                                        table->GetColumnLen(col_idx));
+  {
+    std::lock_guard<std::mutex> tables_lock(tables_mutex_);
+    indexes_[index_name] = index;
+    id2index_[index->GetID()] = index;
+  }
+  {
+    std::lock_guard<std::mutex> fd_lock(fd_mutex_);
+    fd2table_[fd] = index->GetID();
+  }
+  // 先加入表，之后插入的记录同时写入索引，再写入已有的记录
+  table->AddIndex(index);
+  // 不在事务中时使用单独的事务
+  TxManager &tx_manager = TxManager::GetInstance();
+  TID tid = std::this_thread::get_id();
+  XID xid = tx_manager.Get(tid);
+  bool own_tx = xid == INVALID_XID;
+  if (own_tx) {
+    xid = tx_manager.Push(tid);
+    log_manager_.Begin(xid);
+  }
+  try {
+    table->BuildIndex(index, xid);
+    index->SetValid(xid);
+  } catch (...) {
+    if (own_tx) {
+      log_manager_.Abort(xid);
+      tx_manager.Pop(tid);
+    }
+    std::lock_guard<std::mutex> tables_lock(tables_mutex_);
+    RemoveIndex(index_name);
+    throw;
+  }
+  if (own_tx) {
+    log_manager_.Commit(xid);
+    tx_manager.Pop(tid);
+  }
+  return Result(std::vector<std::string>{"SUCCESS"});
+}
+
+Result SystemManager::DropIndex(const std::string &index_name) {
+  UsingTest();
+  WritableTest();
+  if (indexes_.find(index_name) == indexes_.end()) {
+    throw IndexNotExistsError(index_name);
+  }
+  // 后台回滚不访问索引，恢复时已删除索引的页面不再重做
+  std::lock_guard<std::mutex> tables_lock(tables_mutex_);
+  RemoveIndex(index_name);
+  return Result(std::vector<std::string>{"SUCCESS"});
+}
+
+void SystemManager::RemoveIndex(const std::string &index_name) {
+  Index *index = indexes_[index_name];
+  GetTable(index->GetTableID())->RemoveIndex(index);
+  id2index_.erase(index->GetID());
+  indexes_.erase(index_name);
+  delete index;
+  disk_manager_.CloseFile(index2fd_[index_name]);
+  {
+    std::lock_guard<std::mutex> fd_lock(fd_mutex_);
+    fd2table_.erase(index2fd_[index_name]);
+  }
+  disk_manager_.DeleteFile(index_name + DB_INDEX_SUFFIX);
+  index2fd_.erase(index_name);
+}
+
+Result SystemManager::ShowIndexes() {
+  UsingTest();
+  std::lock_guard<std::mutex> tables_lock(tables_mutex_);
+  std::vector<std::string> index_names;
+  for (const auto &index : indexes_) index_names.push_back(index.first);
+  std::sort(index_names.begin(), index_names.end());
+  RecordList records;
+  for (const auto &index_name : index_names) {
+    Index *index = indexes_[index_name];
+    Table *table = GetTable(index->GetTableID());
+    std::string table_name = table->GetName();
+    std::string col_name = table->GetColumnNames()[index->GetColumn()];
+    IndexStats stats = index->GetStats();
+    std::string type = index->GetType() == IndexType::HASH ? "HASH" : "BTREE";
+    Record *record = new Record();
+    record->PushBack(new StrField(index_name.c_str(), index_name.size()));
+    record->PushBack(new StrField(type.c_str(), type.size()));
+    record->PushBack(new StrField(table_name.c_str(), table_name.size()));
+    record->PushBack(new StrField(col_name.c_str(), col_name.size()));
+    record->PushBack(new IntField(stats.pages));
+    record->PushBack(new IntField(stats.height));
+    record->PushBack(new IntField(stats.entries));
+    record->PushBack(new StrField(stats.valid ? "YES" : "NO", stats.valid ? 3 : 2));
+    records.push_back(record);
+  }
+  return Result(std::vector<std::string>{"Index", "Type", "Table", "Column", "Pages", "Height", "Entries", "Valid"},
+                records);
+}
+
 void SystemManager::Analyze() {
   if (using_db_.empty()) {
     throw NoUsingDatabaseError();
@@ -265,12 +834,26 @@ void SystemManager::Recover() {
   std::cerr << "< ---------- SystemManager::Recover ------------ >\n";
   // TIPS: Recover算法
   LSN checkpoint_lsn = LoadMasterRecord();
+  auto start = std::chrono::steady_clock::now();
+  // 恢复期间暂停后台写回
+  BufferManager::GetInstance().PauseWriter();
   // Analyse过程
   log_manager_.Analyse(checkpoint_lsn);
+  auto redo_start = std::chrono::steady_clock::now();
   // Redo过程
   log_manager_.Redo();
-  // Undo过程
+  auto redo_end = std::chrono::steady_clock::now();
+  BufferManager::GetInstance().ResumeWriter();
+  // Undo过程，未完成的事务在后台回滚，此时即可接受新事务
   log_manager_.Undo();
+  auto end = std::chrono::steady_clock::now();
+  recovery_ms_ = std::chrono::duration<double, std::milli>(end - start).count();
+  double redo_ms = std::chrono::duration<double, std::milli>(redo_end - redo_start).count();
+  LogStatus status = log_manager_.GetStatus();
+  std::cerr << "Recovery: analysed " << status.analysed_logs << " logs, redo " << status.redo_applied << "/"
+            << status.redo_logs << " logs with " << status.redo_workers << " workers in " << redo_ms << " ms ("
+            << (redo_ms > 0 ? status.redo_logs * 1000 / redo_ms : 0) << " logs/s), total " << recovery_ms_ << " ms"
+            << std::endl;
 }
 
 void SystemManager::LoadLogManager() {
@@ -279,20 +862,23 @@ void SystemManager::LoadLogManager() {
     throw NoUsingDatabaseError();
   }
   std::cerr << "< ----- 6 ----- >\n";
-  log_data_fd_ = disk_manager_.OpenFile(LOG_DATA);
-  log_index_fd_ = disk_manager_.OpenFile(LOG_INDEX);
+  ConfigManager &config = ConfigManager::GetInstance();
+  int recycle_segments = config.GetInt("wal-recycle-segments", 2);
+  if (recycle_segments < 0) throw InvalidConfigError("wal-recycle-segments", std::to_string(recycle_segments));
+  log_storage_ = new LogStorage(config.GetSize("wal-segment-size", 16 * 1024 * 1024), recycle_segments,
+                                config.GetBool("wal-archive", false));
+  // MASTER 在数据库打开期间保持打开，后台检查点线程直接写入
+  master_fd_ = disk_manager_.OpenFile(MASTER_RECORD);
   LSN checkpoint_lsn = LoadMasterRecord();
   std::cerr << "< ----- 7 ----- >\n";
   std::cerr << "ckpt: " << checkpoint_lsn << "\n";
-  if (checkpoint_lsn != 0) {
-    // Load Stored Checkpoint Log
-    Log *log = ReadLog(checkpoint_lsn);
-    assert(log->GetLSN() == checkpoint_lsn);
-    delete log;
-  } else {
-    log_manager_.Init();
-  }
+  // 检查点记录的 ATT 与 DPT 在分析阶段载入
+  log_manager_.Init();
   Recover();
+  if (!read_only_) {
+    log_manager_.StartCheckpointer();
+    StartAutovacuum();
+  }
 }
 
 void SystemManager::StoreLogManager() {
@@ -302,39 +888,16 @@ void SystemManager::StoreLogManager() {
   log_manager_.Checkpoint();
 }
 
-void SystemManager::WriteLog(Log *log) {
-  size_t log_len = log->GetLength();
-  Byte *raw_data = new Byte[log_len];
-  LogFactory::StoreLog(raw_data, log);
-  disk_manager_.AppendRaw(log_data_fd_, raw_data, log_len);
-  disk_manager_.FlushFile(log_data_fd_);
-  size_t fsize = disk_manager_.FileSize(LOG_DATA);
-  disk_manager_.AppendRaw(log_index_fd_, (Byte *)&fsize, sizeof(size_t));
-  disk_manager_.FlushFile(log_index_fd_);
-  delete[] raw_data;
-}
-
-Log *SystemManager::ReadLog(LSN lsn) {
-  size_t lsn_max = disk_manager_.FileSize(LOG_INDEX) / sizeof(size_t);
-  size_t lsn_idx = lsn - INIT_LSN;
-  if (lsn_idx >= lsn_max) return nullptr;
-  size_t lsn_offset = 0, lsn_size = 0;
-  if (lsn_idx == 0) {
-    lsn_offset = 0;
-    lsn_size = disk_manager_.ReadIndex(log_index_fd_, lsn_idx);
-  } else {
-    lsn_offset = disk_manager_.ReadIndex(log_index_fd_, lsn_idx - 1);
-    lsn_size = disk_manager_.ReadIndex(log_index_fd_, lsn_idx) - lsn_offset;
-  }
-  Byte *raw_data = new Byte[lsn_size];
-  disk_manager_.ReadRaw(log_data_fd_, raw_data, lsn_size, lsn_offset);
-  std::cerr << "< ----- 8 ----- >\n";
-  Log *log = LogFactory::LoadLog(raw_data);
-  std::cerr << "< ----- 9 ----- >\n";
-  delete[] raw_data;
-  return log;
+void SystemManager::WriteLog(LSN first_lsn, const Byte *data, const std::vector<size_t> &lengths) {
+  log_storage_->Append(first_lsn, data, lengths);
 }
 
+Log *SystemManager::ReadLog(LSN lsn) { return log_storage_->Read(lsn); }
+
+LogReader SystemManager::ScanLog(LSN lsn) { return log_storage_->Scan(lsn); }
+
+void SystemManager::TruncateLog(LSN lsn) { log_storage_->Truncate(lsn); }
+
 void SystemManager::InitLog(const string &db_name) {
   // 切换目录
   std::string directory;
@@ -343,14 +906,14 @@ void SystemManager::InitLog(const string &db_name) {
   } else {
     directory = db_name + "/";
   }
-  // 创建Log文件
-  disk_manager_.CreateFile(directory + LOG_INDEX);
-  disk_manager_.CreateFile(directory + LOG_DATA);
+  // 日志段在第一次写入日志时创建
   // 初始化MASTER RECORD
   disk_manager_.CreateFile(directory + MASTER_RECORD);
   int master_fd = disk_manager_.OpenFile(directory + MASTER_RECORD);
   const LSN init_lsn = 0;
   disk_manager_.WriteRaw(master_fd, (Byte *)&init_lsn, sizeof(LSN));
+  const TableID init_table_id = INVALID_TABLE_ID + 1;
+  disk_manager_.WriteRaw(master_fd, (Byte *)&init_table_id, sizeof(TableID), sizeof(LSN));
   disk_manager_.CloseFile(master_fd);
 }
 
@@ -374,16 +937,26 @@ std::string SystemManager::GetTableByColumn(const std::string &col_name, const s
   return table_name_of_col;
 }
 
-std::string SystemManager::GetTableByFd(int fd) { return fd2table_[fd]; }
+TableID SystemManager::GetTableIDByFd(int fd) {
+  // 后台写回线程也会调用
+  std::lock_guard<std::mutex> fd_lock(fd_mutex_);
+  auto iter = fd2table_.find(fd);
+  return iter == fd2table_.end() ? INVALID_TABLE_ID : iter->second;
+}
 
-void SystemManager::StoreMasterRecord() {
+Index *SystemManager::GetIndex(TableID index_id) {
+  auto index = id2index_.find(index_id);
+  return index == id2index_.end() ? nullptr : index->second;
+}
+
+bool SystemManager::Exists(TableID id) { return id2table_.count(id) > 0 || id2index_.count(id) > 0; }
+
+void SystemManager::StoreMasterRecord(LSN checkpoint_lsn) {
   if (using_db_.empty()) {
     throw NoUsingDatabaseError();
   }
-  int master_fd = disk_manager_.OpenFile(MASTER_RECORD);
-  LSN current_lsn = log_manager_.GetCurrent();
-  disk_manager_.WriteRaw(master_fd, (Byte *)&current_lsn, sizeof(LSN));
-  disk_manager_.CloseFile(master_fd);
+  disk_manager_.WriteRaw(master_fd_, (Byte *)&checkpoint_lsn, sizeof(LSN));
+  disk_manager_.FlushFiles({master_fd_});
 }
 
 LSN SystemManager::LoadMasterRecord() {
@@ -391,10 +964,21 @@ LSN SystemManager::LoadMasterRecord() {
     throw NoUsingDatabaseError();
   }
   LSN checkpoint_lsn = 0;
-  int master_fd = disk_manager_.OpenFile(MASTER_RECORD);
-  disk_manager_.ReadRaw(master_fd, (Byte *)&checkpoint_lsn, sizeof(LSN));
-  disk_manager_.CloseFile(master_fd);
+  disk_manager_.ReadRaw(master_fd_, (Byte *)&checkpoint_lsn, sizeof(LSN));
+  if (disk_manager_.FileSize(master_fd_) >= sizeof(LSN) + sizeof(TableID)) {
+    TableID next_table_id = INVALID_TABLE_ID + 1;
+    disk_manager_.ReadRaw(master_fd_, (Byte *)&next_table_id, sizeof(TableID), sizeof(LSN));
+    next_table_id_ = std::max(next_table_id_, next_table_id);
+  }
   return checkpoint_lsn;
 }
 
+TableID SystemManager::AllocTableID() {
+  TableID table_id = next_table_id_++;
+  TableID next_table_id = next_table_id_;
+  disk_manager_.WriteRaw(master_fd_, (Byte *)&next_table_id, sizeof(TableID), sizeof(LSN));
+  disk_manager_.FlushFiles({master_fd_});
+  return table_id;
+}
+
 }  // namespace dbtrain
@@ -1,10 +1,17 @@
 #ifndef DBTRAIN_SYSTEMMANAGER_H
 #define DBTRAIN_SYSTEMMANAGER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
+#include "../index/index.h"
 #include "../log/log_manager.h"
+#include "../log/log_storage.h"
 #include "../oper/conditions/conditions.h"
 #include "../result/result.h"
 #include "../storage/disk_manager.h"
@@ -24,27 +31,58 @@ class SystemManager {
   Result DropDatabase(const std::string &db_name, bool if_exists);
   void CloseDatabase();
   void CloseDatabase(const std::string &db_name);
+  // 校验数据库中所有表文件的页面，db_name 为空时校验所有数据库，corrupted_pages 为未通过校验的页面数
+  Result VerifyDatabase(const std::string &db_name, size_t &corrupted_pages);
 
-  Result CreateTable(const std::string &table_name, const std::vector<Column> &columns);
+  // options 为 CREATE TABLE ... WITH (key = value, ...) 中的表选项，目前支持 layout
+  Result CreateTable(const std::string &table_name, const std::vector<Column> &columns,
+                     const std::map<std::string, std::string> &options = {});
   Result DropTable(const std::string &table_name);
   Result ShowTables();
   Result DescTable(const std::string &table_name);
+  // 在表的一列上建立索引，建立期间的插入同时写入索引，在事务中执行时使用该事务记录日志
+  // index_type 为 btree 或 hash，为空时使用 B+ 树
+  Result CreateIndex(const std::string &index_name, const std::string &table_name, const std::string &col_name,
+                     const std::string &index_type = "");
+  Result DropIndex(const std::string &index_name);
+  // 每个索引的类型、所在的表与列、页面数、层数与项数
+  Result ShowIndexes();
+
+  Result ShowBufferStatus();
+  Result ShowLogStatus();
+  // 每张表的记录数、已删除记录的比例与清理次数，以及页面摘要已知的页面数与扫描跳过的页面数
+  Result ShowTableStatus();
+  // 清理指定表中对所有事务都不可见的记录，table_name 为空时清理所有表，不能在事务中执行
+  Result Vacuum(const std::string &table_name);
 
   void LoadLogManager();
   void StoreLogManager();
-  void WriteLog(Log *log);
+  // 追加一批 LSN 从 first_lsn 开始连续的日志，lengths 为每条日志的长度
+  void WriteLog(LSN first_lsn, const Byte *data, const std::vector<size_t> &lengths);
   Log *ReadLog(LSN lsn);
+  // 从 lsn 开始顺序读取日志
+  LogReader ScanLog(LSN lsn);
+  // 移除 LSN 均小于 lsn 的日志段
+  void TruncateLog(LSN lsn);
   void Crash();
   void Flush();
   void Recover();
-  void StoreMasterRecord();
+  // MASTER 记录最近一次完成的检查点结束日志的 LSN
+  void StoreMasterRecord(LSN checkpoint_lsn);
   void UsingTest();
   void Analyze();
 
  public:
   Table *GetTable(const std::string &table_name);
+  // 日志中的表以编号表示
+  Table *GetTable(TableID table_id);
   std::string GetTableByColumn(const std::string &col_name, const std::vector<std::string> &table_names);
-  std::string GetTableByFd(int fd);
+  // 数据文件对应的表编号，不是数据文件时返回 INVALID_TABLE_ID
+  TableID GetTableIDByFd(int fd);
+  // 日志中的索引与表共用编号，不是索引时返回空
+  Index *GetIndex(TableID index_id);
+  // 编号对应的表或索引是否存在
+  bool Exists(TableID id);
 
  private:
   SystemManager();
@@ -55,12 +93,50 @@ class SystemManager {
   std::unordered_map<std::string, Table *> tables_;
   std::unordered_map<std::string, int> table2datafd_;
   std::unordered_map<std::string, int> table2metafd_;
-  std::unordered_map<int, std::string> fd2table_;
-  int log_index_fd_;
-  int log_data_fd_;
+  std::unordered_map<TableID, Table *> id2table_;
+  std::unordered_map<std::string, Index *> indexes_;
+  std::unordered_map<std::string, int> index2fd_;
+  std::unordered_map<TableID, Index *> id2index_;
+  // 下一个新建表或索引的编号，保存在 MASTER 中检查点 LSN 之后，已删除的表与索引的编号不再使用
+  // 没有保存编号的旧数据库打开时为已有表与索引的最大编号加一
+  TableID next_table_id_;
+  // 数据文件与索引文件到编号的反向映射
+  std::unordered_map<int, TableID> fd2table_;
+  std::mutex fd_mutex_;
+  LogStorage *log_storage_;
+  int master_fd_;
+  // 最近一次恢复的耗时
+  double recovery_ms_;
+  // read-only 参数打开时数据库只读，恢复完成后表数据通过内存映射访问
+  bool read_only_;
+
+  // 保护 tables_ 的修改，后台清理线程遍历表时持有
+  std::mutex tables_mutex_;
+  // autovacuum 参数打开时，后台线程每隔 autovacuum-naptime 毫秒检查各表，
+  // 已删除的记录数超过 autovacuum-threshold 加上记录数的 autovacuum-scale% 时清理该表
+  bool autovacuum_;
+  int autovacuum_naptime_ms_;
+  size_t autovacuum_threshold_;
+  size_t autovacuum_scale_;
+  std::thread autovacuumer_;
+  std::mutex autovacuum_mutex_;
+  std::condition_variable autovacuum_cv_;
+  std::atomic<bool> autovacuum_stop_;
 
   void InitLog(const std::string &db_name);
+  void WritableTest();
+  // 同时读入 MASTER 中保存的下一个表与索引编号
   LSN LoadMasterRecord();
+  // 分配新建表或索引的编号，下一个编号落盘后才返回，日志中已删除的表的记录不会作用到之后新建的表上
+  TableID AllocTableID();
+  // 清理作为一个单独的事务执行
+  VacuumResult VacuumTable(Table *table);
+  // 打开数据库完成恢复后启动后台清理线程，关闭或崩溃前停止
+  void StartAutovacuum();
+  // 从表上移除索引并删除索引文件，调用者持有 tables_mutex_
+  void RemoveIndex(const std::string &index_name);
+  void StopAutovacuum();
+  void AutovacuumLoop();
 };
 
 }  // namespace dbtrain
@@ -0,0 +1,138 @@
+#include "free_space_map.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../storage/disk_manager.h"
+
+namespace dbtrain {
+
+FreeSpaceMap::FreeSpaceMap(int meta_fd) : meta_fd_(meta_fd), buffer_manager_(BufferManager::GetInstance()) {}
+
+uint8_t FreeSpaceMap::Category(size_t free_space) {
+  return (uint8_t)std::min((free_space + FSM_UNIT - 1) / FSM_UNIT, FSM_CATEGORIES - 1);
+}
+
+void FreeSpaceMap::Load(PageID page_count) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  file_pages_ = std::max<PageID>(FSM_FIRST_PAGE, DiskManager::GetInstance().FileSize(meta_fd_) / PAGE_SIZE);
+  categories_.assign(page_count, 0);
+  claimed_.assign(page_count, false);
+  pos_.assign(page_count, 0);
+  for (auto &bucket : buckets_) bucket.clear();
+  // 映射页不存在的部分记为没有空闲空间
+  for (PageID first = 0; first < page_count; first += FSM_ENTRIES_PER_PAGE) {
+    PageID map_page = FSM_FIRST_PAGE + first / FSM_ENTRIES_PER_PAGE;
+    if (map_page >= file_pages_) break;
+    PageGuard page = buffer_manager_.GetPage(meta_fd_, map_page);
+    size_t count = std::min<size_t>(FSM_ENTRIES_PER_PAGE, page_count - first);
+    memcpy(categories_.data() + first, page->GetData() + PAGE_CHECKSUM_SIZE, count);
+  }
+  for (PageID page_no = 0; page_no < page_count; page_no++) Push(page_no);
+}
+
+void FreeSpaceMap::Store() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (dirty_pages_.empty()) return;
+  // 文件中不能留下空洞，之前的映射页一并写入
+  for (PageID map_page = file_pages_; map_page < *dirty_pages_.rbegin(); map_page++) dirty_pages_.insert(map_page);
+  for (PageID map_page : dirty_pages_) {
+    PageGuard page = map_page < file_pages_ ? buffer_manager_.GetPage(meta_fd_, map_page)
+                                             : buffer_manager_.AllocPage(meta_fd_, map_page);
+    PageID first = (map_page - FSM_FIRST_PAGE) * FSM_ENTRIES_PER_PAGE;
+    size_t count = std::min<size_t>(FSM_ENTRIES_PER_PAGE, categories_.size() - first);
+    page->WLatch();
+    memset(page->GetData() + PAGE_CHECKSUM_SIZE, 0, FSM_ENTRIES_PER_PAGE);
+    memcpy(page->GetData() + PAGE_CHECKSUM_SIZE, categories_.data() + first, count);
+    page->SetDirty();
+    page->WUnlatch();
+    file_pages_ = std::max(file_pages_, map_page + 1);
+  }
+  dirty_pages_.clear();
+}
+
+PageID FreeSpaceMap::Claim(size_t length) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t category = Category(length); category < FSM_CATEGORIES; category++) {
+    if (buckets_[category].empty()) continue;
+    // 取桶中最后放入的页面，连续的插入倾向于继续使用刚释放的页面
+    PageID page_no = buckets_[category].back();
+    Remove(page_no);
+    claimed_[page_no] = true;
+    return page_no;
+  }
+  return NULL_PAGE;
+}
+
+bool FreeSpaceMap::Claim(PageID page_no) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (page_no >= (PageID)claimed_.size() || claimed_[page_no]) return false;
+  Remove(page_no);
+  claimed_[page_no] = true;
+  return true;
+}
+
+void FreeSpaceMap::Extend(PageID page_no) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (page_no >= (PageID)categories_.size()) {
+    categories_.resize(page_no + 1, 0);
+    claimed_.resize(page_no + 1, false);
+    pos_.resize(page_no + 1, 0);
+  } else if (!claimed_[page_no]) {
+    Remove(page_no);
+  }
+  claimed_[page_no] = true;
+}
+
+void FreeSpaceMap::Grow(PageID page_end) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  PageID old_end = categories_.size();
+  if (page_end <= old_end) return;
+  categories_.resize(page_end, 0);
+  claimed_.resize(page_end, false);
+  pos_.resize(page_end, 0);
+  for (PageID page_no = old_end; page_no < page_end; page_no++) Push(page_no);
+}
+
+void FreeSpaceMap::Release(PageID page_no, size_t free_space) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!claimed_[page_no]) Remove(page_no);
+  claimed_[page_no] = false;
+  Set(page_no, Category(free_space));
+  Push(page_no);
+}
+
+void FreeSpaceMap::Update(PageID page_no, size_t free_space) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (page_no >= (PageID)categories_.size()) return;
+  if (claimed_[page_no]) {
+    Set(page_no, Category(free_space));
+    return;
+  }
+  Remove(page_no);
+  Set(page_no, Category(free_space));
+  Push(page_no);
+}
+
+void FreeSpaceMap::Set(PageID page_no, uint8_t category) {
+  if (categories_[page_no] == category) return;
+  categories_[page_no] = category;
+  dirty_pages_.insert(FSM_FIRST_PAGE + page_no / FSM_ENTRIES_PER_PAGE);
+}
+
+void FreeSpaceMap::Push(PageID page_no) {
+  std::vector<PageID> &bucket = buckets_[categories_[page_no]];
+  pos_[page_no] = bucket.size();
+  bucket.push_back(page_no);
+}
+
+void FreeSpaceMap::Remove(PageID page_no) {
+  // 与桶中最后一个页面交换后删除
+  std::vector<PageID> &bucket = buckets_[categories_[page_no]];
+  PageID last = bucket.back();
+  bucket[pos_[page_no]] = last;
+  pos_[last] = pos_[page_no];
+  bucket.pop_back();
+}
+
+}  // namespace dbtrain
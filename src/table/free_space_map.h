@@ -0,0 +1,67 @@
+#ifndef DBTRAIN_FREE_SPACE_MAP_H
+#define DBTRAIN_FREE_SPACE_MAP_H
+
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "../defines.h"
+#include "../storage/buffer_manager.h"
+
+namespace dbtrain {
+
+// 每个数据页的空闲空间用一个字节记录，单位为 FSM_UNIT 字节，向上取整
+static const size_t FSM_UNIT = PAGE_SIZE / 256;
+static const size_t FSM_CATEGORIES = 256;
+// 映射保存在元信息文件中元信息页之后，每页开头为页面校验值
+static const PageID FSM_FIRST_PAGE = META_PAGE_NO + 1;
+static const size_t FSM_ENTRIES_PER_PAGE = PAGE_SIZE - PAGE_CHECKSUM_SIZE;
+
+// 空闲空间映射：与元信息一样在写回元信息时写入，不记录日志，崩溃后可能过时，
+// 只作为选择页面的提示，使用者需要核对页面的实际空闲空间
+// 插入期间页面被占用，不会分配给其他插入，并发插入因此分散在不同页面上
+class FreeSpaceMap {
+ public:
+  explicit FreeSpaceMap(int meta_fd);
+
+  // 读取前 page_count 个数据页的记录
+  void Load(PageID page_count);
+  // 把修改过的映射页写入缓冲池
+  void Store();
+
+  // 占用一个空闲空间可能不少于 length 字节的页面，优先选择能放下的最满的页面，没有时返回 NULL_PAGE
+  PageID Claim(size_t length);
+  // 占用指定页面，已被占用或不在映射中时返回 false
+  bool Claim(PageID page_no);
+  // 新建的页面，由创建者占用
+  void Extend(PageID page_no);
+  // 扩展映射到 page_end 个页面，新增页面记为没有空闲空间
+  void Grow(PageID page_end);
+  // 结束占用并记录页面当前的空闲空间
+  void Release(PageID page_no, size_t free_space);
+  // 记录页面当前的空闲空间，页面被占用时只更新记录值
+  void Update(PageID page_no, size_t free_space);
+
+  static uint8_t Category(size_t free_space);
+
+ private:
+  void Set(PageID page_no, uint8_t category);
+  void Push(PageID page_no);
+  void Remove(PageID page_no);
+
+  int meta_fd_;
+  BufferManager &buffer_manager_;
+  std::mutex mutex_;
+  std::vector<uint8_t> categories_;
+  std::vector<bool> claimed_;
+  // 未被占用的页面按记录值分桶，pos_ 为页面在桶中的下标
+  std::vector<PageID> buckets_[FSM_CATEGORIES];
+  std::vector<size_t> pos_;
+  // 元信息文件中已经存在的页面数与需要写回的映射页
+  PageID file_pages_ = FSM_FIRST_PAGE;
+  std::set<PageID> dirty_pages_;
+};
+
+}  // namespace dbtrain
+
+#endif
@@ -1,28 +1,70 @@
 #include "page_handle.h"
 
+#include <algorithm>
 #include <cassert>
 #include <set>
 #include <iostream>
 
+#include "../exception/exceptions.h"
+#include "../record/fields.h"
 #include "../record/record_factory.h"
-#include "../tx/lock_manager.h"
+#include "../table/hidden.h"
+#include "../table/table.h"
 
 namespace dbtrain {
 
-PageHandle::PageHandle(Page *page, const TableMeta &meta)
-    : page_(page),
-      record_length_(meta.record_length_),
-      bitmap_(page->GetData() + sizeof(PageHeader), meta.record_per_page_),
-      meta_(meta) {
-  header_ = (PageHeader *)page->GetData();
-  slots_ = page->GetData() + sizeof(PageHeader) + meta.bitmap_length_;
+// 创建版本号与删除版本号为记录的最后两列
+static XID GetCreateXid(const uint8_t *raw, size_t length) {
+  XID xid;
+  memcpy(&xid, raw + length - CREATE_XID_OFFSET * sizeof(XID), sizeof(XID));
+  return xid;
+}
+
+static XID GetDeleteXid(const uint8_t *raw, size_t length) {
+  XID xid;
+  memcpy(&xid, raw + length - DELETE_XID_OFFSET * sizeof(XID), sizeof(XID));
+  return xid;
+}
+
+// 事务 xid 能否看到该版本，uncommit_xids 为 xid 开始时仍在运行的事务
+static bool IsVisible(XID create_xid, XID delete_xid, XID xid, const std::set<XID> &uncommit_xids) {
+  if (create_xid < delete_xid) { // 已删除
+    if (xid < delete_xid) { // 后事务删除，需要包含在内
+      return true;
+    }
+    //之前已经删除，看是否已提交
+    return uncommit_xids.find(delete_xid) != uncommit_xids.end();
+  } else if (create_xid > delete_xid) { // 新插入
+    if (xid < create_xid) { // 后事务插入，需要去除
+      return false;
+    }
+    //之前已经插入，看是否已提交
+    return uncommit_xids.find(create_xid) == uncommit_xids.end();
+  }
+  return false;
+}
+
+// 删除事务已经结束且早于所有正在运行的事务，插入与删除为同一事务时同样不可见
+static bool IsDead(XID create_xid, XID delete_xid, XID oldest_xid) {
+  return delete_xid != INVALID_XID && create_xid <= delete_xid && delete_xid < oldest_xid;
+}
+
+PageHandle::PageHandle(PageGuard page, const TableMeta &meta, Table *table)
+    : record_length_(meta.record_length_), page_(std::move(page)), meta_(meta), table_(table) {
+  header_ = (PageHeader *)page_->GetData();
+  if (Slotted()) {
+    slotted_ = (SlottedHeader *)(page_->GetData() + sizeof(PageHeader));
+    slot_dir_ = (SlotEntry *)(page_->GetData() + sizeof(PageHeader) + sizeof(SlottedHeader));
+    return;
+  }
+  bitmap_ = Bitmap(page_->GetData() + sizeof(PageHeader), meta.record_per_page_);
+  slots_ = page_->GetData() + sizeof(PageHeader) + meta.bitmap_length_;
 }
 
 void PageHandle::InsertRecord(Record *record) {
   std::cerr << "< ----------------- PageHandle::InsertRecord ---------------- >\n";
   // 获取排它锁
-  LockManager &lock_manager = LockManager::GetInstance();
-  lock_manager.Lock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WLatch();
   // TODO: 插入记录
   // LAB 1 BEGIN
   Rid rid = RecordFactory::GetRid(record);
@@ -30,24 +72,22 @@ void PageHandle::InsertRecord(Record *record) {
   // TIPS: 使用RecordFactory的StoreRecord方法将record序列化到页面中
   RecordFactory record_factory(&meta_);
   // bitmap_.Display();
-  record_factory.StoreRecord(slots_ + free_slot * record_length_, record);
+  StoreRow(free_slot, record_factory, record);
   // TIPS: 将bitmap_的第一个空槽标记为已使用
   bitmap_.Set(free_slot);
   // bitmap_.Display();
   // TIPS: 将page_标记为dirty
   page_->SetDirty();
   // LAB 1 END
-  // LAB 2: 设置页面LSN
-  SetLSN(LogManager::GetInstance().GetCurrent());
+  // LAB 2: 无并发接口不写日志，没有属于本次修改的 LSN，页面 LSN 保持不变
   // 释放排它锁
-  lock_manager.Unlock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WUnlatch();
 }
 
 void PageHandle::DeleteRecord(SlotID slot_no) {
   std::cerr << "< ----------------- PageHandle::DeleteRecord ---------------- >\n";
   // 获取排他锁
-  LockManager &lock_manager = LockManager::GetInstance();
-  lock_manager.Lock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WLatch();
   // TODO: 删除记录
   // TIPS: 直接设置bitmap_为0即可删除对应记录
   // TIPS: 将page_标记为dirty
@@ -57,123 +97,219 @@ void PageHandle::DeleteRecord(SlotID slot_no) {
   // bitmap_.Display();
   page_->SetDirty();
   // LAB 1 END
-  // LAB 2: 设置页面LSN
-  SetLSN(LogManager::GetInstance().GetCurrent());
+  // LAB 2: 无并发接口不写日志，没有属于本次修改的 LSN，页面 LSN 保持不变
   // 释放排他锁
-  lock_manager.Unlock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WUnlatch();
 }
 
 void PageHandle::UpdateRecord(SlotID slot_no, Record *record) {
   std::cerr << "< ----------------- PageHandle::UpdateRecord ---------------- >\n";
   // 获取排他锁
-  LockManager &lock_manager = LockManager::GetInstance();
-  lock_manager.Lock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WLatch();
   // TODO: 更新记录
   // TIPS: 由于使用了定长数据管理，可以利用新的record序列化结果覆盖对应页面数据
   // TIPS: 将page_标记为dirty
   // LAB 1 BEGIN
   RecordFactory record_factory(&meta_);
-  record_factory.StoreRecord(slots_ + slot_no * record_length_, record);
+  StoreRow(slot_no, record_factory, record);
   page_->SetDirty();
   // LAB 1 END
-  // 设置页面LSN
-  SetLSN(LogManager::GetInstance().GetCurrent());
+  // LAB 2: 无并发接口不写日志，没有属于本次修改的 LSN，页面 LSN 保持不变
   // 释放排他锁
-  lock_manager.Unlock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WUnlatch();
 }
 
 RecordList PageHandle::LoadRecords() {
   std::cerr << "< ----------------- PageHandle::LoadRecords ---------------- >\n";
+  if (Slotted()) return LoadSlottedRecords(false, INVALID_XID, {});
   // 获取共享锁
-  LockManager &lock_manager = LockManager::GetInstance();
-  lock_manager.LockShared("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->RLatch();
   int slot_no = -1;
   RecordFactory record_factory(&meta_);
   std::vector<Record *> record_vector;
+  std::vector<SlotID> used;
   while ((slot_no = bitmap_.NextNotFree(slot_no)) != -1) {
     std::cerr << "< ----------------- finding one slot not free ---------------- >\n";
     std::cerr << "free_slot: " << slot_no << "\n";
+    if (Pax()) {
+      used.push_back(slot_no);
+      continue;
+    }
     Record *record = record_factory.LoadRecord(slots_ + slot_no * record_length_);
     record_vector.push_back(record);
   }
+  if (Pax()) record_vector = LoadColumns(used, {});
 
   // 释放共享锁
-  lock_manager.UnlockShared("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->RUnlatch();
   return record_vector;
 }
 
-uint8_t *PageHandle::GetRaw(SlotID slot_no) { return slots_ + slot_no * record_length_; }
+uint8_t *PageHandle::GetRaw(SlotID slot_no) {
+  if (Slotted()) return page_->GetData() + slot_dir_[slot_no].offset;
+  return slots_ + slot_no * record_length_;
+}
+
+size_t PageHandle::GetLength(SlotID slot_no) {
+  if (Slotted()) return slot_no < slotted_->slot_count ? slot_dir_[slot_no].length : 0;
+  return record_length_;
+}
+
+std::vector<Byte> PageHandle::CopyRaw(SlotID slot_no) {
+  page_->RLatch();
+  std::vector<Byte> copy(GetLength(slot_no));
+  if (Slotted()) {
+    memcpy(copy.data(), GetRaw(slot_no), copy.size());
+  } else {
+    ReadRow(slot_no, 0, copy.size(), copy.data());
+  }
+  page_->RUnlatch();
+  return copy;
+}
 
 Record *PageHandle::GetRecord(SlotID slot_no) {
+  if (Slotted()) {
+    page_->RLatch();
+    std::vector<Byte> raw;
+    if (slot_no < slotted_->slot_count && slot_dir_[slot_no].offset != 0) {
+      raw.assign(GetRaw(slot_no), GetRaw(slot_no) + slot_dir_[slot_no].length);
+    }
+    page_->RUnlatch();
+    if (raw.empty() || raw[0] != (Byte)SlottedRecordType::TUPLE) return nullptr;
+    return LoadSlottedRecord(raw);
+  }
   // 获取共享锁
-  LockManager &lock_manager = LockManager::GetInstance();
-  lock_manager.LockShared("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->RLatch();
 
   if (bitmap_.Test(slot_no)) {
     RecordFactory record_factory(&meta_);
-    Record *record = record_factory.LoadRecord(slots_ + slot_no * record_length_);
+    std::vector<Byte> raw(record_length_);
+    ReadRow(slot_no, 0, record_length_, raw.data());
+    Record *record = record_factory.LoadRecord(raw.data());
     // 释放共享锁
-    lock_manager.UnlockShared("Page" + std::to_string(page_->GetPageId().page_no));
+    page_->RUnlatch();
     return record;
   } else {
     // 释放共享锁
-    lock_manager.UnlockShared("Page" + std::to_string(page_->GetPageId().page_no));
+    page_->RUnlatch();
     return nullptr;
   }
 }
 
-void PageHandle::InsertRecord(SlotID slot_no, const void *src, LSN lsn) {
+void PageHandle::InsertRecord(SlotID slot_no, const void *src, size_t length, LSN lsn) {
   // 获取排他锁
-  LockManager &lock_manager = LockManager::GetInstance();
-  lock_manager.Lock("Page" + std::to_string(page_->GetPageId().page_no));
-
-  bitmap_.Set(slot_no);
-  memcpy(slots_ + slot_no * record_length_, src, meta_.GetLength());
+  page_->WLatch();
+
+  if (Slotted()) {
+    if (slot_no < slotted_->slot_count && slot_dir_[slot_no].offset != 0) FreeSlot(slot_no);
+    try {
+      memcpy(AllocSlot(slot_no, length), src, length);
+    } catch (...) {
+      page_->WUnlatch();
+      throw;
+    }
+  } else {
+    bitmap_.Set(slot_no);
+    WriteRow(slot_no, 0, length, (const Byte *)src);
+  }
   page_->SetDirty();
   // 设置页面LSN
   SetLSN(lsn);
 
   // 释放排他锁
-  lock_manager.Unlock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WUnlatch();
 }
 
 void PageHandle::DeleteRecord(SlotID slot_no, LSN lsn) {
   // 获取排他锁
-  LockManager &lock_manager = LockManager::GetInstance();
-  lock_manager.Lock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WLatch();
 
-  bitmap_.Reset(slot_no);
+  if (Slotted()) {
+    FreeSlot(slot_no);
+  } else {
+    bitmap_.Reset(slot_no);
+  }
   page_->SetDirty();
   // 设置页面LSN
   SetLSN(lsn);
 
   // 释放排他锁
-  lock_manager.Unlock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WUnlatch();
 }
 
 void PageHandle::UpdateRecord(SlotID slot_no, const void *src, LSN lsn) {
   // 获取排他锁
-  LockManager &lock_manager = LockManager::GetInstance();
-  lock_manager.Lock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WLatch();
 
   assert(bitmap_.Test(slot_no));
-  memcpy(slots_ + slot_no * record_length_, src, meta_.GetLength());
+  WriteRow(slot_no, 0, meta_.GetLength(), (const Byte *)src);
   page_->SetDirty();
   // 设置页面LSN
   SetLSN(lsn);
 
   // 释放排他锁
-  lock_manager.Unlock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WUnlatch();
 }
 
-void PageHandle::InsertRecord(Record *record, XID xid) {
+void PageHandle::PatchRecord(SlotID slot_no, SlotID base_slot, const std::vector<ByteRange> &ranges, const Byte *data,
+                             bool used, LSN lsn) {
+  // 获取排他锁
+  page_->WLatch();
+
+  if (Slotted()) {
+    try {
+      if (base_slot != slot_no) {
+        // 新版本以 base_slot 中的记录为基础，二者长度相同
+        size_t length = slot_dir_[base_slot].length;
+        if (slot_no < slotted_->slot_count && slot_dir_[slot_no].offset != 0) FreeSlot(slot_no);
+        uint8_t *dst = AllocSlot(slot_no, length);
+        memcpy(dst, GetRaw(base_slot), length);
+      }
+      if (slot_no >= slotted_->slot_count || slot_dir_[slot_no].offset == 0) {
+        std::cerr << "Error in PageHandle::PatchRecord\n";
+        throw UnknownError();
+      }
+    } catch (...) {
+      page_->WUnlatch();
+      throw;
+    }
+    uint8_t *dst = GetRaw(slot_no);
+    for (const auto &range : ranges) {
+      memcpy(dst + range.offset, data, range.length);
+      data += range.length;
+    }
+    if (!used) FreeSlot(slot_no);
+  } else {
+    if (base_slot != slot_no) {
+      std::vector<Byte> base(record_length_);
+      ReadRow(base_slot, 0, record_length_, base.data());
+      WriteRow(slot_no, 0, record_length_, base.data());
+    }
+    for (const auto &range : ranges) {
+      WriteRow(slot_no, range.offset, range.length, data);
+      data += range.length;
+    }
+    if (used) {
+      bitmap_.Set(slot_no);
+    } else {
+      bitmap_.Reset(slot_no);
+    }
+  }
+  page_->SetDirty();
+  // 设置页面LSN
+  SetLSN(lsn);
+
+  // 释放排他锁
+  page_->WUnlatch();
+}
+
+void PageHandle::InsertRecord(Record *record, XID xid, LSN lsn) {
   // TODO: MVCC情况下的数据插入
   // TIPS: 注意需要利用锁保证页面仅能同时被单个线程修改
   // TIPS: 注意MVCC需要设置版本号，版本号可以用事务号表示
   // LAB 3 BEGIN
   // 获取排他锁
-  LockManager &lock_manager = LockManager::GetInstance();
-  lock_manager.Lock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WLatch();
 
   Rid rid = RecordFactory::GetRid(record);
   
@@ -181,7 +317,7 @@ void PageHandle::InsertRecord(Record *record, XID xid) {
   // TIPS: 使用RecordFactory的StoreRecord方法将record序列化到页面中
   RecordFactory record_factory(&meta_);
   // bitmap_.Display();
-  record_factory.StoreRecord(slots_ + free_slot * record_length_, record);
+  StoreRow(free_slot, record_factory, record);
   // TIPS: 将bitmap_的第一个空槽标记为已使用
   bitmap_.Set(free_slot);
   // bitmap_.Display();
@@ -189,93 +325,397 @@ void PageHandle::InsertRecord(Record *record, XID xid) {
   page_->SetDirty();
   // LAB 1 END
   // LAB 2: 设置页面LSN
-  SetLSN(LogManager::GetInstance().GetCurrent());
+  SetLSN(lsn);
 
   // 释放排他锁
-  lock_manager.Unlock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WUnlatch();
   // LAB 3 END
 }
 
-void PageHandle::DeleteRecord(SlotID slot_no, XID xid, bool) {
+void PageHandle::DeleteRecord(SlotID slot_no, XID xid, LSN lsn) {
   // TODO: MVCC情况下的数据删除
   // TIPS: 注意需要利用锁保证页面仅能同时被单个线程修改
   // TIPS: 注意MVCC删除不能直接清除数据，只是设置对应记录失效
   // LAB 3 BEGIN
   // 获取排他锁
-  LockManager &lock_manager = LockManager::GetInstance();
-  lock_manager.Lock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WLatch();
   // bitmap_.Reset(slot_no);
 
-  RecordFactory record_factory(&meta_);
-  Record *record = record_factory.LoadRecord(slots_ + slot_no * record_length_);
-  RecordFactory::SetDeleteXid(record, xid);
-  record_factory.StoreRecord(slots_ + slot_no * record_length_, record);
+  // 删除版本号为记录的最后一列，直接修改，不需要解析整条记录
+  if (Slotted()) {
+    memcpy(GetRaw(slot_no) + GetLength(slot_no) - DELETE_XID_OFFSET * sizeof(XID), &xid, sizeof(XID));
+  } else {
+    WriteRow(slot_no, record_length_ - DELETE_XID_OFFSET * sizeof(XID), sizeof(XID), (const Byte *)&xid);
+  }
 
   page_->SetDirty();
-  SetLSN(LogManager::GetInstance().GetCurrent());
+  SetLSN(lsn);
   // 释放排他锁
-  lock_manager.Unlock("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->WUnlatch();
   // LAB 3 END
 }
 
-RecordList PageHandle::LoadRecords(XID xid, const std::set<XID> &uncommit_xids) {
+RecordList PageHandle::LoadRecords(XID xid, const std::set<XID> &uncommit_xids, const std::vector<int> &cols) {
   std::cerr << "< ----------------- PageHandle::LoadRecords MVCC ---------------- >\n";
+  if (Slotted()) return LoadSlottedRecords(true, xid, uncommit_xids);
   // 获取共享锁
-  LockManager &lock_manager = LockManager::GetInstance();
-  lock_manager.LockShared("Page" + std::to_string(page_->GetPageId().page_no));
+  page_->RLatch();
   // 生成判定集合
   assert(uncommit_xids.find(xid) == uncommit_xids.end());
 
   int slot_no = -1;
   std::vector<Record *> record_vector;
   RecordFactory record_factory(&meta_);
+  // PAX 布局与只读取部分列时先确定可见的槽，再逐列解析
+  bool by_column = Pax() || !cols.empty();
+  std::vector<SlotID> visible;
   while ((slot_no = bitmap_.NextNotFree(slot_no)) != -1) {
-    Record *record = record_factory.LoadRecord(slots_ + slot_no * record_length_);
     // TODO: MVCC情况下的数据读取
     // TIPS: 注意MVCC在数据读取过程中存在无效数据（已提交的删除以及未提交的插入），注意去除
     // LAB 3 BEGIN
-    // 创建版本号 & 删除版本号，若未设置则为 0
-    XID create_xid = RecordFactory::GetCreateXid(record);
-    XID delete_xid = RecordFactory::GetDeleteXid(record);
+    // 先直接读取记录末尾的创建版本号与删除版本号，不可见的记录不需要解析
+    XID create_xid, delete_xid;
+    ReadXids(slot_no, create_xid, delete_xid);
+    if (!IsVisible(create_xid, delete_xid, xid, uncommit_xids)) {
+      continue;
+    }
+    // LAB 3 END
+    if (by_column) {
+      visible.push_back(slot_no);
+    } else {
+      record_vector.push_back(record_factory.LoadRecord(slots_ + slot_no * record_length_));
+    }
+  }
+  if (by_column) record_vector = LoadColumns(visible, cols);
+
+  // 释放共享锁
+  page_->RUnlatch();
+  return record_vector;
+}
+
+RecordList PageHandle::LoadRecords(const std::vector<SlotID> &slots, XID xid, const std::set<XID> &uncommit_xids) {
+  // 与 LoadSlottedRecords 一样持有共享锁时只复制记录
+  std::vector<std::vector<Byte>> raws;
+  page_->RLatch();
+  for (SlotID slot_no : slots) {
+    if (Slotted()) {
+      if (slot_no >= slotted_->slot_count || slot_dir_[slot_no].offset == 0) continue;
+      if (GetRaw(slot_no)[0] != (uint8_t)SlottedRecordType::TUPLE) continue;
+    } else if (slot_no >= (SlotID)meta_.record_per_page_ || !bitmap_.Test(slot_no)) {
+      continue;
+    }
+    size_t length = GetLength(slot_no);
+    std::vector<Byte> raw(length);
+    if (Slotted()) {
+      memcpy(raw.data(), GetRaw(slot_no), length);
+    } else {
+      ReadRow(slot_no, 0, length, raw.data());
+    }
+    if (xid != INVALID_XID &&
+        !IsVisible(GetCreateXid(raw.data(), length), GetDeleteXid(raw.data(), length), xid, uncommit_xids)) {
+      continue;
+    }
+    raws.push_back(std::move(raw));
+  }
+  page_->RUnlatch();
 
-    if (create_xid < delete_xid) { // 已删除
-      if (xid < delete_xid) { // 后事务删除，需要包含在内
+  RecordList records;
+  RecordFactory record_factory(&meta_);
+  try {
+    for (const auto &raw : raws) {
+      records.push_back(Slotted() ? LoadSlottedRecord(raw) : record_factory.LoadRecord(raw.data()));
+    }
+  } catch (...) {
+    for (Record *record : records) delete record;
+    throw;
+  }
+  return records;
+}
 
-      } else { //之前已经删除，看是否已提交
-        if (uncommit_xids.find(delete_xid) == uncommit_xids.end()) { // 已经提交，去除
-          continue;
-        }
+size_t PageHandle::CollectDead(XID oldest_xid, std::vector<SlotID> &dead, size_t &deleted) {
+  size_t remaining = 0;
+  deleted = 0;
+  page_->RLatch();
+  if (Slotted()) {
+    for (SlotID slot_no = 0; slot_no < slotted_->slot_count; slot_no++) {
+      const SlotEntry &entry = slot_dir_[slot_no];
+      if (entry.offset == 0 || GetRaw(slot_no)[0] != (uint8_t)SlottedRecordType::TUPLE) continue;
+      XID create_xid = GetCreateXid(GetRaw(slot_no), entry.length);
+      XID delete_xid = GetDeleteXid(GetRaw(slot_no), entry.length);
+      if (IsDead(create_xid, delete_xid, oldest_xid)) {
+        dead.push_back(slot_no);
+        continue;
       }
-    } else if (create_xid > delete_xid) { // 新插入
-      if (xid < create_xid) { // 后事务插入，需要去除
+      remaining++;
+      if (delete_xid != INVALID_XID && create_xid <= delete_xid) deleted++;
+    }
+  } else {
+    int slot_no = -1;
+    while ((slot_no = bitmap_.NextNotFree(slot_no)) != -1) {
+      XID create_xid, delete_xid;
+      ReadXids(slot_no, create_xid, delete_xid);
+      if (IsDead(create_xid, delete_xid, oldest_xid)) {
+        dead.push_back(slot_no);
         continue;
-      } else { //之前已经插入，看是否已提交
-        if (uncommit_xids.find(create_xid) != uncommit_xids.end()) { // 未提交，去除
-          continue;
-        }
       }
-    } else {
+      remaining++;
+      if (delete_xid != INVALID_XID && create_xid <= delete_xid) deleted++;
+    }
+  }
+  page_->RUnlatch();
+  return remaining;
+}
+
+RecordList PageHandle::LoadInlineRecords() {
+  if (Slotted()) return LoadSlottedRecords(false, INVALID_XID, {}, false);
+  return LoadRecords();
+}
+
+RecordList PageHandle::LoadSlottedRecords(bool mvcc, XID xid, const std::set<XID> &uncommit_xids, bool read_overflow) {
+  // 持有共享锁时只复制可见的记录，读取溢出的字符串需要访问其他页面，在释放锁后进行
+  std::vector<std::vector<Byte>> raws;
+  page_->RLatch();
+  for (SlotID slot_no = 0; slot_no < slotted_->slot_count; slot_no++) {
+    const SlotEntry &entry = slot_dir_[slot_no];
+    if (entry.offset == 0) continue;
+    const uint8_t *raw = GetRaw(slot_no);
+    if (raw[0] != (uint8_t)SlottedRecordType::TUPLE) continue;
+    if (mvcc && !IsVisible(GetCreateXid(raw, entry.length), GetDeleteXid(raw, entry.length), xid, uncommit_xids)) {
       continue;
     }
+    raws.emplace_back(raw, raw + entry.length);
+  }
+  page_->RUnlatch();
 
-    // LAB 3 END
-    record_vector.push_back(record);
+  RecordList records;
+  try {
+    RecordFactory record_factory(&meta_);
+    for (const auto &raw : raws) {
+      std::vector<OverflowValue> overflow;
+      records.push_back(read_overflow ? LoadSlottedRecord(raw) : record_factory.LoadVarRecord(raw.data(), &overflow));
+    }
+  } catch (...) {
+    for (Record *record : records) delete record;
+    throw;
   }
+  return records;
+}
 
-  // 释放共享锁
-  lock_manager.UnlockShared("Page" + std::to_string(page_->GetPageId().page_no));
-  return record_vector;
+Record *PageHandle::LoadSlottedRecord(const std::vector<Byte> &raw) {
+  RecordFactory record_factory(&meta_);
+  std::vector<OverflowValue> overflow;
+  Record *record = record_factory.LoadVarRecord(raw.data(), &overflow);
+  try {
+    for (const auto &value : overflow) {
+      std::string str = table_->ReadOverflow(value.rid, value.length);
+      record->SetField(value.col, new StrField(str.c_str(), str.size()));
+    }
+  } catch (...) {
+    delete record;
+    throw;
+  }
+  return record;
 }
 
 Rid PageHandle::Next() { return Rid{0, 0}; }
 
-bool PageHandle::Full() { return bitmap_.Full(); }
+bool PageHandle::Full() {
+  if (Slotted()) return FreeSpace() < meta_.GetMinLength();
+  page_->RLatch();
+  bool full = bitmap_.Full();
+  page_->RUnlatch();
+  return full;
+}
 
-PageID PageHandle::GetNextFree() { return header_->next_free; }
+SlotID PageHandle::FirstFree() {
+  page_->RLatch();
+  SlotID slot_no = FirstFreeSlot();
+  page_->RUnlatch();
+  return slot_no;
+}
 
-SlotID PageHandle::FirstFree() { return bitmap_.FirstFree(); }
+size_t PageHandle::FreeSpace() {
+  page_->RLatch();
+  size_t free_space = FreeBytes();
+  page_->RUnlatch();
+  return free_space;
+}
 
-void PageHandle::SetLSN(LSN lsn) { header_->page_lsn = lsn; }
+SlotID PageHandle::FirstFreeSlot() {
+  if (Slotted()) {
+    for (SlotID slot_no = 0; slot_no < slotted_->slot_count; slot_no++) {
+      if (slot_dir_[slot_no].offset == 0) return slot_no;
+    }
+    return slotted_->slot_count;
+  }
+  return bitmap_.FirstFree();
+}
+
+size_t PageHandle::FreeBytes() {
+  if (!Slotted()) {
+    size_t free_slots = 0;
+    for (int slot_no = bitmap_.FirstFree(); slot_no != -1; slot_no = bitmap_.NextFree(slot_no)) free_slots++;
+    return free_slots * record_length_;
+  }
+  // 使用新的槽时还需要一个槽目录项
+  size_t used = SlottedDirEnd() + slotted_->live_length;
+  if (FirstFreeSlot() == slotted_->slot_count) used += sizeof(SlotEntry);
+  return used < PAGE_SIZE ? PAGE_SIZE - used : 0;
+}
+
+bool PageHandle::ReadOverflow(SlotID slot_no, std::string &value, Rid &next) {
+  page_->RLatch();
+  if (slot_no >= slotted_->slot_count || slot_dir_[slot_no].offset == 0 ||
+      GetRaw(slot_no)[0] != (uint8_t)SlottedRecordType::OVERFLOW) {
+    page_->RUnlatch();
+    return false;
+  }
+  // 溢出记录：类型字节、下一条溢出记录的页号与槽号、字符串的一段
+  const uint8_t *raw = GetRaw(slot_no) + sizeof(uint8_t);
+  memcpy(&next.page_no, raw, sizeof(PageID));
+  memcpy(&next.slot_no, raw + sizeof(PageID), sizeof(SlotID));
+  size_t header = sizeof(uint8_t) + sizeof(PageID) + sizeof(SlotID);
+  value.append((const char *)raw + sizeof(PageID) + sizeof(SlotID), slot_dir_[slot_no].length - header);
+  page_->RUnlatch();
+  return true;
+}
+
+bool PageHandle::Slotted() const { return meta_.layout_ == TableLayout::SLOTTED; }
+
+bool PageHandle::Pax() const { return meta_.layout_ == TableLayout::PAX; }
+
+uint8_t *PageHandle::MiniPage(size_t col_offset) const { return slots_ + col_offset * meta_.record_per_page_; }
+
+void PageHandle::ReadRow(SlotID slot_no, size_t offset, size_t length, Byte *dst) const {
+  if (!Pax()) {
+    memcpy(dst, slots_ + slot_no * record_length_ + offset, length);
+    return;
+  }
+  // 依次复制 [offset, offset + length) 覆盖的每一列中的部分
+  size_t col_offset = 0;
+  for (const Column &col : meta_.cols_) {
+    size_t begin = std::max(offset, col_offset), end = std::min(offset + length, col_offset + col.len_);
+    if (begin < end) {
+      memcpy(dst + begin - offset, MiniPage(col_offset) + slot_no * col.len_ + begin - col_offset, end - begin);
+    }
+    col_offset += col.len_;
+  }
+}
+
+void PageHandle::WriteRow(SlotID slot_no, size_t offset, size_t length, const Byte *src) {
+  if (!Pax()) {
+    memcpy(slots_ + slot_no * record_length_ + offset, src, length);
+    return;
+  }
+  size_t col_offset = 0;
+  for (const Column &col : meta_.cols_) {
+    size_t begin = std::max(offset, col_offset), end = std::min(offset + length, col_offset + col.len_);
+    if (begin < end) {
+      memcpy(MiniPage(col_offset) + slot_no * col.len_ + begin - col_offset, src + begin - offset, end - begin);
+    }
+    col_offset += col.len_;
+  }
+}
+
+void PageHandle::StoreRow(SlotID slot_no, const RecordFactory &record_factory, Record *record) {
+  if (!Pax()) {
+    record_factory.StoreRecord(slots_ + slot_no * record_length_, record);
+    return;
+  }
+  std::vector<Byte> raw(record_length_);
+  record_factory.StoreRecord(raw.data(), record);
+  WriteRow(slot_no, 0, record_length_, raw.data());
+}
+
+void PageHandle::ReadXids(SlotID slot_no, XID &create_xid, XID &delete_xid) const {
+  Byte raw[CREATE_XID_OFFSET * sizeof(XID)];
+  ReadRow(slot_no, record_length_ - sizeof(raw), sizeof(raw), raw);
+  create_xid = GetCreateXid(raw, sizeof(raw));
+  delete_xid = GetDeleteXid(raw, sizeof(raw));
+}
+
+RecordList PageHandle::LoadColumns(const std::vector<SlotID> &slots, const std::vector<int> &cols) {
+  std::vector<bool> needed(meta_.cols_.size(), cols.empty());
+  for (int col : cols) needed[col] = true;
+  RecordList records;
+  for (size_t i = 0; i < slots.size(); i++) {
+    records.push_back(new Record());
+    for (size_t col = 0; col < meta_.cols_.size(); col++) records.back()->PushBack(nullptr);
+  }
+  // 外层按列，PAX 页面中同一列的值连续存放
+  size_t col_offset = 0;
+  for (size_t col = 0; col < meta_.cols_.size(); col_offset += meta_.cols_[col].len_, col++) {
+    if (!needed[col]) continue;
+    const Column &column = meta_.cols_[col];
+    for (size_t i = 0; i < slots.size(); i++) {
+      const uint8_t *src = Pax() ? MiniPage(col_offset) + slots[i] * column.len_
+                                 : slots_ + slots[i] * record_length_ + col_offset;
+      records[i]->SetField(col, RecordFactory::LoadField(src, column.type_, column.len_));
+    }
+  }
+  return records;
+}
+
+size_t PageHandle::SlottedDirEnd() const {
+  return sizeof(PageHeader) + sizeof(SlottedHeader) + slotted_->slot_count * sizeof(SlotEntry);
+}
+
+uint8_t *PageHandle::AllocSlot(SlotID slot_no, size_t length) {
+  // 先保证槽目录扩展后仍有足够的连续空间，再扩展槽目录
+  size_t dir_end = SlottedDirEnd();
+  if (slot_no >= slotted_->slot_count) dir_end += (slot_no + 1 - slotted_->slot_count) * sizeof(SlotEntry);
+  if (PAGE_SIZE - slotted_->data_length < dir_end + length) Compact();
+  if (PAGE_SIZE - slotted_->data_length < dir_end + length) {
+    std::cerr << "Error in PageHandle::AllocSlot\n";
+    throw UnknownError();
+  }
+  while (slotted_->slot_count <= slot_no) {
+    slot_dir_[slotted_->slot_count] = {0, 0};
+    slotted_->slot_count++;
+  }
+  slotted_->data_length += length;
+  slotted_->live_length += length;
+  slot_dir_[slot_no] = {(uint16_t)(PAGE_SIZE - slotted_->data_length), (uint16_t)length};
+  return GetRaw(slot_no);
+}
+
+void PageHandle::FreeSlot(SlotID slot_no) {
+  SlotEntry &entry = slot_dir_[slot_no];
+  if (entry.offset == 0) return;
+  slotted_->live_length -= entry.length;
+  // 位于记录区起点的记录直接归还连续空间，其余的留待整理
+  if (entry.offset == PAGE_SIZE - slotted_->data_length) slotted_->data_length -= entry.length;
+  entry = {0, 0};
+  while (slotted_->slot_count > 0 && slot_dir_[slotted_->slot_count - 1].offset == 0) slotted_->slot_count--;
+}
+
+void PageHandle::Compact() {
+  uint8_t *data = page_->GetData();
+  std::vector<Byte> buffer(slotted_->live_length);
+  size_t pos = 0;
+  for (SlotID slot_no = 0; slot_no < slotted_->slot_count; slot_no++) {
+    const SlotEntry &entry = slot_dir_[slot_no];
+    if (entry.offset == 0) continue;
+    memcpy(buffer.data() + pos, data + entry.offset, entry.length);
+    pos += entry.length;
+  }
+  size_t offset = PAGE_SIZE;
+  pos = 0;
+  for (SlotID slot_no = 0; slot_no < slotted_->slot_count; slot_no++) {
+    SlotEntry &entry = slot_dir_[slot_no];
+    if (entry.offset == 0) continue;
+    offset -= entry.length;
+    memcpy(data + offset, buffer.data() + pos, entry.length);
+    entry.offset = offset;
+    pos += entry.length;
+  }
+  slotted_->data_length = slotted_->live_length;
+}
+
+void PageHandle::SetLSN(LSN lsn) {
+  if (lsn > header_->page_lsn) header_->page_lsn = lsn;
+  page_->SetLSN(lsn);
+}
 
 LSN PageHandle::GetLSN() { return header_->page_lsn; }
 
@@ -6,25 +6,54 @@
 #include "../defines.h"
 #include "../storage/buffer_manager.h"
 #include "../storage/page.h"
+#include "../storage/page_guard.h"
 #include "../table/table_meta.h"
 #include "../utils/bitmap.h"
 #include "../log/update_log.h"
 
 namespace dbtrain {
 
+class Table;
+class RecordFactory;
+
 // TIPS: 可自行添加字段
 struct PageHeader {
+  // 页面校验值，由 DiskManager 维护，必须位于页面开头，见 PAGE_CHECKSUM_SIZE
+  uint32_t checksum;
   LSN page_lsn;
-  PageID next_free;
 };
 
+// SLOTTED 布局的页面：PageHeader 之后依次为 SlottedHeader 与槽目录，记录从页尾向前存放，
+// 槽目录与记录区之间为连续的空闲空间，全零的页面即为空页面
+struct SlottedHeader {
+  uint16_t slot_count;   // 槽目录项数
+  uint16_t data_length;  // 记录区长度，从页尾算起，包含已释放记录留下的空洞
+  uint16_t live_length;  // 有效记录的总长度
+};
+
+// 槽目录项，offset 为 0 表示空槽
+struct SlotEntry {
+  uint16_t offset;
+  uint16_t length;
+};
+
+static_assert(PAGE_SIZE <= UINT16_MAX, "slotted page offsets are 16-bit");
+
+// 空页面中单条记录的最大长度
+static const size_t SLOTTED_PAGE_CAPACITY = PAGE_SIZE - sizeof(PageHeader) - sizeof(SlottedHeader) - sizeof(SlotEntry);
+
+// SLOTTED 页面中记录的首字节，溢出记录保存较长字符串的一段，顺序扫描时跳过
+enum class SlottedRecordType : uint8_t { TUPLE, OVERFLOW };
+
 class PageHandle {
   friend class Table;
   friend class UpdateLog;
 
  public:
   PageHandle() = default;
-  PageHandle(Page *page, const TableMeta &meta);
+  // 持有页面的 pin，PageHandle 存在期间页面不会被替换
+  // SLOTTED 布局读取溢出存放的字符串时需要通过 table 访问其他页面
+  PageHandle(PageGuard page, const TableMeta &meta, Table *table = nullptr);
   ~PageHandle() = default;
 
   // 无并发接口
@@ -34,34 +63,86 @@ class PageHandle {
   RecordList LoadRecords();
 
   // LAB 2: 新增部分函数方便后续实验
+  // 槽中记录在页面中的起点，PAX 布局的记录不连续存放，需通过 CopyRaw 读取
   uint8_t *GetRaw(SlotID slot_no);
+  // 槽中记录的长度，FIXED 布局为定长
+  size_t GetLength(SlotID slot_no);
+  // 持有共享锁复制槽中的记录，SLOTTED 页面中的记录可能被整理移动，PAX 页面按行格式拼接各列
+  std::vector<Byte> CopyRaw(SlotID slot_no);
   Record *GetRecord(SlotID slot_no);
 
-  void InsertRecord(SlotID slot_no, const void *data, LSN lsn);
+  void InsertRecord(SlotID slot_no, const void *data, size_t length, LSN lsn);
   void DeleteRecord(SlotID slot_no, LSN lsn);
   void UpdateRecord(SlotID slot_no, const void *data, LSN lsn);
+  // 增量日志的重做与回滚：base_slot 与 slot_no 不同时先复制 base_slot 的记录，再依次用 data 覆盖 ranges 中的字节
+  // used 为槽位之后是否被占用
+  void PatchRecord(SlotID slot_no, SlotID base_slot, const std::vector<ByteRange> &ranges, const Byte *data, bool used,
+                   LSN lsn);
 
   // LAB 3: MVCC接口
-  void InsertRecord(Record *record, XID xid);
-  // 第三个参数没有实际含义，仅用于区分重载函数 DeleteRecord(SlotID slot_no, LSN lsn)
-  void DeleteRecord(SlotID, XID xid, bool);
-  RecordList LoadRecords(XID xid, const std::set<XID> &uncommit_xids);
+  // lsn 为写入的日志的 LSN
+  void InsertRecord(Record *record, XID xid, LSN lsn);
+  void DeleteRecord(SlotID slot_no, XID xid, LSN lsn);
+  // cols 不为空时只解析其中的列，其余列为空指针；SLOTTED 布局忽略 cols
+  RecordList LoadRecords(XID xid, const std::set<XID> &uncommit_xids, const std::vector<int> &cols = {});
+  // 读取所有记录版本，SLOTTED 布局中溢出存放的字符串不读取，读为空字符串；用于只需要数值列的页面摘要
+  RecordList LoadInlineRecords();
+  // 读取 slots 中对事务 xid 可见的记录，跳过空槽，xid 为 INVALID_XID 时不检查可见性
+  RecordList LoadRecords(const std::vector<SlotID> &slots, XID xid, const std::set<XID> &uncommit_xids);
+  // 清理：收集删除版本号小于 oldest_xid、对所有事务都不可见的记录所在的槽，返回页面中其余的记录数
+  // deleted 为其余记录中已标记删除、仍可能被正在运行的事务看到的记录数；SLOTTED 布局不包括溢出记录
+  size_t CollectDead(XID oldest_xid, std::vector<SlotID> &dead, size_t &deleted);
 
   Rid Next();
 
+  // 以下三个函数持有共享锁读取页面
   bool Full();
-  PageID GetNextFree();
   SlotID FirstFree();
+  // 在 FirstFree() 槽中插入记录时可用的最大长度，FIXED 布局为空槽数乘以记录长度
+  size_t FreeSpace();
+  // 读取溢出记录中的一段字符串追加到 value 后，next 为下一条溢出记录，不是溢出记录时返回 false
+  bool ReadOverflow(SlotID slot_no, std::string &value, Rid &next);
+  // 页面 LSN 只增不减
   void SetLSN(LSN lsn);
   LSN GetLSN();
+  // 先写日志再修改页面时，在写日志之前调用，返回值析构前页面不会被写回
+  PageUpdate BeginUpdate() { return PageUpdate(page_.Get()); }
 
  private:
+  bool Slotted() const;
+  bool Pax() const;
+  // PAX 布局中列的小页起点，col_offset 为该列在行格式记录中的偏移
+  uint8_t *MiniPage(size_t col_offset) const;
+  // FIXED 与 PAX 布局：按行格式读写槽中记录的 [offset, offset + length)，日志中的记录与增量始终为行格式
+  void ReadRow(SlotID slot_no, size_t offset, size_t length, Byte *dst) const;
+  void WriteRow(SlotID slot_no, size_t offset, size_t length, const Byte *src);
+  void StoreRow(SlotID slot_no, const RecordFactory &record_factory, Record *record);
+  void ReadXids(SlotID slot_no, XID &create_xid, XID &delete_xid) const;
+  // 逐列解析 slots 中记录的 cols 列，cols 为空时解析所有列，调用者持有共享锁
+  RecordList LoadColumns(const std::vector<SlotID> &slots, const std::vector<int> &cols);
+  // 以下 SLOTTED 布局的操作需要持有排他锁
+  // 为槽分配 length 字节的空间，连续空间不足时先整理页面
+  uint8_t *AllocSlot(SlotID slot_no, size_t length);
+  void FreeSlot(SlotID slot_no);
+  // 按槽号顺序把有效记录重新排列到页尾，结果只取决于页面内容，重做时得到相同的布局
+  void Compact();
+  size_t SlottedDirEnd() const;
+  // FirstFree 与 FreeSpace 的实现，调用者持有页面的锁
+  SlotID FirstFreeSlot();
+  size_t FreeBytes();
+  // 解析 SLOTTED 布局的记录并读入溢出存放的字符串，不持有页面的锁
+  Record *LoadSlottedRecord(const std::vector<Byte> &raw);
+  RecordList LoadSlottedRecords(bool mvcc, XID xid, const std::set<XID> &uncommit_xids, bool read_overflow = true);
+
   Bitmap bitmap_;
   PageHeader *header_;
   int record_length_;
   uint8_t *slots_;
-  Page *page_;
+  SlottedHeader *slotted_ = nullptr;
+  SlotEntry *slot_dir_ = nullptr;
+  PageGuard page_;
   TableMeta meta_;
+  Table *table_ = nullptr;
 };
 
 }  // namespace dbtrain
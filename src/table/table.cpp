@@ -2,12 +2,15 @@
 
 #include <algorithm>
 #include <iostream>
+#include <set>
 #include "../exception/exceptions.h"
 #include "../exception/table_exceptions.h"
+#include "../index/index.h"
 #include "../log/log_manager.h"
 #include "../record/fields.h"
 #include "../record/record_factory.h"
 #include "../result/result.h"
+#include "../storage/disk_manager.h"
 #include "../table/hidden.h"
 #include "../tx/tx_manager.h"
 #include "defines.h"
@@ -15,14 +18,39 @@
 
 namespace dbtrain {
 
+// SLOTTED 布局中超过该长度的记录把最长的字符串移到溢出记录中
+static const size_t SLOTTED_INLINE_MAX = PAGE_SIZE / 4;
+// 短于该长度的字符串不溢出存放
+static const size_t OVERFLOW_MIN_LENGTH = 32;
+// 溢出记录的头部：类型字节、下一条溢出记录的页号与槽号
+static const size_t OVERFLOW_HEADER_SIZE = sizeof(uint8_t) + sizeof(PageID) + sizeof(SlotID);
+// 剩余空间放不下头部与该长度的内容时不再向该页面写入溢出记录
+static const size_t OVERFLOW_CHUNK_MIN = 64;
+
 Table::Table(const std::string &table_name, int meta_fd, int data_fd)
-    : table_name_(table_name), meta_fd_(meta_fd), data_fd_(data_fd), buffer_manager_(BufferManager::GetInstance()) {
-  Page *meta_page = buffer_manager_.GetPage(meta_fd_, META_PAGE_NO);
-  meta_.Load(meta_page->GetData());
+    : table_name_(table_name),
+      meta_fd_(meta_fd),
+      data_fd_(data_fd),
+      fsm_(meta_fd),
+      buffer_manager_(BufferManager::GetInstance()) {
+  // 元信息页开头为页面校验值，元信息保存在其后
+  PageGuard meta_page = buffer_manager_.GetPage(meta_fd_, META_PAGE_NO);
+  meta_.Load(meta_page->GetData() + PAGE_CHECKSUM_SIZE);
+  table_end_ = meta_.table_end_page_;
+  fsm_.Load(table_end_);
+  zone_map_.Load(ZoneColumns(), table_end_);
+  ExtendTo(DiskManager::GetInstance().FileSize(data_fd_) / PAGE_SIZE);
 }
 
-Table::Table(const std::string &table_name, int meta_fd, int data_fd, const std::vector<Column> &columns)
-    : table_name_(table_name), meta_fd_(meta_fd), data_fd_(data_fd), buffer_manager_(BufferManager::GetInstance()) {
+Table::Table(const std::string &table_name, int meta_fd, int data_fd, const std::vector<Column> &columns,
+             TableID table_id, TableLayout layout)
+    : table_name_(table_name),
+      meta_fd_(meta_fd),
+      data_fd_(data_fd),
+      fsm_(meta_fd),
+      buffer_manager_(BufferManager::GetInstance()) {
+  meta_.table_id_ = table_id;
+  meta_.layout_ = layout;
   meta_.record_length_ = 0;
   for (auto &col : columns) {
     meta_.record_length_ += col.len_;
@@ -37,28 +65,74 @@ Table::Table(const std::string &table_name, int meta_fd, int data_fd, const std:
   meta_.record_per_page_ = (BITMAP_WIDTH * (PAGE_SIZE - sizeof(PageHeader)) - (BITMAP_WIDTH - 1)) /
                            (1 + BITMAP_WIDTH * meta_.record_length_);
   meta_.table_end_page_ = 0;
-  meta_.first_free_ = NULL_PAGE;
   meta_.bitmap_length_ = (meta_.record_per_page_ + BITMAP_WIDTH - 1) / BITMAP_WIDTH;
+  zone_map_.Load(ZoneColumns(), 0);
 
-  Page *meta_page = buffer_manager_.AllocPage(meta_fd_, META_PAGE_NO);
-  Store(meta_page->GetData());
+  PageGuard meta_page = buffer_manager_.AllocPage(meta_fd_, META_PAGE_NO);
+  Store(meta_page->GetData() + PAGE_CHECKSUM_SIZE);
   meta_page->SetDirty();
 }
 
 void Table::StoreMeta() {
   if (meta_modified) {
-    Page *meta_page = buffer_manager_.GetPage(meta_fd_, META_PAGE_NO);
-    Store(meta_page->GetData());
+    PageGuard meta_page = buffer_manager_.GetPage(meta_fd_, META_PAGE_NO);
+    Store(meta_page->GetData() + PAGE_CHECKSUM_SIZE);
     meta_page->SetDirty();
   }
+  fsm_.Store();
+}
+
+void Table::ExtendTo(PageID page_end) {
+  std::lock_guard<std::mutex> extend_lock(extend_mutex_);
+  if (page_end > table_end_) {
+    table_end_ = page_end;
+    meta_modified = true;
+    fsm_.Grow(page_end);
+    zone_map_.Grow(page_end);
+  }
+  // 从未写回的页面在文件中补为全零的空页面，重做从空页面开始
+  DiskManager &disk_manager = DiskManager::GetInstance();
+  size_t table_size = (size_t)table_end_ * PAGE_SIZE;
+  if (disk_manager.FileSize(data_fd_) < table_size) disk_manager.TruncateFile(data_fd_, table_size);
+}
+
+void Table::UpdateFreeSpace(PageHandle &page_handle) {
+  fsm_.Update(page_handle.page_->GetPageId().page_no, page_handle.FreeSpace());
 }
 
+bool Table::PageMayMatch(PageID page_no, const std::vector<ZoneBound> &bounds) {
+  return zone_map_.MayMatch(page_no, bounds);
+}
+
+void Table::CountSkippedPage() { zone_map_.CountSkipped(); }
+
+void Table::FillZone(PageID page_no) {
+  uint64_t version;
+  if (zone_map_.GetVersion(page_no, version)) return;
+  PageHandle page_handle = GetPage(page_no);
+  ComputeZone(page_handle, version);
+}
+
+void Table::ComputeZone(PageHandle &page_handle, uint64_t version) {
+  RecordList records = page_handle.LoadInlineRecords();
+  zone_map_.Set(page_handle.page_->GetPageId().page_no, version, records);
+  for (Record *record : records) delete record;
+}
+
+void Table::InvalidateZone(PageID page_no) { zone_map_.Invalidate(page_no); }
+
+bool Table::ZoneTracks(int col_idx) const { return zone_map_.Tracks(col_idx); }
+
+ZoneStats Table::GetZoneStats() { return zone_map_.GetStats(); }
+
 Table::~Table() {
+  delete mapped_;
   if (meta_modified) {
-    Page *meta_page = buffer_manager_.GetPage(meta_fd_, META_PAGE_NO);
-    Store(meta_page->GetData());
+    PageGuard meta_page = buffer_manager_.GetPage(meta_fd_, META_PAGE_NO);
+    Store(meta_page->GetData() + PAGE_CHECKSUM_SIZE);
     meta_page->SetDirty();
   }
+  fsm_.Store();
   buffer_manager_.FlushFile(meta_fd_);
   buffer_manager_.FlushFile(data_fd_);
 }
@@ -77,29 +151,66 @@ Result Table::Desc() {
   return Result({"Name", "Type", "Length"}, records);
 }
 
-int Table::Load(const uint8_t *src) { return meta_.Load(src); }
+int Table::Load(const uint8_t *src) {
+  int ret = meta_.Load(src);
+  table_end_ = meta_.table_end_page_;
+  return ret;
+}
 
-int Table::Store(uint8_t *dst) { return meta_.Store(dst); }
+int Table::Store(uint8_t *dst) { return GetMeta().Store(dst); }
 
 PageHandle Table::CreatePage() {
-  Page *page = buffer_manager_.AllocPage(data_fd_, meta_.table_end_page_);
-  meta_.first_free_ = meta_.table_end_page_;
-  meta_.table_end_page_++;
+  if (read_only_) throw ReadOnlyError();
+  // 页面进入缓冲池后再移动表尾，扫描不会读到文件中还不存在的页面
+  std::unique_lock<std::mutex> extend_lock(extend_mutex_);
+  PageID page_no = table_end_;
+  PageGuard page = buffer_manager_.AllocPage(data_fd_, page_no);
+  table_end_++;
   meta_modified = true;
-  PageHandle page_handle = PageHandle(page, meta_);
-  page_handle.header_->next_free = NULL_PAGE;
-  page_handle.bitmap_.Init();
+  fsm_.Extend(page_no);
+  zone_map_.Extend(page_no);
+  extend_lock.unlock();
+  PageHandle page_handle = PageHandle(std::move(page), meta_, this);
+  if (meta_.layout_ == TableLayout::SLOTTED) {
+    memset(page_handle.slotted_, 0, sizeof(SlottedHeader));
+  } else {
+    page_handle.bitmap_.Init();
+  }
   return page_handle;
 }
 
 PageHandle Table::GetPage(PageID page_id) {
-  Page *page = buffer_manager_.GetPage(data_fd_, page_id);
-  PageHandle page_handle = PageHandle(page, meta_);
+  if (mapped_ != nullptr) return PageHandle(PageGuard(mapped_->GetPage(page_id)), meta_, this);
+  PageGuard page = buffer_manager_.GetPage(data_fd_, page_id);
+  PageHandle page_handle = PageHandle(std::move(page), meta_, this);
   return page_handle;
 }
 
-void Table::InsertRecord(Record *record) {
+void Table::ReadAhead(PageID page_id, ReadAheadState &state) {
+  if (mapped_ != nullptr) {
+    mapped_->ReadAhead(page_id);
+  } else {
+    buffer_manager_.ReadAhead(data_fd_, page_id, table_end_, state);
+  }
+}
+
+void Table::Prefetch(const vector<PageID> &pages) {
+  if (mapped_ == nullptr) buffer_manager_.Prefetch(data_fd_, pages);
+}
+
+void Table::MapData() {
+  StoreMeta();
+  // 写回并释放缓冲池中的数据页，之后只通过映射访问
+  buffer_manager_.FlushFile(data_fd_);
+  read_only_ = true;
+  if (!DiskManager::GetInstance().IsCompressed(data_fd_)) mapped_ = new MappedFile(data_fd_);
+}
+
+void Table::InsertRecord(Record *record) { InsertRecord(record, nullptr); }
+
+void Table::InsertRecord(Record *record, const Rid *old_rid) {
   std::cerr << "< ---------------- Table::InsertRecord --------------- >\n";
+  if (read_only_) throw ReadOnlyError();
   if (record->GetSize() != meta_.cols_.size()) {
     throw InvalidInsertCountError(record->GetSize(), meta_.cols_.size());
   }
@@ -120,42 +231,55 @@ void Table::InsertRecord(Record *record) {
   // TIPS: 需要在LAB 1之间添加代码
   // LAB 2 BEGIN
 
-  // TIPS: 判断meta_.first_free_变量是否为NULL_PAGE
-  // TIPS: 若为NULL_PAGE，则调用CreatePage()创建一个新的页面
-  // TIPS: 若不为NULL_PAGE，则调用GetPage()获取meta_.first_free_页面
-  std::cerr << "before meta.first_free: " << meta_.first_free_ << "\n";
-  PageHandle page_handle;
-  if (meta_.first_free_ == NULL_PAGE) {
-    page_handle = CreatePage();
-  } else {
-    page_handle = GetPage(meta_.first_free_);
+  // 从空闲空间映射中占用有空槽的页面，没有时创建新页面，插入期间其他插入不会选中同一页面
+  XID xid = TxManager::GetInstance().Get(std::this_thread::get_id());
+  if (meta_.layout_ == TableLayout::SLOTTED) {
+    InsertSlotted(record, old_rid, xid);
+    return;
   }
+  // 更新产生的新版本优先放在旧版本所在页面，日志只需记录二者不同的字节
+  PageHandle page_handle;
+  bool same_page = old_rid != nullptr && ClaimPage(old_rid->page_no, meta_.record_length_, page_handle);
+  if (!same_page) page_handle = ClaimPage(meta_.record_length_);
 
   // TIPS: 通过bitmap_.FirstFree()获取第一个空槽
-  int free_slot = page_handle.bitmap_.FirstFree();
+  int free_slot = page_handle.FirstFree();
   // TIPS: 使用RecordFactory::SetRid设置record的rid
   Rid rid;
   rid.page_no = page_handle.page_->GetPageId().page_no;
   rid.slot_no = free_slot;
   RecordFactory::SetRid(record, rid);
 
-  XID xid = TxManager::GetInstance().Get(std::this_thread::get_id());
   LogManager &log_manager = LogManager::GetInstance();
   RecordFactory record_factory(&meta_);
   RecordFactory::SetCreateXid(record, xid);
-  Byte* new_record_raw = new Byte[meta_.record_length_];
-  record_factory.StoreRecord(new_record_raw, record);
-  log_manager.InsertRecordLog(xid, table_name_, rid, meta_.record_length_, new_record_raw);
-  // LAB 2 END
-  // TODO: 更改LAB 1,2代码，适应MVCC情景
-  // TIPS: 注意记录日志时需要设置新的隐藏列
-  // LAB 3 BEGIN
-  page_handle.InsertRecord(record, xid);
-  if (page_handle.Full()) {
-    std::cerr << "------ full! ------\n";
-    meta_.first_free_ = page_handle.GetNextFree();
-    meta_modified = true;
+  std::vector<Byte> new_record_raw(meta_.record_length_);
+  record_factory.StoreRecord(new_record_raw.data(), record);
+  LSN lsn;
+  {
+    PageUpdate update = page_handle.BeginUpdate();
+    try {
+      if (same_page) {
+        std::vector<Byte> old_record_raw = page_handle.CopyRaw(old_rid->slot_no);
+        lsn = log_manager.InsertRecordLog(xid, meta_.table_id_, rid, meta_.record_length_, new_record_raw.data(),
+                                          old_rid->slot_no, old_record_raw.data());
+      } else {
+        lsn = log_manager.InsertRecordLog(xid, meta_.table_id_, rid, meta_.record_length_, new_record_raw.data());
+      }
+    } catch (...) {
+      fsm_.Release(rid.page_no, page_handle.FreeSpace());
+      throw;
+    }
+    // LAB 2 END
+    // TODO: 更改LAB 1,2代码，适应MVCC情景
+    // TIPS: 注意记录日志时需要设置新的隐藏列
+    // LAB 3 BEGIN
+    page_handle.InsertRecord(record, xid, lsn);
   }
+  zone_map_.Widen(rid.page_no, record);
+  fsm_.Release(rid.page_no, page_handle.FreeSpace());
+  tuples_++;
+  InsertIndexes(record, rid, xid);
   // LAB 3 END
 
   // TODO: 寻找有空页面并插入记录
@@ -174,27 +298,33 @@ void Table::InsertRecord(Record *record) {
 
 void Table::DeleteRecord(const Rid &rid) {
   std::cerr << "< ---------------- Table::DeleteRecord --------------- >\n";
+  if (read_only_) throw ReadOnlyError();
   // TODO: 添加数据删除日志信息
   // TIPS: 注意ARIES使用的是WAL，所以需要先写入日志，再更新数据
   // TIPS: 利用LogManager对应函数记录日志
   // LAB 2 BEGIN
-  PageHandle page_handle = GetPage(rid.page_no);
   XID xid = TxManager::GetInstance().Get(std::this_thread::get_id());
   LogManager &log_manager = LogManager::GetInstance();
+  // 记录可能正被后台回滚修改
+  log_manager.WaitUndo();
+  PageHandle page_handle = GetPage(rid.page_no);
 
-  log_manager.DeleteRecordLog(
-    xid, 
-    table_name_, 
-    rid, 
-    meta_.record_length_, 
-    page_handle.GetRaw(rid.slot_no) 
-  );
-  // LAB 2 END
-
-  // TODO: 更改LAB 1,2代码，适应MVCC情景
-  // TIPS: 注意删除日志没有清除实际数据，页面不会由满变空
-  // LAB 3 BEGIN
-  page_handle.DeleteRecord(rid.slot_no, xid, true);
+  // 标记删除只修改位于记录末尾的删除版本号，日志只记录修改的字节
+  std::vector<Byte> old_record_raw = page_handle.CopyRaw(rid.slot_no);
+  std::vector<Byte> new_record_raw = old_record_raw;
+  memcpy(new_record_raw.data() + new_record_raw.size() - DELETE_XID_OFFSET * sizeof(XID), &xid, sizeof(XID));
+  {
+    PageUpdate update = page_handle.BeginUpdate();
+    LSN lsn = log_manager.DeleteRecordLog(xid, meta_.table_id_, rid, old_record_raw.size(), old_record_raw.data(),
+                                          new_record_raw.data());
+    // LAB 2 END
+
+    // TODO: 更改LAB 1,2代码，适应MVCC情景
+    // TIPS: 注意删除日志没有清除实际数据，页面不会由满变空
+    // LAB 3 BEGIN
+    page_handle.DeleteRecord(rid.slot_no, xid, lsn);
+  }
+  dead_tuples_++;
   // meta_.first_free_ = rid.page_no;
   // LAB 3 END
 
@@ -255,7 +385,7 @@ void Table::UpdateRecord(const Rid &rid, Record *record) {
   // LAB 3 BEGIN
   DeleteRecord(rid);
   // meta_.first_free_ = rid.page_no;
-  InsertRecord(record);
+  InsertRecord(record, &rid);
   // if (page_handle.Full()) {
   //   std::cerr << "------ full! ------\n";
   //   meta_.first_free_ = page_handle.GetNextFree();
@@ -271,14 +401,315 @@ void Table::UpdateRecord(const Rid &rid, Record *record) {
   // LAB 1 END
 }
 
+void Table::InsertSlotted(Record *record, const Rid *old_rid, XID xid) {
+  LogManager &log_manager = LogManager::GetInstance();
+  RecordFactory record_factory(&meta_);
+  RecordFactory::SetCreateXid(record, xid);
+
+  // 先确认所有较长的字符串都溢出存放后记录能放入空页面
+  std::vector<OverflowValue> overflow;
+  for (size_t i = 0; i < record->GetSize(); i++) {
+    if (meta_.cols_[i].type_ == FieldType::STRING && record->GetField(i)->ToString().size() >= OVERFLOW_MIN_LENGTH) {
+      overflow.push_back({i, {NULL_PAGE, NULL_PAGE}, record->GetField(i)->ToString().size()});
+    }
+  }
+  if (record_factory.GetVarLength(record, overflow) > SLOTTED_PAGE_CAPACITY) {
+    throw RecordTooLongError(record_factory.GetVarLength(record, overflow), SLOTTED_PAGE_CAPACITY);
+  }
+  // 记录过长时依次把最长的字符串移到溢出记录中
+  overflow.clear();
+  size_t length = record_factory.GetVarLength(record, overflow);
+  while (length > SLOTTED_INLINE_MAX) {
+    size_t col = record->GetSize();
+    size_t col_length = OVERFLOW_MIN_LENGTH - 1;
+    for (size_t i = 0; i < record->GetSize(); i++) {
+      if (meta_.cols_[i].type_ != FieldType::STRING) continue;
+      bool moved = std::any_of(overflow.begin(), overflow.end(), [i](const OverflowValue &v) { return v.col == i; });
+      size_t size = record->GetField(i)->ToString().size();
+      if (!moved && size > col_length) {
+        col = i;
+        col_length = size;
+      }
+    }
+    if (col == record->GetSize()) break;
+    std::string value = record->GetField(col)->ToString();
+    overflow.push_back({col, WriteOverflow(xid, value), value.size()});
+    length = record_factory.GetVarLength(record, overflow);
+  }
+
+  // 更新产生的新版本放在旧版本所在页面时，长度相同则日志只需记录二者不同的字节
+  PageHandle page_handle;
+  bool same_page = old_rid != nullptr && ClaimPage(old_rid->page_no, length, page_handle);
+  if (!same_page) page_handle = ClaimPage(length);
+
+  Rid rid = {page_handle.page_->GetPageId().page_no, page_handle.FirstFree()};
+  try {
+    RecordFactory::SetRid(record, rid);
+    std::vector<Byte> new_record_raw(length);
+    record_factory.StoreVarRecord(new_record_raw.data(), record, overflow);
+    LSN lsn;
+    std::vector<Byte> base_raw;
+    if (same_page) base_raw = page_handle.CopyRaw(old_rid->slot_no);
+    PageUpdate update = page_handle.BeginUpdate();
+    if (same_page && base_raw.size() == length) {
+      lsn = log_manager.InsertRecordLog(xid, meta_.table_id_, rid, length, new_record_raw.data(), old_rid->slot_no,
+                                        base_raw.data());
+    } else {
+      lsn = log_manager.InsertRecordLog(xid, meta_.table_id_, rid, length, new_record_raw.data());
+    }
+    page_handle.InsertRecord(rid.slot_no, new_record_raw.data(), length, lsn);
+  } catch (...) {
+    fsm_.Release(rid.page_no, page_handle.FreeSpace());
+    throw;
+  }
+  zone_map_.Widen(rid.page_no, record);
+  fsm_.Release(rid.page_no, page_handle.FreeSpace());
+  tuples_++;
+  InsertIndexes(record, rid, xid);
+}
+
+PageHandle Table::ClaimPage(size_t length) {
+  // 映射中的记录可能过时，核对实际空闲空间，放不下的页面全部检查完后再释放，避免再次选中
+  std::vector<std::pair<PageID, size_t>> skipped;
+  PageHandle page_handle;
+  bool found = false;
+  for (PageID page_no = fsm_.Claim(length); page_no != NULL_PAGE; page_no = fsm_.Claim(length)) {
+    try {
+      page_handle = GetPage(page_no);
+    } catch (...) {
+      skipped.push_back({page_no, 0});
+      for (const auto &page : skipped) fsm_.Release(page.first, page.second);
+      throw;
+    }
+    size_t free_space = page_handle.FreeSpace();
+    if (free_space >= length) {
+      found = true;
+      break;
+    }
+    skipped.push_back({page_no, free_space});
+  }
+  for (const auto &page : skipped) fsm_.Release(page.first, page.second);
+  return found ? page_handle : CreatePage();
+}
+
+bool Table::ClaimPage(PageID page_no, size_t length, PageHandle &page_handle) {
+  if (!fsm_.Claim(page_no)) return false;
+  try {
+    page_handle = GetPage(page_no);
+  } catch (...) {
+    fsm_.Release(page_no, 0);
+    throw;
+  }
+  size_t free_space = page_handle.FreeSpace();
+  if (free_space >= length) return true;
+  fsm_.Release(page_no, free_space);
+  return false;
+}
+
+Rid Table::WriteOverflow(XID xid, const std::string &value) {
+  // 从字符串末尾开始写入，每条溢出记录都能指向已写入的下一段；每段尽量填满所选页面的剩余空间
+  LogManager &log_manager = LogManager::GetInstance();
+  Rid next = {NULL_PAGE, NULL_PAGE};
+  size_t end = value.size();
+  while (end > 0) {
+    PageHandle page_handle = ClaimPage(OVERFLOW_HEADER_SIZE + std::min(end, OVERFLOW_CHUNK_MIN));
+    size_t chunk = std::min(end, page_handle.FreeSpace() - OVERFLOW_HEADER_SIZE);
+    std::vector<Byte> raw(OVERFLOW_HEADER_SIZE + chunk);
+    raw[0] = (Byte)SlottedRecordType::OVERFLOW;
+    memcpy(raw.data() + sizeof(uint8_t), &next.page_no, sizeof(PageID));
+    memcpy(raw.data() + sizeof(uint8_t) + sizeof(PageID), &next.slot_no, sizeof(SlotID));
+    memcpy(raw.data() + OVERFLOW_HEADER_SIZE, value.data() + end - chunk, chunk);
+    Rid rid = {page_handle.page_->GetPageId().page_no, page_handle.FirstFree()};
+    try {
+      PageUpdate update = page_handle.BeginUpdate();
+      LSN lsn = log_manager.InsertRecordLog(xid, meta_.table_id_, rid, raw.size(), raw.data());
+      page_handle.InsertRecord(rid.slot_no, raw.data(), raw.size(), lsn);
+    } catch (...) {
+      fsm_.Release(rid.page_no, page_handle.FreeSpace());
+      throw;
+    }
+    fsm_.Release(rid.page_no, page_handle.FreeSpace());
+    next = rid;
+    end -= chunk;
+  }
+  return next;
+}
+
+std::string Table::ReadOverflow(const Rid &rid, size_t length) {
+  std::string value;
+  value.reserve(length);
+  Rid next = rid;
+  while (value.size() < length) {
+    if (next.page_no == NULL_PAGE || !GetPage(next.page_no).ReadOverflow(next.slot_no, value, next)) {
+      std::cerr << "Error in Table::ReadOverflow\n";
+      throw UnknownError();
+    }
+  }
+  return value;
+}
+
+VacuumResult Table::Vacuum(XID xid, XID oldest_xid) {
+  if (read_only_) throw ReadOnlyError();
+  std::lock_guard<std::mutex> vacuum_lock(vacuum_mutex_);
+  LogManager &log_manager = LogManager::GetInstance();
+  VacuumResult result = {0, 0, 0, 0};
+  // 释放的记录位置，之后移除索引中指向它们的项
+  std::set<std::pair<PageID, SlotID>> reclaimed;
+  PageID table_end = table_end_;
+  ReadAheadState read_ahead;
+  for (PageID page_no = 0; page_no < table_end; page_no++) {
+    ReadAhead(page_no, read_ahead);
+    PageHandle page_handle = GetPage(page_no);
+    uint64_t zone_version;
+    bool zone_known = zone_map_.GetVersion(page_no, zone_version);
+    std::vector<SlotID> dead;
+    size_t deleted = 0;
+    result.tuples += page_handle.CollectDead(oldest_xid, dead, deleted);
+    result.dead_tuples += deleted;
+    result.pages++;
+    if (dead.empty()) {
+      if (!zone_known) ComputeZone(page_handle, zone_version);
+      continue;
+    }
+    for (SlotID slot_no : dead) {
+      // 被清理的记录不会再被修改，释放记录后再释放其溢出记录，中途崩溃只会遗留无法访问的溢出记录
+      std::vector<OverflowValue> overflow;
+      size_t length = meta_.record_length_;
+      if (meta_.layout_ == TableLayout::SLOTTED) {
+        std::vector<Byte> raw = page_handle.CopyRaw(slot_no);
+        RecordFactory record_factory(&meta_);
+        delete record_factory.LoadVarRecord(raw.data(), &overflow);
+        length = raw.size();
+      }
+      {
+        PageUpdate update = page_handle.BeginUpdate();
+        LSN lsn = log_manager.VacuumRecordLog(xid, meta_.table_id_, {page_no, slot_no}, length);
+        page_handle.DeleteRecord(slot_no, lsn);
+      }
+      for (const auto &value : overflow) VacuumOverflow(xid, value.rid);
+      reclaimed.insert({page_no, slot_no});
+    }
+    UpdateFreeSpace(page_handle);
+    // 释放记录后按其余的记录版本缩小摘要
+    ComputeZone(page_handle, zone_version);
+    result.reclaimed += dead.size();
+  }
+  // 释放的位置可能已被新记录占用，新记录的键与项相同时保留该项
+  for (Index *index : GetIndexes()) {
+    if (reclaimed.empty()) break;
+    index->BulkDelete(xid, [&](const Byte *key, const Rid &rid) {
+      if (reclaimed.count({rid.page_no, rid.slot_no}) == 0) return false;
+      Record *record = GetPage(rid.page_no).GetRecord(rid.slot_no);
+      bool dead = record == nullptr || !index->KeyEquals(key, record->GetField(index->GetColumn()));
+      delete record;
+      return dead;
+    });
+  }
+  // 清理期间的插入与删除不计入，统计值只是估计
+  tuples_ = result.tuples;
+  dead_tuples_ = result.dead_tuples;
+  vacuums_++;
+  reclaimed_ += result.reclaimed;
+  return result;
+}
+
+void Table::VacuumOverflow(XID xid, Rid rid) {
+  LogManager &log_manager = LogManager::GetInstance();
+  while (rid.page_no != NULL_PAGE) {
+    PageHandle page_handle = GetPage(rid.page_no);
+    std::string chunk;
+    Rid next;
+    if (!page_handle.ReadOverflow(rid.slot_no, chunk, next)) {
+      std::cerr << "Error in Table::VacuumOverflow\n";
+      throw UnknownError();
+    }
+    {
+      PageUpdate update = page_handle.BeginUpdate();
+      LSN lsn = log_manager.VacuumRecordLog(xid, meta_.table_id_, rid, OVERFLOW_HEADER_SIZE + chunk.size());
+      page_handle.DeleteRecord(rid.slot_no, lsn);
+    }
+    UpdateFreeSpace(page_handle);
+    rid = next;
+  }
+}
+
+VacuumStats Table::GetVacuumStats() const { return {tuples_, dead_tuples_, vacuums_, reclaimed_}; }
+
+void Table::AddIndex(Index *index) {
+  std::unique_lock<std::shared_mutex> indexes_lock(indexes_mutex_);
+  indexes_.push_back(index);
+}
+
+void Table::RemoveIndex(Index *index) {
+  std::unique_lock<std::shared_mutex> indexes_lock(indexes_mutex_);
+  indexes_.erase(std::remove(indexes_.begin(), indexes_.end(), index), indexes_.end());
+}
+
+std::vector<Index *> Table::GetIndexes() {
+  std::shared_lock<std::shared_mutex> indexes_lock(indexes_mutex_);
+  return indexes_;
+}
+
+Index *Table::GetIndex(int col_idx, bool range) {
+  Index *found = nullptr;
+  for (Index *index : GetIndexes()) {
+    if (index->GetColumn() != col_idx || !index->IsValid()) continue;
+    if (index->SupportsRange()) {
+      if (found == nullptr) found = index;
+    } else if (!range) {
+      return index;
+    }
+  }
+  return found;
+}
+
+void Table::InsertIndexes(Record *record, const Rid &rid, XID xid) {
+  // 索引在建立期间已加入，建立时的扫描从加入之后开始，不会漏掉并发插入的记录
+  for (Index *index : GetIndexes()) index->Insert(xid, record->GetField(index->GetColumn()), rid);
+}
+
+void Table::BuildIndex(Index *index, XID xid) {
+  std::lock_guard<std::mutex> vacuum_lock(vacuum_mutex_);
+  PageID table_end = table_end_;
+  ReadAheadState read_ahead;
+  for (PageID page_no = 0; page_no < table_end; page_no++) {
+    ReadAhead(page_no, read_ahead);
+    RecordList records = GetPage(page_no).LoadRecords();
+    try {
+      for (Record *record : records) {
+        index->Insert(xid, record->GetField(index->GetColumn()), RecordFactory::GetRid(record));
+      }
+    } catch (...) {
+      for (Record *record : records) delete record;
+      throw;
+    }
+    for (Record *record : records) delete record;
+  }
+}
+
 int Table::GetColumnSize() const { return meta_.GetSize(); }
 
-TableMeta Table::GetMeta() const { return meta_; }
+TableMeta Table::GetMeta() const {
+  TableMeta meta = meta_;
+  meta.table_end_page_ = table_end_;
+  return meta;
+}
 
 string Table::GetName() const { return table_name_; }
 
+TableID Table::GetID() const { return meta_.table_id_; }
+
 bool Table::IsHiddenColumn(const string &col_name) const { return col_name[0] == '-'; }
 
+std::vector<int> Table::ZoneColumns() const {
+  std::vector<int> cols;
+  for (size_t i = 0; i < meta_.cols_.size(); i++) {
+    const Column &col = meta_.cols_[i];
+    if (!IsHiddenColumn(col.name_) && (col.type_ == FieldType::INT || col.type_ == FieldType::FLOAT)) cols.push_back(i);
+  }
+  return cols;
+}
+
 int Table::GetColumnIdx(string col_name) const {
   // 所有的隐藏列都不满足正常明明要求
   auto col_it = std::find_if(meta_.cols_.begin(), meta_.cols_.end(),
@@ -302,4 +733,6 @@ vector<string> Table::GetColumnNames() const {
 
 FieldType Table::GetColumnType(int col_idx) const { return meta_.cols_[col_idx].type_; }
 
+size_t Table::GetColumnLen(int col_idx) const { return meta_.cols_[col_idx].len_; }
+
 }  // namespace dbtrain
@@ -1,21 +1,47 @@
 #ifndef DBTRAIN_TABLE_H
 #define DBTRAIN_TABLE_H
 
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 
 #include "../defines.h"
 #include "../record/record.h"
 #include "../result/result.h"
 #include "../storage/buffer_manager.h"
+#include "../storage/mapped_file.h"
+#include "../table/free_space_map.h"
 #include "../table/page_handle.h"
 #include "../table/table_meta.h"
+#include "../table/zone_map.h"
 
 namespace dbtrain {
 
+class Index;
+
+// 一次清理的结果：扫描的页面数、释放的记录数，以及清理后表中其余的记录数与其中已标记删除的记录数
+struct VacuumResult {
+  PageID pages;
+  size_t reclaimed;
+  size_t tuples;
+  size_t dead_tuples;
+};
+
+// 表的记录版本统计，打开表后按插入与删除累计，每次清理后按扫描结果校正
+struct VacuumStats {
+  size_t tuples;
+  // 已标记删除、尚未清理的记录数
+  size_t dead_tuples;
+  size_t vacuums;
+  size_t reclaimed;
+};
+
 class Table {
  public:
   Table(const std::string &table_name, int meta_fd, int data_fd);
-  Table(const std::string &table_name, int meta_fd, int data_fd, const std::vector<Column> &columns);
+  Table(const std::string &table_name, int meta_fd, int data_fd, const std::vector<Column> &columns, TableID table_id,
+        TableLayout layout = TableLayout::FIXED);
   ~Table();
 
   Result Desc();
@@ -36,25 +62,97 @@ class Table {
   int GetColumnSize() const;
 
  public:
+  // 新建的页面由调用者在空闲空间映射中占用
   PageHandle CreatePage();
   PageHandle GetPage(PageID page_id);
+  // 顺序扫描读取 page_id 前调用，从 page_id 开始预读数据页，state 由扫描者持有
+  void ReadAhead(PageID page_id, ReadAheadState &state);
+  // 预读指定的数据页，页号需升序排列
+  void Prefetch(const vector<PageID> &pages);
+  // 只读模式：写回数据文件后改为内存映射访问，之后表不可修改
+  // 压缩存放的数据文件不能直接映射，仍经过缓冲池读取
+  void MapData();
   string GetName() const;
+  TableID GetID() const;
   vector<string> GetColumnNames() const;
   FieldType GetColumnType(int col_idx) const;
+  size_t GetColumnLen(int col_idx) const;
   void StoreMeta();
+  // 元信息只在检查点与关闭时写回，恢复时表尾需扩展到日志与数据文件中出现的页面，
+  // 扩展出的页面在空闲空间映射中记为没有空闲空间，直到页面被重做或清理；数据文件同时补齐到表尾
+  void ExtendTo(PageID page_end);
+  // 按页面当前内容更新空闲空间映射
+  void UpdateFreeSpace(PageHandle &page_handle);
+  // 页面摘要表明页面中没有记录能满足 bounds 时返回 false，bounds 只能限制 ZoneTracks 的列
+  bool PageMayMatch(PageID page_no, const std::vector<ZoneBound> &bounds);
+  void CountSkippedPage();
+  // 页面摘要未知时读取页面中的所有记录版本计算摘要
+  void FillZone(PageID page_no);
+  // 回滚与重做可能向页面写入摘要范围之外的值
+  void InvalidateZone(PageID page_no);
+  bool ZoneTracks(int col_idx) const;
+  ZoneStats GetZoneStats();
+  // 读取从 rid 开始的溢出记录链中保存的长为 length 的字符串
+  std::string ReadOverflow(const Rid &rid, size_t length);
+  // 在清理事务 xid 中释放删除版本号小于 oldest_xid 的记录及其溢出记录，并更新空闲空间映射
+  VacuumResult Vacuum(XID xid, XID oldest_xid);
+  VacuumStats GetVacuumStats() const;
+  // 表上的索引由 SystemManager 创建与删除，加入后插入的记录同时写入索引
+  void AddIndex(Index *index);
+  void RemoveIndex(Index *index);
+  std::vector<Index *> GetIndexes();
+  // 列上已建立完成的索引，没有时返回空；range 为 true 时只返回支持范围扫描的索引，否则优先返回哈希索引
+  Index *GetIndex(int col_idx, bool range);
+  // 在事务 xid 中把表中所有记录的所有版本写入索引，期间不清理
+  void BuildIndex(Index *index, XID xid);
 
  private:
   TableMeta meta_;
+  // 并发插入会扩展表尾，meta_ 中的表尾只在打开时读取，GetMeta 与 Store 使用此值
+  std::atomic<PageID> table_end_{0};
 
   std::string table_name_;
   int data_fd_;
   int meta_fd_;
 
-  bool meta_modified = false;
+  std::atomic<bool> meta_modified{false};
+  // 保护表尾的扩展，空槽的选择由空闲空间映射对页面的占用保护
+  std::mutex extend_mutex_;
+  FreeSpaceMap fsm_;
+  ZoneMap zone_map_;
+  // 同一时间只有一个清理，被清理的记录对所有事务都不可见，清理与其他修改只通过页面的锁互斥
+  std::mutex vacuum_mutex_;
+  std::atomic<size_t> tuples_{0};
+  std::atomic<size_t> dead_tuples_{0};
+  std::atomic<size_t> vacuums_{0};
+  std::atomic<size_t> reclaimed_{0};
+  std::shared_mutex indexes_mutex_;
+  std::vector<Index *> indexes_;
 
   BufferManager &buffer_manager_;
+  // 只读模式下数据页直接从映射中读取
+  MappedFile *mapped_ = nullptr;
+  bool read_only_ = false;
 
   bool IsHiddenColumn(const string &col_name) const;
+  // 页面摘要记录的列：非隐藏的 INT 与 FLOAT 列
+  std::vector<int> ZoneColumns() const;
+  // 以读取页面前取得的修改计数保存页面当前的摘要
+  void ComputeZone(PageHandle &page_handle, uint64_t version);
+  // old_rid 不为空时为更新产生的新版本，优先放在旧版本所在页面
+  void InsertRecord(Record *record, const Rid *old_rid);
+  // SLOTTED 布局的插入
+  void InsertSlotted(Record *record, const Rid *old_rid, XID xid);
+  // 从空闲空间映射中占用一个能放下 length 字节记录的页面，没有时创建新页面，用完后通过 fsm_.Release 释放
+  PageHandle ClaimPage(size_t length);
+  // 占用旧版本所在页面，页面已被占用或放不下 length 字节时返回 false
+  bool ClaimPage(PageID page_no, size_t length, PageHandle &page_handle);
+  // 把字符串写入溢出记录链，返回第一条溢出记录的位置
+  Rid WriteOverflow(XID xid, const std::string &value);
+  // 清理从 rid 开始的溢出记录链
+  void VacuumOverflow(XID xid, Rid rid);
+  // 记录插入堆页面后写入各索引
+  void InsertIndexes(Record *record, const Rid &rid, XID xid);
 };
 
 }  // namespace dbtrain
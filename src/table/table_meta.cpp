@@ -43,12 +43,13 @@ int TableMeta::Load(const uint8_t *src) {
   memcpy(&table_end_page_, src + offset, sizeof(int));
   // std::cerr << "table_end_page_: " << table_end_page_ << "\n";
   offset += sizeof(int);
-  memcpy(&first_free_, src + offset, sizeof(PageID));
-  // std::cerr << "first_free_: " << first_free_ << "\n";
-  offset += sizeof(PageID);
   memcpy(&bitmap_length_, src + offset, sizeof(int));
   // std::cerr << "bitmap_length_: " << bitmap_length_ << "\n";
+  offset += sizeof(int);
+  memcpy(&table_id_, src + offset, sizeof(TableID));
   // std::cerr << "cols_[0]: " << cols_[0].len_ << " " << int(cols_[0].type_) << "\n";
+  offset += sizeof(TableID);
+  memcpy(&layout_, src + offset, sizeof(TableLayout));
 
   return 0;
   // LAB 1 END
@@ -87,13 +88,14 @@ int TableMeta::Store(uint8_t *dst) {
   memcpy(dst + offset, &table_end_page_, sizeof(int));
   // std::cerr << "table_end_page_: " << table_end_page_ << "\n";
   offset += sizeof(int);
-  memcpy(dst + offset, &first_free_, sizeof(PageID));
-  // std::cerr << "first_free_: " << first_free_ << "\n";
-  offset += sizeof(PageID);
   memcpy(dst + offset, &bitmap_length_, sizeof(int));
   // std::cerr << "bitmap_length_: " << bitmap_length_ << "\n";
+  offset += sizeof(int);
+  memcpy(dst + offset, &table_id_, sizeof(TableID));
   // std::cerr << "cols_[0]: " << cols_[0].len_ << " " << int(cols_[0].type_) << "\n";
-  
+  offset += sizeof(TableID);
+  memcpy(dst + offset, &layout_, sizeof(TableLayout));
+
   return 0;
   // LAB 1 END
 }
@@ -110,4 +112,15 @@ size_t TableMeta::GetLength() const {
 
 PageID TableMeta::GetTableEnd() const { return table_end_page_; }
 
+TableLayout TableMeta::GetLayout() const { return layout_; }
+
+size_t TableMeta::GetMinLength() const {
+  // 记录类型字节，字符串为空时只有一个字节的长度
+  size_t length = sizeof(uint8_t);
+  for (const auto &col : cols_) {
+    length += col.type_ == FieldType::STRING ? 1 : col.len_;
+  }
+  return length;
+}
+
 }  // namespace dbtrain
@@ -14,6 +14,12 @@ struct Column {
   std::string name_;
 };
 
+// 数据页布局：FIXED 为定长槽加 bitmap，字符串按声明的最大长度存放；
+// SLOTTED 为槽目录加变长记录，字符串只存放实际内容，较长的值存放在溢出记录中；
+// PAX 的 bitmap 与每页记录数同 FIXED，bitmap 之后每列（包括隐藏列）的值在各自的小页中连续存放，
+// 只读取部分列的扫描只访问这些列的小页
+enum class TableLayout : uint8_t { FIXED, SLOTTED, PAX };
+
 class TableMeta {
  public:
   TableMeta() = default;
@@ -24,6 +30,9 @@ class TableMeta {
   size_t GetSize() const;
   size_t GetLength() const;
   PageID GetTableEnd() const;
+  TableLayout GetLayout() const;
+  // SLOTTED 布局中最短的记录长度，页面剩余空间不足该值时视为已满
+  size_t GetMinLength() const;
 
  private:
   vector<Column> cols_;
@@ -33,8 +42,9 @@ class TableMeta {
   int record_length_; // 每条记录的长度
   int record_per_page_; // 每一页存放多少条记录
   int table_end_page_; // 表的最后一页 / 表的总页面数
-  PageID first_free_; // 第一个有空闲槽位的页面
   int bitmap_length_; // 页头 bitmap 的长度
+  TableID table_id_; // 表编号，日志中以编号代替表名
+  TableLayout layout_ = TableLayout::FIXED; // 数据页布局
 
   friend class Table;
   friend class PageHandle;
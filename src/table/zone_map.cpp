@@ -0,0 +1,120 @@
+#include "zone_map.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "../record/fields.h"
+
+namespace dbtrain {
+
+static double NumericValue(const Field *field) {
+  if (field->GetType() == FieldType::INT) return dynamic_cast<const IntField *>(field)->GetValue();
+  return dynamic_cast<const FloatField *>(field)->GetValue();
+}
+
+static const ZoneRange EMPTY_RANGE = {DBL_MAX, -DBL_MAX};
+
+void ZoneMap::Load(const std::vector<int> &cols, PageID page_count) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cols_ = cols;
+  col_pos_.clear();
+  for (size_t i = 0; i < cols_.size(); i++) {
+    if ((int)col_pos_.size() <= cols_[i]) col_pos_.resize(cols_[i] + 1, -1);
+    col_pos_[cols_[i]] = i;
+  }
+  known_.assign(page_count, false);
+  versions_.assign(page_count, 0);
+  ranges_.assign((size_t)page_count * cols_.size(), EMPTY_RANGE);
+}
+
+ZoneRange *ZoneMap::Ranges(PageID page_no) { return ranges_.data() + (size_t)page_no * cols_.size(); }
+
+void ZoneMap::Grow(PageID page_end) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (page_end <= (PageID)known_.size()) return;
+  known_.resize(page_end, false);
+  versions_.resize(page_end, 0);
+  ranges_.resize((size_t)page_end * cols_.size(), EMPTY_RANGE);
+}
+
+void ZoneMap::Extend(PageID page_no) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (page_no >= (PageID)known_.size()) {
+    known_.resize(page_no + 1, false);
+    versions_.resize(page_no + 1, 0);
+    ranges_.resize((size_t)(page_no + 1) * cols_.size(), EMPTY_RANGE);
+  }
+  known_[page_no] = true;
+  versions_[page_no]++;
+  std::fill(Ranges(page_no), Ranges(page_no) + cols_.size(), EMPTY_RANGE);
+}
+
+void ZoneMap::Widen(PageID page_no, const Record *record) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (page_no >= (PageID)known_.size()) return;
+  versions_[page_no]++;
+  if (!known_[page_no]) return;
+  ZoneRange *ranges = Ranges(page_no);
+  for (size_t i = 0; i < cols_.size(); i++) {
+    double value = NumericValue(record->GetField(cols_[i]));
+    ranges[i].min = std::min(ranges[i].min, value);
+    ranges[i].max = std::max(ranges[i].max, value);
+  }
+}
+
+void ZoneMap::Invalidate(PageID page_no) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (page_no >= (PageID)known_.size()) return;
+  versions_[page_no]++;
+  known_[page_no] = false;
+}
+
+bool ZoneMap::GetVersion(PageID page_no, uint64_t &version) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // 尚未加入映射的页面不保存摘要
+  if (page_no >= (PageID)known_.size()) {
+    version = UINT64_MAX;
+    return false;
+  }
+  version = versions_[page_no];
+  return known_[page_no];
+}
+
+void ZoneMap::Set(PageID page_no, uint64_t version, const RecordList &records) {
+  std::vector<ZoneRange> computed(cols_.size(), EMPTY_RANGE);
+  for (const Record *record : records) {
+    for (size_t i = 0; i < cols_.size(); i++) {
+      double value = NumericValue(record->GetField(cols_[i]));
+      computed[i].min = std::min(computed[i].min, value);
+      computed[i].max = std::max(computed[i].max, value);
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (page_no >= (PageID)known_.size() || versions_[page_no] != version) return;
+  known_[page_no] = true;
+  std::copy(computed.begin(), computed.end(), Ranges(page_no));
+}
+
+bool ZoneMap::MayMatch(PageID page_no, const std::vector<ZoneBound> &bounds) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (page_no >= (PageID)known_.size() || !known_[page_no]) return true;
+  const ZoneRange *ranges = Ranges(page_no);
+  for (const ZoneBound &bound : bounds) {
+    const ZoneRange &range = ranges[col_pos_[bound.col]];
+    bool miss = range.min > range.max || (bound.low_open ? range.max <= bound.low : range.max < bound.low) ||
+                (bound.high_open ? range.min >= bound.high : range.min > bound.high);
+    if (miss) return false;
+  }
+  return true;
+}
+
+bool ZoneMap::Tracks(int col) const { return col >= 0 && col < (int)col_pos_.size() && col_pos_[col] != -1; }
+
+void ZoneMap::CountSkipped() { skipped_++; }
+
+ZoneStats ZoneMap::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return {(PageID)std::count(known_.begin(), known_.end(), true), skipped_};
+}
+
+}  // namespace dbtrain
@@ -0,0 +1,76 @@
+#ifndef DBTRAIN_ZONE_MAP_H
+#define DBTRAIN_ZONE_MAP_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "../defines.h"
+#include "../record/record.h"
+
+namespace dbtrain {
+
+// 一个数值列在页面所有记录版本上的取值范围，min 大于 max 表示页面中没有记录
+struct ZoneRange {
+  double min;
+  double max;
+};
+
+// 扫描条件对一个数值列的限制，open 为 true 时不含该端点
+struct ZoneBound {
+  int col;
+  double low;
+  double high;
+  bool low_open;
+  bool high_open;
+};
+
+// 摘要已知的页面数与带条件的扫描跳过的页面数
+struct ZoneStats {
+  PageID known_pages;
+  size_t skipped_pages;
+};
+
+// 页面摘要：每个数据页中 INT 与 FLOAT 列的最小值与最大值，只保存在内存中
+// 打开表后已有页面的摘要未知，新建的页面从空范围开始；带条件的扫描与清理读取页面时计算摘要
+// 插入扩大范围，标记删除不修改范围，回滚与重做修改过的页面重新记为未知
+// 修改页面之后再修改摘要，计算摘要前取得的修改计数已经变化时丢弃计算结果
+class ZoneMap {
+ public:
+  // 记录 cols 中各列的范围，前 page_count 个页面的摘要未知
+  void Load(const std::vector<int> &cols, PageID page_count);
+  // 扩展到 page_end 个页面，新增页面的摘要未知
+  void Grow(PageID page_end);
+  // 新建的空页面
+  void Extend(PageID page_no);
+  // 记录写入页面后扩大范围，摘要未知时只增加修改计数
+  void Widen(PageID page_no, const Record *record);
+  void Invalidate(PageID page_no);
+  // 读取页面之前取得修改计数，返回摘要是否已知
+  bool GetVersion(PageID page_no, uint64_t &version);
+  // records 为页面中的所有记录版本，修改计数仍为 version 时保存摘要
+  void Set(PageID page_no, uint64_t version, const RecordList &records);
+  // 摘要已知且页面中没有记录能满足 bounds 时返回 false
+  bool MayMatch(PageID page_no, const std::vector<ZoneBound> &bounds);
+  bool Tracks(int col) const;
+  // 扫描因摘要跳过了一个页面
+  void CountSkipped();
+  ZoneStats GetStats();
+
+ private:
+  ZoneRange *Ranges(PageID page_no);
+
+  std::vector<int> cols_;
+  // 列在 cols_ 中的位置，不记录的列为 -1
+  std::vector<int> col_pos_;
+  std::mutex mutex_;
+  std::vector<bool> known_;
+  std::vector<uint64_t> versions_;
+  // 每个页面 cols_.size() 个范围
+  std::vector<ZoneRange> ranges_;
+  std::atomic<size_t> skipped_{0};
+};
+
+}  // namespace dbtrain
+
+#endif
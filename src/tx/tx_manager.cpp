@@ -1,5 +1,7 @@
 #include "tx_manager.h"
 
+#include <algorithm>
+
 #include "log/log_manager.h"
 
 namespace dbtrain {
@@ -43,6 +45,7 @@ XID TxManager::Get(TID tid) {
 std::set<XID> TxManager::ActiveXIDs() {
   auto active_xids = std::set<XID>();
   for (const auto &pair : tx_map_) active_xids.insert(pair.second);
+  active_xids.insert(recovering_.begin(), recovering_.end());
   return active_xids;
 }
 
@@ -54,7 +57,50 @@ std::set<XID> TxManager::GetActiveSet(XID xid) {
   return actset;
 }
 
-void TxManager::SetXID(XID xid) { current_xid_ = xid; }
-XID TxManager::GetXID() { return current_xid_; }
+XID TxManager::GetOldestXID() {
+  tx_lock_.lock();
+  XID oldest = current_xid_;
+  // actset_map_ 的键为所有正在运行的事务，值为其开始时仍在运行的事务
+  for (const auto &pair : actset_map_) {
+    oldest = std::min(oldest, pair.first);
+    if (!pair.second.empty()) oldest = std::min(oldest, *pair.second.begin());
+  }
+  if (!recovering_.empty()) oldest = std::min(oldest, *recovering_.begin());
+  tx_lock_.unlock();
+  return oldest;
+}
+
+size_t TxManager::ActiveCount() {
+  tx_lock_.lock();
+  size_t count = tx_map_.size();
+  tx_lock_.unlock();
+  return count;
+}
+
+void TxManager::SetXID(XID xid) {
+  tx_lock_.lock();
+  current_xid_ = xid;
+  tx_lock_.unlock();
+}
+
+void TxManager::SetRecovering(const std::set<XID> &xids) {
+  tx_lock_.lock();
+  recovering_ = xids;
+  tx_lock_.unlock();
+}
+
+void TxManager::EndRecovering(XID xid) {
+  tx_lock_.lock();
+  recovering_.erase(xid);
+  tx_lock_.unlock();
+}
+
+// 后台检查点线程也会读取
+XID TxManager::GetXID() {
+  tx_lock_.lock();
+  XID xid = current_xid_;
+  tx_lock_.unlock();
+  return xid;
+}
 
 }  // namespace dbtrain
@@ -19,12 +19,22 @@ class TxManager {
   XID Pop(TID tid);
   XID Get(TID tid);
 
+  // 正在运行的事务数
+  size_t ActiveCount();
+
   void SetXID(XID xid);
   XID GetXID();
 
+  // 崩溃恢复后在后台回滚的事务，回滚完成前视为正在运行，其修改对新事务不可见
+  void SetRecovering(const std::set<XID> &xids);
+  void EndRecovering(XID xid);
+
   // TIPS: 获取对应事务开始时仍在运行的事务编号集合
   // TIPS: 用于MVCC数据读取过程中过滤无效数据
   std::set<XID> GetActiveSet(XID xid);
+  // 清理的界限：编号小于该值的事务均已结束，且正在运行的事务开始时它们都已结束
+  // 删除版本号小于该值的记录对所有正在运行与之后开始的事务都不可见
+  XID GetOldestXID();
 
  private:
   TxManager();
@@ -33,6 +43,7 @@ class TxManager {
   std::mutex tx_lock_;
   std::map<TID, XID> tx_map_;
   std::map<XID, std::set<XID>> actset_map_;
+  std::set<XID> recovering_;
   XID current_xid_;
 };
 
@@ -0,0 +1,70 @@
+#include "crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace dbtrain {
+
+namespace {
+
+struct Crc32cTable {
+  uint32_t table[8][256];
+  Crc32cTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int j = 0; j < 8; j++) crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78 : 0);
+      table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+      for (int k = 1; k < 8; k++) table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+    }
+  }
+};
+
+const Crc32cTable crc_table;
+
+#if defined(__x86_64__)
+// SSE4.2 的 crc32 指令使用同一多项式，每条指令处理 8 字节
+__attribute__((target("sse4.2"))) uint32_t Crc32cHardware(const uint8_t *p, size_t size, uint32_t crc) {
+  uint64_t crc64 = crc;
+  while (size >= 8) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    crc64 = _mm_crc32_u64(crc64, value);
+    p += 8;
+    size -= 8;
+  }
+  crc = (uint32_t)crc64;
+  while (size-- > 0) crc = _mm_crc32_u8(crc, *p++);
+  return crc;
+}
+
+const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+#endif
+
+}  // namespace
+
+uint32_t Crc32c(const void *data, size_t size, uint32_t crc) {
+  const uint8_t *p = (const uint8_t *)data;
+  crc = ~crc;
+#if defined(__x86_64__)
+  if (has_sse42) return ~Crc32cHardware(p, size, crc);
+#endif
+  // slicing-by-8，每次处理 8 字节
+  const auto &t = crc_table.table;
+  while (size >= 8) {
+    uint32_t lo = (p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24)) ^ crc;
+    uint32_t hi = p[4] | (p[5] << 8) | (p[6] << 16) | ((uint32_t)p[7] << 24);
+    crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^ t[3][hi & 0xFF] ^
+          t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    p += 8;
+    size -= 8;
+  }
+  while (size-- > 0) crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+  return ~crc;
+}
+
+}  // namespace dbtrain
@@ -0,0 +1,15 @@
+#ifndef DBTRAIN_CRC32C_H
+#define DBTRAIN_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dbtrain {
+
+// CRC-32C (Castagnoli)，crc 为之前数据的校验值，可分段计算
+// x86-64 上 CPU 支持 SSE4.2 时使用硬件指令
+uint32_t Crc32c(const void *data, size_t size, uint32_t crc = 0);
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_CRC32C_H
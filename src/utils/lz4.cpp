@@ -0,0 +1,135 @@
+#include "lz4.h"
+
+#include <cstring>
+#include <vector>
+
+namespace dbtrain {
+
+namespace {
+
+const size_t MIN_MATCH = 4;
+// 块末尾至少 5 字节为字面量，最后一个匹配至少在结尾前 12 字节开始
+const size_t LAST_LITERALS = 5;
+const size_t MF_LIMIT = 12;
+const size_t MAX_OFFSET = 65535;
+const int HASH_BITS = 12;
+
+uint32_t Read32(const uint8_t *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint32_t Hash(uint32_t sequence) { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+// 写入长度的扩展字节，每个 255 表示之后还有字节
+uint8_t *PutLength(uint8_t *op, size_t length) {
+  while (length >= 255) {
+    *op++ = 255;
+    length -= 255;
+  }
+  *op++ = (uint8_t)length;
+  return op;
+}
+
+}  // namespace
+
+size_t Lz4CompressBound(size_t size) { return size + size / 255 + 16; }
+
+size_t Lz4Compress(const uint8_t *src, size_t size, uint8_t *dst, size_t capacity) {
+  uint8_t *op = dst;
+  uint8_t *op_end = dst + capacity;
+  size_t anchor = 0;
+  if (size > MF_LIMIT) {
+    // 记录每个 4 字节序列最近出现的位置加一，0 表示没有出现
+    std::vector<uint32_t> table(1 << HASH_BITS, 0);
+    size_t match_limit = size - MF_LIMIT;
+    size_t ip = 0;
+    while (ip < match_limit) {
+      uint32_t sequence = Read32(src + ip);
+      uint32_t &slot = table[Hash(sequence)];
+      size_t candidate = slot;
+      slot = ip + 1;
+      if (candidate == 0 || ip - (candidate - 1) > MAX_OFFSET || Read32(src + candidate - 1) != sequence) {
+        ip++;
+        continue;
+      }
+      size_t ref = candidate - 1;
+      while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+        ip--;
+        ref--;
+      }
+      size_t match_length = MIN_MATCH;
+      while (ip + match_length < size - LAST_LITERALS && src[ip + match_length] == src[ref + match_length]) {
+        match_length++;
+      }
+      size_t literal_length = ip - anchor;
+      size_t need = 1 + literal_length / 255 + 1 + literal_length + 2 + (match_length - MIN_MATCH) / 255 + 1;
+      if ((size_t)(op_end - op) < need) return 0;
+      uint8_t *token = op++;
+      *token = (uint8_t)((literal_length >= 15 ? 15 : literal_length) << 4);
+      if (literal_length >= 15) op = PutLength(op, literal_length - 15);
+      memcpy(op, src + anchor, literal_length);
+      op += literal_length;
+      size_t offset = ip - ref;
+      *op++ = (uint8_t)(offset & 0xFF);
+      *op++ = (uint8_t)(offset >> 8);
+      size_t extra = match_length - MIN_MATCH;
+      *token |= (uint8_t)(extra >= 15 ? 15 : extra);
+      if (extra >= 15) op = PutLength(op, extra - 15);
+      ip += match_length;
+      anchor = ip;
+    }
+  }
+  // 最后一个序列只有字面量
+  size_t literal_length = size - anchor;
+  size_t need = 1 + literal_length / 255 + 1 + literal_length;
+  if ((size_t)(op_end - op) < need) return 0;
+  *op++ = (uint8_t)((literal_length >= 15 ? 15 : literal_length) << 4);
+  if (literal_length >= 15) op = PutLength(op, literal_length - 15);
+  memcpy(op, src + anchor, literal_length);
+  op += literal_length;
+  return op - dst;
+}
+
+bool Lz4Decompress(const uint8_t *src, size_t compressed_size, uint8_t *dst, size_t size) {
+  size_t ip = 0;
+  size_t op = 0;
+  while (true) {
+    if (ip >= compressed_size) return false;
+    uint8_t token = src[ip++];
+    size_t literal_length = token >> 4;
+    if (literal_length == 15) {
+      uint8_t byte;
+      do {
+        if (ip >= compressed_size) return false;
+        byte = src[ip++];
+        literal_length += byte;
+      } while (byte == 255);
+    }
+    if (literal_length > compressed_size - ip || literal_length > size - op) return false;
+    memcpy(dst + op, src + ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+    if (ip == compressed_size) break;
+    if (compressed_size - ip < 2) return false;
+    size_t offset = src[ip] | (src[ip + 1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > op) return false;
+    size_t match_length = (token & 15) + MIN_MATCH;
+    if ((token & 15) == 15) {
+      uint8_t byte;
+      do {
+        if (ip >= compressed_size) return false;
+        byte = src[ip++];
+        match_length += byte;
+      } while (byte == 255);
+    }
+    if (match_length > size - op) return false;
+    // 匹配可能与输出重叠，逐字节复制
+    for (size_t i = 0; i < match_length; i++, op++) dst[op] = dst[op - offset];
+  }
+  return op == size;
+}
+
+}  // namespace dbtrain
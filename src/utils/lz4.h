@@ -0,0 +1,19 @@
+#ifndef DBTRAIN_LZ4_H
+#define DBTRAIN_LZ4_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dbtrain {
+
+// LZ4 块格式的压缩与解压，与 liblz4 的 LZ4_compress_default/LZ4_decompress_safe 格式兼容
+// 输出缓冲不小于 Lz4CompressBound(size) 时压缩总能成功
+size_t Lz4CompressBound(size_t size);
+// 返回压缩后的长度，输出缓冲不足时返回 0
+size_t Lz4Compress(const uint8_t *src, size_t size, uint8_t *dst, size_t capacity);
+// 解压结果必须恰好为 size 字节，数据损坏时返回 false
+bool Lz4Decompress(const uint8_t *src, size_t compressed_size, uint8_t *dst, size_t size);
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_LZ4_H
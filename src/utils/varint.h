@@ -0,0 +1,47 @@
+#ifndef DBTRAIN_VARINT_H
+#define DBTRAIN_VARINT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dbtrain {
+
+// 无符号整数的变长编码，每字节存放 7 位，最高位为 1 表示之后还有字节，小于 128 的值只占一个字节
+inline size_t VarintLength(uint64_t value) {
+  size_t length = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    length++;
+  }
+  return length;
+}
+
+// 返回写入的字节数
+inline size_t PutVarint(uint8_t *dst, uint64_t value) {
+  size_t length = 0;
+  while (value >= 0x80) {
+    dst[length++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  dst[length++] = (uint8_t)value;
+  return length;
+}
+
+// 返回读取的字节数
+template <class T>
+inline size_t GetVarint(const uint8_t *src, T &value) {
+  uint64_t result = 0;
+  size_t length = 0;
+  int shift = 0;
+  while (src[length] & 0x80) {
+    result |= (uint64_t)(src[length++] & 0x7F) << shift;
+    shift += 7;
+  }
+  result |= (uint64_t)src[length++] << shift;
+  value = (T)result;
+  return length;
+}
+
+}  // namespace dbtrain
+
+#endif  // DBTRAIN_VARINT_H
@@ -0,0 +1,81 @@
+// 多个线程同时写入修改同一页面的日志，LSN 到达 DPT 的顺序与分配顺序不同
+// 检查 DPT 中该页面的 recLSN 等于修改它的最小 LSN，否则检查点可能截断或跳过较早的日志
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "exception/exceptions.h"
+#include "log/log_manager.h"
+#include "system/config_manager.h"
+#include "system/system_manager.h"
+#include "table/table.h"
+#include "tx/tx_manager.h"
+
+using namespace dbtrain;
+
+static const char *TEST_DB = "dpt_order_test";
+static const int ROUNDS = 20;
+static const int THREADS = 8;
+static const int LOGS = 200;
+
+int main(int argc, char *argv[]) {
+  ConfigManager::GetInstance().Init(argc, argv);
+  SystemManager &system_manager = SystemManager::GetInstance();
+  LogManager &log_manager = LogManager::GetInstance();
+  int failures = 0;
+  try {
+    for (int round = 0; round < ROUNDS; round++) {
+      // 每轮使用新的数据库，DPT 在切换数据库时清空
+      std::string db_name = std::string(TEST_DB) + std::to_string(round % 2);
+      system_manager.DropDatabase(db_name, true);
+      system_manager.CreateDatabase(db_name);
+      system_manager.UseDatabase(db_name);
+      system_manager.CreateTable("t", {{FieldType::INT, 4, "a"}});
+      TableID table_id = system_manager.GetTable("t")->GetID();
+      std::atomic<XID> next_xid(TxManager::GetInstance().GetXID());
+      std::vector<LSN> min_lsns(THREADS, NULL_LSN);
+      std::vector<std::thread> workers;
+      for (int k = 0; k < THREADS; k++) {
+        workers.emplace_back([&, k] {
+          if (round % 2 == 0) {
+            // 写入日志，各线程取得 LSN 与加入 DPT 之间可能被其他线程插入
+            Byte value[4] = {0};
+            XID xid = next_xid++;
+            log_manager.Begin(xid);
+            for (int i = 0; i < LOGS; i++) {
+              Rid rid = {0, (SlotID)(k * LOGS + i)};
+              LSN lsn = log_manager.InsertRecordLog(xid, table_id, rid, sizeof(value), value);
+              min_lsns[k] = std::min(min_lsns[k], lsn);
+            }
+            log_manager.Commit(xid);
+          } else {
+            // 直接按 LSN 从大到小加入 DPT，先到达的总不是最小的 LSN，单核上也能复现乱序
+            for (int i = LOGS - 1; i >= 0; i--) {
+              LSN lsn = INIT_LSN + i * THREADS + k;
+              log_manager.AddDirtyPage({table_id, 0}, lsn);
+              min_lsns[k] = std::min(min_lsns[k], lsn);
+            }
+          }
+        });
+      }
+      for (auto &worker : workers) worker.join();
+      LSN min_lsn = *std::min_element(min_lsns.begin(), min_lsns.end());
+      LSN redo_start_lsn = log_manager.GetStatus().redo_start_lsn;
+      if (redo_start_lsn != min_lsn) {
+        std::cerr << "round " << round << ": redo_start_lsn " << redo_start_lsn << " != min lsn " << min_lsn << "\n";
+        failures++;
+      }
+    }
+    system_manager.CloseDatabase();
+  } catch (DbError &e) {
+    std::cerr << e.what() << std::endl;
+    system_manager.CloseDatabase();
+    return 1;
+  }
+  std::cout << (failures == 0 ? "PASS" : "FAIL") << "\n";
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+// 压缩存放的表在两次映射落盘之间反复写回，旧镜像释放的扇区被其他页面重用
+// 模拟崩溃：数据文件保留所有写入，页面映射文件回到最近一次 fsync/fdatasync 时的内容，
+// 恢复后所有页面都应通过校验，表中为最后一次提交的内容
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "exception/exceptions.h"
+#include "exec/exec.h"
+#include "oper/nodes.h"
+#include "record/fields.h"
+#include "system/config_manager.h"
+#include "system/system_manager.h"
+#include "tx/tx_manager.h"
+
+using namespace dbtrain;
+
+static const char *TEST_DB = "page_map_crash_test";
+static const char *OTHER_DB = "page_map_crash_test_other";
+static const int ROWS = 300;
+static const int ROUNDS = 6;
+static const int STR_SIZE = 200;
+
+// 映射文件已落盘的内容，按路径保存
+static std::mutex durable_mutex;
+static std::map<std::string, std::vector<char>> durable_maps;
+
+static void SaveDurable(int fd) {
+  char link[64];
+  char path[4096];
+  snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+  ssize_t length = readlink(link, path, sizeof(path) - 1);
+  if (length <= 0) return;
+  std::string name(path, length);
+  if (name.size() < DB_PAGE_MAP_SUFFIX.size() ||
+      name.compare(name.size() - DB_PAGE_MAP_SUFFIX.size(), DB_PAGE_MAP_SUFFIX.size(), DB_PAGE_MAP_SUFFIX) != 0) {
+    return;
+  }
+  std::vector<char> content(lseek(fd, 0, SEEK_END));
+  if (!content.empty() && pread(fd, content.data(), content.size(), 0) != (ssize_t)content.size()) return;
+  std::lock_guard<std::mutex> durable_lock(durable_mutex);
+  durable_maps[name] = content;
+}
+
+// 替换 libc 中的同名函数，posix 后端落盘时记录映射文件的内容
+extern "C" int fsync(int fd) {
+  int res = syscall(SYS_fsync, fd);
+  if (res == 0) SaveDurable(fd);
+  return res;
+}
+
+extern "C" int fdatasync(int fd) {
+  int res = syscall(SYS_fdatasync, fd);
+  if (res == 0) SaveDurable(fd);
+  return res;
+}
+
+// 操作系统可能在任意时刻把映射文件写回磁盘，这里强制落盘所有打开的映射文件，作为崩溃后映射文件的基准
+static void SyncPageMaps() {
+  for (int fd = 0; fd < 1024; fd++) {
+    char link[64];
+    snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+    if (access(link, F_OK) == 0) fsync(fd);
+  }
+}
+
+static void RestoreDurable() {
+  std::lock_guard<std::mutex> durable_lock(durable_mutex);
+  for (const auto &pair : durable_maps) {
+    int fd = open(pair.first.c_str(), O_WRONLY | O_TRUNC);
+    if (fd < 0 || write(fd, pair.second.data(), pair.second.size()) != (ssize_t)pair.second.size()) {
+      std::cerr << "restore " << pair.first << " failed\n";
+    }
+    if (fd >= 0) close(fd);
+  }
+}
+
+// 奇数轮为难以压缩的内容，偶数轮为重复字符，使页面镜像的长度与位置在各轮之间变化
+static std::string Content(int row, int round) {
+  std::string content(STR_SIZE - 1, 'a' + round % 26);
+  if (round % 2 == 1) {
+    unsigned int seed = row * 131 + round;
+    for (char &c : content) {
+      seed = seed * 1103515245 + 12345;
+      c = 'a' + (seed >> 16) % 26;
+    }
+  }
+  return content;
+}
+
+int main(int argc, char *argv[]) {
+  ConfigManager &config = ConfigManager::GetInstance();
+  config.Init(argc, argv);
+  config.Set("io-backend", "posix");
+  config.Set("double-write", "off");
+  config.Set("bgwriter", "off");
+  config.Set("checkpoint-timeout", "0");
+  config.Set("checkpoint-wal-size", "0");
+  SystemManager &system_manager = SystemManager::GetInstance();
+  int bad = 0;
+  try {
+    system_manager.DropDatabase(TEST_DB, true);
+    system_manager.DropDatabase(OTHER_DB, true);
+    system_manager.CreateDatabase(OTHER_DB);
+    system_manager.CreateDatabase(TEST_DB);
+    system_manager.UseDatabase(TEST_DB);
+    system_manager.CreateTable("t", {{FieldType::INT, 4, "a"}, {FieldType::STRING, STR_SIZE, "s"}},
+                               {{"compression", "lz4"}});
+    Table *table = system_manager.GetTable("t");
+    for (int i = 0; i < ROWS; i++) {
+      Record *record = new Record();
+      record->PushBack(new IntField(i));
+      std::string content = Content(i, 0);
+      record->PushBack(new StrField(content.c_str(), content.size()));
+      Executor exec(new InsertNode(table, {record}));
+      exec.Begin();
+      exec.RunNext();
+      exec.Commit();
+    }
+    system_manager.Flush();
+    SyncPageMaps();
+    for (int round = 1; round <= ROUNDS; round++) {
+      std::string content = Content(0, round);
+      Executor exec(new UpdateNode(new TableScanNode(table), table, {{1, new StrField(content.c_str(), content.size())}}));
+      exec.Begin();
+      exec.RunNext();
+      exec.Commit();
+      // 每轮写回所有脏页，页面写入新的扇区并释放旧镜像的扇区
+      system_manager.Flush();
+    }
+    system_manager.Crash();
+    RestoreDurable();
+    system_manager.UseDatabase(TEST_DB);
+    TxManager::GetInstance().SetXID(1000000);
+    table = system_manager.GetTable("t");
+    Executor exec(new SelectNode(new TableScanNode(table)));
+    exec.Begin();
+    RecordList records = exec.RunNext();
+    exec.Commit();
+    std::string expected = Content(0, ROUNDS);
+    if (records.size() != ROWS) {
+      std::cerr << "rows " << records.size() << " != " << ROWS << "\n";
+      bad++;
+    }
+    for (Record *record : records) {
+      if (record->GetField(1)->ToString() != expected) bad++;
+      delete record;
+    }
+    system_manager.UseDatabase(OTHER_DB);
+  } catch (DbError &e) {
+    std::cerr << e.what() << std::endl;
+    bad++;
+  }
+  std::cout << (bad == 0 ? "PASS" : "FAIL") << "\n";
+  return bad == 0 ? 0 : 1;
+}